@@ -0,0 +1,145 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+
+#include "acresponse.h"
+#include "resulttable.h"
+
+using namespace Spiceplus;
+
+ACResponse::ACResponse()
+{
+}
+
+ACResponse::ACResponse(const ResultTable &table, const QString &probe)
+{
+    int vector = table.findVector(probe);
+    if (vector >= 0 && table.vectorType(vector) == ResultTable::Complex)
+    {
+        m_real = table.real(vector);
+        m_imag = table.imag(vector);
+    }
+    else if (table.contains("real(" + probe + ")") && table.contains("imag(" + probe + ")"))
+    {
+        m_real = table.real("real(" + probe + ")");
+        m_imag = table.real("imag(" + probe + ")");
+    }
+    else
+        return;
+
+    m_frequencies = table.axis();
+}
+
+ACResponse::ACResponse(const QMemArray<double> &frequencies, const QMemArray<double> &real, const QMemArray<double> &imag)
+    : m_frequencies(frequencies),
+      m_real(real),
+      m_imag(imag)
+{
+}
+
+QMemArray<double> ACResponse::magnitude() const
+{
+    uint n = count();
+    QMemArray<double> result(n);
+    const double *re = m_real.data();
+    const double *im = m_imag.data();
+    double *out = result.data();
+
+    for (uint i = 0; i < n; ++i)
+        out[i] = sqrt(re[i] * re[i] + im[i] * im[i]);
+
+    return result;
+}
+
+QMemArray<double> ACResponse::magnitudeDB() const
+{
+    uint n = count();
+    QMemArray<double> result(n);
+    const double *re = m_real.data();
+    const double *im = m_imag.data();
+    double *out = result.data();
+
+    for (uint i = 0; i < n; ++i)
+        out[i] = 10 * log10(re[i] * re[i] + im[i] * im[i]);
+
+    return result;
+}
+
+QMemArray<double> ACResponse::phase() const
+{
+    uint n = count();
+    QMemArray<double> result(n);
+    const double *re = m_real.data();
+    const double *im = m_imag.data();
+    double *out = result.data();
+
+    for (uint i = 0; i < n; ++i)
+        out[i] = atan2(im[i], re[i]) * (180 / M_PI);
+
+    return result;
+}
+
+QMemArray<double> ACResponse::unwrappedPhase() const
+{
+    QMemArray<double> result = phase();
+    double *out = result.data();
+
+    double offset = 0;
+    for (uint i = 1; i < count(); ++i)
+    {
+        double step = out[i] + offset - out[i - 1];
+        if (step > 180)
+            offset -= 360;
+        else if (step < -180)
+            offset += 360;
+        out[i] += offset;
+    }
+
+    return result;
+}
+
+QMemArray<double> ACResponse::groupDelay() const
+{
+    uint n = count();
+    QMemArray<double> result(n);
+    if (n < 2)
+    {
+        result.fill(0);
+        return result;
+    }
+
+    QMemArray<double> phi = unwrappedPhase();
+    const double *p = phi.data();
+    const double *f = m_frequencies.data();
+    double *out = result.data();
+
+    // degrees over hertz to radians over radians per second
+    const double scale = -1.0 / 360;
+
+    // one-sided at the ends, central everywhere else
+    out[0] = scale * (p[1] - p[0]) / (f[1] - f[0]);
+    for (uint i = 1; i + 1 < n; ++i)
+        out[i] = scale * (p[i + 1] - p[i - 1]) / (f[i + 1] - f[i - 1]);
+    out[n - 1] = scale * (p[n - 1] - p[n - 2]) / (f[n - 1] - f[n - 2]);
+
+    return result;
+}
+
+// vim: ts=4 sw=4 et
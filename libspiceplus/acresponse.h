@@ -0,0 +1,68 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ACRESPONSE_H
+#define ACRESPONSE_H
+
+#include <qstring.h>
+#include <qmemarray.h>
+
+namespace Spiceplus {
+
+class ResultTable;
+
+// The complex response of an AC sweep, kept once and turned into the
+// quantity a view plots on demand. Each conversion is a single pass over
+// plain arrays.
+class ACResponse
+{
+public:
+    ACResponse();
+    // the complex vector of the probe, or the vectors "real(probe)" and
+    // "imag(probe)" of ".print ac real(x) imag(x) ..."; empty if the table
+    // has neither
+    ACResponse(const ResultTable &table, const QString &probe);
+    // columns of as many values, like those of a complex WaveformExpression
+    ACResponse(const QMemArray<double> &frequencies, const QMemArray<double> &real, const QMemArray<double> &imag);
+
+    uint count() const { return m_frequencies.size(); }
+    const QMemArray<double> &frequencies() const { return m_frequencies; }
+    const QMemArray<double> &real() const { return m_real; }
+    const QMemArray<double> &imag() const { return m_imag; }
+
+    QMemArray<double> magnitude() const;
+    QMemArray<double> magnitudeDB() const;
+    // in degrees between -180 and 180, like ph() in SPICE
+    QMemArray<double> phase() const;
+    // in degrees, without the jumps at +-180
+    QMemArray<double> unwrappedPhase() const;
+    // -d(phase)/d(omega) in seconds
+    QMemArray<double> groupDelay() const;
+
+private:
+    QMemArray<double> m_frequencies;
+    QMemArray<double> m_real;
+    QMemArray<double> m_imag;
+};
+
+} // namespace Spiceplus
+
+#endif // ACRESPONSE_H
+
+// vim: ts=4 sw=4 et
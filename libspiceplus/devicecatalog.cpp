@@ -0,0 +1,259 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <qdir.h>
+#include <qfile.h>
+#include <qfileinfo.h>
+#include <qdatetime.h>
+#include <qdatastream.h>
+#include <qregexp.h>
+
+#include <kapplication.h>
+#include <kconfig.h>
+#include <kstandarddirs.h>
+#include <kdebug.h>
+
+#include "devicecatalog.h"
+#include "settings.h"
+
+using namespace Spiceplus;
+
+static const Q_UINT32 CatalogMagic = 0x53504443; // "SPDC"
+static const Q_UINT32 CatalogVersion = 2;
+
+DeviceCatalog *DeviceCatalog::s_self = 0;
+
+DeviceCatalog::DeviceCatalog()
+    : QObject(kapp), m_validated(false)
+{
+    load();
+}
+
+DeviceCatalog::~DeviceCatalog()
+{
+    s_self = 0;
+}
+
+DeviceCatalog *DeviceCatalog::self()
+{
+    if (!s_self)
+        s_self = new DeviceCatalog;
+    return s_self;
+}
+
+void DeviceCatalog::validate()
+{
+    if (!isValid())
+    {
+        rebuild();
+        if (!save())
+            kdError() << k_funcinfo << "Could not save device catalog to " << cacheFile() << endl;
+    }
+
+    m_validated = true;
+}
+
+bool DeviceCatalog::find(const QString &path, Entry &entry)
+{
+    if (!m_validated)
+        validate();
+
+    QMap<QString, Entry>::ConstIterator it = m_entries.find(QDir::cleanDirPath(path));
+    if (it == m_entries.end())
+        return false;
+
+    entry = it.data();
+    return true;
+}
+
+QString DeviceCatalog::library(const QString &deviceID)
+{
+    if (!m_validated)
+        validate();
+
+    return m_libraries.contains(deviceID) ? m_libraries[deviceID] : QString::null;
+}
+
+QStringList DeviceCatalog::deviceIDs()
+{
+    if (!m_validated)
+        validate();
+
+    return m_libraries.keys();
+}
+
+bool DeviceCatalog::isValid() const
+{
+    if (m_dirTimes.isEmpty() || m_deviceDir != QDir::cleanDirPath(Settings::self()->deviceDir()))
+        return false;
+
+    for (QMap<QString, uint>::ConstIterator it = m_dirTimes.begin(); it != m_dirTimes.end(); ++it)
+    {
+        QFileInfo fi(it.key());
+        if (!fi.exists() || fi.lastModified().toTime_t() != it.data())
+            return false;
+    }
+
+    return true;
+}
+
+void DeviceCatalog::rebuild()
+{
+    m_deviceDir = QDir::cleanDirPath(Settings::self()->deviceDir());
+    m_dirTimes.clear();
+    m_entries.clear();
+    m_libraries.clear();
+
+    // device IDs are relative to the device directory, like "Standard/Resistor"
+    QDir dir(m_deviceDir);
+    m_dirTimes[m_deviceDir] = QFileInfo(m_deviceDir).lastModified().toTime_t();
+
+    QStringList subDirs = dir.entryList(QDir::Dirs);
+    for (QStringList::Iterator it = subDirs.begin(); it != subDirs.end(); ++it)
+        if (*it != "." && *it != "..")
+            scanDir(m_deviceDir + "/" + *it, m_deviceDir);
+
+    QStringList files = dir.entryList("*.device", QDir::Files);
+    for (QStringList::Iterator it = files.begin(); it != files.end(); ++it)
+        scanDir(m_deviceDir + "/" + *it, m_deviceDir);
+}
+
+void DeviceCatalog::scanDir(const QString &path, const QString &rootPath)
+{
+    QFileInfo fi(path);
+
+    if (fi.isDir())
+    {
+        m_dirTimes[path] = fi.lastModified().toTime_t();
+
+        Entry entry;
+        KConfig config(path + "/_directory", true);
+        entry.name = config.readEntry("Name", fi.fileName());
+        entry.position = config.readEntry("Position", "9999").toInt();
+        m_entries[path] = entry;
+
+        QDir dir(path);
+        QStringList names = dir.entryList(QDir::Dirs | QDir::Files);
+        for (QStringList::Iterator it = names.begin(); it != names.end(); ++it)
+        {
+            if (*it == "." || *it == "..")
+                continue;
+
+            QString childPath = path + "/" + *it;
+            if (QFileInfo(childPath).isDir() || (*it).endsWith(".device"))
+                scanDir(childPath, rootPath);
+        }
+    }
+    else
+    {
+        Entry entry;
+        KConfig config(path, true);
+        entry.id = path.mid(rootPath.length() + 1).remove(QRegExp("\\.device$"));
+        entry.name = config.readEntry("Name", fi.fileName().remove(QRegExp("\\.device$")));
+        entry.position = config.readEntry("Position", "9999").toInt();
+        entry.icon = config.readEntry("Icon");
+        entry.library = config.readEntry("Library");
+        m_entries[path] = entry;
+
+        if (!entry.library.isEmpty() && !m_libraries.contains(entry.id))
+            m_libraries[entry.id] = entry.library;
+    }
+}
+
+QString DeviceCatalog::cacheFile() const
+{
+    QString path = KGlobal::dirs()->saveLocation("data", "spiceplus/");
+    return !path.isNull() ? path + "device-catalog" : QString::null;
+}
+
+bool DeviceCatalog::load()
+{
+    QString path = cacheFile();
+    if (path.isNull())
+        return false;
+
+    QFile file(path);
+    if (!file.open(IO_ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    Q_UINT32 magic, version;
+
+    stream >> magic >> version;
+    if (magic != CatalogMagic || version != CatalogVersion)
+        return false;
+
+    QMap<QString, uint> dirTimes;
+    Q_UINT32 count;
+
+    stream >> m_deviceDir >> count;
+    for (Q_UINT32 i = 0; i < count && !stream.atEnd(); ++i)
+    {
+        QString dirPath;
+        Q_UINT32 mtime;
+        stream >> dirPath >> mtime;
+        dirTimes[dirPath] = mtime;
+    }
+
+    stream >> count;
+    for (Q_UINT32 i = 0; i < count && !stream.atEnd(); ++i)
+    {
+        QString entryPath;
+        Entry entry;
+        Q_INT32 position;
+
+        stream >> entryPath >> entry.id >> entry.name >> position >> entry.icon >> entry.library;
+        entry.position = position;
+        m_entries[entryPath] = entry;
+
+        if (!entry.library.isEmpty() && !m_libraries.contains(entry.id))
+            m_libraries[entry.id] = entry.library;
+    }
+
+    m_dirTimes = dirTimes;
+    return true;
+}
+
+bool DeviceCatalog::save() const
+{
+    QString path = cacheFile();
+    if (path.isNull())
+        return false;
+
+    QFile file(path);
+    if (!file.open(IO_WriteOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream << CatalogMagic << CatalogVersion;
+
+    stream << m_deviceDir << Q_UINT32(m_dirTimes.count());
+    for (QMap<QString, uint>::ConstIterator it = m_dirTimes.begin(); it != m_dirTimes.end(); ++it)
+        stream << it.key() << Q_UINT32(it.data());
+
+    stream << Q_UINT32(m_entries.count());
+    for (QMap<QString, Entry>::ConstIterator it = m_entries.begin(); it != m_entries.end(); ++it)
+        stream << it.key() << it.data().id << it.data().name << Q_INT32(it.data().position) << it.data().icon << it.data().library;
+
+    return file.status() == IO_Ok;
+}
+
+#include "devicecatalog.moc"
+
+// vim: ts=4 sw=4 et
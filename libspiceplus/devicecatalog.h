@@ -0,0 +1,80 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DEVICECATALOG_H
+#define DEVICECATALOG_H
+
+#include <qobject.h>
+#include <qmap.h>
+#include <qstringlist.h>
+
+namespace Spiceplus {
+
+// Cache of all .device and _directory files below the device directory.
+// It is stored on disk and only rebuilt when a directory mtime changed.
+class DeviceCatalog : public QObject
+{
+    Q_OBJECT
+
+private:
+    DeviceCatalog();
+
+public:
+    ~DeviceCatalog();
+
+    static DeviceCatalog *self();
+
+    struct Entry
+    {
+        Entry() : position(9999) {}
+
+        QString id;
+        QString name;
+        int position;
+        QString icon;
+        QString library;
+    };
+
+    void validate();
+
+    bool find(const QString &path, Entry &entry);
+    QString library(const QString &deviceID);
+    QStringList deviceIDs();
+
+private:
+    bool isValid() const;
+    void rebuild();
+    void scanDir(const QString &path, const QString &rootPath);
+    QString cacheFile() const;
+    bool load();
+    bool save() const;
+
+    static DeviceCatalog *s_self;
+    bool m_validated;
+    QString m_deviceDir;
+    QMap<QString, uint> m_dirTimes;
+    QMap<QString, Entry> m_entries;
+    QMap<QString, QString> m_libraries;
+};
+
+} // namespace Spiceplus
+
+#endif // DEVICECATALOG_H
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,194 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+
+#include <qtl.h>
+
+#include "histogram.h"
+
+using namespace Spiceplus;
+
+Histogram::Histogram(int numBins)
+    : m_bins(QMAX(2, numBins & ~1)),
+      m_pending(QMAX(2, numBins & ~1))
+{
+    clear();
+}
+
+Histogram &Histogram::operator=(const Histogram &other)
+{
+    m_bins = other.m_bins.copy();
+    m_start = other.m_start;
+    m_width = other.m_width;
+    m_pending = other.m_pending.copy();
+
+    m_count = other.m_count;
+    m_mean = other.m_mean;
+    m_sumOfSquares = other.m_sumOfSquares;
+    m_minimum = other.m_minimum;
+    m_maximum = other.m_maximum;
+
+    return *this;
+}
+
+void Histogram::clear()
+{
+    m_bins.fill(0);
+    m_pending.resize(m_bins.size());
+    m_start = 0.0;
+    m_width = 0.0;
+
+    m_count = 0;
+    m_mean = 0.0;
+    m_sumOfSquares = 0.0;
+    m_minimum = 0.0;
+    m_maximum = 0.0;
+}
+
+void Histogram::add(double value)
+{
+    // infinite values can't be binned, callers have to sort them out
+    if (!finite(value))
+        return;
+
+    if (m_count == 0 || value < m_minimum)
+        m_minimum = value;
+    if (m_count == 0 || value > m_maximum)
+        m_maximum = value;
+
+    // Welford's update, stable even for values far from zero
+    ++m_count;
+    double delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_sumOfSquares += delta * (value - m_mean);
+
+    if (m_width == 0.0)
+    {
+        m_pending[m_count - 1] = value;
+        if (m_count == static_cast<int>(m_pending.size()))
+            initializeBins();
+        return;
+    }
+
+    widen(value);
+    ++m_bins[binIndex(value)];
+}
+
+void Histogram::flush()
+{
+    if (m_width == 0.0 && m_count > 0)
+        initializeBins();
+}
+
+double Histogram::standardDeviation() const
+{
+    return m_count > 1 ? sqrt(m_sumOfSquares / (m_count - 1)) : 0.0;
+}
+
+double Histogram::percentile(double p) const
+{
+    if (m_count == 0)
+        return 0.0;
+
+    double fraction = QMIN(QMAX(p / 100, 0.0), 1.0);
+
+    // few values are still at hand, so the percentile is exact
+    if (m_width == 0.0)
+    {
+        QMemArray<double> sorted;
+        sorted.duplicate(m_pending.data(), m_count);
+        qHeapSort(sorted.begin(), sorted.end());
+
+        double position = fraction * (m_count - 1);
+        int index = int(position);
+        if (index + 1 >= m_count)
+            return sorted[m_count - 1];
+        return sorted[index] + (position - index) * (sorted[index + 1] - sorted[index]);
+    }
+
+    double target = fraction * m_count;
+    int cumulative = 0;
+    for (int bin = firstBin(); bin <= lastBin(); ++bin)
+    {
+        if (m_bins[bin] > 0 && cumulative + m_bins[bin] >= target)
+        {
+            double value = binStart(bin) + (target - cumulative) / m_bins[bin] * m_width;
+            return QMIN(QMAX(value, m_minimum), m_maximum);
+        }
+        cumulative += m_bins[bin];
+    }
+
+    return m_maximum;
+}
+
+int Histogram::firstBin() const
+{
+    return m_width == 0.0 ? 0 : binIndex(m_minimum);
+}
+
+int Histogram::lastBin() const
+{
+    return m_width == 0.0 ? -1 : binIndex(m_maximum);
+}
+
+void Histogram::initializeBins()
+{
+    double range = m_maximum - m_minimum;
+    if (range == 0.0)
+        range = m_minimum != 0.0 ? fabs(m_minimum) * 1e-6 : 1e-12;
+
+    // a quarter of the range as headroom on either side, so that later
+    // values rarely need a wider range
+    m_width = range * 1.5 / m_bins.size();
+    m_start = m_minimum - range * 0.25;
+
+    for (int i = 0; i < m_count; ++i)
+        ++m_bins[binIndex(m_pending[i])];
+    m_pending.resize(0);
+}
+
+void Histogram::widen(double value)
+{
+    int numBins = m_bins.size();
+
+    // pairs of bins are merged, the range doubles toward the value
+    while (value < m_start || value >= m_start + numBins * m_width)
+    {
+        bool downward = value < m_start;
+
+        QMemArray<int> bins(numBins);
+        bins.fill(0);
+        for (int i = 0; i < numBins / 2; ++i)
+            bins[(downward ? numBins / 2 : 0) + i] = m_bins[2 * i] + m_bins[2 * i + 1];
+
+        if (downward)
+            m_start -= numBins * m_width;
+        m_width *= 2;
+        m_bins = bins;
+    }
+}
+
+int Histogram::binIndex(double value) const
+{
+    int bin = int(floor((value - m_start) / m_width));
+    return QMIN(QMAX(bin, 0), static_cast<int>(m_bins.size()) - 1);
+}
+
+// vim: ts=4 sw=4 et
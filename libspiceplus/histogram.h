@@ -0,0 +1,82 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <qmemarray.h>
+
+namespace Spiceplus {
+
+// Summarizes a stream of values in constant memory: count, mean, standard
+// deviation and extremes exactly, percentiles from a histogram. The bin
+// range is found from the first values and doubled whenever a later value
+// falls outside of it.
+class Histogram
+{
+public:
+    Histogram(int numBins = 1024);
+    // copies are deep
+    Histogram(const Histogram &other) { *this = other; }
+    Histogram &operator=(const Histogram &other);
+
+    void add(double value);
+    void clear();
+    // Bins the values held back so far, with the range they span. The bins
+    // are empty before that while there are fewer values than bins.
+    void flush();
+
+    int count() const { return m_count; }
+    double mean() const { return m_mean; }
+    double standardDeviation() const;
+    double minimum() const { return m_minimum; }
+    double maximum() const { return m_maximum; }
+    // p in percent, interpolated within the bin it falls into
+    double percentile(double p) const;
+
+    // bins covering [minimum(), maximum()], empty until the range is known
+    int firstBin() const;
+    int lastBin() const;
+    double binStart(int bin) const { return m_start + bin * m_width; }
+    double binWidth() const { return m_width; }
+    int binCount(int bin) const { return m_bins[bin]; }
+
+private:
+    void initializeBins();
+    void widen(double value);
+    int binIndex(double value) const;
+
+    QMemArray<int> m_bins;
+    double m_start;
+    double m_width;
+    // values are held back until there are as many as bins
+    QMemArray<double> m_pending;
+
+    int m_count;
+    double m_mean;
+    double m_sumOfSquares;
+    double m_minimum;
+    double m_maximum;
+};
+
+} // namespace Spiceplus
+
+#endif // HISTOGRAM_H
+
+// vim: ts=4 sw=4 et
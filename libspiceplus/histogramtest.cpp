@@ -0,0 +1,98 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+
+#include <qglobal.h>
+
+#include "histogram.h"
+
+using namespace Spiceplus;
+
+static int s_numFailures = 0;
+
+static void check(bool condition, const char *description)
+{
+    if (!condition)
+    {
+        qWarning("FAIL: %s", description);
+        ++s_numFailures;
+    }
+}
+
+static int binnedCount(const Histogram &histogram)
+{
+    int count = 0;
+    for (int bin = histogram.firstBin(); bin <= histogram.lastBin(); ++bin)
+        count += histogram.binCount(bin);
+
+    return count;
+}
+
+// fewer values than bins are held back until flush()
+static void testFewValues()
+{
+    Histogram histogram(1024);
+    for (int i = 1; i <= 10; ++i)
+        histogram.add(i);
+
+    check(histogram.count() == 10, "count of few values");
+    check(histogram.lastBin() < histogram.firstBin(), "no bins before flush()");
+    check(fabs(histogram.percentile(50) - 5.5) < 1e-12, "exact median of few values");
+
+    Histogram copy(histogram);
+    copy.flush();
+    check(histogram.lastBin() < histogram.firstBin(), "flush() of a copy leaves the original alone");
+    check(copy.firstBin() <= copy.lastBin(), "bins after flush()");
+    check(binnedCount(copy) == 10, "all values binned by flush()");
+    check(copy.binStart(copy.firstBin()) <= 1.0, "first bin covers the minimum");
+    check(copy.binStart(copy.lastBin()) + copy.binWidth() > 10.0, "last bin covers the maximum");
+
+    // values after flush() are binned at once, the range widens as needed
+    copy.add(100.0);
+    check(binnedCount(copy) == 11, "value after flush() binned");
+    check(copy.binStart(copy.lastBin()) + copy.binWidth() > 100.0, "range widened after flush()");
+}
+
+// a single value has no range of its own
+static void testSingleValue()
+{
+    Histogram histogram(16);
+    histogram.add(3.0);
+    histogram.flush();
+
+    check(histogram.firstBin() == histogram.lastBin(), "single value in one bin");
+    check(binnedCount(histogram) == 1, "single value binned");
+}
+
+int main()
+{
+    testFewValues();
+    testSingleValue();
+
+    if (s_numFailures > 0)
+    {
+        qWarning("%d checks failed", s_numFailures);
+        return 1;
+    }
+
+    return 0;
+}
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,1220 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+#include <unistd.h>
+
+#include <qthread.h>
+#include <qmutex.h>
+#include <qptrlist.h>
+#include <qtl.h>
+
+#include <klocale.h>
+
+#include "linearcircuit.h"
+#include "sparselu.h"
+#include "spicenumber.h"
+#include "schematic.h"
+#include "schematicstandarddevice.h"
+#include "schematicground.h"
+#include "schematicjunction.h"
+#include "schematictestpoint.h"
+#include "schematicammeter.h"
+#include "trace.h"
+
+using namespace Spiceplus;
+
+typedef std::complex<double> Complex;
+
+template<class T>
+static T probeValue(const LinearCircuit::Probe &probe, int numNodes, const QMemArray<T> &x)
+{
+    if (probe.branch >= 0)
+        return x[numNodes + probe.branch];
+
+    T value = probe.node1 >= 0 ? x[probe.node1] : T(0);
+    if (probe.node2 >= 0)
+        value -= x[probe.node2];
+
+    return value;
+}
+
+// the step from one phase to another in degrees, across the wrap at 180
+static double phaseStep(double phase1, double phase2)
+{
+    double step = fmod(phase2 - phase1, 360.0);
+    if (step > 180)
+        step -= 360;
+    else if (step < -180)
+        step += 360;
+    return step;
+}
+
+// An interval between two frequencies an adaptive AC sweep would split,
+// sorted worst first.
+struct RefinedInterval
+{
+    uint row;
+    double error;
+
+    bool operator<(const RefinedInterval &other) const { return error > other.error; }
+};
+
+// intervals narrower than this are not split any further
+static const double MinRefinedRatio = 1 + 1e-6;
+
+static int numProcessors()
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? int(n) : 1;
+}
+
+// the admittance g + jwc; only the conductance is there at DC
+template<class T>
+inline T updateValue(double g, double c, double omega);
+
+template<>
+inline double updateValue<double>(double g, double, double)
+{
+    return g;
+}
+
+template<>
+inline Complex updateValue<Complex>(double g, double c, double omega)
+{
+    return Complex(g, omega * c);
+}
+
+//
+// LowRankUpdate
+//
+
+namespace Spiceplus {
+
+// Solves (A + U D U^T) x = b given a factorization of A, with
+// x = y - Z (I + D U^T Z)^-1 D U^T y, y = A^-1 b and Z = A^-1 U.
+// Z and the small dense matrix are computed once in prepare(). The
+// factors are the recording of lu with the numeric values given.
+template<class T>
+class LowRankUpdate
+{
+public:
+    LowRankUpdate() : m_rank(0) {}
+
+    int rank() const { return m_rank; }
+
+    bool prepare(const SparseLU<T> &lu, const QMemArray<T> &values, const QValueVector<LinearCircuit::UpdateTerm> &terms, double omega);
+    // b is used as scratch space
+    void solve(const SparseLU<T> &lu, const QMemArray<T> &values, QMemArray<T> &b, QMemArray<T> &x) const;
+
+private:
+    T project(int i, const QMemArray<T> &x) const;
+
+    int m_rank;
+    QMemArray<int> m_index1;
+    QMemArray<int> m_index2;
+    QMemArray<T> m_d;
+    QValueVector<QMemArray<T> > m_z;
+    QMemArray<T> m_matrix;
+    QMemArray<int> m_pivots;
+};
+
+} // namespace Spiceplus
+
+template<class T>
+T LowRankUpdate<T>::project(int i, const QMemArray<T> &x) const
+{
+    T value = m_index1[i] >= 0 ? x[m_index1[i]] : T(0);
+    if (m_index2[i] >= 0)
+        value -= x[m_index2[i]];
+
+    return value;
+}
+
+template<class T>
+bool LowRankUpdate<T>::prepare(const SparseLU<T> &lu, const QMemArray<T> &values, const QValueVector<LinearCircuit::UpdateTerm> &terms, double omega)
+{
+    int k = m_rank = terms.size();
+    m_index1.resize(k);
+    m_index2.resize(k);
+    m_d.resize(k);
+    m_z.resize(k);
+    m_matrix.resize(k * k);
+    m_pivots.resize(k);
+
+    QMemArray<T> u(lu.size());
+    for (int i = 0; i < k; ++i)
+    {
+        m_index1[i] = terms[i].index1;
+        m_index2[i] = terms[i].index2;
+        m_d[i] = updateValue<T>(terms[i].g, terms[i].c, omega);
+
+        u.fill(T(0));
+        if (m_index1[i] >= 0)
+            u[m_index1[i]] = T(1);
+        if (m_index2[i] >= 0)
+            u[m_index2[i]] = T(-1);
+        lu.solve(values, u, m_z[i]);
+    }
+
+    // I + D U^T Z, factored with partial pivoting
+    for (int i = 0; i < k; ++i)
+        for (int j = 0; j < k; ++j)
+            m_matrix[i * k + j] = (i == j ? T(1) : T(0)) + m_d[i] * project(i, m_z[j]);
+
+    for (int col = 0; col < k; ++col)
+    {
+        int p = col;
+        for (int row = col + 1; row < k; ++row)
+            if (sparseAbs(m_matrix[row * k + col]) > sparseAbs(m_matrix[p * k + col]))
+                p = row;
+
+        if (sparseAbs(m_matrix[p * k + col]) < 1e-12)
+            return false;
+
+        m_pivots[col] = p;
+        for (int j = 0; j < k; ++j)
+            qSwap(m_matrix[col * k + j], m_matrix[p * k + j]);
+
+        for (int row = col + 1; row < k; ++row)
+        {
+            T mult = m_matrix[row * k + col] /= m_matrix[col * k + col];
+            for (int j = col + 1; j < k; ++j)
+                m_matrix[row * k + j] -= mult * m_matrix[col * k + j];
+        }
+    }
+
+    return true;
+}
+
+template<class T>
+void LowRankUpdate<T>::solve(const SparseLU<T> &lu, const QMemArray<T> &values, QMemArray<T> &b, QMemArray<T> &x) const
+{
+    lu.solve(values, b, x);
+
+    int k = m_rank;
+    if (k == 0)
+        return;
+
+    QMemArray<T> w(k);
+    for (int i = 0; i < k; ++i)
+        w[i] = m_d[i] * project(i, x);
+
+    for (int col = 0; col < k; ++col)
+    {
+        qSwap(w[col], w[m_pivots[col]]);
+        for (int row = col + 1; row < k; ++row)
+            w[row] -= m_matrix[row * k + col] * w[col];
+    }
+
+    for (int row = k - 1; row >= 0; --row)
+    {
+        for (int j = row + 1; j < k; ++j)
+            w[row] -= m_matrix[row * k + j] * w[j];
+        w[row] /= m_matrix[row * k + row];
+    }
+
+    for (int i = 0; i < k; ++i)
+        for (uint j = 0; j < x.size(); ++j)
+            x[j] -= m_z[i][j] * w[i];
+}
+
+//
+// ACSweepWorker
+//
+
+namespace Spiceplus {
+
+// The frequencies of an AC sweep, handed out in chunks to the workers.
+// Workers only share this, the solution goes straight into the columns.
+// The vectors are read by all workers at once, so only through const.
+struct ACSweepJob
+{
+    static const int ChunkSize = 16;
+
+    int numNodes;
+    LinearCircuit::ProbeList probes;
+    QMemArray<int> matrixSlots;
+    QMemArray<double> g;
+    QMemArray<double> c;
+
+    int numRows;
+    const double *frequencies;
+    // the columns of each probe
+    QValueVector<double *> real;
+    QValueVector<double *> imag;
+
+    // with factors of an earlier sweep only the changed elements are
+    // applied, otherwise new factors may be kept for later. All share the
+    // recording of factor, so only their values are kept, one array for
+    // each row. Rows that needed other pivots are left empty.
+    bool useFactors;
+    bool keepFactors;
+    const SparseLU<Complex> *factor;
+    QMemArray<Complex> *factorValues;
+    QValueVector<LinearCircuit::UpdateTerm> terms;
+
+    QMutex mutex;
+    int nextRow;
+    int failedRow;
+};
+
+class ACSweepWorker : public QThread
+{
+public:
+    ACSweepWorker(ACSweepJob *job, const SparseLU<Complex> &lu, const QMemArray<Complex> &b)
+        : m_job(job), m_lu(lu), m_b(b.copy()) {}
+
+    const SparseLU<Complex> &lu() const { return m_lu; }
+
+    bool solve(int row);
+    void sweep();
+
+protected:
+    void run();
+
+private:
+    void store(int row);
+
+    ACSweepJob *m_job;
+    SparseLU<Complex> m_lu;
+    QMemArray<Complex> m_b;
+    QMemArray<Complex> m_rhs;
+    QMemArray<Complex> m_x;
+};
+
+} // namespace Spiceplus
+
+bool ACSweepWorker::solve(int row)
+{
+    double omega = 2 * M_PI * m_job->frequencies[row];
+
+    if (m_job->useFactors && !m_job->factorValues[row].isEmpty())
+    {
+        const QMemArray<Complex> &factorValues = m_job->factorValues[row];
+        LowRankUpdate<Complex> update;
+        if (update.prepare(*m_job->factor, factorValues, m_job->terms, omega))
+        {
+            m_rhs.duplicate(m_b);
+            update.solve(*m_job->factor, factorValues, m_rhs, m_x);
+            store(row);
+            return true;
+        }
+    }
+
+    const int *matrixSlots = m_job->matrixSlots.data();
+    const double *g = m_job->g.data();
+    const double *c = m_job->c.data();
+    int numEntries = m_job->matrixSlots.size();
+
+    m_lu.clear();
+    Complex *values = m_lu.values();
+    for (int i = 0; i < numEntries; ++i)
+        values[matrixSlots[i]] += Complex(g[i], omega * c[i]);
+
+    if (!m_lu.factor())
+        return false;
+
+    if (m_job->keepFactors && m_lu.numAnalyses() == m_job->factor->numAnalyses())
+        m_job->factorValues[row] = m_lu.factorValues().copy();
+
+    m_rhs.duplicate(m_b);
+    m_lu.solve(m_rhs, m_x);
+    store(row);
+
+    return true;
+}
+
+void ACSweepWorker::store(int row)
+{
+    // only const access, the implicitly shared vectors must not detach
+    // while other workers read them
+    const ACSweepJob &job = *m_job;
+    for (uint i = 0; i < job.probes.size(); ++i)
+    {
+        Complex value = probeValue(job.probes[i], job.numNodes, m_x);
+        job.real[i][row] = value.real();
+        job.imag[i][row] = value.imag();
+    }
+}
+
+void ACSweepWorker::sweep()
+{
+    for (;;)
+    {
+        m_job->mutex.lock();
+        int row = m_job->nextRow;
+        int endRow = QMIN(row + ACSweepJob::ChunkSize, m_job->numRows);
+        m_job->nextRow = endRow;
+        bool failed = m_job->failedRow >= 0;
+        m_job->mutex.unlock();
+
+        if (failed || row >= endRow)
+            return;
+
+        for (; row < endRow; ++row)
+        {
+            if (!solve(row))
+            {
+                QMutexLocker locker(&m_job->mutex);
+                if (m_job->failedRow < 0 || row < m_job->failedRow)
+                    m_job->failedRow = row;
+                return;
+            }
+        }
+    }
+}
+
+void ACSweepWorker::run()
+{
+    TraceSpan span("LinearCircuit AC worker");
+    sweep();
+}
+
+//
+// LinearCircuit
+//
+
+LinearCircuit::LinearCircuit()
+    : m_numBranches(0),
+      m_hasDCFactor(false),
+      m_acStartFrequency(0),
+      m_acStopFrequency(0),
+      m_acNumPointsPerDecade(0)
+{
+}
+
+bool LinearCircuit::build(Schematic *schematic)
+{
+    QMap<QString, int> nodes = m_nodes;
+    QValueVector<Element> elements = m_elements;
+    return finishBuild(buildElements(schematic), nodes, elements);
+}
+
+bool LinearCircuit::build(const QStringList &netlist)
+{
+    QMap<QString, int> nodes = m_nodes;
+    QValueVector<Element> elements = m_elements;
+    return finishBuild(buildElements(netlist), nodes, elements);
+}
+
+bool LinearCircuit::finishBuild(bool isBuilt, const QMap<QString, int> &nodes, const QValueVector<Element> &elements)
+{
+    if (!isBuilt)
+    {
+        discardFactors();
+        return false;
+    }
+
+    // the factors stay useful if only element values changed
+    if (!isSameStructure(nodes, elements))
+        discardFactors();
+
+    return true;
+}
+
+bool LinearCircuit::buildElements(Schematic *schematic)
+{
+    m_nodes.clear();
+    m_elements.clear();
+    m_numBranches = 0;
+
+    QCanvasItemList l = schematic->allItems();
+    for (QCanvasItemList::Iterator it = l.begin(); it != l.end(); ++it)
+    {
+        if (!(*it)->isVisible() || (*it)->rtti() != SchematicDevice::RTTI)
+            continue;
+
+        SchematicDevice *device = static_cast<SchematicDevice *>(*it);
+        QString id = device->id();
+
+        if (id == SchematicGround::ID || id == SchematicJunction::ID || id == SchematicTestPoint::ID)
+            continue;
+
+        SchematicStandardDevice *dev = dynamic_cast<SchematicStandardDevice *>(device);
+        bool isResistor = id == "Standard/Resistor";
+        ElementType type = Resistor;
+        bool isSupported = true;
+
+        if (id == "Standard/Capacitor")
+            type = Capacitor;
+        else if (id == "Standard/Inductor")
+            type = Inductor;
+        else if (id == "Standard/IndependentVoltageSource" || id == SchematicAmmeter::ID)
+            type = VoltageSource;
+        else if (id == "Standard/IndependentCurrentSource")
+            type = CurrentSource;
+        else if (!isResistor)
+            isSupported = false;
+
+        // semiconductor resistors and capacitors need SPICE
+        if (!dev || !isSupported || dev->hasModel() || (isResistor && !dev->parameter("temp").isEmpty()))
+        {
+            m_errorString = i18n("Device %1 is not supported by the built-in solver").arg(device->name());
+            return false;
+        }
+
+        SchematicDevicePin *pin1 = dev->findPin(isResistor ? "a" : "p");
+        SchematicDevicePin *pin2 = dev->findPin(isResistor ? "b" : "n");
+        if (!pin1 || !pin2 || !pin1->node() || !pin2->node())
+        {
+            m_errorString = i18n("Device %1: Pin(s) not connected").arg(dev->name());
+            return false;
+        }
+
+        Element *element = addElement(type, dev->name(), nodeIndex(pin1->node()->name()), nodeIndex(pin2->node()->name()));
+
+        if (id == SchematicAmmeter::ID)
+        {
+            element->hasDCValue = element->hasACValue = true;
+            continue;
+        }
+
+        if (type == VoltageSource || type == CurrentSource)
+        {
+            // only plain DC sources have a DC value for sure; like SPICE,
+            // take missing values as zero
+            if (dev->parameter("type") == "dc")
+                element->hasDCValue = dev->parameter("dcvalue").isEmpty() || dev->parameterValue("dcvalue", element->dcValue);
+
+            element->hasACValue = (dev->parameter("acmag").isEmpty() || dev->parameterValue("acmag", element->acMagnitude)) &&
+                                  (dev->parameter("acphase").isEmpty() || dev->parameterValue("acphase", element->acPhase));
+        }
+        else if (!dev->parameterValue("value", element->value) || (type == Resistor && element->value == 0))
+        {
+            m_errorString = i18n("Device %1: Invalid value").arg(dev->name());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LinearCircuit::buildElements(const QStringList &netlist)
+{
+    m_nodes.clear();
+    m_elements.clear();
+    m_numBranches = 0;
+
+    for (QStringList::ConstIterator it = netlist.begin(); it != netlist.end(); ++it)
+    {
+        QStringList fields = QStringList::split(QChar(' '), (*it).simplifyWhiteSpace());
+        if (fields.isEmpty())
+            continue;
+
+        QString name = fields[0];
+        ElementType type = Resistor;
+        switch (name[0].lower().latin1())
+        {
+        case 'r': type = Resistor; break;
+        case 'c': type = Capacitor; break;
+        case 'l': type = Inductor; break;
+        case 'v': type = VoltageSource; break;
+        case 'i': type = CurrentSource; break;
+        default:
+            m_errorString = i18n("Device %1 is not supported by the built-in solver").arg(name);
+            return false;
+        }
+
+        if (fields.count() < 3)
+        {
+            m_errorString = i18n("Device %1: Pin(s) not connected").arg(name);
+            return false;
+        }
+
+        Element *element = addElement(type, name, nodeIndex(fields[1]), nodeIndex(fields[2]));
+        bool ok = true;
+        if (type == VoltageSource || type == CurrentSource)
+        {
+            // "dc" and "ac" with their values, missing ones are zero
+            element->hasDCValue = element->hasACValue = true;
+            for (uint i = 3; i < fields.count() && ok; ++i)
+            {
+                QString key = fields[i].lower();
+                if (key == "dc" && i + 1 < fields.count())
+                    ok = SpiceNumber::parse(fields[++i], element->dcValue);
+                else if (key == "ac" && i + 1 < fields.count())
+                {
+                    ok = SpiceNumber::parse(fields[++i], element->acMagnitude);
+                    if (ok && i + 1 < fields.count() && SpiceNumber::parse(fields[i + 1], element->acPhase))
+                        ++i;
+                }
+                else
+                    ok = false;
+            }
+        }
+        else
+            ok = fields.count() == 4 && SpiceNumber::parse(fields[3], element->value) && (type != Resistor || element->value != 0);
+
+        if (!ok)
+        {
+            m_errorString = i18n("Device %1: Invalid value").arg(name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LinearCircuit::voltageProbe(const QString &nodeName1, const QString &nodeName2, Probe &probe)
+{
+    probe = Probe();
+
+    if ((nodeName1 != "0" && !m_nodes.contains(nodeName1)) || (nodeName2 != "0" && !m_nodes.contains(nodeName2)))
+    {
+        m_errorString = i18n("Node not connected to any device");
+        return false;
+    }
+
+    probe.node1 = nodeIndex(nodeName1);
+    probe.node2 = nodeIndex(nodeName2);
+    return true;
+}
+
+bool LinearCircuit::currentProbe(const QString &sourceName, Probe &probe)
+{
+    probe = Probe();
+
+    int i = findSource(sourceName);
+    if (i < 0 || m_elements[i].type != VoltageSource)
+    {
+        m_errorString = i18n("Voltage source %1 not found").arg(sourceName);
+        return false;
+    }
+
+    probe.branch = m_elements[i].branch;
+    return true;
+}
+
+bool LinearCircuit::dcSweep(const Sweep &sweep1, const Sweep &sweep2, const ProbeList &probes, ResultTable &table)
+{
+    TraceSpan span("LinearCircuit::dcSweep");
+
+    int source1 = findSource(sweep1.source);
+    int source2 = sweep2.source.isEmpty() ? -1 : findSource(sweep2.source);
+    if (source1 < 0 || (!sweep2.source.isEmpty() && source2 < 0))
+    {
+        m_errorString = i18n("Source %1 not found").arg(source1 < 0 ? sweep1.source : sweep2.source);
+        return false;
+    }
+
+    for (uint i = 0; i < m_elements.size(); ++i)
+    {
+        const Element &e = m_elements[i];
+        if ((e.type == VoltageSource || e.type == CurrentSource) && !e.hasDCValue && int(i) != source1 && int(i) != source2)
+        {
+            m_errorString = i18n("Source %1 has no DC value").arg(e.name);
+            return false;
+        }
+    }
+
+    QValueVector<double> values1, values2;
+    if (!sweepValues(sweep1, values1))
+        return false;
+    if (source2 < 0)
+        values2.push_back(0);
+    else if (!sweepValues(sweep2, values2))
+        return false;
+
+    // the sources only enter the right-hand side, so one factorization
+    // serves the whole sweep, and later ones as long as few values change
+    int numNodes = m_nodes.count();
+    LowRankUpdate<double> update;
+    bool isUpdated = false;
+
+    if (m_hasDCFactor)
+    {
+        QValueVector<UpdateTerm> terms = updateTerms(m_dcBaseValues, true);
+        isUpdated = terms.size() <= MaxUpdateRank && update.prepare(m_dcFactor, m_dcFactor.factorValues(), terms, 0);
+    }
+
+    if (!isUpdated)
+    {
+        m_hasDCFactor = false;
+        m_dcFactor = SparseLU<double>(numUnknowns());
+        m_dcBaseValues = elementValues();
+
+        QValueVector<MatrixEntry> entries = matrixEntries();
+        for (uint i = 0; i < entries.size(); ++i)
+        {
+            int s = m_dcFactor.slot(entries[i].row, entries[i].col);
+            m_dcFactor.values()[s] += entries[i].g;
+        }
+
+        if (!m_dcFactor.factor())
+        {
+            m_errorString = i18n("Singular matrix");
+            return false;
+        }
+
+        m_hasDCFactor = true;
+    }
+
+    uint numRows = values1.size() * values2.size();
+    QMemArray<double> axis(numRows);
+    QValueVector<QMemArray<double> > probeValues(probes.size());
+    for (uint i = 0; i < probes.size(); ++i)
+        probeValues[i].resize(numRows);
+
+    QMemArray<double> b(numUnknowns()), x;
+    uint row = 0;
+
+    for (uint i2 = 0; i2 < values2.size(); ++i2)
+    {
+        for (uint i1 = 0; i1 < values1.size(); ++i1, ++row)
+        {
+            b.fill(0);
+            for (uint i = 0; i < m_elements.size(); ++i)
+            {
+                const Element &e = m_elements[i];
+                if (e.type != VoltageSource && e.type != CurrentSource)
+                    continue;
+
+                double value = int(i) == source1 ? values1[i1] : int(i) == source2 ? values2[i2] : e.dcValue;
+                if (e.type == VoltageSource)
+                    b[numNodes + e.branch] += value;
+                else
+                {
+                    // current flows from the positive node through the source
+                    if (e.node1 >= 0)
+                        b[e.node1] -= value;
+                    if (e.node2 >= 0)
+                        b[e.node2] += value;
+                }
+            }
+
+            update.solve(m_dcFactor, m_dcFactor.factorValues(), b, x);
+
+            axis[row] = values1[i1];
+            for (uint i = 0; i < probes.size(); ++i)
+                probeValues[i][row] = probeValue(probes[i], numNodes, x);
+        }
+    }
+
+    table = ResultTable();
+    table.setAxis(sweep1.source, axis);
+    for (uint i = 0; i < probes.size(); ++i)
+        table.addVector(probes[i].name, probeValues[i]);
+    return true;
+}
+
+bool LinearCircuit::acSweep(double startFrequency, double stopFrequency, int numPointsPerDecade, const ProbeList &probes, ResultTable &table)
+{
+    TraceSpan span("LinearCircuit::acSweep");
+
+    if (startFrequency <= 0 || stopFrequency < startFrequency || numPointsPerDecade < 1)
+    {
+        m_errorString = i18n("Invalid frequency range");
+        return false;
+    }
+
+    uint numRows = uint(floor(log10(stopFrequency / startFrequency) * numPointsPerDecade + 1e-9)) + 1;
+    QValueVector<QMemArray<double> > columns(3 + 2 * probes.size());
+    columns[1].resize(numRows);
+
+    double ratio = pow(10.0, 1.0 / numPointsPerDecade);
+    for (uint row = 0; row < numRows; ++row)
+        columns[1][row] = startFrequency * pow(ratio, double(row));
+
+    // the kept factors belong to one sweep
+    if (m_acStartFrequency != startFrequency || m_acStopFrequency != stopFrequency || m_acNumPointsPerDecade != numPointsPerDecade)
+    {
+        discardFactors();
+        m_acStartFrequency = startFrequency;
+        m_acStopFrequency = stopFrequency;
+        m_acNumPointsPerDecade = numPointsPerDecade;
+    }
+
+    if (!solveAC(probes, true, columns))
+        return false;
+
+    setACResult(columns, probes, table);
+    return true;
+}
+
+bool LinearCircuit::adaptiveACSweep(double startFrequency, double stopFrequency, int numPointsPerDecade, double tolerance, uint maxPoints, const ProbeList &probes, ResultTable &table)
+{
+    TraceSpan span("LinearCircuit::adaptiveACSweep");
+
+    if (startFrequency <= 0 || stopFrequency < startFrequency || numPointsPerDecade < 1)
+    {
+        m_errorString = i18n("Invalid frequency range");
+        return false;
+    }
+
+    uint numRows = uint(floor(log10(stopFrequency / startFrequency) * numPointsPerDecade + 1e-9)) + 1;
+    QValueVector<QMemArray<double> > columns(3 + 2 * probes.size());
+    columns[1].resize(numRows);
+
+    double ratio = pow(10.0, 1.0 / numPointsPerDecade);
+    for (uint row = 0; row < numRows; ++row)
+        columns[1][row] = startFrequency * pow(ratio, double(row));
+
+    if (!solveAC(probes, false, columns))
+        return false;
+
+    uint numColumns = columns.size();
+    while (numRows < maxPoints)
+    {
+        const double *f = columns[1].data();
+        QMemArray<double> error(numRows - 1);
+        error.fill(0);
+
+        for (uint col = 3; col < numColumns; col += 2)
+        {
+            QMemArray<double> magnitude(numRows), phase(numRows);
+            for (uint row = 0; row < numRows; ++row)
+            {
+                double re = columns[col][row];
+                double im = columns[col + 1][row];
+                magnitude[row] = 10 * log10(QMAX(re * re + im * im, 1e-300));
+                phase[row] = atan2(im, re) * 180 / M_PI;
+            }
+
+            // the error of each interval is the larger of the step between
+            // its ends and the bend at either end; straight slopes need few
+            // points, so steps count less
+            for (uint row = 0; row + 1 < numRows; ++row)
+                error[row] = QMAX(error[row], QMAX(fabs(magnitude[row + 1] - magnitude[row]), fabs(phaseStep(phase[row], phase[row + 1])) / 10) / 8);
+
+            for (uint row = 1; row + 1 < numRows; ++row)
+            {
+                // deviation from the straight line through the neighbours
+                double t = log(f[row] / f[row - 1]) / log(f[row + 1] / f[row - 1]);
+                double bend = QMAX(fabs(magnitude[row] - magnitude[row - 1] - t * (magnitude[row + 1] - magnitude[row - 1])),
+                                   fabs(phaseStep(phase[row - 1], phase[row]) - t * phaseStep(phase[row - 1], phase[row + 1])) / 10);
+                error[row - 1] = QMAX(error[row - 1], bend);
+                error[row] = QMAX(error[row], bend);
+            }
+        }
+
+        QValueVector<RefinedInterval> intervals;
+        for (uint row = 0; row + 1 < numRows; ++row)
+        {
+            if (error[row] > tolerance && f[row + 1] > f[row] * MinRefinedRatio)
+            {
+                RefinedInterval interval;
+                interval.row = row;
+                interval.error = error[row];
+                intervals.push_back(interval);
+            }
+        }
+
+        if (intervals.isEmpty())
+            break;
+
+        // the worst intervals first, as far as the budget goes
+        uint numNewRows = QMIN(uint(intervals.size()), maxPoints - numRows);
+        if (numNewRows < intervals.size())
+        {
+            qHeapSort(intervals);
+            intervals.resize(numNewRows);
+        }
+
+        QValueVector<QMemArray<double> > refinement(numColumns);
+        refinement[1].resize(numNewRows);
+        QMemArray<uint> positions(numNewRows);
+        for (uint i = 0; i < numNewRows; ++i)
+            positions[i] = intervals[i].row;
+        qHeapSort(positions.data(), positions.data() + numNewRows);
+        for (uint i = 0; i < numNewRows; ++i)
+            refinement[1][i] = sqrt(f[positions[i]] * f[positions[i] + 1]);
+
+        if (!solveAC(probes, false, refinement))
+            return false;
+
+        // each new point goes right after the start of its interval
+        QValueVector<QMemArray<double> > merged(numColumns);
+        for (uint col = 0; col < numColumns; ++col)
+            merged[col].resize(numRows + numNewRows);
+
+        uint i = 0;
+        for (uint row = 0, mergedRow = 0; row < numRows; ++row)
+        {
+            for (uint col = 1; col < numColumns; ++col)
+                merged[col][mergedRow] = columns[col][row];
+            ++mergedRow;
+
+            if (i < numNewRows && positions[i] == row)
+            {
+                for (uint col = 1; col < numColumns; ++col)
+                    merged[col][mergedRow] = refinement[col][i];
+                ++mergedRow;
+                ++i;
+            }
+        }
+
+        numRows += numNewRows;
+        for (uint row = 0; row < numRows; ++row)
+            merged[0][row] = row;
+        columns = merged;
+    }
+
+    setACResult(columns, probes, table);
+    return true;
+}
+
+bool LinearCircuit::solveAC(const ProbeList &probes, bool isKept, QValueVector<QMemArray<double> > &columns)
+{
+    int numNodes = m_nodes.count();
+    QMemArray<Complex> b(numUnknowns());
+    b.fill(Complex(0));
+
+    // the excitation does not depend on the frequency
+    for (uint i = 0; i < m_elements.size(); ++i)
+    {
+        const Element &e = m_elements[i];
+        if (e.type != VoltageSource && e.type != CurrentSource)
+            continue;
+
+        if (!e.hasACValue)
+        {
+            m_errorString = i18n("Source %1 has no AC value").arg(e.name);
+            return false;
+        }
+
+        Complex value = std::polar(e.acMagnitude, e.acPhase * M_PI / 180);
+        if (e.type == VoltageSource)
+            b[numNodes + e.branch] += value;
+        else
+        {
+            if (e.node1 >= 0)
+                b[e.node1] -= value;
+            if (e.node2 >= 0)
+                b[e.node2] += value;
+        }
+    }
+
+    QValueVector<MatrixEntry> entries = matrixEntries();
+    uint numRows = columns[1].size();
+
+    columns.resize(3 + 2 * probes.size());
+    for (uint col = 0; col < columns.size(); ++col)
+        if (col != 1)
+            columns[col].resize(numRows);
+
+    ACSweepJob job;
+    job.numNodes = numNodes;
+    job.probes = probes;
+    job.numRows = numRows;
+    job.frequencies = columns[1].data();
+    for (uint i = 0; i < probes.size(); ++i)
+    {
+        job.real.push_back(columns[3 + 2 * i].data());
+        job.imag.push_back(columns[4 + 2 * i].data());
+    }
+    job.nextRow = 0;
+    job.failedRow = -1;
+
+    job.useFactors = false;
+    job.keepFactors = false;
+    if (isKept && m_acFactorValues.size() == numRows)
+    {
+        job.terms = updateTerms(m_acBaseValues, false);
+        job.useFactors = job.terms.size() <= MaxUpdateRank;
+    }
+
+    if (isKept && !job.useFactors)
+        discardFactors();
+
+    // detached here, the workers only write their own rows
+    QValueVector<QMemArray<Complex> > factorValues(numRows);
+    job.factor = &m_acFactor;
+    job.factorValues = job.useFactors ? m_acFactorValues.begin() : factorValues.begin();
+
+    for (uint row = 0; row < numRows; ++row)
+    {
+        columns[0][row] = row;
+        columns[2][row] = 0;
+    }
+
+    // the matrix is stored as conductances and capacitances in separate
+    // arrays, so that assembling it is a plain loop over the entries
+    SparseLU<Complex> lu(numUnknowns());
+    job.matrixSlots.resize(entries.size());
+    job.g.resize(entries.size());
+    job.c.resize(entries.size());
+    for (uint i = 0; i < entries.size(); ++i)
+    {
+        job.matrixSlots[i] = lu.slot(entries[i].row, entries[i].col);
+        job.g[i] = entries[i].g;
+        job.c[i] = entries[i].c;
+    }
+
+    // the first frequency chooses the pivots for all the others
+    ACSweepWorker first(&job, lu, b);
+    if (!job.useFactors)
+    {
+        if (!first.solve(0))
+        {
+            m_errorString = i18n("Singular matrix at %1 Hz").arg(job.frequencies[0]);
+            return false;
+        }
+
+        job.nextRow = 1;
+        if (isKept && numRows * first.lu().numEntries() <= MaxCachedACEntries)
+        {
+            job.keepFactors = true;
+            m_acFactor = first.lu();
+            factorValues[0] = m_acFactor.factorValues().copy();
+        }
+    }
+
+    int numThreads = QMIN(numProcessors(), int((numRows - 1) / ACSweepJob::ChunkSize));
+    if (numThreads < 2)
+        first.sweep();
+    else
+    {
+        QPtrList<ACSweepWorker> workers;
+        workers.setAutoDelete(true);
+        for (int i = 0; i < numThreads; ++i)
+        {
+            workers.append(new ACSweepWorker(&job, first.lu(), b));
+            workers.last()->start();
+        }
+
+        for (ACSweepWorker *worker = workers.first(); worker; worker = workers.next())
+            worker->wait();
+    }
+
+    if (job.keepFactors)
+    {
+        m_acFactorValues = factorValues;
+        m_acBaseValues = elementValues();
+    }
+
+    if (job.failedRow >= 0)
+    {
+        if (isKept)
+            discardFactors();
+        m_errorString = i18n("Singular matrix at %1 Hz").arg(job.frequencies[job.failedRow]);
+        return false;
+    }
+
+    return true;
+}
+
+void LinearCircuit::setACResult(const QValueVector<QMemArray<double> > &columns, const ProbeList &probes, ResultTable &table)
+{
+    table = ResultTable();
+    table.setAxis("frequency", columns[1]);
+    for (uint i = 0; i < probes.size(); ++i)
+        table.addVector(probes[i].name, columns[3 + 2 * i], columns[4 + 2 * i]);
+}
+
+int LinearCircuit::nodeIndex(const QString &nodeName)
+{
+    if (nodeName == "0")
+        return -1;
+
+    QMap<QString, int>::ConstIterator it = m_nodes.find(nodeName);
+    if (it != m_nodes.end())
+        return it.data();
+
+    int index = m_nodes.count();
+    m_nodes[nodeName] = index;
+    return index;
+}
+
+LinearCircuit::Element *LinearCircuit::addElement(ElementType type, const QString &name, int node1, int node2)
+{
+    Element element;
+    element.type = type;
+    element.name = name;
+    element.node1 = node1;
+    element.node2 = node2;
+
+    if (type == VoltageSource || type == Inductor)
+        element.branch = m_numBranches++;
+
+    m_elements.push_back(element);
+    return &m_elements.back();
+}
+
+int LinearCircuit::findSource(const QString &name) const
+{
+    for (uint i = 0; i < m_elements.size(); ++i)
+    {
+        const Element &e = m_elements[i];
+        if ((e.type == VoltageSource || e.type == CurrentSource) && e.name.lower() == name.lower())
+            return i;
+    }
+
+    return -1;
+}
+
+QValueVector<LinearCircuit::MatrixEntry> LinearCircuit::matrixEntries() const
+{
+    QValueVector<MatrixEntry> entries;
+    int numNodes = m_nodes.count();
+
+    for (uint i = 0; i < m_elements.size(); ++i)
+    {
+        const Element &e = m_elements[i];
+        int n[] = { e.node1, e.node2 };
+        double sign[] = { 1, -1 };
+
+        if (e.type == Resistor || e.type == Capacitor)
+        {
+            double g = e.type == Resistor ? 1 / e.value : 0;
+            double c = e.type == Capacitor ? e.value : 0;
+
+            for (int j = 0; j < 2; ++j)
+            {
+                for (int k = 0; k < 2; ++k)
+                {
+                    if (n[j] < 0 || n[k] < 0)
+                        continue;
+
+                    MatrixEntry entry = { n[j], n[k], sign[j] * sign[k] * g, sign[j] * sign[k] * c };
+                    entries.push_back(entry);
+                }
+            }
+        }
+        else if (e.type == VoltageSource || e.type == Inductor)
+        {
+            // the branch current flows from the positive node through the element
+            int branch = numNodes + e.branch;
+            for (int j = 0; j < 2; ++j)
+            {
+                if (n[j] < 0)
+                    continue;
+
+                MatrixEntry entry1 = { n[j], branch, sign[j], 0 };
+                MatrixEntry entry2 = { branch, n[j], sign[j], 0 };
+                entries.push_back(entry1);
+                entries.push_back(entry2);
+            }
+
+            if (e.type == Inductor)
+            {
+                MatrixEntry entry = { branch, branch, 0, -e.value };
+                entries.push_back(entry);
+            }
+        }
+    }
+
+    return entries;
+}
+
+QMemArray<double> LinearCircuit::elementValues() const
+{
+    QMemArray<double> values(m_elements.size());
+    for (uint i = 0; i < m_elements.size(); ++i)
+        values[i] = m_elements[i].value;
+
+    return values;
+}
+
+QValueVector<LinearCircuit::UpdateTerm> LinearCircuit::updateTerms(const QMemArray<double> &baseValues, bool dc) const
+{
+    QValueVector<UpdateTerm> terms;
+    int numNodes = m_nodes.count();
+
+    for (uint i = 0; i < m_elements.size(); ++i)
+    {
+        const Element &e = m_elements[i];
+        if (e.value == baseValues[i])
+            continue;
+
+        UpdateTerm term = { e.node1, e.node2, 0, 0 };
+        if (e.type == Resistor)
+            term.g = 1 / e.value - 1 / baseValues[i];
+        else if (e.type == Capacitor)
+            term.c = e.value - baseValues[i];
+        else if (e.type == Inductor)
+        {
+            term.index1 = numNodes + e.branch;
+            term.index2 = -1;
+            term.c = baseValues[i] - e.value;
+        }
+        else
+            continue;
+
+        // capacitors and inductors do not show up in the DC matrix
+        if (dc && term.g == 0)
+            continue;
+
+        terms.push_back(term);
+    }
+
+    return terms;
+}
+
+bool LinearCircuit::isSameStructure(const QMap<QString, int> &nodes, const QValueVector<Element> &elements) const
+{
+    if (nodes.count() != m_nodes.count() || elements.size() != m_elements.size())
+        return false;
+
+    QMap<QString, int>::ConstIterator it;
+    for (it = nodes.begin(); it != nodes.end(); ++it)
+    {
+        QMap<QString, int>::ConstIterator n = m_nodes.find(it.key());
+        if (n == m_nodes.end() || n.data() != it.data())
+            return false;
+    }
+
+    for (uint i = 0; i < elements.size(); ++i)
+    {
+        const Element &e1 = elements[i];
+        const Element &e2 = m_elements[i];
+        if (e1.type != e2.type || e1.name != e2.name || e1.node1 != e2.node1 || e1.node2 != e2.node2 || e1.branch != e2.branch)
+            return false;
+    }
+
+    return true;
+}
+
+void LinearCircuit::discardFactors()
+{
+    m_hasDCFactor = false;
+    m_dcFactor = SparseLU<double>();
+    m_acFactor = SparseLU<Complex>();
+    m_acFactorValues.clear();
+}
+
+bool LinearCircuit::sweepValues(const Sweep &sweep, QValueVector<double> &values)
+{
+    values.clear();
+
+    if (sweep.step == 0 || (sweep.stop - sweep.start) * sweep.step < 0)
+    {
+        if (sweep.start != sweep.stop)
+        {
+            m_errorString = i18n("Invalid increment for source %1").arg(sweep.source);
+            return false;
+        }
+
+        values.push_back(sweep.start);
+        return true;
+    }
+
+    double epsilon = fabs(sweep.step) * 1e-9;
+    for (int i = 0;; ++i)
+    {
+        double value = sweep.start + i * sweep.step;
+        if (sweep.step > 0 ? value > sweep.stop + epsilon : value < sweep.stop - epsilon)
+            break;
+        values.push_back(value);
+    }
+
+    return true;
+}
+
+// vim: ts=4 sw=4 et
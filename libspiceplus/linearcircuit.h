@@ -0,0 +1,196 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINEARCIRCUIT_H
+#define LINEARCIRCUIT_H
+
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qmap.h>
+#include <qvaluevector.h>
+#include <qmemarray.h>
+
+#include "resulttable.h"
+#include "sparselu.h"
+
+namespace Spiceplus {
+
+class Schematic;
+
+// A circuit of resistors, capacitors, inductors, independent sources and
+// ammeters, solved in process by modified nodal analysis. build() fails for
+// anything else, in which case the analysis has to be left to SPICE.
+// Results come back as a ResultTable with a vector for each probe, named
+// like the probe.
+//
+// The factorizations of the last sweeps are kept. When build() finds the
+// same circuit with only a few resistor, capacitor or inductor values
+// changed, the next sweep corrects the old solution with a low-rank
+// (Woodbury) update instead of factoring again.
+class LinearCircuit
+{
+    friend struct ACSweepJob;
+    template<class T> friend class LowRankUpdate;
+
+public:
+    struct Probe
+    {
+        Probe() : node1(-1), node2(-1), branch(-1) {}
+
+        // the name of its vector in the result, like the SPICE expression
+        QString name;
+        // unknowns of a node voltage difference or a branch current;
+        // -1 stands for ground or unused
+        int node1;
+        int node2;
+        int branch;
+    };
+    typedef QValueVector<Probe> ProbeList;
+
+    struct Sweep
+    {
+        Sweep() : start(0), stop(0), step(0) {}
+
+        QString source;
+        double start;
+        double stop;
+        double step;
+    };
+
+    LinearCircuit();
+    ~LinearCircuit();
+
+    bool build(Schematic *schematic);
+    // Like build(), from a netlist with a device on each line as in SPICE:
+    // "R1 a b 1k", "C1 b 0 100n", "L1 a b 1m", "V1 a 0 dc 5 ac 1 90",
+    // "I1 0 a dc 1m". Node "0" is ground.
+    bool build(const QStringList &netlist);
+
+    bool voltageProbe(const QString &nodeName1, const QString &nodeName2, Probe &probe);
+    bool currentProbe(const QString &sourceName, Probe &probe);
+
+    // The axis is the value of the first source, each probe has a real
+    // vector. With a second source the first sweep is repeated for each of
+    // its values.
+    bool dcSweep(const Sweep &sweep1, const Sweep &sweep2, const ProbeList &probes, ResultTable &table);
+
+    // The axis is the frequency, spaced logarithmically like ".ac dec";
+    // each probe has a complex vector.
+    bool acSweep(double startFrequency, double stopFrequency, int numPointsPerDecade, const ProbeList &probes, ResultTable &table);
+
+    // Like acSweep(), but numPointsPerDecade only sets the coarse first
+    // pass. Points are then added where the magnitude in dB bends away from
+    // a straight line by more than the tolerance, or steps by more than
+    // eight times the tolerance, until maxPoints are reached. Phase counts
+    // in steps of ten degrees. The worst of the probes counts.
+    bool adaptiveACSweep(double startFrequency, double stopFrequency, int numPointsPerDecade, double tolerance, uint maxPoints, const ProbeList &probes, ResultTable &table);
+
+    QString errorString() const { return m_errorString; }
+
+private:
+    enum ElementType { Resistor, Capacitor, Inductor, VoltageSource, CurrentSource };
+
+    struct Element
+    {
+        Element() : type(Resistor), node1(-1), node2(-1), branch(-1), value(0),
+                    hasDCValue(false), dcValue(0), hasACValue(false), acMagnitude(0), acPhase(0) {}
+
+        ElementType type;
+        QString name;
+        int node1;
+        int node2;
+        int branch;
+        double value;
+        bool hasDCValue;
+        double dcValue;
+        bool hasACValue;
+        double acMagnitude;
+        double acPhase;
+    };
+
+    // an entry of the matrix G + jwC
+    struct MatrixEntry
+    {
+        int row;
+        int col;
+        double g;
+        double c;
+    };
+
+    // the change of one element since the matrix was factored:
+    // (g + jwc) u u^T with u = e(index1) - e(index2)
+    struct UpdateTerm
+    {
+        int index1;
+        int index2;
+        double g;
+        double c;
+    };
+
+    // beyond this many changed elements factoring again is cheaper
+    static const uint MaxUpdateRank = 4;
+    // limit on the factor values kept for all frequencies of an AC sweep
+    static const uint MaxCachedACEntries = 4000000;
+
+    bool buildElements(Schematic *schematic);
+    bool buildElements(const QStringList &netlist);
+    // after buildElements() with the nodes and elements from before
+    bool finishBuild(bool isBuilt, const QMap<QString, int> &nodes, const QValueVector<Element> &elements);
+    int nodeIndex(const QString &nodeName);
+    Element *addElement(ElementType type, const QString &name, int node1, int node2);
+    int findSource(const QString &name) const;
+    int numUnknowns() const { return m_nodes.count() + m_numBranches; }
+    QValueVector<MatrixEntry> matrixEntries() const;
+    QMemArray<double> elementValues() const;
+    QValueVector<UpdateTerm> updateTerms(const QMemArray<double> &baseValues, bool dc) const;
+    bool isSameStructure(const QMap<QString, int> &nodes, const QValueVector<Element> &elements) const;
+    void discardFactors();
+    bool sweepValues(const Sweep &sweep, QValueVector<double> &values);
+    // Solves for the frequencies in columns[1] and fills in the other
+    // columns in the layout of the SPICE print output: index, frequency
+    // (real and imaginary), for each probe its value (real and imaginary).
+    // Only the regular sweep of acSweep() keeps its factors.
+    bool solveAC(const ProbeList &probes, bool isKept, QValueVector<QMemArray<double> > &columns);
+    // hands the frequency and probe columns to the table as they are
+    static void setACResult(const QValueVector<QMemArray<double> > &columns, const ProbeList &probes, ResultTable &table);
+
+    QMap<QString, int> m_nodes;
+    QValueVector<Element> m_elements;
+    int m_numBranches;
+    QString m_errorString;
+
+    bool m_hasDCFactor;
+    SparseLU<double> m_dcFactor;
+    QMemArray<double> m_dcBaseValues;
+
+    // the recording of the AC elimination and, for each frequency, the
+    // values of its factors
+    SparseLU<std::complex<double> > m_acFactor;
+    QValueVector<QMemArray<std::complex<double> > > m_acFactorValues;
+    QMemArray<double> m_acBaseValues;
+    double m_acStartFrequency;
+    double m_acStopFrequency;
+    int m_acNumPointsPerDecade;
+};
+
+} // namespace Spiceplus
+
+#endif // LINEARCIRCUIT_H
+
+// vim: ts=4 sw=4 et
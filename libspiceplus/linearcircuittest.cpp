@@ -0,0 +1,319 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+#include <complex>
+
+#include <qglobal.h>
+#include <qstringlist.h>
+
+#include "linearcircuit.h"
+#include "resulttable.h"
+#include "sparselu.h"
+
+using namespace Spiceplus;
+
+typedef std::complex<double> Complex;
+
+static int s_numFailures = 0;
+
+static void check(bool condition, const char *description)
+{
+    if (!condition)
+    {
+        qWarning("FAIL: %s", description);
+        ++s_numFailures;
+    }
+}
+
+static bool isClose(double value, double expected, double tolerance = 1e-9)
+{
+    return fabs(value - expected) <= tolerance * QMAX(fabs(expected), 1e-300);
+}
+
+static bool isClose(const Complex &value, const Complex &expected, double tolerance = 1e-9)
+{
+    return std::abs(value - expected) <= tolerance * std::abs(expected);
+}
+
+//
+// SparseLU
+//
+
+static void stamp(SparseLU<double> &lu, int row, int col, double value)
+{
+    int s = lu.slot(row, col);
+    lu.values()[s] += value;
+}
+
+static bool solveMatrix(SparseLU<double> &lu, const double *b, int size, QMemArray<double> &x)
+{
+    if (!lu.factor())
+        return false;
+
+    QMemArray<double> rhs(size);
+    for (int i = 0; i < size; ++i)
+        rhs[i] = b[i];
+    lu.solve(rhs, x);
+    return true;
+}
+
+static void testSparseSolve()
+{
+    // 4 1 0 / 1 4 1 / 0 1 4 times 1 2 3
+    SparseLU<double> lu(3);
+    stamp(lu, 0, 0, 4); stamp(lu, 0, 1, 1);
+    stamp(lu, 1, 0, 1); stamp(lu, 1, 1, 4); stamp(lu, 1, 2, 1);
+    stamp(lu, 2, 1, 1); stamp(lu, 2, 2, 4);
+
+    double b[] = { 6, 12, 14 };
+    QMemArray<double> x;
+    check(solveMatrix(lu, b, 3, x), "tridiagonal matrix factored");
+    check(isClose(x[0], 1) && isClose(x[1], 2) && isClose(x[2], 3), "tridiagonal solution");
+}
+
+static void testSparseScaling()
+{
+    // a voltage source (entries 1) and a milliohm load next to a node held
+    // by two 10 Tohm resistors: its pivot is far below the largest entry
+    SparseLU<double> lu(3);
+    stamp(lu, 0, 0, 1e3); stamp(lu, 0, 2, 1); stamp(lu, 2, 0, 1);
+    stamp(lu, 0, 0, 1e-13); stamp(lu, 0, 1, -1e-13);
+    stamp(lu, 1, 0, -1e-13); stamp(lu, 1, 1, 2e-13);
+
+    double b[] = { 0, 0, 1 };
+    QMemArray<double> x;
+    check(solveMatrix(lu, b, 3, x), "matrix with high impedance node factored");
+    check(isClose(x[0], 1) && isClose(x[1], 0.5), "high impedance node solution");
+}
+
+static void testSparseSingular()
+{
+    SparseLU<double> lu(2);
+    stamp(lu, 0, 0, 1); stamp(lu, 0, 1, 1);
+    stamp(lu, 1, 0, 1); stamp(lu, 1, 1, 1);
+    check(!lu.factor(), "singular matrix rejected");
+
+    // the second row differs only by rounding
+    SparseLU<double> nearly(2);
+    stamp(nearly, 0, 0, 1); stamp(nearly, 0, 1, 1);
+    stamp(nearly, 1, 0, 1); stamp(nearly, 1, 1, 1 + 1e-15);
+    check(!nearly.factor(), "matrix singular but for rounding rejected");
+}
+
+static void testSparseRefactor()
+{
+    // the diagonal is the only choice of pivots
+    SparseLU<double> lu(2);
+    int s00 = lu.slot(0, 0), s01 = lu.slot(0, 1), s10 = lu.slot(1, 0), s11 = lu.slot(1, 1);
+    lu.values()[s00] = 4; lu.values()[s01] = 0.01; lu.values()[s10] = 0.01; lu.values()[s11] = 4;
+
+    double b1[] = { 4.01, 4.01 };
+    QMemArray<double> x;
+    check(solveMatrix(lu, b1, 2, x) && isClose(x[0], 1) && isClose(x[1], 1), "first factorization");
+    int numAnalyses = lu.numAnalyses();
+
+    lu.clear();
+    lu.values()[s00] = 2; lu.values()[s01] = 0.01; lu.values()[s10] = 0.01; lu.values()[s11] = 2;
+    double b2[] = { 2.01, 2.01 };
+    check(solveMatrix(lu, b2, 2, x) && isClose(x[0], 1) && isClose(x[1], 1), "refactorization");
+    check(lu.numAnalyses() == numAnalyses, "refactorization keeps the pivots");
+
+    // the recorded pivots are zero now, so they are chosen again
+    lu.clear();
+    lu.values()[s01] = 1; lu.values()[s10] = 1;
+    double b3[] = { 2, 5 };
+    check(solveMatrix(lu, b3, 2, x) && isClose(x[0], 5) && isClose(x[1], 2), "factorization with new pivots");
+    check(lu.numAnalyses() > numAnalyses, "new pivots chosen");
+}
+
+//
+// LinearCircuit
+//
+
+static double dcValue(LinearCircuit &circuit, const QString &source, double value, LinearCircuit::Probe probe)
+{
+    LinearCircuit::Sweep sweep;
+    sweep.source = source;
+    sweep.start = sweep.stop = value;
+
+    probe.name = "probe";
+    LinearCircuit::ProbeList probes;
+    probes.push_back(probe);
+
+    ResultTable table;
+    if (!circuit.dcSweep(sweep, LinearCircuit::Sweep(), probes, table) || table.numRows() != 1)
+    {
+        qWarning("%s", circuit.errorString().latin1());
+        return HUGE_VAL;
+    }
+
+    return table.real(0)[0];
+}
+
+static void testDCDivider()
+{
+    QStringList netlist;
+    netlist << "V1 in 0 dc 10" << "R1 in out 1k" << "R2 out 0 3k";
+
+    LinearCircuit circuit;
+    LinearCircuit::Probe out, current;
+    check(circuit.build(netlist), "divider built");
+    check(circuit.voltageProbe("out", "0", out) && circuit.currentProbe("V1", current), "divider probes");
+    check(isClose(dcValue(circuit, "V1", 10, out), 7.5), "divider voltage");
+    // into the positive node of the source, like SPICE
+    check(isClose(dcValue(circuit, "V1", 10, current), -2.5e-3), "divider current");
+    check(isClose(dcValue(circuit, "V1", 4, out), 3), "divider voltage with swept source");
+}
+
+static void testDCInductor()
+{
+    // the inductor is a short, the capacitor open
+    QStringList netlist;
+    netlist << "V1 a 0 dc 1" << "R1 a b 100" << "L1 b 0 1m" << "C1 a b 1u";
+
+    LinearCircuit circuit;
+    LinearCircuit::Probe b, current;
+    check(circuit.build(netlist), "RL circuit built");
+    check(circuit.voltageProbe("b", "0", b) && circuit.currentProbe("V1", current), "RL probes");
+    check(fabs(dcValue(circuit, "V1", 1, b)) < 1e-12, "voltage across DC inductor");
+    check(isClose(dcValue(circuit, "V1", 1, current), -1e-2), "current through DC inductor");
+}
+
+static void testDCHighImpedance()
+{
+    // the milliohm load sets the scale of the matrix far above the node
+    // between the 10 Tohm resistors
+    QStringList netlist;
+    netlist << "V1 a 0 dc 1" << "R0 a 0 1m" << "R1 a b 10t" << "R2 b 0 10t";
+
+    LinearCircuit circuit;
+    LinearCircuit::Probe b;
+    check(circuit.build(netlist), "high impedance divider built");
+    check(circuit.voltageProbe("b", "0", b), "high impedance probe");
+    check(isClose(dcValue(circuit, "V1", 1, b), 0.5), "high impedance divider voltage");
+}
+
+// runs an AC sweep and compares the probe with response(f) at each frequency
+static void checkACSweep(LinearCircuit &circuit, const QString &node, double start, double stop,
+                         Complex (*response)(double, double), double parameter, const char *description)
+{
+    LinearCircuit::Probe probe;
+    if (!circuit.voltageProbe(node, "0", probe))
+    {
+        check(false, description);
+        return;
+    }
+
+    probe.name = "v(" + node + ")";
+    LinearCircuit::ProbeList probes;
+    probes.push_back(probe);
+
+    ResultTable table;
+    if (!circuit.acSweep(start, stop, 10, probes, table))
+    {
+        qWarning("%s", circuit.errorString().latin1());
+        check(false, description);
+        return;
+    }
+
+    bool ok = table.numRows() == uint(10 * log10(stop / start) + 1.5);
+    for (uint row = 0; row < table.numRows() && ok; ++row)
+    {
+        double f = table.axis()[row];
+        ok = isClose(Complex(table.real(0)[row], table.imag(0)[row]), response(f, parameter), 1e-8);
+    }
+
+    check(ok, description);
+}
+
+// first order low pass, parameter is RC
+static Complex lowPass(double f, double rc)
+{
+    return 1.0 / Complex(1, 2 * M_PI * f * rc);
+}
+
+// first order high pass, parameter is RC or L/R
+static Complex highPass(double f, double tau)
+{
+    Complex s(0, 2 * M_PI * f * tau);
+    return s / (1.0 + s);
+}
+
+static void testACLowPass()
+{
+    QStringList netlist;
+    netlist << "V1 in 0 ac 1" << "R1 in out 1k" << "C1 out 0 1u";
+
+    LinearCircuit circuit;
+    check(circuit.build(netlist), "RC low pass built");
+    checkACSweep(circuit, "out", 1, 1e6, lowPass, 1e-3, "RC low pass response");
+
+    // only a value changed, so the kept factors are updated
+    netlist[1] = "R1 in out 2k";
+    check(circuit.build(netlist), "RC low pass rebuilt");
+    checkACSweep(circuit, "out", 1, 1e6, lowPass, 2e-3, "RC low pass response after update");
+}
+
+static void testACHighImpedance()
+{
+    // 100 fF into 1 Tohm at a few hertz: the admittances of the output
+    // node are some 1e-12, next to the 1e3 of the milliohm load
+    QStringList netlist;
+    netlist << "V1 in 0 ac 1" << "R0 in 0 1m" << "C1 in out 100f" << "R1 out 0 1t";
+
+    LinearCircuit circuit;
+    check(circuit.build(netlist), "low frequency high pass built");
+    checkACSweep(circuit, "out", 1e-2, 1e2, highPass, 0.1, "low frequency high pass response");
+}
+
+static void testACInductor()
+{
+    QStringList netlist;
+    netlist << "V1 in 0 ac 1" << "R1 in out 1k" << "L1 out 0 1";
+
+    LinearCircuit circuit;
+    check(circuit.build(netlist), "RL high pass built");
+    checkACSweep(circuit, "out", 1, 1e6, highPass, 1e-3, "RL high pass response");
+}
+
+int main()
+{
+    testSparseSolve();
+    testSparseScaling();
+    testSparseSingular();
+    testSparseRefactor();
+
+    testDCDivider();
+    testDCInductor();
+    testDCHighImpedance();
+    testACLowPass();
+    testACHighImpedance();
+    testACInductor();
+
+    if (s_numFailures > 0)
+    {
+        qWarning("%d checks failed", s_numFailures);
+        return 1;
+    }
+
+    return 0;
+}
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,343 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <qthread.h>
+#include <qdeepcopy.h>
+#include <qdir.h>
+#include <qfile.h>
+#include <qfileinfo.h>
+#include <qdatetime.h>
+#include <qdatastream.h>
+#include <qdom.h>
+#include <qregexp.h>
+
+#include <kapplication.h>
+#include <kstandarddirs.h>
+#include <kurl.h>
+#include <kdebug.h>
+
+#include "modelindex.h"
+#include "settings.h"
+#include "project.h"
+
+using namespace Spiceplus;
+
+static const Q_UINT32 IndexMagic = 0x53504d49; // "SPMI"
+static const Q_UINT32 IndexVersion = 2;
+
+static ModelIndex::EntryMap deepCopy(const ModelIndex::EntryMap &entries)
+{
+    ModelIndex::EntryMap copy;
+
+    for (ModelIndex::EntryMap::ConstIterator it = entries.begin(); it != entries.end(); ++it)
+    {
+        ModelIndex::Entry entry;
+        entry.mtime = it.data().mtime;
+        entry.isModel = it.data().isModel;
+        entry.deviceType = QDeepCopy<QString>(it.data().deviceType);
+        entry.fileName = QDeepCopy<QString>(it.data().fileName);
+        entry.alias = QDeepCopy<QString>(it.data().alias);
+        copy[QDeepCopy<QString>(it.key())] = entry;
+    }
+
+    return copy;
+}
+
+//
+// ModelIndexThread
+//
+
+namespace Spiceplus {
+
+class ModelIndexThread : public QThread
+{
+public:
+    ModelIndexThread(ModelIndex *index, const QStringList &dirs, const ModelIndex::EntryMap &entries);
+
+    ModelIndex::EntryMap entries() const { return m_entries; }
+    bool changed() const { return m_changed; }
+
+protected:
+    void run();
+
+private:
+    void scanDir(const QString &path, int depth);
+    bool parse(const QString &path, ModelIndex::Entry &entry) const;
+
+    ModelIndex *m_index;
+    QStringList m_dirs;
+    ModelIndex::EntryMap m_oldEntries;
+    ModelIndex::EntryMap m_entries;
+    bool m_changed;
+};
+
+} // namespace Spiceplus
+
+ModelIndexThread::ModelIndexThread(ModelIndex *index, const QStringList &dirs, const ModelIndex::EntryMap &entries)
+    : m_index(index), m_oldEntries(deepCopy(entries)), m_changed(false)
+{
+    for (QStringList::ConstIterator it = dirs.begin(); it != dirs.end(); ++it)
+        m_dirs << QDeepCopy<QString>(*it);
+}
+
+void ModelIndexThread::run()
+{
+    for (QStringList::Iterator it = m_dirs.begin(); it != m_dirs.end(); ++it)
+        scanDir(*it, 0);
+
+    // entries of removed files
+    for (ModelIndex::EntryMap::ConstIterator it = m_oldEntries.begin(); it != m_oldEntries.end() && !m_changed; ++it)
+        if (!m_entries.contains(it.key()))
+            m_changed = true;
+
+    QApplication::postEvent(m_index, new QCustomEvent(ModelIndex::UpdateEvent));
+}
+
+void ModelIndexThread::scanDir(const QString &path, int depth)
+{
+    // guard against symlink loops
+    if (depth > 32)
+        return;
+
+    QDir dir(path);
+    const QFileInfoList *list = dir.entryInfoList(QDir::Dirs | QDir::Files | QDir::Readable);
+    if (!list)
+        return;
+
+    for (QFileInfoListIterator it(*list); it.current(); ++it)
+    {
+        QFileInfo *fi = it.current();
+
+        if (fi->isDir())
+        {
+            if (fi->fileName() != "." && fi->fileName() != "..")
+                scanDir(fi->filePath(), depth + 1);
+            continue;
+        }
+
+        if (!fi->fileName().endsWith(".model") || m_entries.contains(fi->filePath()))
+            continue;
+
+        uint mtime = fi->lastModified().toTime_t();
+
+        ModelIndex::EntryMap::ConstIterator old = m_oldEntries.find(fi->filePath());
+        if (old != m_oldEntries.end() && old.data().mtime == mtime)
+        {
+            m_entries[fi->filePath()] = old.data();
+            continue;
+        }
+
+        // a file that is no model is kept as such
+        ModelIndex::Entry entry;
+        entry.mtime = mtime;
+        entry.isModel = parse(fi->filePath(), entry);
+        m_entries[fi->filePath()] = entry;
+        m_changed = true;
+    }
+}
+
+bool ModelIndexThread::parse(const QString &path, ModelIndex::Entry &entry) const
+{
+    QFile file(path);
+    if (!file.open(IO_ReadOnly))
+        return false;
+
+    QDomDocument doc;
+    if (!doc.setContent(&file))
+        return false;
+
+    QDomElement root = doc.documentElement();
+    if (root.tagName() != "model")
+        return false;
+
+    entry.fileName = QFileInfo(path).fileName().remove(QRegExp("\\.model$"));
+    entry.alias = root.attribute("alias");
+    entry.deviceType = root.attribute("device-type").lower();
+
+    return true;
+}
+
+//
+// ModelIndex
+//
+
+ModelIndex *ModelIndex::s_self = 0;
+
+ModelIndex::ModelIndex()
+    : QObject(kapp), m_thread(0), m_updatePending(false)
+{
+    load();
+
+    connect(Settings::self(), SIGNAL(settingsChanged()), SLOT(update()));
+    connect(Project::self(), SIGNAL(opened()), SLOT(update()));
+
+    update();
+}
+
+ModelIndex::~ModelIndex()
+{
+    if (m_thread)
+    {
+        m_thread->wait();
+        delete m_thread;
+    }
+
+    s_self = 0;
+}
+
+ModelIndex *ModelIndex::self()
+{
+    if (!s_self)
+        s_self = new ModelIndex;
+    return s_self;
+}
+
+bool ModelIndex::find(const QString &path, Entry &entry) const
+{
+    EntryMap::ConstIterator it = m_entries.find(QDir::cleanDirPath(path));
+    if (it == m_entries.end() || !it.data().isModel)
+        return false;
+
+    entry = it.data();
+    return true;
+}
+
+void ModelIndex::update()
+{
+    if (m_thread)
+    {
+        m_updatePending = true;
+        return;
+    }
+
+    m_thread = new ModelIndexThread(this, modelDirs(), m_entries);
+    m_thread->start(QThread::LowPriority);
+}
+
+void ModelIndex::customEvent(QCustomEvent *event)
+{
+    if (event->type() != UpdateEvent || !m_thread)
+        return;
+
+    m_thread->wait();
+
+    bool changed = m_thread->changed();
+    if (changed)
+        m_entries = m_thread->entries();
+
+    delete m_thread;
+    m_thread = 0;
+
+    if (changed && !save())
+        kdError() << k_funcinfo << "Could not save model index to " << indexFile() << endl;
+
+    // the model dirs may have changed even if the models haven't; only the
+    // last of a row of updates is announced
+    if (m_updatePending)
+    {
+        m_updatePending = false;
+        update();
+    }
+    else
+        emit updated();
+}
+
+QStringList ModelIndex::modelDirs() const
+{
+    QStringList dirs;
+
+    dirs << QDir::cleanDirPath(Settings::self()->standardModelDir());
+
+    if (Project::self()->isOpen() && Project::self()->dir().isLocalFile())
+        dirs << QDir::cleanDirPath(Project::self()->dir().path());
+
+    QMap<QString, ModelDirs::Dir> userDirs = Settings::self()->userModelDirs().dirs();
+    for (QMap<QString, ModelDirs::Dir>::Iterator it = userDirs.begin(); it != userDirs.end(); ++it)
+    {
+        KURL url = it.data().path;
+        if (url.isLocalFile())
+            dirs << QDir::cleanDirPath(url.path());
+    }
+
+    return dirs;
+}
+
+QString ModelIndex::indexFile() const
+{
+    QString path = KGlobal::dirs()->saveLocation("data", "spiceplus/");
+    return !path.isNull() ? path + "model-index" : QString::null;
+}
+
+bool ModelIndex::load()
+{
+    QString path = indexFile();
+    if (path.isNull())
+        return false;
+
+    QFile file(path);
+    if (!file.open(IO_ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    Q_UINT32 magic, version, count;
+
+    stream >> magic >> version;
+    if (magic != IndexMagic || version != IndexVersion)
+        return false;
+
+    stream >> count;
+    for (Q_UINT32 i = 0; i < count && !stream.atEnd(); ++i)
+    {
+        QString key;
+        Entry entry;
+        Q_UINT32 mtime;
+        Q_UINT8 isModel;
+
+        stream >> key >> mtime >> isModel >> entry.deviceType >> entry.fileName >> entry.alias;
+        entry.mtime = mtime;
+        entry.isModel = isModel != 0;
+        m_entries[key] = entry;
+    }
+
+    return true;
+}
+
+bool ModelIndex::save() const
+{
+    QString path = indexFile();
+    if (path.isNull())
+        return false;
+
+    QFile file(path);
+    if (!file.open(IO_WriteOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream << IndexMagic << IndexVersion << Q_UINT32(m_entries.count());
+
+    for (EntryMap::ConstIterator it = m_entries.begin(); it != m_entries.end(); ++it)
+        stream << it.key() << Q_UINT32(it.data().mtime) << Q_UINT8(it.data().isModel)
+               << it.data().deviceType << it.data().fileName << it.data().alias;
+
+    return file.status() == IO_Ok;
+}
+
+#include "modelindex.moc"
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,96 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MODELINDEX_H
+#define MODELINDEX_H
+
+#include <qobject.h>
+#include <qevent.h>
+#include <qmap.h>
+#include <qstringlist.h>
+
+namespace Spiceplus {
+
+class ModelIndexThread;
+
+// Caches device type, name and alias of all model files in the model
+// directories, so that model trees can be filled without parsing files.
+class ModelIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    ModelIndex();
+
+public:
+    ~ModelIndex();
+
+    static ModelIndex *self();
+
+    struct Entry
+    {
+        Entry() : mtime(0), isModel(true) {}
+
+        QString name() const { return !alias.isEmpty() ? alias : fileName; }
+
+        uint mtime;
+        // false for a file that could not be parsed as a model, so that it
+        // is parsed again only once it changes
+        bool isModel;
+        QString deviceType;
+        QString fileName;
+        QString alias;
+    };
+
+    typedef QMap<QString, Entry> EntryMap;
+
+    // false for files that are not models
+    bool find(const QString &path, Entry &entry) const;
+    bool isUpdating() const { return m_thread != 0; }
+
+    static const int UpdateEvent = QEvent::User + 1;
+
+public slots:
+    void update();
+
+signals:
+    // after each update, which follows changes of the settings and the
+    // opening of a project
+    void updated();
+
+protected:
+    void customEvent(QCustomEvent *event);
+
+private:
+    QStringList modelDirs() const;
+    QString indexFile() const;
+    bool load();
+    bool save() const;
+
+    static ModelIndex *s_self;
+    EntryMap m_entries;
+    ModelIndexThread *m_thread;
+    bool m_updatePending;
+};
+
+} // namespace Spiceplus
+
+#endif // MODELINDEX_H
+
+// vim: ts=4 sw=4 et
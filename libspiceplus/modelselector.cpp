@@ -31,6 +31,7 @@
 
 #include "modelselector.h"
 #include "modelfile.h"
+#include "modelindex.h"
 #include "settings.h"
 #include "file.h"
 #include "project.h"
@@ -55,12 +56,18 @@ ModelSelectorTreeBranch::ModelSelectorTreeBranch(const KURL &modelDir,
 
 bool ModelSelectorTreeBranch::matchesFilter(const KFileItem *item) const
 {
-    ModelFile model;
-
-    if (item->isDir() || model.load(item->url()) && model.deviceType() == m_deviceType)
+    if (item->isDir())
         return true;
 
-    return false;
+    // files not indexed yet show up once the index has been updated
+    if (item->isLocalFile())
+    {
+        ModelIndex::Entry entry;
+        return ModelIndex::self()->find(item->url().path(), entry) && entry.deviceType == m_deviceType;
+    }
+
+    ModelFile model;
+    return model.load(item->url()) && model.deviceType() == m_deviceType;
 }
 
 KFileTreeViewItem *ModelSelectorTreeBranch::createTreeViewItem(KFileTreeViewItem *parent, KFileItem *fileItem)
@@ -76,9 +83,15 @@ KFileTreeViewItem *ModelSelectorTreeBranch::createTreeViewItem(KFileTreeViewItem
     }
     else
     {
-        ModelFile model;
-        model.load(fileItem->url());
-        name = model.name();
+        ModelIndex::Entry entry;
+        if (fileItem->isLocalFile() && ModelIndex::self()->find(fileItem->url().path(), entry))
+            name = entry.name();
+        else
+        {
+            ModelFile model;
+            model.load(fileItem->url());
+            name = model.name();
+        }
     }
 
     item->setText(0, name);
@@ -107,8 +120,9 @@ ModelSelector::ModelSelector(const QString &deviceType, QWidget *parent)
 
     topLayout->addWidget(m_tree);
 
-    connect(Settings::self(), SIGNAL(settingsChanged()), SLOT(setupTree()));
-    connect(Project::self(), SIGNAL(opened()), SLOT(setupTree()));
+    // the index is updated for new settings and an opened project, so that
+    // the tree is built once the models are known
+    connect(ModelIndex::self(), SIGNAL(updated()), SLOT(setupTree()));
     connect(Project::self(), SIGNAL(closed()), SLOT(setupTree()));
 }
 
@@ -0,0 +1,175 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+
+#include <qmap.h>
+
+#include <klocale.h>
+
+#include "montecarlo.h"
+#include "schematic.h"
+#include "schematicstandarddevice.h"
+#include "trace.h"
+
+namespace Spiceplus {
+
+// SplitMix64: tiny, fast and with the same sequence on every platform,
+// unlike rand(). Consecutive seeds give unrelated sequences.
+class RandomGenerator
+{
+public:
+    RandomGenerator(Q_ULLONG seed) : m_state(seed) {}
+
+    Q_ULLONG next()
+    {
+        Q_ULLONG z = (m_state += Q_ULLONG(0x9e3779b97f4a7c15ULL));
+        z = (z ^ (z >> 30)) * Q_ULLONG(0xbf58476d1ce4e5b9ULL);
+        z = (z ^ (z >> 27)) * Q_ULLONG(0x94d049bb133111ebULL);
+        return z ^ (z >> 31);
+    }
+
+    // uniform in [0, 1)
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // standard normal, by Box-Muller
+    double gaussian()
+    {
+        double u1 = 1.0 - uniform();
+        double u2 = uniform();
+        return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+    }
+
+private:
+    Q_ULLONG m_state;
+};
+
+} // namespace Spiceplus
+
+using namespace Spiceplus;
+
+MonteCarlo::MonteCarlo(Schematic *schematic)
+    : m_schematic(schematic)
+{
+}
+
+bool MonteCarlo::prepare()
+{
+    m_variations.clear();
+
+    // sorted by name, so that the values drawn don't depend on the order
+    // of the devices in the schematic
+    QMap<QString, SchematicStandardDevice *> devices;
+
+    QCanvasItemList l = m_schematic->allItems();
+    for (QCanvasItemList::Iterator it = l.begin(); it != l.end(); ++it)
+    {
+        if (!(*it)->isVisible() || (*it)->rtti() != SchematicDevice::RTTI)
+            continue;
+
+        SchematicStandardDevice *dev = dynamic_cast<SchematicStandardDevice *>(*it);
+        if (dev && !dev->parameter("tolerance").isEmpty())
+            devices[dev->name()] = dev;
+    }
+
+    for (QMap<QString, SchematicStandardDevice *>::Iterator it = devices.begin(); it != devices.end(); ++it)
+    {
+        Variation variation;
+        variation.device = it.data();
+        variation.nominalText = it.data()->parameter("value");
+        variation.distribution = parseDistribution(it.data()->parameter("distribution"));
+
+        if (!it.data()->parameterValue("value", variation.nominal))
+        {
+            m_errorString = i18n("Device %1 has a tolerance but no value").arg(it.key());
+            return false;
+        }
+
+        if (!parseTolerance(it.data()->parameter("tolerance"), variation.tolerance))
+        {
+            m_errorString = i18n("Device %1: Invalid tolerance %2").arg(it.key()).arg(it.data()->parameter("tolerance"));
+            return false;
+        }
+
+        m_variations.append(variation);
+    }
+
+    return true;
+}
+
+QString MonteCarlo::createCommandList(Q_UINT32 seed, int run)
+{
+    TraceSpan span("MonteCarlo::createCommandList");
+
+    RandomGenerator random((Q_ULLONG(seed) << 32) | Q_UINT32(run));
+
+    for (uint i = 0; i < m_variations.count(); ++i)
+    {
+        const Variation &variation = m_variations[i];
+
+        double deviation;
+        if (variation.distribution == Gaussian)
+            deviation = QMIN(QMAX(random.gaussian() / 3, -1.0), 1.0);
+        else
+            deviation = 2 * random.uniform() - 1;
+
+        variation.device->setParameter("value", SchematicParameter(variation.nominal * (1 + variation.tolerance * deviation)));
+    }
+
+    QString cmdList = m_schematic->createCommandList();
+    if (cmdList.isNull())
+        m_errorString = m_schematic->errorString();
+
+    for (uint i = 0; i < m_variations.count(); ++i)
+        m_variations[i].device->setParameter("value", m_variations[i].nominalText);
+
+    return cmdList;
+}
+
+bool MonteCarlo::parseTolerance(const QString &text, double &tolerance)
+{
+    QString number = text.stripWhiteSpace();
+    if (number.endsWith("%"))
+        number.truncate(number.length() - 1);
+
+    bool ok;
+    double percent = number.toDouble(&ok);
+    if (!ok || percent < 0 || percent >= 100)
+        return false;
+
+    tolerance = percent / 100;
+    return true;
+}
+
+QString MonteCarlo::formatTolerance(double tolerance)
+{
+    return QString::number(tolerance * 100) + "%";
+}
+
+MonteCarlo::Distribution MonteCarlo::parseDistribution(const QString &text)
+{
+    return text.lower() == "gaussian" ? Gaussian : Uniform;
+}
+
+QString MonteCarlo::distributionName(Distribution distribution)
+{
+    return distribution == Gaussian ? "gaussian" : "uniform";
+}
+
+// vim: ts=4 sw=4 et
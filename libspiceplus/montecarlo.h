@@ -0,0 +1,77 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <qstring.h>
+#include <qvaluevector.h>
+
+namespace Spiceplus {
+
+class Schematic;
+class SchematicStandardDevice;
+
+// Random variation of device values within their tolerances. A device
+// takes part if it has a "tolerance" parameter such as "5%". Its
+// "distribution" parameter is "uniform" (the default) or "gaussian"; a
+// gaussian tolerance is three standard deviations, and values beyond it
+// are clipped to the tolerance.
+class MonteCarlo
+{
+public:
+    enum Distribution { Uniform, Gaussian };
+
+    MonteCarlo(Schematic *schematic);
+
+    // collects the toleranced devices and their nominal values
+    bool prepare();
+    int numVariedDevices() const { return m_variations.count(); }
+
+    // the netlist of one run; the same seed and run give the same values
+    // on every machine and in any order of runs
+    QString createCommandList(Q_UINT32 seed, int run);
+    QString errorString() const { return m_errorString; }
+
+    // tolerances are given in percent, the "%" is optional
+    static bool parseTolerance(const QString &text, double &tolerance);
+    static QString formatTolerance(double tolerance);
+    static Distribution parseDistribution(const QString &text);
+    static QString distributionName(Distribution distribution);
+
+private:
+    struct Variation
+    {
+        SchematicStandardDevice *device;
+        QString nominalText;
+        double nominal;
+        double tolerance;
+        Distribution distribution;
+    };
+
+    Schematic *m_schematic;
+    QValueVector<Variation> m_variations;
+    QString m_errorString;
+};
+
+} // namespace Spiceplus
+
+#endif // MONTECARLO_H
+
+// vim: ts=4 sw=4 et
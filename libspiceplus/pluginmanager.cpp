@@ -18,26 +18,78 @@
  */
 
 #include <qfile.h>
+#include <qthread.h>
+#include <qtimer.h>
+#include <qdeepcopy.h>
 
 #include <kapplication.h>
 #include <klocale.h>
+#include <kdebug.h>
 
 #include "pluginmanager.h"
 #include "schematicdevice.h"
 #include "model.h"
 #include "settings.h"
+#include "devicecatalog.h"
+#include "trace.h"
 
 using namespace Spiceplus;
 
+namespace Spiceplus {
+
+// Reads the plugin libraries once, so that loading them afterwards finds
+// them in the page cache. The libraries are not opened here: their static
+// constructors have to run on the GUI thread.
+class PluginPreloadThread : public QThread
+{
+public:
+    PluginPreloadThread(PluginManager *manager, const QStringList &paths)
+        : m_manager(manager)
+    {
+        for (QStringList::ConstIterator it = paths.begin(); it != paths.end(); ++it)
+            m_paths << QDeepCopy<QString>(*it);
+    }
+
+protected:
+    void run()
+    {
+        TraceSpan span("PluginManager::preload");
+
+        char buffer[65536];
+        for (QStringList::Iterator it = m_paths.begin(); it != m_paths.end(); ++it)
+        {
+            QFile file(*it);
+            if (!file.open(IO_ReadOnly | IO_Raw))
+                continue;
+            while (file.readBlock(buffer, sizeof(buffer)) > 0)
+                ;
+        }
+
+        QApplication::postEvent(m_manager, new QCustomEvent(PluginManager::PreloadEvent));
+    }
+
+private:
+    PluginManager *m_manager;
+    QStringList m_paths;
+};
+
+} // namespace Spiceplus
+
 PluginManager *PluginManager::s_self = 0;
 
 PluginManager::PluginManager()
-    : QObject(kapp)
+    : QObject(kapp), m_preloadThread(0)
 {
 }
 
 PluginManager::~PluginManager()
 {
+    if (m_preloadThread)
+    {
+        m_preloadThread->wait();
+        delete m_preloadThread;
+    }
+
     s_self = 0;
 }
 
@@ -53,10 +105,16 @@ SchematicDeviceFactory *PluginManager::deviceFactory(const QString &deviceID)
     if (m_deviceFactories.contains(deviceID))
         return m_deviceFactories[deviceID];
 
+    TraceSpan span("PluginManager::deviceFactory");
+
     QString path = Settings::self()->deviceDir() + "/" + deviceID + ".device";
-    KConfig *config = new KConfig(path, true);
-    QString libname = config->readEntry("Library");
-    delete config;
+    QString libname = DeviceCatalog::self()->library(deviceID);
+    if (libname.isEmpty())
+    {
+        KConfig *config = new KConfig(path, true);
+        libname = config->readEntry("Library");
+        delete config;
+    }
 
     if (libname.isEmpty())
     {
@@ -114,6 +172,62 @@ ModelViewFactory *PluginManager::modelViewFactory(const QString &deviceType)
     return m_modelViewFactories[deviceType] = static_cast<ModelViewFactory *>(lib->factory());
 }
 
+void PluginManager::preloadPlugins()
+{
+    if (m_preloadThread)
+        return;
+
+    QStringList paths;
+    QStringList ids = DeviceCatalog::self()->deviceIDs();
+    for (QStringList::Iterator it = ids.begin(); it != ids.end(); ++it)
+    {
+        if (m_deviceFactories.contains(*it))
+            continue;
+
+        QString path = KLibLoader::findLibrary(QFile::encodeName(DeviceCatalog::self()->library(*it)));
+        if (!path.isEmpty() && !paths.contains(path))
+            paths << path;
+    }
+
+    if (paths.isEmpty())
+        return;
+
+    m_preloadThread = new PluginPreloadThread(this, paths);
+    m_preloadThread->start(QThread::LowPriority);
+}
+
+void PluginManager::customEvent(QCustomEvent *event)
+{
+    if (event->type() != PreloadEvent || !m_preloadThread)
+        return;
+
+    m_preloadThread->wait();
+    delete m_preloadThread;
+    m_preloadThread = 0;
+
+    // the libraries are read now, loading them is cheap
+    m_pendingDeviceIDs = DeviceCatalog::self()->deviceIDs();
+    loadNextPlugin();
+}
+
+void PluginManager::loadNextPlugin()
+{
+    while (!m_pendingDeviceIDs.isEmpty())
+    {
+        QString id = m_pendingDeviceIDs.first();
+        m_pendingDeviceIDs.remove(m_pendingDeviceIDs.begin());
+        if (m_deviceFactories.contains(id))
+            continue;
+
+        if (!deviceFactory(id))
+            kdWarning() << k_funcinfo << m_errorString << endl;
+
+        // the next one once the events so far are handled
+        QTimer::singleShot(0, this, SLOT(loadNextPlugin()));
+        return;
+    }
+}
+
 #include "pluginmanager.moc"
 
 // vim: ts=4 sw=4 et
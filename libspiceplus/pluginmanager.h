@@ -21,12 +21,15 @@
 #define PLUGINMANAGER_H
 
 #include <qobject.h>
+#include <qevent.h>
 #include <qmap.h>
+#include <qstringlist.h>
 
 namespace Spiceplus {
 
 class SchematicDeviceFactory;
 class ModelViewFactory;
+class PluginPreloadThread;
 
 class PluginManager : public QObject
 {
@@ -45,10 +48,24 @@ public:
 
     QString errorString() const { return m_errorString; }
 
+    static const int PreloadEvent = QEvent::User + 2;
+
+public slots:
+    void preloadPlugins();
+
+protected:
+    void customEvent(QCustomEvent *event);
+
+private slots:
+    void loadNextPlugin();
+
 private:
     static PluginManager *s_self;
     QMap<QString, SchematicDeviceFactory *> m_deviceFactories;
     QMap<QString, ModelViewFactory *> m_modelViewFactories;
+    PluginPreloadThread *m_preloadThread;
+    // devices whose plugins are loaded one at a time while the GUI is idle
+    QStringList m_pendingDeviceIDs;
     QString m_errorString;
 };
 
@@ -0,0 +1,403 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <qfile.h>
+#include <qfileinfo.h>
+#include <qtextstream.h>
+
+#include <kapplication.h>
+#include <klocale.h>
+#include <kdebug.h>
+#include <kmdcodec.h>
+
+#include "resultstore.h"
+#include "project.h"
+#include "trace.h"
+
+using namespace Spiceplus;
+
+// The first bytes of the data file, which keeps the columns 8-byte
+// aligned. Written in the byte order of this machine like the columns, so
+// that it only matches where the columns can be read as they are.
+static const Q_ULLONG DataMagic = 0x5350524441544132ULL;
+static const char IndexHeader[] = "SPICE+ results 1";
+
+ResultStore *ResultStore::s_self = 0;
+
+ResultStore::ResultStore()
+    : QObject(kapp),
+      m_data(0),
+      m_dataSize(0)
+{
+    connect(Project::self(), SIGNAL(opened()), SLOT(openProject()));
+    connect(Project::self(), SIGNAL(closed()), SLOT(closeProject()));
+    openProject();
+}
+
+ResultStore::~ResultStore()
+{
+    unmapData();
+    s_self = 0;
+}
+
+ResultStore *ResultStore::self()
+{
+    if (!s_self)
+        s_self = new ResultStore;
+    return s_self;
+}
+
+bool ResultStore::hasVector(uint index, const QString &name) const
+{
+    const QValueVector<Column> &vectors = m_entries[index].vectors;
+    for (uint i = 0; i < vectors.count(); ++i)
+        if (vectors[i].name == name)
+            return true;
+    return false;
+}
+
+bool ResultStore::append(const Run &run, const ResultTable &table)
+{
+    TraceSpan span("ResultStore::append");
+
+    if (!isOpen())
+    {
+        m_errorString = i18n("No project is open");
+        return false;
+    }
+
+    Entry entry;
+    entry.run = run;
+    entry.run.numRows = table.numRows();
+    if (!entry.run.time.isValid())
+        entry.run.time = QDateTime::currentDateTime();
+
+    QFile data(dataPath());
+    if (!data.open(IO_WriteOnly | IO_Append))
+    {
+        m_errorString = i18n("Could not open %1").arg(dataPath());
+        return false;
+    }
+
+    // the file is buffered, so its size only tells where the appending
+    // starts and the offsets are counted from there
+    bool ok = true;
+    Q_ULLONG position = data.size();
+    if (position == 0)
+    {
+        ok = data.writeBlock(reinterpret_cast<const char *>(&DataMagic), sizeof(DataMagic)) == sizeof(DataMagic);
+        position = sizeof(DataMagic);
+    }
+
+    entry.axis.name = table.axisName();
+    ok = ok && writeColumn(data, table.axis(), table.numRows(), position, entry.axis.realOffset);
+
+    for (uint i = 0; i < table.numVectors() && ok; ++i)
+    {
+        Column column;
+        column.name = table.vectorName(i);
+        column.type = table.vectorType(i);
+        ok = writeColumn(data, table.real(i), table.numRows(), position, column.realOffset);
+        if (ok && column.type == ResultTable::Complex)
+            ok = writeColumn(data, table.imag(i), table.numRows(), position, column.imagOffset);
+        entry.vectors.push_back(column);
+    }
+
+    data.close();
+    if (!ok)
+    {
+        m_errorString = i18n("Could not write %1").arg(dataPath());
+        return false;
+    }
+
+    // the data is complete before the index refers to it
+    QFile index(indexPath());
+    if (!index.open(IO_WriteOnly | IO_Append))
+    {
+        m_errorString = i18n("Could not open %1").arg(indexPath());
+        return false;
+    }
+
+    QTextStream stream(&index);
+    stream.setEncoding(QTextStream::UnicodeUTF8);
+    if (index.size() == 0)
+        stream << IndexHeader << "\n";
+    stream << formatEntry(entry) << "\n";
+    index.close();
+
+    m_entries.push_back(entry);
+    Trace::addCounter("stored rows", entry.run.numRows);
+    return true;
+}
+
+bool ResultStore::readTable(uint index, const QStringList &vectorNames, ResultTable &table)
+{
+    TraceSpan span("ResultStore::readTable");
+
+    const Entry &entry = m_entries[index];
+    uint numRows = entry.run.numRows;
+    table = ResultTable();
+
+    QMemArray<double> axis;
+    if (!readColumn(entry.axis.realOffset, numRows, axis))
+        return false;
+    table.setAxis(entry.axis.name, axis);
+
+    for (uint i = 0; i < entry.vectors.count(); ++i)
+    {
+        const Column &column = entry.vectors[i];
+        if (!vectorNames.contains(column.name))
+            continue;
+
+        QMemArray<double> real, imag;
+        if (!readColumn(column.realOffset, numRows, real))
+            return false;
+
+        if (column.type == ResultTable::Complex)
+        {
+            if (!readColumn(column.imagOffset, numRows, imag))
+                return false;
+            table.addVector(column.name, real, imag);
+        }
+        else
+            table.addVector(column.name, real);
+    }
+
+    return true;
+}
+
+QString ResultStore::hash(const QString &text)
+{
+    KMD5 md5(text.utf8());
+    return md5.hexDigest();
+}
+
+void ResultStore::openProject()
+{
+    closeProject();
+
+    Project *project = Project::self();
+    if (!project->isOpen() || !project->dir().isLocalFile())
+        return;
+
+    m_dirPath = project->dir().path();
+    if (!m_dirPath.endsWith("/"))
+        m_dirPath += "/";
+
+    // nothing is added to files that are not ours
+    if (!readIndex())
+    {
+        kdWarning() << k_funcinfo << m_errorString << endl;
+        closeProject();
+    }
+}
+
+void ResultStore::closeProject()
+{
+    unmapData();
+    m_entries.clear();
+    m_dirPath = QString::null;
+}
+
+bool ResultStore::readIndex()
+{
+    TraceSpan span("ResultStore::readIndex");
+
+    QFileInfo dataInfo(dataPath());
+    if (dataInfo.exists() && dataInfo.size() > 0 && !checkDataMagic())
+        return false;
+
+    QFile index(indexPath());
+    if (!index.open(IO_ReadOnly))
+        return true;
+
+    QTextStream stream(&index);
+    stream.setEncoding(QTextStream::UnicodeUTF8);
+    if (stream.readLine() != IndexHeader)
+    {
+        m_errorString = i18n("%1 is not a result index").arg(indexPath());
+        return false;
+    }
+
+    // a run whose data didn't make it to the disk is left out
+    Q_ULLONG dataSize = dataInfo.exists() ? dataInfo.size() : 0;
+    while (!stream.atEnd())
+    {
+        Entry entry;
+        if (!parseEntry(stream.readLine(), entry))
+            continue;
+
+        Q_ULLONG end = entry.axis.realOffset;
+        for (uint i = 0; i < entry.vectors.count(); ++i)
+            end = QMAX(end, QMAX(entry.vectors[i].realOffset, entry.vectors[i].imagOffset));
+        if (end + entry.run.numRows * sizeof(double) <= dataSize)
+            m_entries.push_back(entry);
+    }
+
+    return true;
+}
+
+bool ResultStore::checkDataMagic()
+{
+    QFile data(dataPath());
+    Q_ULLONG magic = 0;
+    if (!data.open(IO_ReadOnly) || data.readBlock(reinterpret_cast<char *>(&magic), sizeof(magic)) != sizeof(magic) || magic != DataMagic)
+    {
+        m_errorString = i18n("%1 is not a result file of this machine").arg(dataPath());
+        return false;
+    }
+
+    return true;
+}
+
+// Fields are separated by tabs: time, analysis, schematic hash, meters
+// separated by ";", number of rows, axis name and offset, then name, type
+// ("r" or "c"), real and imaginary offset of each vector.
+bool ResultStore::parseEntry(const QString &line, Entry &entry)
+{
+    QStringList fields = QStringList::split('\t', line, true);
+    if (fields.count() < 7 || (fields.count() - 7) % 4 != 0)
+        return false;
+
+    bool ok;
+    entry.run.time = QDateTime::fromString(fields[0], Qt::ISODate);
+    entry.run.analysis = fields[1];
+    entry.run.schematicHash = fields[2];
+    entry.run.meters = QStringList::split(';', fields[3]);
+    entry.run.numRows = fields[4].toUInt(&ok);
+    if (!ok)
+        return false;
+
+    entry.axis.name = fields[5];
+    entry.axis.realOffset = fields[6].toULongLong(&ok);
+    if (!ok)
+        return false;
+
+    for (uint i = 7; i < fields.count(); i += 4)
+    {
+        Column column;
+        column.name = fields[i];
+        column.type = fields[i + 1] == "c" ? ResultTable::Complex : ResultTable::Real;
+        column.realOffset = fields[i + 2].toULongLong(&ok);
+        if (!ok)
+            return false;
+        if (column.type == ResultTable::Complex)
+        {
+            column.imagOffset = fields[i + 3].toULongLong(&ok);
+            if (!ok)
+                return false;
+        }
+        entry.vectors.push_back(column);
+    }
+
+    return true;
+}
+
+QString ResultStore::formatEntry(const Entry &entry)
+{
+    QStringList fields;
+    fields << entry.run.time.toString(Qt::ISODate)
+           << entry.run.analysis
+           << entry.run.schematicHash
+           << entry.run.meters.join(";")
+           << QString::number(entry.run.numRows)
+           << entry.axis.name
+           << QString::number(entry.axis.realOffset);
+
+    for (uint i = 0; i < entry.vectors.count(); ++i)
+    {
+        const Column &column = entry.vectors[i];
+        fields << column.name
+               << (column.type == ResultTable::Complex ? "c" : "r")
+               << QString::number(column.realOffset)
+               << (column.type == ResultTable::Complex ? QString::number(column.imagOffset) : QString("-"));
+    }
+
+    return fields.join("\t");
+}
+
+bool ResultStore::writeColumn(QFile &file, const QMemArray<double> &values, uint numRows, Q_ULLONG &position, Q_ULLONG &offset)
+{
+    // in the byte order of this machine, ready to be mapped
+    offset = position;
+    int length = numRows * sizeof(double);
+    position += length;
+    return values.size() >= numRows && file.writeBlock(reinterpret_cast<const char *>(values.data()), length) == length;
+}
+
+bool ResultStore::readColumn(Q_ULLONG offset, uint numRows, QMemArray<double> &values)
+{
+    Q_ULLONG end = offset + numRows * sizeof(double);
+    if (offset < sizeof(DataMagic) || (end > m_dataSize && (!mapData(QFileInfo(dataPath()).size()) || end > m_dataSize)))
+    {
+        m_errorString = i18n("Could not read %1").arg(dataPath());
+        return false;
+    }
+
+    // only the pages of this column are read from the disk
+    values.duplicate(reinterpret_cast<const double *>(m_data + offset), numRows);
+    return true;
+}
+
+bool ResultStore::mapData(Q_ULLONG size)
+{
+    unmapData();
+    if (size == 0)
+        return false;
+
+    int fd = ::open(QFile::encodeName(dataPath()), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    void *data = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    // the file may have been replaced since the index was read
+    if (size < sizeof(DataMagic) || memcmp(data, &DataMagic, sizeof(DataMagic)) != 0)
+    {
+        munmap(data, size);
+        return false;
+    }
+
+    m_data = static_cast<const char *>(data);
+    m_dataSize = size;
+    return true;
+}
+
+void ResultStore::unmapData()
+{
+    if (!m_data)
+        return;
+
+    munmap(const_cast<char *>(m_data), m_dataSize);
+    m_data = 0;
+    m_dataSize = 0;
+}
+
+#include "resultstore.moc"
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,137 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RESULTSTORE_H
+#define RESULTSTORE_H
+
+#include <qobject.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qdatetime.h>
+#include <qvaluevector.h>
+#include <qmemarray.h>
+
+#include "resulttable.h"
+
+class QFile;
+
+namespace Spiceplus {
+
+// The results of past analyses of the open project, kept in its directory
+// so that later runs can be compared with them.
+//
+// The store only ever grows. "results.dat" holds the columns of all runs
+// one after another as raw doubles, "results.idx" a line per run with
+// its metadata and where its columns are. Only the index is read when
+// the project opens; the data file is mapped into memory, and a column
+// is read when it is asked for. Files another machine wrote, or that are
+// not a store at all, leave the store closed.
+class ResultStore : public QObject
+{
+    Q_OBJECT
+
+private:
+    ResultStore();
+
+public:
+    ~ResultStore();
+
+    static ResultStore *self();
+
+    struct Run
+    {
+        Run() : numRows(0) {}
+
+        // like "DC", "AC" or "Transient"
+        QString analysis;
+        // tells whether the schematic has changed since
+        QString schematicHash;
+        QStringList meters;
+        QDateTime time;
+        uint numRows;
+    };
+
+    bool isOpen() const { return !m_dirPath.isNull(); }
+    uint numRuns() const { return m_entries.count(); }
+    const Run &run(uint index) const { return m_entries[index].run; }
+    bool hasVector(uint index, const QString &name) const;
+
+    // The run gives the metadata, the table the rest.
+    bool append(const Run &run, const ResultTable &table);
+    // the axis and those of the named vectors the run has
+    bool readTable(uint index, const QStringList &vectorNames, ResultTable &table);
+
+    // for Run::schematicHash, of the command list of a schematic
+    static QString hash(const QString &text);
+
+    QString errorString() const { return m_errorString; }
+
+private slots:
+    void openProject();
+    void closeProject();
+
+private:
+    struct Column
+    {
+        Column() : type(ResultTable::Real), realOffset(0), imagOffset(0) {}
+
+        QString name;
+        ResultTable::Type type;
+        // in bytes from the start of the data file
+        Q_ULLONG realOffset;
+        Q_ULLONG imagOffset;
+    };
+
+    struct Entry
+    {
+        Run run;
+        Column axis;
+        QValueVector<Column> vectors;
+    };
+
+    QString dataPath() const { return m_dirPath + "results.dat"; }
+    QString indexPath() const { return m_dirPath + "results.idx"; }
+    // false if the files are not a store this machine can read
+    bool readIndex();
+    bool checkDataMagic();
+    static bool parseEntry(const QString &line, Entry &entry);
+    static QString formatEntry(const Entry &entry);
+    // at position, which is moved past the column
+    static bool writeColumn(QFile &file, const QMemArray<double> &values, uint numRows, Q_ULLONG &position, Q_ULLONG &offset);
+    bool readColumn(Q_ULLONG offset, uint numRows, QMemArray<double> &values);
+    bool mapData(Q_ULLONG size);
+    void unmapData();
+
+    static ResultStore *s_self;
+
+    // ends with a slash; null while no project is open
+    QString m_dirPath;
+    QValueVector<Entry> m_entries;
+    QString m_errorString;
+
+    // the data file as far as it is mapped; mapped again once it has grown
+    const char *m_data;
+    Q_ULLONG m_dataSize;
+};
+
+} // namespace Spiceplus
+
+#endif // RESULTSTORE_H
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,202 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+
+#include <qglobal.h>
+#include <qdir.h>
+#include <qfile.h>
+#include <qstringlist.h>
+
+#include <kurl.h>
+
+#include "project.h"
+#include "resultstore.h"
+#include "resulttable.h"
+
+using namespace Spiceplus;
+
+static int s_numFailures = 0;
+
+static void check(bool condition, const char *description)
+{
+    if (!condition)
+    {
+        qWarning("FAIL: %s", description);
+        ++s_numFailures;
+    }
+}
+
+static QMemArray<double> column(uint numRows, double first, double step)
+{
+    QMemArray<double> values(numRows);
+    for (uint row = 0; row < numRows; ++row)
+        values[row] = first + row * step;
+
+    return values;
+}
+
+static bool isSameColumn(const QMemArray<double> &values, const QMemArray<double> &expected)
+{
+    if (values.size() != expected.size())
+        return false;
+
+    for (uint row = 0; row < values.size(); ++row)
+        if (values[row] != expected[row])
+            return false;
+
+    return true;
+}
+
+// the runs of the test: a real, a complex and another real one
+static ResultTable table(uint run)
+{
+    ResultTable table;
+    switch (run)
+    {
+    case 0:
+        table.setAxis("time", column(5, 0, 1e-3));
+        table.addVector("v(out)", column(5, 1, 0.5));
+        break;
+    case 1:
+        table.setAxis("frequency", column(3, 1, 10));
+        table.addVector("v(out)", column(3, 0.25, -0.125), column(3, -1, 0.75));
+        table.addVector("i(v1)", column(3, 1e-3, 1e-3));
+        break;
+    default:
+        table.setAxis("v1", column(7 + run, -1, 1.0 / 3));
+        table.addVector("v(out)", column(7 + run, 2, -0.1));
+        break;
+    }
+
+    return table;
+}
+
+static void checkRun(ResultStore *store, uint run, const char *description)
+{
+    ResultTable expected = table(run);
+    QStringList names;
+    for (uint i = 0; i < expected.numVectors(); ++i)
+        names.append(expected.vectorName(i));
+
+    ResultTable read;
+    bool ok = run < store->numRuns() && store->readTable(run, names, read);
+    ok = ok && read.numRows() == expected.numRows() && read.axisName() == expected.axisName();
+    ok = ok && isSameColumn(read.axis(), expected.axis()) && read.numVectors() == expected.numVectors();
+    for (uint i = 0; i < expected.numVectors() && ok; ++i)
+    {
+        QString name = expected.vectorName(i);
+        ok = read.contains(name) && read.vectorType(read.findVector(name)) == expected.vectorType(i) &&
+             isSameColumn(read.real(name), expected.real(i)) && isSameColumn(read.imag(name), expected.imag(i));
+    }
+
+    check(ok, description);
+}
+
+static bool appendRun(ResultStore *store, uint run)
+{
+    ResultStore::Run info;
+    info.analysis = run == 1 ? "AC" : "DC";
+    info.schematicHash = ResultStore::hash(QString("schematic %1").arg(run));
+    info.meters.append("out");
+
+    return store->append(info, table(run));
+}
+
+static void testRoundTrip(const QString &dirPath)
+{
+    Project *project = Project::self();
+    project->open("test", KURL(dirPath), KURL());
+    ResultStore *store = ResultStore::self();
+    check(store->isOpen(), "store open with the project");
+
+    for (uint run = 0; run < 3; ++run)
+        check(appendRun(store, run), "run appended");
+    check(store->numRuns() == 3, "runs counted");
+    checkRun(store, 0, "first real run read back");
+    checkRun(store, 1, "complex run read back");
+    checkRun(store, 2, "second real run read back");
+
+    // only the index is read again, the columns come from the data file
+    project->close();
+    check(!store->isOpen(), "store closed with the project");
+    project->open("test", KURL(dirPath), KURL());
+    check(store->isOpen() && store->numRuns() == 3, "runs found after reopening");
+    check(store->numRuns() == 3 && store->run(1).analysis == "AC" &&
+          store->run(1).schematicHash == ResultStore::hash("schematic 1") &&
+          store->run(1).meters == QStringList("out") && store->run(1).numRows == 3, "run metadata after reopening");
+    checkRun(store, 0, "first real run after reopening");
+    checkRun(store, 1, "complex run after reopening");
+    checkRun(store, 2, "second real run after reopening");
+
+    check(appendRun(store, 3), "run appended after reopening");
+    checkRun(store, 3, "run appended after reopening read back");
+    checkRun(store, 1, "earlier run still read back");
+    project->close();
+}
+
+static void testForeignData(const QString &dirPath)
+{
+    QFile data(dirPath + "/results.dat");
+    if (data.open(IO_WriteOnly))
+    {
+        data.writeBlock("not a result store", 18);
+        data.close();
+    }
+
+    Project::self()->open("test", KURL(dirPath), KURL());
+    check(!ResultStore::self()->isOpen(), "store with foreign data rejected");
+    Project::self()->close();
+}
+
+static void removeDir(const QString &dirPath)
+{
+    QDir dir(dirPath);
+    QStringList files = dir.entryList(QDir::Files);
+    for (QStringList::ConstIterator it = files.begin(); it != files.end(); ++it)
+        dir.remove(*it);
+    dir.rmdir(dirPath);
+}
+
+int main()
+{
+    char roundTripDir[] = "/tmp/resultstoretestXXXXXX";
+    char foreignDir[] = "/tmp/resultstoretestXXXXXX";
+    if (!mkdtemp(roundTripDir) || !mkdtemp(foreignDir))
+    {
+        qWarning("Could not create a temporary directory");
+        return 1;
+    }
+
+    testRoundTrip(roundTripDir);
+    testForeignData(foreignDir);
+
+    removeDir(roundTripDir);
+    removeDir(foreignDir);
+
+    if (s_numFailures > 0)
+    {
+        qWarning("%d checks failed", s_numFailures);
+        return 1;
+    }
+
+    return 0;
+}
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,189 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "resulttable.h"
+
+using namespace Spiceplus;
+
+const QMemArray<double> ResultTable::s_noValues;
+
+ResultTable::ResultTable()
+    : m_numRows(0),
+      m_capacity(0)
+{
+}
+
+int ResultTable::findVector(const QString &name) const
+{
+    for (uint i = 0; i < m_vectors.count(); ++i)
+        if (m_vectors[i].name == name)
+            return i;
+    return -1;
+}
+
+const QMemArray<double> &ResultTable::real(const QString &name) const
+{
+    int vector = findVector(name);
+    return vector < 0 ? s_noValues : m_vectors[vector].real;
+}
+
+const QMemArray<double> &ResultTable::imag(const QString &name) const
+{
+    int vector = findVector(name);
+    return vector < 0 ? s_noValues : m_vectors[vector].imag;
+}
+
+void ResultTable::setAxis(const QString &name, const QMemArray<double> &values)
+{
+    if (m_vectors.isEmpty())
+        m_numRows = m_capacity = values.size();
+
+    m_axis.name = name;
+    m_axis.type = Real;
+    m_axis.real = values;
+    m_axis.imag = QMemArray<double>();
+}
+
+void ResultTable::addVector(const QString &name, const QMemArray<double> &values)
+{
+    if (m_axis.name.isNull() && m_vectors.isEmpty())
+        m_numRows = m_capacity = values.size();
+
+    Column column;
+    column.name = name;
+    column.real = values;
+    m_vectors.push_back(column);
+}
+
+void ResultTable::addVector(const QString &name, const QMemArray<double> &real, const QMemArray<double> &imag)
+{
+    if (m_axis.name.isNull() && m_vectors.isEmpty())
+        m_numRows = m_capacity = real.size();
+
+    Column column;
+    column.name = name;
+    column.type = Complex;
+    column.real = real;
+    column.imag = imag;
+    m_vectors.push_back(column);
+}
+
+bool ResultTable::addVectors(const ResultTable &other)
+{
+    if (other.m_numRows != m_numRows)
+        return false;
+
+    for (uint i = 0; i < other.m_vectors.count(); ++i)
+        m_vectors.push_back(other.m_vectors[i]);
+    return true;
+}
+
+void ResultTable::setAxis(const QString &name, Type type)
+{
+    m_axis.name = name;
+    m_axis.type = type;
+    resizeColumn(m_axis, m_capacity);
+}
+
+void ResultTable::addVector(const QString &name, Type type)
+{
+    Column column;
+    column.name = name;
+    column.type = type;
+    resizeColumn(column, m_capacity);
+    m_vectors.push_back(column);
+}
+
+uint ResultTable::numValuesPerRow() const
+{
+    uint numValues = m_axis.type == Complex ? 2 : 1;
+    for (uint i = 0; i < m_vectors.count(); ++i)
+        numValues += m_vectors[i].type == Complex ? 2 : 1;
+    return numValues;
+}
+
+void ResultTable::reserve(uint numRows)
+{
+    if (numRows > m_capacity)
+        setCapacity(numRows);
+}
+
+void ResultTable::appendRow(const double *values)
+{
+    if (m_numRows == m_capacity)
+        setCapacity(QMAX(2 * m_capacity, 64u));
+
+    m_axis.real[m_numRows] = *values++;
+    if (m_axis.type == Complex)
+        m_axis.imag[m_numRows] = *values++;
+
+    for (uint i = 0; i < m_vectors.count(); ++i)
+    {
+        Column &column = m_vectors[i];
+        column.real[m_numRows] = *values++;
+        if (column.type == Complex)
+            column.imag[m_numRows] = *values++;
+    }
+
+    ++m_numRows;
+}
+
+void ResultTable::appendRow(const ResultTable &other, uint row)
+{
+    if (m_numRows == m_capacity)
+        setCapacity(QMAX(2 * m_capacity, 64u));
+
+    m_axis.real[m_numRows] = other.m_axis.real[row];
+    if (m_axis.type == Complex)
+        m_axis.imag[m_numRows] = other.m_axis.imag[row];
+
+    for (uint i = 0; i < m_vectors.count(); ++i)
+    {
+        Column &column = m_vectors[i];
+        column.real[m_numRows] = other.m_vectors[i].real[row];
+        if (column.type == Complex)
+            column.imag[m_numRows] = other.m_vectors[i].imag[row];
+    }
+
+    ++m_numRows;
+}
+
+void ResultTable::squeeze()
+{
+    if (m_numRows < m_capacity)
+        setCapacity(m_numRows);
+}
+
+void ResultTable::setCapacity(uint capacity)
+{
+    resizeColumn(m_axis, capacity);
+    for (uint i = 0; i < m_vectors.count(); ++i)
+        resizeColumn(m_vectors[i], capacity);
+    m_capacity = capacity;
+}
+
+void ResultTable::resizeColumn(Column &column, uint capacity)
+{
+    if (column.real.size() != capacity)
+        column.real.resize(capacity);
+    if (column.type == Complex && column.imag.size() != capacity)
+        column.imag.resize(capacity);
+}
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,118 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RESULTTABLE_H
+#define RESULTTABLE_H
+
+#include <qstring.h>
+#include <qvaluevector.h>
+#include <qmemarray.h>
+
+namespace Spiceplus {
+
+// The result of an analysis, column by column: the axis (swept value,
+// frequency or time) and a vector for each printed expression, found by
+// that expression. A vector is real or complex.
+//
+// The columns are explicitly shared arrays that do not change once the
+// table is complete, so copying a table or handing a column to a plot
+// curve copies no values. A table built row by row has room for
+// capacity() rows in each column and grows them in place; a copy taken
+// meanwhile is good for its own numRows() only. squeeze() gives back the
+// room that is left.
+class ResultTable
+{
+public:
+    enum Type { Real, Complex };
+
+    ResultTable();
+
+    bool isEmpty() const { return m_numRows == 0; }
+    uint numRows() const { return m_numRows; }
+    uint capacity() const { return m_capacity; }
+
+    QString axisName() const { return m_axis.name; }
+    // the real part only, as for the frequency of an AC analysis
+    const QMemArray<double> &axis() const { return m_axis.real; }
+
+    uint numVectors() const { return m_vectors.count(); }
+    QString vectorName(uint vector) const { return m_vectors[vector].name; }
+    Type vectorType(uint vector) const { return m_vectors[vector].type; }
+    // -1 if there is no such vector
+    int findVector(const QString &name) const;
+    bool contains(const QString &name) const { return findVector(name) >= 0; }
+
+    // the values of a real vector or the real part of a complex one
+    const QMemArray<double> &real(uint vector) const { return m_vectors[vector].real; }
+    // empty for a real vector
+    const QMemArray<double> &imag(uint vector) const { return m_vectors[vector].imag; }
+    // empty if there is no such vector
+    const QMemArray<double> &real(const QString &name) const;
+    const QMemArray<double> &imag(const QString &name) const;
+
+    // Whole columns of numRows() values are taken over without a copy.
+    // The first column sets numRows().
+    void setAxis(const QString &name, const QMemArray<double> &values);
+    void addVector(const QString &name, const QMemArray<double> &values);
+    void addVector(const QString &name, const QMemArray<double> &real, const QMemArray<double> &imag);
+    // the vectors of a complete table with as many rows, like the rest of
+    // a print that SPICE split into several tables; false if the rows differ
+    bool addVectors(const ResultTable &other);
+
+    // Building row by row: the columns are declared first, without values.
+    void setAxis(const QString &name, Type type);
+    void addVector(const QString &name, Type type);
+    // for the axis and each vector in turn its value, or its real and
+    // imaginary part
+    uint numValuesPerRow() const;
+    void reserve(uint numRows);
+    // numValuesPerRow() values; the capacity doubles when it runs out
+    void appendRow(const double *values);
+    // a row of a table with the same columns
+    void appendRow(const ResultTable &other, uint row);
+    void squeeze();
+
+private:
+    struct Column
+    {
+        Column() : type(Real) {}
+
+        QString name;
+        Type type;
+        QMemArray<double> real;
+        QMemArray<double> imag;
+    };
+
+    void setCapacity(uint capacity);
+    static void resizeColumn(Column &column, uint capacity);
+
+    Column m_axis;
+    QValueVector<Column> m_vectors;
+    uint m_numRows;
+    uint m_capacity;
+
+    // returned for a vector that is not there
+    static const QMemArray<double> s_noValues;
+};
+
+} // namespace Spiceplus
+
+#endif // RESULTTABLE_H
+
+// vim: ts=4 sw=4 et
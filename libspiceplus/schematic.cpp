@@ -36,6 +36,8 @@
 #include "settings.h"
 #include "pluginmanager.h"
 #include "model.h"
+#include "trace.h"
+#include "spicenumber.h"
 
 using namespace Spiceplus;
 
@@ -85,6 +87,7 @@ void Schematic::updateAll()
 
 bool Schematic::load(const KURL &url)
 {
+    TraceSpan span("Schematic::load");
     File file(url);
 
     if (!file.open(IO_ReadOnly))
@@ -235,7 +238,10 @@ bool Schematic::load(const KURL &url)
             }
         }
     }
-    
+
+    mergeJunctions();
+
+    Trace::addCounter("schematic items", allItems().count());
     return true;
 }
 
@@ -332,6 +338,22 @@ SchematicItem *Schematic::findItem(const QPoint &point) const
     return 0;
 }
 
+QCanvasItemList Schematic::findItems(const QRect &rect) const
+{
+    QCanvasItemList l = collisions(rect);
+
+    // polyline wires collide with their bounding box, so check the segments
+    for (QCanvasItemList::Iterator it = l.begin(); it != l.end();)
+    {
+        if ((*it)->rtti() == SchematicWire::RTTI && !static_cast<SchematicWire *>(*it)->hitsSegment(rect))
+            it = l.remove(it);
+        else
+            ++it;
+    }
+
+    return l;
+}
+
 SchematicDevice *Schematic::findDevice(const QString &name)
 {
     QCanvasItemList l = allItems();
@@ -624,6 +646,7 @@ bool Schematic::createModelList(QMap<QString, Model> &modelList)
 
 QString Schematic::createCommandList()
 {
+    TraceSpan span("Schematic::createCommandList");
     QString cmdList = "Generated by SPICE+ " VERSION "\n";
 
     QMap<QString, Model> ml;
@@ -658,7 +681,79 @@ QString Schematic::createCommandList()
 QCanvasItemList Schematic::collisionsSnapped(const QPoint &p) const
 {
     int s = Settings::self()->gridSize();
-    return collisions(QRect(p.x() - s / 2, p.y() - s / 2, s, s));
+    return findItems(QRect(p.x() - s / 2, p.y() - s / 2, s, s));
+}
+
+void Schematic::mergeJunctions()
+{
+    // Older schematics route bends through junctions connecting exactly two
+    // wires. Replace each of them by a vertex of a single polyline wire.
+    QValueList<SchematicJunction *> junctions;
+
+    QCanvasItemList l = allItems();
+    for (QCanvasItemList::Iterator it = l.begin(); it != l.end(); ++it)
+    {
+        if ((*it)->rtti() == SchematicDevice::RTTI)
+        {
+            SchematicDevice *dev = static_cast<SchematicDevice *>(*it);
+            if (dev->id() == SchematicJunction::ID)
+                junctions.append(static_cast<SchematicJunction *>(dev));
+        }
+    }
+
+    for (QValueList<SchematicJunction *>::Iterator it = junctions.begin(); it != junctions.end(); ++it)
+    {
+        SchematicDevicePin *pin = (*it)->pin();
+        if (pin->wireCount() != 2)
+            continue;
+
+        SchematicWireEnd *wireEnd1 = pin->wireEnds().first();
+        SchematicWireEnd *wireEnd2 = pin->wireEnds().last();
+        SchematicDevicePin *pin1 = wireEnd1->oppositePin();
+        SchematicDevicePin *pin2 = wireEnd2->oppositePin();
+
+        if (wireEnd1->wire() == wireEnd2->wire() || pin1 == pin2)
+            continue;
+
+        SchematicWire *wire = new SchematicWire(pin1, pin2, this);
+        wire->setVertices(SchematicWire::joinVertices(wireEnd1, wireEnd2));
+        wire->show();
+
+        SchematicWire *oldWires[] = { wireEnd1->wire(), wireEnd2->wire() };
+        for (int i = 0; i < 2; ++i)
+        {
+            oldWires[i]->end1()->disconnect();
+            oldWires[i]->end2()->disconnect();
+            delete oldWires[i];
+        }
+
+        pin->setNode(0);
+        delete *it;
+    }
+}
+
+//
+// SchematicParameter
+//
+
+SchematicParameter::SchematicParameter(double value)
+    : m_type(TypeString),
+      m_string(SpiceNumber::format(value)),
+      m_numberState(Number),
+      m_number(value)
+{
+}
+
+bool SchematicParameter::toDouble(double &value) const
+{
+    if (m_numberState == Unparsed)
+        m_numberState = SpiceNumber::parse(m_string, m_number) ? Number : NotNumber;
+
+    if (m_numberState != Number)
+        return false;
+
+    value = m_number;
+    return true;
 }
 
 #include "schematic.moc"
@@ -53,6 +53,7 @@ public:
     bool save(const KURL &url);
 
     SchematicItem *findItem(const QPoint &point) const;
+    QCanvasItemList findItems(const QRect &rect) const;
 
     SchematicDevice *findDevice(const QString &name);
     SchematicDevice *findDevice(const QPoint &point) const;
@@ -91,6 +92,7 @@ private slots:
 
 private:
     QCanvasItemList collisionsSnapped(const QPoint &p) const;
+    void mergeJunctions();
 
     QValueList<SchematicNode *> m_nodes;
     QString m_errorString;
@@ -136,20 +138,28 @@ class SchematicParameter
 public:
     enum Type { TypeInvalid, TypeString, TypeStringTable };
 
-    SchematicParameter() : m_type(TypeInvalid) {}
-    SchematicParameter(const char *str) : m_type(TypeString), m_string(str) {}
-    SchematicParameter(const QString &str) : m_type(TypeString), m_string(str) {}
-    SchematicParameter(const StringTable &tab) : m_type(TypeStringTable), m_stringTable(tab) {}
+    SchematicParameter() : m_type(TypeInvalid), m_numberState(NotNumber) {}
+    SchematicParameter(const char *str) : m_type(TypeString), m_string(str), m_numberState(Unparsed) {}
+    SchematicParameter(const QString &str) : m_type(TypeString), m_string(str), m_numberState(Unparsed) {}
+    SchematicParameter(const StringTable &tab) : m_type(TypeStringTable), m_stringTable(tab), m_numberState(NotNumber) {}
+    // a number in SPICE notation that reads back as exactly this value
+    SchematicParameter(double value);
 
     Type type() const { return m_type; }
 
     QString toString() const { return m_string; }
     StringTable toStringTable() const { return m_stringTable; }
+    // the string as a SPICE number, parsed only once
+    bool toDouble(double &value) const;
 
 private:
+    enum NumberState { Unparsed, Number, NotNumber };
+
     Type m_type;
     QString m_string;
     StringTable m_stringTable;
+    mutable NumberState m_numberState;
+    mutable double m_number;
 };
 
 } // namespace Spiceplus
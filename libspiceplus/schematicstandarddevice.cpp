@@ -164,6 +164,21 @@ QString SchematicStandardDevice::parameter(const QString &name) const
     return it != m_parameters.end() ? it.data().toString() : QString::null;
 }
 
+QStringList SchematicStandardDevice::parameterNames() const
+{
+    QStringList names;
+    for (QMap<QString, SchematicParameter>::ConstIterator it = m_parameters.begin(); it != m_parameters.end(); ++it)
+        names << it.key();
+
+    return names;
+}
+
+bool SchematicStandardDevice::parameterValue(const QString &name, double &value) const
+{
+    QMap<QString, SchematicParameter>::ConstIterator it = m_parameters.find(name);
+    return it != m_parameters.end() && it.data().toDouble(value);
+}
+
 StringTable SchematicStandardDevice::parameterToStringTable(const QString &name) const
 {
     QMap<QString, SchematicParameter>::ConstIterator it = m_parameters.find(name);
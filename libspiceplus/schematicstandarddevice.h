@@ -43,6 +43,8 @@ public:
     void setHighlighted(bool yes);
 
     virtual QString parameter(const QString &name) const;
+    QStringList parameterNames() const;
+    bool parameterValue(const QString &name, double &value) const;
     virtual StringTable parameterToStringTable(const QString &name) const;
     virtual void setParameter(const QString &name, const SchematicParameter &param);
     virtual void removeParameter(const QString &name);
@@ -28,6 +28,62 @@
 
 using namespace Spiceplus;
 
+static bool segmentIntersects(const QPoint &a, const QPoint &b, const QRect &r)
+{
+    if (r.contains(a) || r.contains(b))
+        return true;
+
+    // Liang-Barsky clipping
+    double dx = b.x() - a.x(), dy = b.y() - a.y();
+    double p[] = { -dx, dx, -dy, dy };
+    double q[] = { double(a.x() - r.left()), double(r.right() - a.x()), double(a.y() - r.top()), double(r.bottom() - a.y()) };
+    double t0 = 0, t1 = 1;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        if (p[i] == 0)
+        {
+            if (q[i] < 0)
+                return false;
+        }
+        else
+        {
+            double t = q[i] / p[i];
+            if (p[i] < 0)
+            {
+                if (t > t1)
+                    return false;
+                if (t > t0)
+                    t0 = t;
+            }
+            else
+            {
+                if (t < t0)
+                    return false;
+                if (t < t1)
+                    t1 = t;
+            }
+        }
+    }
+
+    return true;
+}
+
+static double segmentDistance(const QPoint &a, const QPoint &b, const QPoint &p)
+{
+    double dx = b.x() - a.x(), dy = b.y() - a.y();
+    double len = dx * dx + dy * dy;
+    double t = len > 0 ? ((p.x() - a.x()) * dx + (p.y() - a.y()) * dy) / len : 0;
+
+    if (t < 0)
+        t = 0;
+    else if (t > 1)
+        t = 1;
+
+    double ex = a.x() + t * dx - p.x(), ey = a.y() + t * dy - p.y();
+    return ex * ex + ey * ey;
+}
+
 //
 // SchematicWireEnd
 //
@@ -89,9 +145,123 @@ void SchematicWireBase::setPoints(int xa, int ya, int xb, int yb)
     update();
 }
 
+void SchematicWireBase::setVertices(const QPointArray &vertices)
+{
+    invalidate();
+    m_vertices = vertices.copy();
+    update();
+}
+
+void SchematicWireBase::addVertex(const QPoint &p)
+{
+    invalidate();
+    m_vertices.resize(m_vertices.size() + 1);
+    m_vertices.setPoint(m_vertices.size() - 1, p);
+    update();
+}
+
+void SchematicWireBase::removeLastVertex()
+{
+    if (m_vertices.isEmpty())
+        return;
+
+    invalidate();
+    m_vertices.resize(m_vertices.size() - 1);
+    update();
+}
+
+void SchematicWireBase::moveVerticesBy(int dx, int dy)
+{
+    if (m_vertices.isEmpty())
+        return;
+
+    invalidate();
+    m_vertices.translate(dx, dy);
+    update();
+}
+
+QPointArray SchematicWireBase::points() const
+{
+    QPointArray p(m_vertices.size() + 2);
+    p.setPoint(0, x1, y1);
+    for (size_t i = 0; i < m_vertices.size(); ++i)
+        p.setPoint(i + 1, m_vertices.point(i));
+    p.setPoint(p.size() - 1, x2, y2);
+    return p;
+}
+
+bool SchematicWireBase::hitsSegment(const QRect &r) const
+{
+    int pw = pen().width() / 2;
+    QRect rect = r;
+    rect.addCoords(-pw, -pw, pw, pw);
+    rect.moveBy(-int(x()), -int(y()));
+
+    QPointArray p = points();
+    for (size_t i = 0; i + 1 < p.size(); ++i)
+        if (segmentIntersects(p.point(i), p.point(i + 1), rect))
+            return true;
+
+    return false;
+}
+
+int SchematicWireBase::findSegment(const QPoint &point) const
+{
+    QPoint pt = point - QPoint(int(x()), int(y()));
+    QPointArray p = points();
+
+    int segment = 0;
+    double minDistance = segmentDistance(p.point(0), p.point(1), pt);
+
+    for (size_t i = 1; i + 1 < p.size(); ++i)
+    {
+        double d = segmentDistance(p.point(i), p.point(i + 1), pt);
+        if (d < minDistance)
+        {
+            minDistance = d;
+            segment = i;
+        }
+    }
+
+    return segment;
+}
+
+QPointArray SchematicWireBase::simplified(const QPoint &start, const QPointArray &vertices, const QPoint &end)
+{
+    QPointArray result(vertices.size());
+    int n = 0;
+    QPoint prev = start;
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        QPoint v = vertices.point(i);
+        QPoint next = i + 1 < vertices.size() ? vertices.point(i + 1) : end;
+
+        // drop duplicate and collinear vertices
+        if (v == prev || v == next)
+            continue;
+        if ((v.x() - prev.x()) * (next.y() - v.y()) == (v.y() - prev.y()) * (next.x() - v.x()) &&
+            (v.x() - prev.x()) * (next.x() - v.x()) + (v.y() - prev.y()) * (next.y() - v.y()) > 0)
+            continue;
+
+        result.setPoint(n++, v);
+        prev = v;
+    }
+
+    result.resize(n);
+    return result;
+}
+
 void SchematicWireBase::drawShape(QPainter &p)
 {
-    p.drawLine((int)(x()+x1), (int)(y()+y1), (int)(x()+x2), (int)(y()+y2));
+    if (m_vertices.isEmpty())
+        p.drawLine((int)(x()+x1), (int)(y()+y1), (int)(x()+x2), (int)(y()+y2));
+    else
+    {
+        QPointArray pa = points();
+        pa.translate(int(x()), int(y()));
+        p.drawPolyline(pa);
+    }
 }
 
 QPointArray SchematicWireBase::areaPoints() const
@@ -100,6 +270,21 @@ QPointArray SchematicWireBase::areaPoints() const
     int xi = int(x());
     int yi = int(y());
     int pw = pen().width();
+
+    if (!m_vertices.isEmpty())
+    {
+        // polyline wires cover their bounding box; use hitsSegment() for exact hits
+        QRect r = points().boundingRect();
+        pw = pw*4/3+2;
+        r.addCoords(-pw, -pw, pw, pw);
+        r.moveBy(xi, yi);
+        p.setPoint(0, r.topLeft());
+        p.setPoint(1, r.topRight());
+        p.setPoint(2, r.bottomRight());
+        p.setPoint(3, r.bottomLeft());
+        return p;
+    }
+
     int dx = QABS(x1-x2);
     int dy = QABS(y1-y2);
     pw = pw*4/3+2; // approx pw*sqrt(2)
@@ -185,6 +370,49 @@ void SchematicWire::raiseToTop()
     setZ(Schematic::nextZIndex());
 }
 
+QPointArray SchematicWire::verticesFrom(SchematicDevicePin *pin) const
+{
+    QPointArray v = vertices();
+    if (pin == m_end1->pin() || pin != m_end2->pin())
+        return v;
+
+    QPointArray r(v.size());
+    for (size_t i = 0; i < v.size(); ++i)
+        r.setPoint(i, v.point(v.size() - 1 - i));
+    return r;
+}
+
+void SchematicWire::splitVertices(const QPoint &p, QPointArray &vertices1, QPointArray &vertices2) const
+{
+    QPointArray v = vertices();
+    int segment = findSegment(p);
+
+    // vertices1 runs from end1 to p, vertices2 from end2 to p
+    vertices1.resize(segment);
+    for (int i = 0; i < segment; ++i)
+        vertices1.setPoint(i, v.point(i));
+
+    vertices2.resize(v.size() - segment);
+    for (size_t i = 0; i < vertices2.size(); ++i)
+        vertices2.setPoint(i, v.point(v.size() - 1 - i));
+}
+
+QPointArray SchematicWire::joinVertices(SchematicWireEnd *wireEnd1, SchematicWireEnd *wireEnd2)
+{
+    // both wire ends are connected to the same pin, which becomes a vertex
+    QPointArray v1 = wireEnd1->wire()->verticesFrom(wireEnd1->oppositePin());
+    QPointArray v2 = wireEnd2->wire()->verticesFrom(wireEnd2->pin());
+
+    QPointArray v(v1.size() + v2.size() + 1);
+    for (size_t i = 0; i < v1.size(); ++i)
+        v.setPoint(i, v1.point(i));
+    v.setPoint(v1.size(), wireEnd1->pin()->worldPoint());
+    for (size_t i = 0; i < v2.size(); ++i)
+        v.setPoint(v1.size() + 1 + i, v2.point(i));
+
+    return simplified(wireEnd1->oppositePin()->worldPoint(), v, wireEnd2->oppositePin()->worldPoint());
+}
+
 bool SchematicWire::loadData(const QDomElement &elem)
 {
     SchematicDevice *dev1 = schematic()->findDevice(elem.attribute("device-name1"));
@@ -206,6 +434,21 @@ bool SchematicWire::loadData(const QDomElement &elem)
     m_end1->connect(pin1);
     m_end2->connect(pin2);
 
+    QPointArray v;
+    for (QDomNode node = elem.firstChild(); !node.isNull(); node = node.nextSibling())
+    {
+        if (!node.isElement())
+            continue;
+
+        QDomElement vertexElem = node.toElement();
+        if (vertexElem.tagName() == "vertex")
+        {
+            v.resize(v.size() + 1);
+            v.setPoint(v.size() - 1, vertexElem.attribute("x").toInt(), vertexElem.attribute("y").toInt());
+        }
+    }
+    setVertices(v);
+
     updatePosition();
 
     return true;
@@ -223,6 +466,15 @@ void SchematicWire::saveData(QDomElement &elem) const
     elem.setAttribute("device-name2", m_end2->pin()->device()->name());
     elem.setAttribute("device-pin-id1", m_end1->pin()->id());
     elem.setAttribute("device-pin-id2", m_end2->pin()->id());
+
+    QPointArray v = vertices();
+    for (size_t i = 0; i < v.size(); ++i)
+    {
+        QDomElement vertexElem = elem.ownerDocument().createElement("vertex");
+        vertexElem.setAttribute("x", v.point(i).x());
+        vertexElem.setAttribute("y", v.point(i).y());
+        elem.appendChild(vertexElem);
+    }
 }
 
 bool SchematicWire::highlighted() const
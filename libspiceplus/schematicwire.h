@@ -57,6 +57,19 @@ public:
     QPoint startPoint() const { return QPoint(x1, y1); }
     QPoint endPoint() const { return QPoint(x2, y2); }
 
+    // interior vertices between start and end point
+    QPointArray vertices() const { return m_vertices.copy(); }
+    void setVertices(const QPointArray &vertices);
+    void addVertex(const QPoint &p);
+    void removeLastVertex();
+    void moveVerticesBy(int dx, int dy);
+    QPointArray points() const;
+
+    bool hitsSegment(const QRect &r) const;
+    int findSegment(const QPoint &p) const;
+
+    static QPointArray simplified(const QPoint &start, const QPointArray &vertices, const QPoint &end);
+
     void setPen(QPen p);
     void moveBy(double dx, double dy);
 
@@ -66,6 +79,7 @@ protected:
 
 private:
     int x1, y1, x2, y2;
+    QPointArray m_vertices;
 };
 
 class SchematicWire : public SchematicWireBase
@@ -81,6 +95,10 @@ public:
     void updatePosition();
     void raiseToTop();
 
+    QPointArray verticesFrom(SchematicDevicePin *pin) const;
+    void splitVertices(const QPoint &p, QPointArray &vertices1, QPointArray &vertices2) const;
+    static QPointArray joinVertices(SchematicWireEnd *wireEnd1, SchematicWireEnd *wireEnd2);
+
     static const int RTTI = 1000;
     int rtti() const { return RTTI; }
 
@@ -20,6 +20,7 @@
 #include <qstring.h>
 #include <qsize.h>
 #include <qfont.h>
+#include <qdir.h>
 
 #include <kapplication.h>
 #include <kstandarddirs.h>
@@ -71,6 +72,13 @@ Settings::Settings()
 
     setCurrentGroup("Analysis");
     addItemInt("ACAnalysisNumPointsPerDecade", m_acAnalysisNumPointsPerDecade, 100);
+    addItemBool("ACAnalysisAdaptive", m_isACAnalysisAdaptive, false);
+    addItemDouble("ACAnalysisTolerance", m_acAnalysisTolerance, 0.1);
+    addItemInt("ACAnalysisMaxPoints", m_acAnalysisMaxPoints, 2000);
+    addItemBool("UseBuiltInSolver", m_useBuiltInSolver, true);
+    addItemInt("NumSpiceJobs", m_numSpiceJobs, 0);
+    addItemInt("SpiceTimeLimit", m_spiceTimeLimit, 0);
+    addItemInt("SpiceMemoryLimit", m_spiceMemoryLimit, 0);
 
     setCurrentGroup("Paths");
     addItemPath("SpiceExecutablePath", m_spiceExecutablePath, KStandardDirs::findExe("spice3"));
@@ -89,6 +97,10 @@ Settings::Settings()
 
     setCurrentGroup("Project");
     addItemPath("ProjectsDir", m_projectsDir, KGlobalSettings::documentPath());
+
+    setCurrentGroup("Tracing");
+    addItemBool("TraceEnabled", m_isTraceEnabled, false);
+    addItemPath("TraceFile", m_traceFile, QDir::homeDirPath() + "/spiceplus-trace.json");
 }
 
 Settings::~Settings()
@@ -77,6 +77,17 @@ public:
     // [Analysis]
 
     int acAnalysisNumPointsPerDecade() const { return m_acAnalysisNumPointsPerDecade; }
+    // adaptive sweeps refine a coarse grid up to the tolerance (in dB)
+    // or the maximum number of points, see LinearCircuit::adaptiveACSweep()
+    bool isACAnalysisAdaptive() const { return m_isACAnalysisAdaptive; }
+    double acAnalysisTolerance() const { return m_acAnalysisTolerance; }
+    int acAnalysisMaxPoints() const { return m_acAnalysisMaxPoints; }
+    bool useBuiltInSolver() const { return m_useBuiltInSolver; }
+    // 0 runs one SPICE process per processor
+    int numSpiceJobs() const { return m_numSpiceJobs; }
+    // limits of each SPICE run in seconds and megabytes, 0 for none
+    int spiceTimeLimit() const { return m_spiceTimeLimit; }
+    int spiceMemoryLimit() const { return m_spiceMemoryLimit; }
 
     // [Paths]
 
@@ -99,6 +110,11 @@ public:
     QString projectsDir() const { return m_projectsDir; }
     void setProjectsDir(const QString &dir) { m_projectsDir = dir; }
 
+    // [Tracing]
+
+    bool isTraceEnabled() const { return m_isTraceEnabled; }
+    QString traceFile() const { return m_traceFile; }
+
 public slots:
     void emitSettingsChanged() { emit settingsChanged(); }
 
@@ -134,6 +150,13 @@ private:
     QFont m_hugeSymbolFont;
 
     int m_acAnalysisNumPointsPerDecade;
+    bool m_isACAnalysisAdaptive;
+    double m_acAnalysisTolerance;
+    int m_acAnalysisMaxPoints;
+    bool m_useBuiltInSolver;
+    int m_numSpiceJobs;
+    int m_spiceTimeLimit;
+    int m_spiceMemoryLimit;
 
     QString m_spiceExecutablePath;
     QString m_deviceDir;
@@ -144,6 +167,9 @@ private:
     ModelDirs m_userModelDirs;
 
     QString m_projectsDir;
+
+    bool m_isTraceEnabled;
+    QString m_traceFile;
 };
 
 } // namespace Spiceplus
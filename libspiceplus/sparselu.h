@@ -0,0 +1,440 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SPARSELU_H
+#define SPARSELU_H
+
+#include <math.h>
+#include <complex>
+
+#include <qvaluevector.h>
+#include <qmemarray.h>
+#include <qmap.h>
+
+namespace Spiceplus {
+
+inline double sparseAbs(double value) { return fabs(value); }
+inline double sparseAbs(const std::complex<double> &value) { return std::abs(value); }
+
+// A pivot below this times the largest entry its column had before the
+// elimination counts as zero: what is left of the column cancelled out.
+// Relative to the column, so that small admittances like those of high
+// impedance nodes or of capacitors at low frequencies are still fine.
+static const double SparsePivotTolerance = 1e-12;
+
+// The active columns by their number of entries, so that the sparsest
+// one is found without looking at every column.
+class SparseColumnBuckets
+{
+public:
+    SparseColumnBuckets(int size) : m_heads(size + 1, -1), m_next(size, -1), m_prev(size, -1), m_counts(size, -1) {}
+
+    void insert(int col, int count)
+    {
+        count = QMIN(count, int(m_heads.size()) - 1);
+        m_counts[col] = count;
+        m_prev[col] = -1;
+        m_next[col] = m_heads[count];
+        if (m_heads[count] >= 0)
+            m_prev[m_heads[count]] = col;
+        m_heads[count] = col;
+    }
+
+    void remove(int col)
+    {
+        if (m_prev[col] >= 0)
+            m_next[m_prev[col]] = m_next[col];
+        else
+            m_heads[m_counts[col]] = m_next[col];
+        if (m_next[col] >= 0)
+            m_prev[m_next[col]] = m_prev[col];
+    }
+
+    void update(int col, int count)
+    {
+        remove(col);
+        insert(col, count);
+    }
+
+    // with at least one entry; -1 if there is none
+    int sparsest() const
+    {
+        for (uint count = 1; count < m_heads.size(); ++count)
+            if (m_heads[count] >= 0)
+                return m_heads[count];
+        return -1;
+    }
+
+private:
+    QValueVector<int> m_heads;
+    QValueVector<int> m_next;
+    QValueVector<int> m_prev;
+    QValueVector<int> m_counts;
+};
+
+// Sparse LU factorization for the matrices of modified nodal analysis.
+//
+// Entries are registered with slot() and stamped into values(). The first
+// factor() chooses pivots (sparsity first, with a threshold on magnitude)
+// and records the elimination, including fill-in, as a list of slot
+// operations. Later calls on a matrix with the same structure replay that
+// list without any searching or allocation, unless a pivot turns out too
+// small, in which case the pivots are chosen again.
+template<class T>
+class SparseLU
+{
+public:
+    SparseLU(int size = 0) : m_size(size), m_isAnalyzed(false), m_numAnalyses(0) {}
+    // copies are deep, so that a copy can be used in another thread
+    SparseLU(const SparseLU<T> &other) { *this = other; }
+    SparseLU<T> &operator=(const SparseLU<T> &other);
+
+    int size() const { return m_size; }
+    int numEntries() const { return m_values.size(); }
+
+    int slot(int row, int col);
+    T *values() { return m_values.data(); }
+    void clear();
+
+    bool factor();
+    // b is used as scratch space
+    void solve(QMemArray<T> &b, QMemArray<T> &x) const { solve(m_values, b, x); }
+
+    // The numeric part of the factors. Factors of matrices with the same
+    // structure and the same pivots, which is as long as numAnalyses()
+    // does not change, can be solved with the recording of either.
+    const QMemArray<T> &factorValues() const { return m_values; }
+    int numAnalyses() const { return m_numAnalyses; }
+    void solve(const QMemArray<T> &factorValues, QMemArray<T> &b, QMemArray<T> &x) const;
+
+private:
+    bool factorWithPivoting();
+    bool refactor();
+    // the largest magnitude in each column, before the elimination
+    QMemArray<double> columnScales() const;
+
+    int m_size;
+    QMap<int, int> m_slots;
+    QValueVector<int> m_slotRows;
+    QValueVector<int> m_slotCols;
+    QMemArray<T> m_values;
+    bool m_isAnalyzed;
+    int m_numAnalyses;
+
+    // the recorded elimination
+    QValueVector<int> m_pivotRows, m_pivotCols, m_pivotSlots;
+    QValueVector<int> m_multStart, m_multSlots, m_multRows;
+    QValueVector<int> m_updateStart, m_updateTargets, m_updateSources;
+    QValueVector<int> m_upperStart, m_upperSlots, m_upperCols;
+};
+
+template<class T>
+static QValueVector<T> sparseDeepCopy(const QValueVector<T> &v)
+{
+    QValueVector<T> copy;
+    copy.reserve(v.size());
+    for (uint i = 0; i < v.size(); ++i)
+        copy.push_back(v[i]);
+
+    return copy;
+}
+
+template<class T>
+SparseLU<T> &SparseLU<T>::operator=(const SparseLU<T> &other)
+{
+    m_size = other.m_size;
+    m_slots.clear();
+    for (QMap<int, int>::ConstIterator it = other.m_slots.begin(); it != other.m_slots.end(); ++it)
+        m_slots.insert(it.key(), it.data());
+    m_slotRows = sparseDeepCopy(other.m_slotRows);
+    m_slotCols = sparseDeepCopy(other.m_slotCols);
+    m_values = other.m_values.copy();
+    m_isAnalyzed = other.m_isAnalyzed;
+    m_numAnalyses = other.m_numAnalyses;
+
+    m_pivotRows = sparseDeepCopy(other.m_pivotRows);
+    m_pivotCols = sparseDeepCopy(other.m_pivotCols);
+    m_pivotSlots = sparseDeepCopy(other.m_pivotSlots);
+    m_multStart = sparseDeepCopy(other.m_multStart);
+    m_multSlots = sparseDeepCopy(other.m_multSlots);
+    m_multRows = sparseDeepCopy(other.m_multRows);
+    m_updateStart = sparseDeepCopy(other.m_updateStart);
+    m_updateTargets = sparseDeepCopy(other.m_updateTargets);
+    m_updateSources = sparseDeepCopy(other.m_updateSources);
+    m_upperStart = sparseDeepCopy(other.m_upperStart);
+    m_upperSlots = sparseDeepCopy(other.m_upperSlots);
+    m_upperCols = sparseDeepCopy(other.m_upperCols);
+
+    return *this;
+}
+
+template<class T>
+int SparseLU<T>::slot(int row, int col)
+{
+    int key = row * m_size + col;
+    QMap<int, int>::ConstIterator it = m_slots.find(key);
+    if (it != m_slots.end())
+        return it.data();
+
+    // a new entry changes the structure
+    m_isAnalyzed = false;
+
+    int s = m_slotRows.size();
+    m_slots[key] = s;
+    m_slotRows.push_back(row);
+    m_slotCols.push_back(col);
+    m_values.resize(s + 1);
+    m_values[s] = T(0);
+
+    return s;
+}
+
+template<class T>
+void SparseLU<T>::clear()
+{
+    for (uint i = 0; i < m_values.size(); ++i)
+        m_values[i] = T(0);
+}
+
+template<class T>
+QMemArray<double> SparseLU<T>::columnScales() const
+{
+    QMemArray<double> scales(m_size);
+    scales.fill(0);
+    for (uint s = 0; s < m_values.size(); ++s)
+        scales[m_slotCols[s]] = QMAX(scales[m_slotCols[s]], sparseAbs(m_values[s]));
+
+    return scales;
+}
+
+template<class T>
+bool SparseLU<T>::factor()
+{
+    if (m_isAnalyzed && refactor())
+        return true;
+
+    return factorWithPivoting();
+}
+
+template<class T>
+bool SparseLU<T>::refactor()
+{
+    QMemArray<T> original = m_values.copy();
+    T *v = m_values.data();
+    QMemArray<double> colScale = columnScales();
+
+    for (int k = 0; k < m_size; ++k)
+    {
+        T pivot = v[m_pivotSlots[k]];
+        if (sparseAbs(pivot) <= SparsePivotTolerance * colScale[m_pivotCols[k]])
+        {
+            // the recorded pivots do not fit these values
+            m_values = original;
+            m_isAnalyzed = false;
+            return false;
+        }
+
+        for (int m = m_multStart[k]; m < m_multStart[k + 1]; ++m)
+        {
+            T mult = v[m_multSlots[m]] /= pivot;
+            for (int u = m_updateStart[m]; u < m_updateStart[m + 1]; ++u)
+                v[m_updateTargets[u]] -= mult * v[m_updateSources[u]];
+        }
+    }
+
+    return true;
+}
+
+template<class T>
+bool SparseLU<T>::factorWithPivoting()
+{
+    ++m_numAnalyses;
+
+    // fill-in from an earlier factorization is kept; its slots are zero
+    QValueVector<QMap<int, int> > rowSlots(m_size);
+    QValueVector<QMap<int, int> > colSlots(m_size);
+    for (int s = 0; s < int(m_slotRows.size()); ++s)
+    {
+        rowSlots[m_slotRows[s]][m_slotCols[s]] = s;
+        colSlots[m_slotCols[s]][m_slotRows[s]] = s;
+    }
+
+    QValueVector<bool> rowActive(m_size, true), colActive(m_size, true);
+    QValueVector<int> colCount(m_size), rowCount(m_size);
+    SparseColumnBuckets buckets(m_size);
+    for (int i = 0; i < m_size; ++i)
+    {
+        colCount[i] = colSlots[i].count();
+        rowCount[i] = rowSlots[i].count();
+        buckets.insert(i, colCount[i]);
+    }
+
+    QMemArray<double> colScale = columnScales();
+
+    m_pivotRows.clear(); m_pivotCols.clear(); m_pivotSlots.clear();
+    m_multStart.clear(); m_multSlots.clear(); m_multRows.clear();
+    m_updateStart.clear(); m_updateTargets.clear(); m_updateSources.clear();
+    m_upperStart.clear(); m_upperSlots.clear(); m_upperCols.clear();
+
+    for (int k = 0; k < m_size; ++k)
+    {
+        // the sparsest column first; one that cancelled out is passed
+        // over for now, later pivots may still fill it in
+        QValueVector<int> passed;
+        int c;
+        double max = 0;
+        QMap<int, int>::ConstIterator it;
+        while ((c = buckets.sparsest()) >= 0)
+        {
+            max = 0;
+            for (it = colSlots[c].begin(); it != colSlots[c].end(); ++it)
+                if (rowActive[it.key()])
+                    max = QMAX(max, sparseAbs(m_values[it.data()]));
+
+            if (max > SparsePivotTolerance * colScale[c])
+                break;
+
+            buckets.remove(c);
+            passed.push_back(c);
+        }
+
+        for (uint i = 0; i < passed.size(); ++i)
+            buckets.insert(passed[i], colCount[passed[i]]);
+
+        if (c < 0)
+            return false;
+
+        // among the large enough candidates the sparsest row
+        int r = -1;
+        for (it = colSlots[c].begin(); it != colSlots[c].end(); ++it)
+        {
+            int i = it.key();
+            if (rowActive[i] && sparseAbs(m_values[it.data()]) >= 0.1 * max && (r < 0 || rowCount[i] < rowCount[r]))
+                r = i;
+        }
+
+        int pivotSlot = rowSlots[r][c];
+        T pivot = m_values[pivotSlot];
+
+        m_pivotRows.push_back(r);
+        m_pivotCols.push_back(c);
+        m_pivotSlots.push_back(pivotSlot);
+
+        rowActive[r] = false;
+        colActive[c] = false;
+        buckets.remove(c);
+        for (it = rowSlots[r].begin(); it != rowSlots[r].end(); ++it)
+        {
+            if (colActive[it.key()])
+                buckets.update(it.key(), --colCount[it.key()]);
+            else if (it.key() == c)
+                --colCount[c];
+        }
+
+        QValueVector<int> upperSlots, upperCols;
+        m_upperStart.push_back(m_upperSlots.size());
+        for (it = rowSlots[r].begin(); it != rowSlots[r].end(); ++it)
+        {
+            if (!colActive[it.key()])
+                continue;
+
+            upperSlots.push_back(it.data());
+            upperCols.push_back(it.key());
+            m_upperSlots.push_back(it.data());
+            m_upperCols.push_back(it.key());
+        }
+
+        m_multStart.push_back(m_multSlots.size());
+        for (it = colSlots[c].begin(); it != colSlots[c].end(); ++it)
+        {
+            int i = it.key();
+            if (!rowActive[i])
+                continue;
+
+            int multSlot = it.data();
+            T mult = m_values[multSlot] /= pivot;
+            m_multSlots.push_back(multSlot);
+            m_multRows.push_back(i);
+            m_updateStart.push_back(m_updateTargets.size());
+            --rowCount[i];
+
+            for (uint u = 0; u < upperSlots.size(); ++u)
+            {
+                int j = upperCols[u];
+                int target;
+
+                QMap<int, int>::ConstIterator t = rowSlots[i].find(j);
+                if (t != rowSlots[i].end())
+                    target = t.data();
+                else
+                {
+                    target = m_slotRows.size();
+                    m_slots[i * m_size + j] = target;
+                    m_slotRows.push_back(i);
+                    m_slotCols.push_back(j);
+                    m_values.resize(target + 1);
+                    m_values[target] = T(0);
+                    rowSlots[i][j] = target;
+                    colSlots[j][i] = target;
+                    ++rowCount[i];
+                    buckets.update(j, ++colCount[j]);
+                }
+
+                m_values[target] -= mult * m_values[upperSlots[u]];
+                m_updateTargets.push_back(target);
+                m_updateSources.push_back(upperSlots[u]);
+            }
+        }
+    }
+
+    m_multStart.push_back(m_multSlots.size());
+    m_updateStart.push_back(m_updateTargets.size());
+    m_upperStart.push_back(m_upperSlots.size());
+
+    m_isAnalyzed = true;
+    return true;
+}
+
+template<class T>
+void SparseLU<T>::solve(const QMemArray<T> &factorValues, QMemArray<T> &b, QMemArray<T> &x) const
+{
+    x.resize(m_size);
+    const T *v = factorValues.data();
+
+    for (int k = 0; k < m_size; ++k)
+    {
+        T br = b[m_pivotRows[k]];
+        for (int m = m_multStart[k]; m < m_multStart[k + 1]; ++m)
+            b[m_multRows[m]] -= v[m_multSlots[m]] * br;
+    }
+
+    for (int k = m_size - 1; k >= 0; --k)
+    {
+        T sum = b[m_pivotRows[k]];
+        for (int u = m_upperStart[k]; u < m_upperStart[k + 1]; ++u)
+            sum -= v[m_upperSlots[u]] * x[m_upperCols[u]];
+        x[m_pivotCols[k]] = sum / v[m_pivotSlots[k]];
+    }
+}
+
+} // namespace Spiceplus
+
+#endif // SPARSELU_H
+
+// vim: ts=4 sw=4 et
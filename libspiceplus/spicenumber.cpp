@@ -0,0 +1,285 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "spicenumber.h"
+
+using namespace Spiceplus;
+
+namespace {
+
+struct ScaleFactor
+{
+    const char *suffix;
+    int exponent;
+    // applied to the digits, so that the result is still rounded once
+    int multiplier;
+};
+
+// longer suffixes first, "meg" and "mil" must win over "m"
+const ScaleFactor scaleFactors[] =
+{
+    { "meg", 6, 1 },
+    { "mil", -7, 254 },
+    { "t", 12, 1 },
+    { "g", 9, 1 },
+    { "k", 3, 1 },
+    { "m", -3, 1 },
+    { "u", -6, 1 },
+    { "n", -9, 1 },
+    { "p", -12, 1 },
+    { "f", -15, 1 }
+};
+
+const int numScaleFactors = sizeof(scaleFactors) / sizeof(scaleFactors[0]);
+
+// significant digits kept; beyond that they only count for the exponent
+const int MaxDigits = 48;
+
+// the suffixes used by format(), indexed by (exponent + 15) / 3
+const char *const formatSuffixes[] = { "f", "p", "n", "u", "m", "", "k", "meg", "g", "t" };
+
+// powers of ten that are exact doubles
+const double exactPowers[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Converts significant digits times a power of ten. Up to 15 digits and
+// with an exact power of ten, a single multiplication or division gives
+// the correctly rounded result; anything else goes to strtod.
+double convert(const char *digits, int numDigits, int exponent, bool negative)
+{
+    double value;
+
+    if (numDigits <= 15 && exponent >= -22 && exponent <= 22)
+    {
+        double mantissa = 0;
+        for (int i = 0; i < numDigits; ++i)
+            mantissa = mantissa * 10 + (digits[i] - '0');
+
+        value = exponent < 0 ? mantissa / exactPowers[-exponent] : mantissa * exactPowers[exponent];
+    }
+    else
+    {
+        char buffer[64];
+        if (numDigits > 40)
+        {
+            exponent += numDigits - 40;
+            numDigits = 40;
+        }
+        memcpy(buffer, digits, numDigits);
+        sprintf(buffer + numDigits, "e%d", exponent);
+        value = strtod(buffer, 0);
+    }
+
+    return negative ? -value : value;
+}
+
+// multiplies the significant digits by a small factor in place; the
+// buffer needs room for as many digits more as the factor has
+void multiplyDigits(char *digits, int &numDigits, int factor)
+{
+    char reversed[MaxDigits + 8];
+    int n = 0;
+    int carry = 0;
+    for (int i = numDigits - 1; i >= 0; --i)
+    {
+        int d = (digits[i] - '0') * factor + carry;
+        reversed[n++] = '0' + d % 10;
+        carry = d / 10;
+    }
+    for (; carry > 0; carry /= 10)
+        reversed[n++] = '0' + carry % 10;
+
+    for (int i = 0; i < n; ++i)
+        digits[i] = reversed[n - 1 - i];
+    numDigits = n;
+}
+
+}
+
+bool SpiceNumber::parse(const QString &text, double &value)
+{
+    // SPICE numbers are plain ASCII
+    return parse(text.latin1(), value);
+}
+
+bool SpiceNumber::parse(const char *text, double &value)
+{
+    if (!text)
+        return false;
+
+    const char *p = text;
+    while (isspace(*p))
+        ++p;
+
+    bool negative = false;
+    if (*p == '+' || *p == '-')
+        negative = *p++ == '-';
+
+    // significant digits without leading zeros, and the decimal exponent
+    char digits[MaxDigits + 4];
+    int numDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+
+    for (; isdigit(*p); ++p)
+    {
+        hasDigits = true;
+        if (numDigits == 0 && *p == '0')
+            continue;
+        if (numDigits < MaxDigits)
+            digits[numDigits++] = *p;
+        else
+            ++exponent;
+    }
+
+    if (*p == '.')
+    {
+        for (++p; isdigit(*p); ++p)
+        {
+            hasDigits = true;
+            if (numDigits == 0 && *p == '0')
+            {
+                --exponent;
+                continue;
+            }
+            if (numDigits < MaxDigits)
+            {
+                digits[numDigits++] = *p;
+                --exponent;
+            }
+        }
+    }
+
+    if (!hasDigits)
+        return false;
+
+    // an exponent needs digits, otherwise the "e" is a unit
+    if ((*p == 'e' || *p == 'E') &&
+        (isdigit(p[1]) || ((p[1] == '+' || p[1] == '-') && isdigit(p[2]))))
+    {
+        ++p;
+        bool negativeExponent = false;
+        if (*p == '+' || *p == '-')
+            negativeExponent = *p++ == '-';
+
+        int e = 0;
+        for (; isdigit(*p); ++p)
+            if (e < 10000)
+                e = e * 10 + (*p - '0');
+
+        exponent += negativeExponent ? -e : e;
+    }
+
+    for (int i = 0; i < numScaleFactors; ++i)
+    {
+        const char *s = scaleFactors[i].suffix;
+        int n = 0;
+        while (s[n] && tolower(p[n]) == s[n])
+            ++n;
+
+        if (!s[n])
+        {
+            exponent += scaleFactors[i].exponent;
+            if (scaleFactors[i].multiplier != 1)
+                multiplyDigits(digits, numDigits, scaleFactors[i].multiplier);
+            p += n;
+            break;
+        }
+    }
+
+    // units
+    while (isalpha(*p))
+        ++p;
+    while (isspace(*p))
+        ++p;
+    if (*p)
+        return false;
+
+    value = numDigits == 0 ? 0 : convert(digits, numDigits, exponent, negative);
+    return true;
+}
+
+QString SpiceNumber::format(double value)
+{
+    if (value == 0)
+        return "0";
+    if (value != value || value - value != 0)
+        return QString::number(value);
+
+    // the shortest digits that convert back exactly
+    char buffer[40];
+    for (int precision = 1; precision <= 17; ++precision)
+    {
+        sprintf(buffer, "%.*e", precision - 1, value);
+        if (strtod(buffer, 0) == value)
+            break;
+    }
+
+    // split "-d.ddde+xx" into sign, digits and decimal exponent
+    const char *p = buffer;
+    bool negative = *p == '-';
+    if (negative)
+        ++p;
+
+    QString digits;
+    for (; *p && *p != 'e'; ++p)
+        if (isdigit(*p))
+            digits += QChar(*p);
+    int exponent = atoi(p + 1);
+
+    while (digits.length() > 1 && digits.at(digits.length() - 1) == '0')
+        digits.truncate(digits.length() - 1);
+
+    QString text = negative ? "-" : "";
+
+    // far outside the scale factors an exponent is more readable
+    if (exponent < -18 || exponent > 14)
+    {
+        text += digits.left(1);
+        if (digits.length() > 1)
+            text += "." + digits.mid(1);
+        return text + "e" + QString::number(exponent);
+    }
+
+    // a multiple of three for the scale factor, within the table
+    int scale = exponent >= 0 ? exponent / 3 * 3 : -((-exponent + 2) / 3 * 3);
+    scale = QMIN(QMAX(scale, -15), 12);
+
+    int numIntegerDigits = exponent - scale + 1;
+
+    if (numIntegerDigits <= 0)
+        text += "0." + QString().fill('0', -numIntegerDigits) + digits;
+    else if (numIntegerDigits >= int(digits.length()))
+        text += digits + QString().fill('0', numIntegerDigits - digits.length());
+    else
+        text += digits.left(numIntegerDigits) + "." + digits.mid(numIntegerDigits);
+
+    return text + formatSuffixes[(scale + 15) / 3];
+}
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,45 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SPICENUMBER_H
+#define SPICENUMBER_H
+
+#include <qstring.h>
+
+namespace Spiceplus {
+
+// Numbers in SPICE notation: an optional exponent followed by an optional
+// scale factor (f p n u m k meg g t, and mil) and any unit letters, as in
+// "4.7k", "100meg", "1e-3" or "10uF".
+class SpiceNumber
+{
+public:
+    static bool parse(const QString &text, double &value);
+    static bool parse(const char *text, double &value);
+
+    // the shortest text with a scale factor that parses back to exactly
+    // the same value
+    static QString format(double value);
+};
+
+} // namespace Spiceplus
+
+#endif // SPICENUMBER_H
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,215 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+
+#include <qglobal.h>
+#include <qstring.h>
+
+#include "spicenumber.h"
+
+using namespace Spiceplus;
+
+static int s_numFailures = 0;
+
+static void check(bool condition, const char *description)
+{
+    if (!condition)
+    {
+        qWarning("FAIL: %s", description);
+        ++s_numFailures;
+    }
+}
+
+// exactly the value, not just close to it
+static void checkParse(const char *text, double expected)
+{
+    double value;
+    bool ok = SpiceNumber::parse(text, value) && value == expected;
+    if (!ok)
+        qWarning("FAIL: \"%s\" parsed as %.17g, not %.17g", text, value, expected);
+    check(ok, "parse");
+}
+
+static void checkInvalid(const char *text)
+{
+    double value;
+    if (SpiceNumber::parse(text, value))
+        qWarning("FAIL: \"%s\" parsed as %.17g", text, value);
+    check(!SpiceNumber::parse(text, value), "invalid number");
+}
+
+// digits beyond what the fast path converts exactly go to strtod
+static void checkLikeStrtod(const char *text)
+{
+    checkParse(text, strtod(text, 0));
+}
+
+static void checkFormat(double value, const char *expected)
+{
+    QString text = SpiceNumber::format(value);
+    if (text != expected)
+        qWarning("FAIL: %.17g formatted as \"%s\", not \"%s\"", value, text.latin1(), expected);
+    check(text == expected, "format");
+}
+
+static void checkRoundTrip(double value)
+{
+    QString text = SpiceNumber::format(value);
+    double parsed;
+    bool ok = SpiceNumber::parse(text, parsed) && parsed == value;
+    if (!ok)
+        qWarning("FAIL: %.17g formatted as \"%s\" does not parse back", value, text.latin1());
+    check(ok, "round trip");
+}
+
+static void testSuffixes()
+{
+    checkParse("4.7k", 4700);
+    checkParse("1K", 1000);
+    checkParse("2.2n", 2.2e-9);
+    checkParse("10u", 10e-6);
+    checkParse("3p", 3e-12);
+    checkParse("1g", 1e9);
+    checkParse("2t", 2e12);
+
+    // "meg" and "mil" are not milli
+    checkParse("1m", 1e-3);
+    checkParse("1meg", 1e6);
+    checkParse("100MEG", 1e8);
+    checkParse("1mil", 25.4e-6);
+    checkParse("10mil", 254e-6);
+
+    // "f" is femto, not farad
+    checkParse("1f", 1e-15);
+    checkParse("100fF", 100e-15);
+}
+
+static void testUnits()
+{
+    // units after the scale factor, or instead of it
+    checkParse("5kHz", 5e3);
+    checkParse("2mA", 2e-3);
+    checkParse("3megohm", 3e6);
+    checkParse("1ms", 1e-3);
+    checkParse("10uF", 10e-6);
+    checkParse("12V", 12);
+    checkParse("1milinch", 25.4e-6);
+
+    // an "e" without digits is a unit too
+    checkParse("1e", 1);
+    checkParse("2E", 2);
+    checkParse("1e3", 1e3);
+    checkParse("1e+3", 1e3);
+    checkParse("1e-3", 1e-3);
+    checkParse("2.5e2k", 250e3);
+}
+
+static void testPlainNumbers()
+{
+    checkParse("0", 0);
+    checkParse("-0", 0);
+    checkParse("42", 42);
+    checkParse(" 42 ", 42);
+    checkParse("+1.5", 1.5);
+    checkParse("-3.3", -3.3);
+    checkParse(".5", 0.5);
+    checkParse("5.", 5);
+    checkParse("0.1", 0.1);
+    checkParse("0.000001", 1e-6);
+    checkParse("000123", 123);
+
+    checkInvalid("");
+    checkInvalid("k");
+    checkInvalid(".");
+    checkInvalid("-");
+    checkInvalid("abc");
+    checkInvalid("1k 2");
+    checkInvalid("1e3x5");
+    checkInvalid("1,5");
+}
+
+static void testLongMantissas()
+{
+    checkLikeStrtod("3.14159265358979323846");
+    checkLikeStrtod("0.1000000000000000055511151231257827");
+    checkLikeStrtod("1234567890123456789");
+    checkLikeStrtod("12345678901234567890123456789012345678901234567890");
+    checkLikeStrtod("0.00000000000000000000000123456789012345678");
+    checkLikeStrtod("2.2250738585072014e-308");
+    checkLikeStrtod("1.7976931348623157e308");
+    checkLikeStrtod("4.9406564584124654e-324");
+    checkLikeStrtod("1e23");
+    checkLikeStrtod("1e-23");
+    checkLikeStrtod("9007199254740993");
+
+    // a scale factor moves the exponent of the fallback as well
+    double value;
+    check(SpiceNumber::parse("3.14159265358979323846k", value) && value == strtod("3.14159265358979323846e3", 0), "long mantissa with scale factor");
+}
+
+static void testFormat()
+{
+    checkFormat(0, "0");
+    checkFormat(4700, "4.7k");
+    checkFormat(1e6, "1meg");
+    checkFormat(1e-3, "1m");
+    checkFormat(-2.2e-9, "-2.2n");
+    checkFormat(1e14, "100t");
+    checkFormat(1e15, "1e15");
+    checkFormat(1e-19, "1e-19");
+    checkFormat(123, "123");
+}
+
+static void testRoundTrip()
+{
+    double values[] =
+    {
+        1.0 / 3, 2.0 / 3, 0.1 + 0.2, 0.1, 1e-18, 1.5e-18, 9.99e-19, 1e-19, 1e-15,
+        1e15, 1.2345e15, 999999999999999.9, 1e14 / 3, 123456789.123,
+        2.0 / 3 * 1e-6, 4.7e3, 25.4e-6, 5e-324, 2.2250738585072014e-308,
+        1.7976931348623157e308
+    };
+
+    for (uint i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+    {
+        checkRoundTrip(values[i]);
+        checkRoundTrip(-values[i]);
+    }
+}
+
+int main()
+{
+    testSuffixes();
+    testUnits();
+    testPlainNumbers();
+    testLongMantissas();
+    testFormat();
+    testRoundTrip();
+
+    if (s_numFailures > 0)
+    {
+        qWarning("%d checks failed", s_numFailures);
+        return 1;
+    }
+
+    return 0;
+}
+
+// vim: ts=4 sw=4 et
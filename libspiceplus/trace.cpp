@@ -0,0 +1,187 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include <qfile.h>
+#include <qtextstream.h>
+#include <qthread.h>
+
+#include <kapplication.h>
+#include <kdebug.h>
+
+#include "trace.h"
+#include "settings.h"
+
+using namespace Spiceplus;
+
+Trace *Trace::s_self = 0;
+bool Trace::s_enabled = false;
+
+Trace::Trace()
+    : QObject(kapp), m_isEnvironmentOverride(false)
+{
+    QCString env = getenv("SPICEPLUS_TRACE");
+    if (!env.isEmpty() && env != "0")
+    {
+        // The environment wins over the settings, so that startup can be
+        // traced; any value other than 1 names the output file.
+        m_isEnvironmentOverride = true;
+        if (env != "1")
+            m_fileName = QFile::decodeName(env);
+        s_enabled = true;
+    }
+    else
+        loadSettings();
+
+    connect(Settings::self(), SIGNAL(settingsChanged()), SLOT(loadSettings()));
+}
+
+Trace::~Trace()
+{
+    s_enabled = false;
+    s_self = 0;
+}
+
+Trace *Trace::self()
+{
+    if (!s_self)
+        s_self = new Trace;
+    return s_self;
+}
+
+Q_LLONG Trace::now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return Q_LLONG(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+void Trace::addSpan(const char *name, Q_LLONG start, Q_LLONG duration)
+{
+    if (!s_enabled)
+        return;
+
+    Event event;
+    event.name = name;
+    event.phase = 'X';
+    event.start = start;
+    event.duration = duration;
+    event.value = 0;
+    s_self->addEvent(event);
+}
+
+void Trace::addCounter(const char *name, double value)
+{
+    if (!s_enabled)
+        return;
+
+    Event event;
+    event.name = name;
+    event.phase = 'C';
+    event.start = now();
+    event.duration = 0;
+    event.value = value;
+    s_self->addEvent(event);
+}
+
+void Trace::addEvent(const Event &event)
+{
+    Event e = event;
+    e.thread = (unsigned long)QThread::currentThread();
+
+    QMutexLocker locker(&m_mutex);
+    m_events.push_back(e);
+}
+
+bool Trace::write(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(IO_WriteOnly))
+        return false;
+
+    QMutexLocker locker(&m_mutex);
+
+    QTextStream stream(&file);
+    stream << "{\"traceEvents\":[";
+
+    long pid = getpid();
+    QValueVector<Event>::ConstIterator it;
+    for (it = m_events.begin(); it != m_events.end(); ++it)
+    {
+        if (it != m_events.begin())
+            stream << ",";
+        stream << "\n{\"name\":\"" << (*it).name << "\",\"ph\":\"" << (*it).phase
+               << "\",\"ts\":" << QString::number((*it).start)
+               << ",\"pid\":" << pid << ",\"tid\":" << QString::number((*it).thread);
+
+        if ((*it).phase == 'X')
+            stream << ",\"dur\":" << QString::number((*it).duration);
+        else
+            stream << ",\"args\":{\"value\":" << QString::number((*it).value, 'g', 12) << "}";
+
+        stream << "}";
+    }
+
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    file.close();
+
+    return file.status() == IO_Ok;
+}
+
+void Trace::loadSettings()
+{
+    if (m_isEnvironmentOverride)
+        return;
+
+    bool enabled = Settings::self()->isTraceEnabled();
+
+    // Events collected so far belong to the old file
+    if (s_enabled && !enabled)
+    {
+        s_enabled = false;
+        flush();
+    }
+
+    m_fileName = Settings::self()->traceFile();
+    s_enabled = enabled;
+}
+
+void Trace::flush()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_events.isEmpty())
+            return;
+    }
+
+    QString fileName = !m_fileName.isEmpty() ? m_fileName : Settings::self()->traceFile();
+    if (!write(fileName))
+        kdError() << k_funcinfo << "Could not write trace to " << fileName << endl;
+
+    QMutexLocker locker(&m_mutex);
+    m_events.clear();
+}
+
+#include "trace.moc"
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,100 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <qobject.h>
+#include <qvaluevector.h>
+#include <qmutex.h>
+
+namespace Spiceplus {
+
+// Collects timed spans and counters and writes them in the Chrome trace
+// event format, to be viewed with chrome://tracing or Perfetto. Tracing is
+// off unless enabled in the settings or by the SPICEPLUS_TRACE environment
+// variable; a disabled span costs a single flag test.
+class Trace : public QObject
+{
+    Q_OBJECT
+
+private:
+    Trace();
+
+public:
+    ~Trace();
+
+    static Trace *self();
+
+    static bool isEnabled() { return s_enabled; }
+    static Q_LLONG now();
+
+    static void addSpan(const char *name, Q_LLONG start, Q_LLONG duration);
+    static void addCounter(const char *name, double value);
+
+    QString fileName() const { return m_fileName; }
+    bool write(const QString &fileName);
+
+public slots:
+    void loadSettings();
+    void flush();
+
+private:
+    struct Event
+    {
+        const char *name;
+        char phase;
+        Q_LLONG start;
+        Q_LLONG duration;
+        double value;
+        unsigned long thread;
+    };
+
+    void addEvent(const Event &event);
+
+    static Trace *s_self;
+    static bool s_enabled;
+
+    QValueVector<Event> m_events;
+    QMutex m_mutex;
+    QString m_fileName;
+    bool m_isEnvironmentOverride;
+};
+
+// Records the time between construction and destruction as a span.
+class TraceSpan
+{
+public:
+    TraceSpan(const char *name) : m_name(name), m_start(Trace::isEnabled() ? Trace::now() : -1) {}
+    ~TraceSpan()
+    {
+        if (m_start >= 0 && Trace::isEnabled())
+            Trace::addSpan(m_name, m_start, Trace::now() - m_start);
+    }
+
+private:
+    const char *m_name;
+    Q_LLONG m_start;
+};
+
+} // namespace Spiceplus
+
+#endif // TRACE_H
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,895 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <qptrlist.h>
+
+#include <klocale.h>
+
+#include "waveformexpression.h"
+#include "spicenumber.h"
+#include "trace.h"
+
+using namespace Spiceplus;
+
+//
+// WaveformExpression::Parser
+//
+
+// Parses the text into a tree that knows which nodes are complex, then
+// flattens the tree into passes.
+class WaveformExpression::Parser
+{
+public:
+    Parser(WaveformExpression *expression, const ResultTable &table, const QMap<QString, QString> &aliases);
+
+    struct Node
+    {
+        Opcode op;
+        bool isComplex;
+        int column;
+        double value;
+        Node *a;
+        Node *b;
+    };
+
+    // the whole text, or 0 with an errorString()
+    Node *parse();
+    // the temporary column the passes for the node leave its values in
+    int emitPass(Node *node);
+
+    QString errorString() const { return m_errorString; }
+
+private:
+    Node *parseSum();
+    Node *parseProduct();
+    Node *parseUnary();
+    Node *parsePower();
+    Node *parsePrimary();
+    Node *parseNumber();
+    Node *parseFunction(const QString &name, uint position);
+
+    Node *createNode(Opcode op, bool isComplex, Node *a = 0, Node *b = 0);
+    Node *createConstant(double value);
+    Node *createLoad(const QString &name, uint position);
+    Node *createOperation(Opcode op, Node *a, Node *b = 0);
+
+    int findColumn(const QString &name);
+    int addTemporary(bool isComplex);
+    int emit(Node *node, QValueVector<Instruction> &instructions);
+
+    static bool isColumnOp(Opcode op) { return op == Unwrap || op == Derivative || op == Integral; }
+
+    void skipSpace();
+    QChar peek() const { return m_pos < m_text.length() ? m_text[m_pos] : QChar(); }
+    bool expect(char c);
+    bool fail(const QString &errorString);
+
+    WaveformExpression *m_expression;
+    const ResultTable &m_table;
+    const QMap<QString, QString> &m_aliases;
+    QString m_text;
+    uint m_pos;
+    QPtrList<Node> m_nodes;
+    QString m_errorString;
+};
+
+WaveformExpression::Parser::Parser(WaveformExpression *expression, const ResultTable &table, const QMap<QString, QString> &aliases)
+    : m_expression(expression),
+      m_table(table),
+      m_aliases(aliases),
+      m_text(expression->m_text),
+      m_pos(0)
+{
+    m_nodes.setAutoDelete(true);
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::parse()
+{
+    Node *node = parseSum();
+    if (!node)
+        return 0;
+
+    skipSpace();
+    if (m_pos < m_text.length())
+    {
+        fail(i18n("Unexpected \"%1\" at column %2").arg(m_text.mid(m_pos)).arg(m_pos + 1));
+        return 0;
+    }
+    return node;
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::parseSum()
+{
+    Node *node = parseProduct();
+    while (node)
+    {
+        skipSpace();
+        if (peek() == '+' || peek() == '-')
+        {
+            Opcode op = peek() == '+' ? Add : Subtract;
+            ++m_pos;
+            Node *right = parseProduct();
+            node = right ? createOperation(op, node, right) : 0;
+        }
+        else
+            break;
+    }
+    return node;
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::parseProduct()
+{
+    Node *node = parseUnary();
+    while (node)
+    {
+        skipSpace();
+        if (peek() == '*' || peek() == '/')
+        {
+            Opcode op = peek() == '*' ? Multiply : Divide;
+            ++m_pos;
+            Node *right = parseUnary();
+            node = right ? createOperation(op, node, right) : 0;
+        }
+        else
+            break;
+    }
+    return node;
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::parseUnary()
+{
+    skipSpace();
+    if (peek() == '-')
+    {
+        ++m_pos;
+        Node *node = parseUnary();
+        return node ? createOperation(Negate, node) : 0;
+    }
+    if (peek() == '+')
+    {
+        ++m_pos;
+        return parseUnary();
+    }
+    return parsePower();
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::parsePower()
+{
+    Node *node = parsePrimary();
+    skipSpace();
+    if (!node || peek() != '^')
+        return node;
+
+    // -2^2 is -4, 2^-1 is 0.5 and 2^3^2 is 2^9
+    ++m_pos;
+    Node *exponent = parseUnary();
+    return exponent ? createOperation(Power, node, exponent) : 0;
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::parsePrimary()
+{
+    skipSpace();
+    uint start = m_pos;
+    QChar c = peek();
+
+    if (c.isDigit() || c == '.')
+        return parseNumber();
+
+    if (c == '(')
+    {
+        ++m_pos;
+        Node *node = parseSum();
+        return node && expect(')') ? node : 0;
+    }
+
+    if (c == '"')
+    {
+        int end = m_text.find('"', m_pos + 1);
+        if (end < 0)
+        {
+            fail(i18n("Missing closing quote for the name at column %1").arg(start + 1));
+            return 0;
+        }
+        QString name = m_text.mid(m_pos + 1, end - m_pos - 1);
+        m_pos = end + 1;
+        return createLoad(m_aliases.contains(name) ? m_aliases[name] : name, start);
+    }
+
+    if (c.isLetter() || c == '_')
+    {
+        while (peek().isLetterOrNumber() || peek() == '_' || peek() == '#')
+            ++m_pos;
+        QString name = m_text.mid(start, m_pos - start);
+
+        skipSpace();
+        if (peek() == '(')
+        {
+            Node *node = parseFunction(name.lower(), start);
+            if (node || !m_errorString.isNull())
+                return node;
+
+            // a vector like v(3) or v(3,2): the name with everything up to
+            // the matching parenthesis
+            uint depth = 0;
+            uint end = m_pos;
+            for (; end < m_text.length(); ++end)
+            {
+                if (m_text[end] == '(')
+                    ++depth;
+                else if (m_text[end] == ')' && --depth == 0)
+                    break;
+            }
+            if (end == m_text.length())
+            {
+                fail(i18n("Missing closing parenthesis for the one at column %1").arg(m_pos + 1));
+                return 0;
+            }
+            name += m_text.mid(m_pos, end + 1 - m_pos);
+            m_pos = end + 1;
+            return createLoad(name.remove(' '), start);
+        }
+
+        if (name.lower() == "pi")
+            return createConstant(M_PI);
+        return createLoad(name, start);
+    }
+
+    if (c.isNull())
+        fail(i18n("Unexpected end of the expression"));
+    else
+        fail(i18n("Unexpected \"%1\" at column %2").arg(c).arg(start + 1));
+    return 0;
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::parseNumber()
+{
+    // the mantissa, an exponent and then a scale factor and unit for
+    // SpiceNumber
+    uint start = m_pos;
+    while (peek().isDigit() || peek() == '.')
+        ++m_pos;
+    if (peek() == 'e' || peek() == 'E')
+    {
+        uint pos = m_pos + 1;
+        if (pos < m_text.length() && (m_text[pos] == '+' || m_text[pos] == '-'))
+            ++pos;
+        if (pos < m_text.length() && m_text[pos].isDigit())
+        {
+            m_pos = pos;
+            while (peek().isDigit())
+                ++m_pos;
+        }
+    }
+    while (peek().isLetter())
+        ++m_pos;
+
+    QString number = m_text.mid(start, m_pos - start);
+    double value;
+    if (!SpiceNumber::parse(number, value))
+    {
+        fail(i18n("Invalid number \"%1\" at column %2").arg(number).arg(start + 1));
+        return 0;
+    }
+    return createConstant(value);
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::parseFunction(const QString &name, uint position)
+{
+    static const struct
+    {
+        const char *name;
+        Opcode op;
+    } functions[] =
+    {
+        { "real", Real },
+        { "imag", Imag },
+        { "mag", Magnitude },
+        { "abs", Magnitude },
+        { "db", DB },
+        { "ph", Phase },
+        { "lin", Linear },
+        { "sqrt", Sqrt },
+        { "exp", Exp },
+        { "ln", Ln },
+        { "log10", Log10 },
+        { "unwrap", Unwrap },
+        { "deriv", Derivative },
+        { "integ", Integral },
+        // gd is deriv(unwrap(ph(x))) scaled to radians over radians per
+        // second, see below
+        { "gd", Derivative },
+        { 0, Load }
+    };
+
+    int function = 0;
+    while (functions[function].name && name != functions[function].name)
+        ++function;
+    // not a function but a vector
+    if (!functions[function].name)
+        return 0;
+
+    ++m_pos;
+    Node *argument = parseSum();
+    if (!argument || !expect(')'))
+        return 0;
+
+    Opcode op = functions[function].op;
+    if ((op == Derivative || op == Integral) && m_table.axisName().isNull())
+    {
+        fail(i18n("%1() at column %2 needs the axis of the results").arg(name).arg(position + 1));
+        return 0;
+    }
+
+    if (name == "gd")
+    {
+        Node *phase = createOperation(Unwrap, createOperation(Phase, argument));
+        return createOperation(Multiply, createOperation(Derivative, phase), createConstant(-1.0 / 360));
+    }
+
+    Node *node = createOperation(op, argument);
+    if (!node && m_errorString.isNull())
+        fail(i18n("%1() at column %2 needs a real argument").arg(name).arg(position + 1));
+    return node;
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::createNode(Opcode op, bool isComplex, Node *a, Node *b)
+{
+    Node *node = new Node;
+    node->op = op;
+    node->isComplex = isComplex;
+    node->column = -1;
+    node->value = 0;
+    node->a = a;
+    node->b = b;
+    m_nodes.append(node);
+    return node;
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::createConstant(double value)
+{
+    Node *node = createNode(Constant, false);
+    node->value = value;
+    return node;
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::createLoad(const QString &name, uint position)
+{
+    int column = findColumn(name);
+    if (column < 0)
+    {
+        fail(i18n("There is no vector \"%1\" (column %2)").arg(name).arg(position + 1));
+        return 0;
+    }
+
+    Node *node = createNode(Load, m_expression->m_columns[column].isComplex);
+    node->column = column;
+    return node;
+}
+
+WaveformExpression::Parser::Node *WaveformExpression::Parser::createOperation(Opcode op, Node *a, Node *b)
+{
+    bool isComplex = a->isComplex || (b && b->isComplex);
+    switch (op)
+    {
+    case Add:
+    case Subtract:
+    case Multiply:
+    case Divide:
+    case Negate:
+    case Derivative:
+    case Integral:
+        return createNode(op, isComplex, a, b);
+
+    case Real:
+    case Imag:
+    case Magnitude:
+    case DB:
+    case Phase:
+        return createNode(op, false, a);
+
+    case Unwrap:
+        // of the phase of a complex value
+        return createNode(op, false, a->isComplex ? createNode(Phase, false, a) : a);
+
+    case Power:
+        if (isComplex)
+        {
+            fail(i18n("Powers of complex values are not supported"));
+            return 0;
+        }
+        return createNode(op, false, a, b);
+
+    default:
+        // the rest of the functions are real only
+        return isComplex ? 0 : createNode(op, false, a);
+    }
+}
+
+int WaveformExpression::Parser::findColumn(const QString &name)
+{
+    QValueVector<Column> &columns = m_expression->m_columns;
+    for (uint i = 0; i < columns.count(); ++i)
+        if (columns[i].source != Column::Temporary && columns[i].name == name)
+            return i;
+
+    Column column;
+    column.name = name;
+    int vector = m_table.findVector(name);
+    if (vector >= 0)
+    {
+        column.source = Column::Vector;
+        column.isComplex = m_table.vectorType(vector) == ResultTable::Complex;
+    }
+    else if (name == m_table.axisName())
+        column.source = Column::Axis;
+    else if (m_table.contains("real(" + name + ")") && m_table.contains("imag(" + name + ")"))
+    {
+        // as printed by ".print ac real(x) imag(x)"
+        column.source = Column::SplitVector;
+        column.isComplex = true;
+        column.name = "real(" + name + ")";
+        column.imagName = "imag(" + name + ")";
+    }
+    else
+        return -1;
+
+    columns.push_back(column);
+    return columns.count() - 1;
+}
+
+int WaveformExpression::Parser::addTemporary(bool isComplex)
+{
+    Column column;
+    column.isComplex = isComplex;
+    m_expression->m_columns.push_back(column);
+    return m_expression->m_columns.count() - 1;
+}
+
+int WaveformExpression::Parser::emitPass(Node *node)
+{
+    Pass pass;
+    if (isColumnOp(node->op))
+    {
+        pass.columnOp = node->op;
+        pass.argument = node->a->op == Load ? node->a->column : emitPass(node->a);
+    }
+    else
+        emit(node, pass.instructions);
+
+    // after the passes for the arguments
+    pass.result = addTemporary(node->isComplex);
+    m_expression->m_passes.push_back(pass);
+    return pass.result;
+}
+
+int WaveformExpression::Parser::emit(Node *node, QValueVector<Instruction> &instructions)
+{
+    Instruction instruction;
+    instruction.op = node->op;
+    instruction.isComplex = node->isComplex;
+    instruction.value = node->value;
+
+    if (isColumnOp(node->op))
+    {
+        instruction.op = Load;
+        instruction.column = emitPass(node);
+    }
+    else if (node->op == Load)
+        instruction.column = node->column;
+    else
+    {
+        if (node->a)
+            instruction.a = emit(node->a, instructions);
+        if (node->b)
+            instruction.b = emit(node->b, instructions);
+    }
+
+    instructions.push_back(instruction);
+    return instructions.count() - 1;
+}
+
+void WaveformExpression::Parser::skipSpace()
+{
+    while (peek().isSpace())
+        ++m_pos;
+}
+
+bool WaveformExpression::Parser::expect(char c)
+{
+    skipSpace();
+    if (peek() == c)
+    {
+        ++m_pos;
+        return true;
+    }
+    return fail(i18n("Expected \"%1\" at column %2").arg(c).arg(m_pos + 1));
+}
+
+bool WaveformExpression::Parser::fail(const QString &errorString)
+{
+    // the innermost error is the one to report
+    if (m_errorString.isNull())
+        m_errorString = errorString;
+    return false;
+}
+
+//
+// WaveformExpression
+//
+
+WaveformExpression::WaveformExpression()
+    : m_isComplex(false)
+{
+}
+
+bool WaveformExpression::compile(const QString &text, const ResultTable &table, const QMap<QString, QString> &aliases)
+{
+    m_text = text;
+    m_isComplex = false;
+    m_columns.clear();
+    m_passes.clear();
+
+    Parser parser(this, table, aliases);
+    Parser::Node *root = parser.parse();
+    if (!root)
+    {
+        m_errorString = parser.errorString();
+        m_columns.clear();
+        return false;
+    }
+
+    m_isComplex = root->isComplex;
+    parser.emitPass(root);
+
+    uint numRegisters = 0;
+    for (uint i = 0; i < m_passes.count(); ++i)
+        numRegisters = QMAX(numRegisters, m_passes[i].instructions.count());
+    m_registers = QMemArray<double>((2 * numRegisters + 1) * ChunkSize);
+    memset(m_registers.data() + 2 * numRegisters * ChunkSize, 0, ChunkSize * sizeof(double));
+
+    m_errorString = QString::null;
+    return true;
+}
+
+bool WaveformExpression::evaluate(const ResultTable &table, QMemArray<double> &real, QMemArray<double> &imag)
+{
+    TraceSpan span("WaveformExpression::evaluate");
+
+    if (!isValid())
+    {
+        m_errorString = i18n("The expression is not compiled");
+        return false;
+    }
+
+    uint numRows = table.numRows();
+    m_values.resize(m_columns.count());
+    for (uint i = 0; i < m_columns.count(); ++i)
+    {
+        Column &column = m_columns[i];
+        Values &values = m_values[i];
+        values.imag = 0;
+
+        bool isMissing = false;
+        switch (column.source)
+        {
+        case Column::Vector:
+        {
+            int vector = table.findVector(column.name);
+            isMissing = vector < 0 || (table.vectorType(vector) == ResultTable::Complex) != column.isComplex;
+            if (!isMissing)
+            {
+                values.real = table.real(vector).data();
+                if (column.isComplex)
+                    values.imag = table.imag(vector).data();
+            }
+            break;
+        }
+
+        case Column::SplitVector:
+        {
+            int realVector = table.findVector(column.name);
+            int imagVector = table.findVector(column.imagName);
+            isMissing = realVector < 0 || imagVector < 0;
+            if (!isMissing)
+            {
+                values.real = table.real(realVector).data();
+                values.imag = table.real(imagVector).data();
+            }
+            break;
+        }
+
+        case Column::Axis:
+            isMissing = table.axisName() != column.name;
+            values.real = table.axis().data();
+            break;
+
+        case Column::Temporary:
+            // new arrays, those of the last evaluation may be in use
+            column.real = QMemArray<double>(numRows);
+            values.real = column.real.data();
+            if (column.isComplex)
+            {
+                column.imag = QMemArray<double>(numRows);
+                values.imag = column.imag.data();
+            }
+            break;
+        }
+
+        if (isMissing)
+        {
+            m_errorString = i18n("There is no vector \"%1\" in the results").arg(column.name);
+            return false;
+        }
+    }
+
+    const double *axis = table.axis().data();
+    for (uint i = 0; i < m_passes.count(); ++i)
+    {
+        const Pass &pass = m_passes[i];
+        if (!pass.instructions.isEmpty())
+        {
+            runPass(pass, numRows);
+            continue;
+        }
+
+        Column &result = m_columns[pass.result];
+        const Values &argument = m_values[pass.argument];
+        runColumnOp(pass.columnOp, axis, numRows, argument.real, result.real.data());
+        if (result.isComplex)
+            runColumnOp(pass.columnOp, axis, numRows, argument.imag, result.imag.data());
+    }
+
+    Column &result = m_columns[m_passes.back().result];
+    real = result.real;
+    imag = m_isComplex ? result.imag : QMemArray<double>();
+
+    // the temporaries are of no use until the next evaluation
+    for (uint i = 0; i < m_columns.count(); ++i)
+    {
+        m_columns[i].real = QMemArray<double>();
+        m_columns[i].imag = QMemArray<double>();
+    }
+
+    return true;
+}
+
+void WaveformExpression::runPass(const Pass &pass, uint numRows)
+{
+    uint numInstructions = pass.instructions.count();
+    double *registers = m_registers.data();
+    const double *zeros = registers + m_registers.size() - ChunkSize;
+    QValueVector<Values> regs(numInstructions);
+    Column &result = m_columns[pass.result];
+
+    for (uint start = 0; start < numRows; start += ChunkSize)
+    {
+        uint n = QMIN(ChunkSize, numRows - start);
+
+        for (uint i = 0; i < numInstructions; ++i)
+        {
+            const Instruction &instruction = pass.instructions[i];
+            double *outReal = registers + 2 * i * ChunkSize;
+            double *outImag = outReal + ChunkSize;
+            regs[i].real = outReal;
+            regs[i].imag = instruction.isComplex ? outImag : zeros;
+
+            // a real operand has zeros as its imaginary part
+            const double *ar = 0, *ai = 0, *br = 0, *bi = 0;
+            if (instruction.a >= 0)
+            {
+                ar = regs[instruction.a].real;
+                ai = regs[instruction.a].imag;
+            }
+            if (instruction.b >= 0)
+            {
+                br = regs[instruction.b].real;
+                bi = regs[instruction.b].imag;
+            }
+
+            uint k;
+            switch (instruction.op)
+            {
+            case Load:
+            {
+                const Values &values = m_values[instruction.column];
+                regs[i].real = values.real + start;
+                regs[i].imag = values.imag ? values.imag + start : zeros;
+                break;
+            }
+
+            case Constant:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = instruction.value;
+                break;
+
+            case Add:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = ar[k] + br[k];
+                if (instruction.isComplex)
+                    for (k = 0; k < n; ++k)
+                        outImag[k] = ai[k] + bi[k];
+                break;
+
+            case Subtract:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = ar[k] - br[k];
+                if (instruction.isComplex)
+                    for (k = 0; k < n; ++k)
+                        outImag[k] = ai[k] - bi[k];
+                break;
+
+            case Multiply:
+                if (instruction.isComplex)
+                {
+                    for (k = 0; k < n; ++k)
+                    {
+                        outReal[k] = ar[k] * br[k] - ai[k] * bi[k];
+                        outImag[k] = ar[k] * bi[k] + ai[k] * br[k];
+                    }
+                }
+                else
+                    for (k = 0; k < n; ++k)
+                        outReal[k] = ar[k] * br[k];
+                break;
+
+            case Divide:
+                if (instruction.isComplex)
+                {
+                    for (k = 0; k < n; ++k)
+                    {
+                        double d = br[k] * br[k] + bi[k] * bi[k];
+                        outReal[k] = (ar[k] * br[k] + ai[k] * bi[k]) / d;
+                        outImag[k] = (ai[k] * br[k] - ar[k] * bi[k]) / d;
+                    }
+                }
+                else
+                    for (k = 0; k < n; ++k)
+                        outReal[k] = ar[k] / br[k];
+                break;
+
+            case Power:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = pow(ar[k], br[k]);
+                break;
+
+            case Negate:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = -ar[k];
+                if (instruction.isComplex)
+                    for (k = 0; k < n; ++k)
+                        outImag[k] = -ai[k];
+                break;
+
+            // the parts are taken as they are
+            case Real:
+                regs[i].real = ar;
+                break;
+
+            case Imag:
+                regs[i].real = ai;
+                break;
+
+            // as in ACResponse
+            case Magnitude:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = sqrt(ar[k] * ar[k] + ai[k] * ai[k]);
+                break;
+
+            case DB:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = 10 * log10(ar[k] * ar[k] + ai[k] * ai[k]);
+                break;
+
+            case Phase:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = atan2(ai[k], ar[k]) * (180 / M_PI);
+                break;
+
+            case Linear:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = pow(10.0, ar[k] / 20);
+                break;
+
+            case Sqrt:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = sqrt(ar[k]);
+                break;
+
+            case Exp:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = exp(ar[k]);
+                break;
+
+            case Ln:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = log(ar[k]);
+                break;
+
+            case Log10:
+                for (k = 0; k < n; ++k)
+                    outReal[k] = log10(ar[k]);
+                break;
+
+            default:
+                // column operations have passes of their own
+                break;
+            }
+        }
+
+        const Values &last = regs[numInstructions - 1];
+        memcpy(result.real.data() + start, last.real, n * sizeof(double));
+        if (result.isComplex)
+            memcpy(result.imag.data() + start, last.imag, n * sizeof(double));
+    }
+}
+
+void WaveformExpression::runColumnOp(Opcode op, const double *axis, uint numRows, const double *in, double *out)
+{
+    if (numRows == 0)
+        return;
+
+    switch (op)
+    {
+    case Unwrap:
+    {
+        // in degrees, as in ACResponse
+        double offset = 0;
+        out[0] = in[0];
+        for (uint i = 1; i < numRows; ++i)
+        {
+            double step = in[i] + offset - out[i - 1];
+            if (step > 180)
+                offset -= 360;
+            else if (step < -180)
+                offset += 360;
+            out[i] = in[i] + offset;
+        }
+        break;
+    }
+
+    case Derivative:
+        if (numRows < 2)
+        {
+            out[0] = 0;
+            break;
+        }
+
+        // one-sided at the ends, central everywhere else
+        out[0] = (in[1] - in[0]) / (axis[1] - axis[0]);
+        for (uint i = 1; i + 1 < numRows; ++i)
+            out[i] = (in[i + 1] - in[i - 1]) / (axis[i + 1] - axis[i - 1]);
+        out[numRows - 1] = (in[numRows - 1] - in[numRows - 2]) / (axis[numRows - 1] - axis[numRows - 2]);
+        break;
+
+    case Integral:
+        // trapezoids
+        out[0] = 0;
+        for (uint i = 1; i < numRows; ++i)
+            out[i] = out[i - 1] + 0.5 * (axis[i] - axis[i - 1]) * (in[i] + in[i - 1]);
+        break;
+
+    default:
+        break;
+    }
+}
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,161 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef WAVEFORMEXPRESSION_H
+#define WAVEFORMEXPRESSION_H
+
+#include <qstring.h>
+#include <qmap.h>
+#include <qmemarray.h>
+#include <qvaluevector.h>
+
+#include "resulttable.h"
+
+namespace Spiceplus {
+
+// A quantity derived from the vectors of a ResultTable, such as
+// "db(v(3)/v(2))" or "gd(v(out))". The text is compiled once against the
+// columns of a table and can then be evaluated over any table with the same
+// vectors, like the tables of successive runs of an analysis.
+//
+// Operators are + - * / and ^, numbers are in SPICE notation ("4.7k").
+// A vector is named as in the table, like v(3) or i(vam1), or in double
+// quotes, which also takes the aliases given to compile(). A complex vector
+// may come as the two vectors "real(x)" and "imag(x)". The functions are
+//
+//   real imag mag abs db ph    the parts, magnitude, 20 log10 of the
+//                              magnitude and the phase in degrees
+//   lin                        dB to linear, 10^(x/20)
+//   sqrt exp ln log10          of real values
+//   unwrap                     the phase in degrees without jumps
+//   deriv integ                over the axis, integ starting at zero
+//   gd                         the group delay -d(phase)/d(omega)
+//
+// Values are worked out a chunk of rows at a time, one loop per operation,
+// so that the operands stay in the cache. deriv, integ and unwrap need all
+// rows of their argument and work on whole columns in between.
+class WaveformExpression
+{
+public:
+    WaveformExpression();
+
+    // False with an errorString() if the text doesn't make sense for the
+    // columns of the table, which may have no rows yet. An alias maps a
+    // name, like that of a meter, to the name of a vector.
+    bool compile(const QString &text, const ResultTable &table, const QMap<QString, QString> &aliases = QMap<QString, QString>());
+
+    bool isValid() const { return !m_passes.isEmpty(); }
+    QString text() const { return m_text; }
+    bool isComplex() const { return m_isComplex; }
+
+    // The value for each of the numRows() rows of the table; imag is left
+    // empty if the expression is real. False if a vector went missing.
+    bool evaluate(const ResultTable &table, QMemArray<double> &real, QMemArray<double> &imag);
+
+    QString errorString() const { return m_errorString; }
+
+    // rows worked out at a time
+    static const uint ChunkSize = 256;
+
+private:
+    class Parser;
+    friend class Parser;
+
+    enum Opcode
+    {
+        Load, Constant,
+        Add, Subtract, Multiply, Divide, Power, Negate,
+        Real, Imag, Magnitude, DB, Phase, Linear, Sqrt, Exp, Ln, Log10,
+        // on whole columns
+        Unwrap, Derivative, Integral
+    };
+
+    // A vector of the table, the axis, or a column worked out by an
+    // earlier pass.
+    struct Column
+    {
+        enum Source { Vector, SplitVector, Axis, Temporary };
+
+        Column() : source(Temporary), isComplex(false) {}
+
+        Source source;
+        bool isComplex;
+        // the vector, or the real part of a split one
+        QString name;
+        QString imagName;
+        // the values of a temporary column
+        QMemArray<double> real;
+        QMemArray<double> imag;
+    };
+
+    // In a pass each instruction writes the register of its own index.
+    struct Instruction
+    {
+        Instruction() : op(Load), isComplex(false), a(-1), b(-1), column(-1), value(0) {}
+
+        Opcode op;
+        bool isComplex;
+        int a;
+        int b;
+        // the column of a Load
+        int column;
+        double value;
+    };
+
+    // A pass works out the instructions chunk by chunk and keeps the last
+    // register in a temporary column. A pass with a column operation
+    // instead applies it to whole columns.
+    struct Pass
+    {
+        Pass() : columnOp(Load), argument(-1), result(-1) {}
+
+        QValueVector<Instruction> instructions;
+        Opcode columnOp;
+        int argument;
+        int result;
+    };
+
+    // where the values of a column are during evaluate(); imag is null for
+    // a real column
+    struct Values
+    {
+        const double *real;
+        const double *imag;
+    };
+
+    void runPass(const Pass &pass, uint numRows);
+    static void runColumnOp(Opcode op, const double *axis, uint numRows, const double *in, double *out);
+
+    QString m_text;
+    bool m_isComplex;
+    QValueVector<Column> m_columns;
+    QValueVector<Pass> m_passes;
+    QValueVector<Values> m_values;
+    // the real and imaginary part of each register of the longest pass,
+    // ChunkSize values each, then a chunk of zeros as the imaginary part
+    // of real registers
+    QMemArray<double> m_registers;
+    QString m_errorString;
+};
+
+} // namespace Spiceplus
+
+#endif // WAVEFORMEXPRESSION_H
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,334 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+
+#include <qglobal.h>
+#include <qstring.h>
+
+#include "waveformexpression.h"
+#include "resulttable.h"
+
+using namespace Spiceplus;
+
+static int s_numFailures = 0;
+
+static void check(bool condition, const char *description)
+{
+    if (!condition)
+    {
+        qWarning("FAIL: %s", description);
+        ++s_numFailures;
+    }
+}
+
+static bool isClose(double value, double expected, double tolerance = 1e-12)
+{
+    return fabs(value - expected) <= tolerance * QMAX(fabs(expected), 1.0);
+}
+
+static QMemArray<double> ramp(uint numRows, double first, double step)
+{
+    QMemArray<double> values(numRows);
+    for (uint row = 0; row < numRows; ++row)
+        values[row] = first + row * step;
+
+    return values;
+}
+
+// compiles and evaluates the text, with a warning if that fails
+static bool evaluate(const char *text, const ResultTable &table, QMemArray<double> &real, QMemArray<double> &imag)
+{
+    WaveformExpression expression;
+    if (!expression.compile(text, table) || !expression.evaluate(table, real, imag))
+    {
+        qWarning("\"%s\": %s", text, expression.errorString().latin1());
+        return false;
+    }
+
+    return real.size() == table.numRows() && imag.size() == (expression.isComplex() ? table.numRows() : 0);
+}
+
+// the value of a real expression in each row of the table
+static void checkValue(const char *text, const ResultTable &table, double expected)
+{
+    QMemArray<double> real, imag;
+    bool ok = evaluate(text, table, real, imag) && imag.size() == 0;
+    for (uint row = 0; row < real.size() && ok; ++row)
+        ok = isClose(real[row], expected);
+
+    if (!ok && real.size() > 0)
+        qWarning("FAIL: \"%s\" is %.17g, not %.17g", text, real[0], expected);
+    check(ok, "value");
+}
+
+static void testPrecedence()
+{
+    ResultTable table;
+    table.setAxis("time", ramp(3, 0, 1));
+
+    // the power binds tighter than the sign before it, the one after it
+    // belongs to the exponent, and powers group to the right
+    checkValue("-2^2", table, -4);
+    checkValue("2^-1", table, 0.5);
+    checkValue("2^3^2", table, 512);
+    checkValue("(2^3)^2", table, 64);
+    checkValue("(-2)^2", table, 4);
+    checkValue("2*3^2", table, 18);
+    checkValue("-2^-2", table, -0.25);
+    checkValue("1-2-3", table, -4);
+    checkValue("8/2/2", table, 2);
+    checkValue("1+2*3", table, 7);
+    checkValue("2k/4", table, 500);
+}
+
+static void testSplitVector()
+{
+    // as printed by ".print ac real(v(out)) imag(v(out))"
+    ResultTable table;
+    table.setAxis("frequency", ramp(4, 1, 1));
+    table.addVector("real(v(out))", ramp(4, 3, 1));
+    table.addVector("imag(v(out))", ramp(4, -4, 2));
+    table.addVector("v(in)", ramp(4, 1, 0), ramp(4, 1, 0));
+
+    QMemArray<double> real, imag;
+    bool ok = evaluate("v(out)", table, real, imag) && imag.size() == 4;
+    for (uint row = 0; row < 4 && ok; ++row)
+        ok = real[row] == 3 + row && imag[row] == -4 + 2.0 * row;
+    check(ok, "split vector as a complex one");
+
+    // 3-4j over 1+j is -0.5-3.5j
+    ok = evaluate("v(out)/v(in)", table, real, imag) && imag.size() == 4;
+    check(ok && isClose(real[0], -0.5) && isClose(imag[0], -3.5), "split vector in complex arithmetic");
+
+    ok = evaluate("mag(v(out))", table, real, imag) && imag.size() == 0;
+    check(ok && isClose(real[0], 5), "magnitude of a split vector");
+
+    ok = evaluate("real(v(out))*imag(v(out))", table, real, imag) && imag.size() == 0;
+    check(ok && isClose(real[0], -12) && isClose(real[3], 12), "parts of a split vector");
+}
+
+static void testUnwrap()
+{
+    // a phase falling by 7 degrees a row through -180 and on to -700, and
+    // one rising through +180
+    const uint numRows = 101;
+    QMemArray<double> fallingReal(numRows), fallingImag(numRows), risingReal(numRows), risingImag(numRows);
+    for (uint row = 0; row < numRows; ++row)
+    {
+        double phase = -7.0 * row * M_PI / 180;
+        fallingReal[row] = cos(phase);
+        fallingImag[row] = sin(phase);
+        risingReal[row] = cos(-phase);
+        risingImag[row] = sin(-phase);
+    }
+
+    ResultTable table;
+    table.setAxis("frequency", ramp(numRows, 1, 1));
+    table.addVector("v(falling)", fallingReal, fallingImag);
+    table.addVector("v(rising)", risingReal, risingImag);
+
+    QMemArray<double> real, imag;
+    bool ok = evaluate("ph(v(falling))", table, real, imag);
+    bool isWrapped = false;
+    for (uint row = 0; row < numRows && ok; ++row)
+        isWrapped = isWrapped || real[row] > 0;
+    check(ok && isWrapped, "ph() wraps at -180 degrees");
+
+    const char *texts[] = { "unwrap(ph(v(falling)))", "unwrap(v(falling))" };
+    for (uint i = 0; i < 2; ++i)
+    {
+        ok = evaluate(texts[i], table, real, imag) && imag.size() == 0;
+        for (uint row = 0; row < numRows && ok; ++row)
+            ok = isClose(real[row], -7.0 * row, 1e-9);
+        check(ok, "unwrapped falling phase");
+    }
+
+    ok = evaluate("unwrap(v(rising))", table, real, imag);
+    for (uint row = 0; row < numRows && ok; ++row)
+        ok = isClose(real[row], 7.0 * row, 1e-9);
+    check(ok, "unwrapped rising phase");
+}
+
+static void testDerivativeIntegral()
+{
+    // 3t + 1 and t^2 on an even grid, where the differences are exact
+    const uint numRows = 50;
+    const double step = 0.125;
+    QMemArray<double> line(numRows), square(numRows);
+    for (uint row = 0; row < numRows; ++row)
+    {
+        double t = row * step;
+        line[row] = 3 * t + 1;
+        square[row] = t * t;
+    }
+
+    ResultTable table;
+    table.setAxis("time", ramp(numRows, 0, step));
+    table.addVector("v(line)", line);
+    table.addVector("v(square)", square);
+
+    checkValue("deriv(v(line))", table, 3);
+    checkValue("deriv(time)", table, 1);
+
+    QMemArray<double> real, imag;
+    bool ok = evaluate("deriv(v(square))", table, real, imag);
+    // central differences inside, one-sided ones at the ends
+    for (uint row = 1; row + 1 < numRows && ok; ++row)
+        ok = isClose(real[row], 2 * row * step);
+    ok = ok && isClose(real[0], step) && isClose(real[numRows - 1], (2 * numRows - 3) * step);
+    check(ok, "derivative of a square");
+
+    // trapezoids are exact for a straight line
+    ok = evaluate("integ(v(line))", table, real, imag);
+    for (uint row = 0; row < numRows && ok; ++row)
+    {
+        double t = row * step;
+        ok = isClose(real[row], 1.5 * t * t + t);
+    }
+    check(ok, "integral of a ramp");
+
+    ok = evaluate("deriv(integ(v(line)))", table, real, imag);
+    for (uint row = 1; row + 1 < numRows && ok; ++row)
+        ok = isClose(real[row], line[row]);
+    check(ok, "derivative of the integral");
+
+    ResultTable noAxis;
+    noAxis.addVector("v(line)", line);
+    WaveformExpression expression;
+    check(!expression.compile("deriv(v(line))", noAxis), "deriv() without an axis rejected");
+}
+
+static void testGroupDelay()
+{
+    // a one-pole RC low pass, 1 / (1 + jwRC), has a group delay of
+    // RC / (1 + (wRC)^2)
+    const double rc = 1e-3;
+    const uint numRows = 2001;
+    QMemArray<double> frequencies = ramp(numRows, 0, 1);
+    QMemArray<double> real(numRows), imag(numRows);
+    for (uint row = 0; row < numRows; ++row)
+    {
+        double wrc = 2 * M_PI * frequencies[row] * rc;
+        real[row] = 1 / (1 + wrc * wrc);
+        imag[row] = -wrc / (1 + wrc * wrc);
+    }
+
+    ResultTable table;
+    table.setAxis("frequency", frequencies);
+    table.addVector("v(out)", real, imag);
+
+    QMemArray<double> delay, delayImag;
+    bool ok = evaluate("gd(v(out))", table, delay, delayImag) && delayImag.size() == 0;
+    // central differences over 1 Hz steps, left out at the ends
+    for (uint row = 1; row + 1 < numRows && ok; ++row)
+    {
+        double wrc = 2 * M_PI * frequencies[row] * rc;
+        double expected = rc / (1 + wrc * wrc);
+        ok = fabs(delay[row] - expected) <= 1e-4 * expected;
+    }
+    check(ok, "group delay of an RC low pass");
+
+    // a gain doesn't delay
+    ok = evaluate("gd(v(out)*2)-gd(v(out))", table, delay, delayImag);
+    for (uint row = 0; row < numRows && ok; ++row)
+        ok = fabs(delay[row]) < 1e-12 * rc;
+    check(ok, "group delay independent of gain");
+}
+
+// the rows on either side of the end of a chunk
+static void testChunks()
+{
+    const uint counts[] =
+    {
+        1, 2, WaveformExpression::ChunkSize - 1, WaveformExpression::ChunkSize, WaveformExpression::ChunkSize + 1,
+        2 * WaveformExpression::ChunkSize + 1
+    };
+
+    for (uint i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+    {
+        uint numRows = counts[i];
+        ResultTable table;
+        table.setAxis("time", ramp(numRows, 0, 1));
+        table.addVector("v(a)", ramp(numRows, 1, 1));
+        table.addVector("v(c)", ramp(numRows, 0, 1), ramp(numRows, 1, 0));
+
+        // a chunked pass, a pass of its own for integ and one after it
+        QMemArray<double> real, imag;
+        bool ok = evaluate("v(a)*2+1-integ(time)/v(a)", table, real, imag) && imag.size() == 0;
+        for (uint row = 0; row < numRows && ok; ++row)
+            ok = isClose(real[row], 2.0 * (row + 1) + 1 - 0.5 * row * row / (row + 1));
+        check(ok, "real rows at the ends of chunks");
+
+        // (t + j) * 2j = -2 + 2tj
+        ok = evaluate("v(c)*(v(c)-real(v(c)))*2", table, real, imag) && imag.size() == numRows;
+        for (uint row = 0; row < numRows && ok; ++row)
+            ok = isClose(real[row], -2) && isClose(imag[row], 2.0 * row);
+        check(ok, "complex rows at the ends of chunks");
+
+        if (!ok)
+            qWarning("with %u rows", numRows);
+    }
+}
+
+static void testErrors()
+{
+    ResultTable table;
+    table.setAxis("time", ramp(2, 0, 1));
+    table.addVector("v(a)", ramp(2, 1, 1));
+    table.addVector("v(c)", ramp(2, 0, 1), ramp(2, 1, 0));
+
+    const char *texts[] = { "", "v(b)", "db(v(a)", "1 2", "sqrt(v(c))", "v(c)^2", "2^" };
+    for (uint i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i)
+    {
+        WaveformExpression expression;
+        bool ok = !expression.compile(texts[i], table) && !expression.errorString().isEmpty();
+        if (!ok)
+            qWarning("FAIL: \"%s\" compiled", texts[i]);
+        check(ok, "invalid expression rejected");
+    }
+
+    // a vector missing from later results
+    WaveformExpression expression;
+    ResultTable other;
+    other.setAxis("time", ramp(2, 0, 1));
+    QMemArray<double> real, imag;
+    check(expression.compile("v(a)+1", table) && !expression.evaluate(other, real, imag), "missing vector reported");
+}
+
+int main()
+{
+    testPrecedence();
+    testSplitVector();
+    testUnwrap();
+    testDerivativeIntegral();
+    testGroupDelay();
+    testChunks();
+    testErrors();
+
+    if (s_numFailures > 0)
+    {
+        qWarning("%d checks failed", s_numFailures);
+        return 1;
+    }
+
+    return 0;
+}
+
+// vim: ts=4 sw=4 et
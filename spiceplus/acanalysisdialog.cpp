@@ -22,221 +22,361 @@
 #include <klocale.h>
 
 #include "acanalysisdialog.h"
+#include "acanalysisrun.h"
+#include "acresponse.h"
 #include "schematic.h"
 #include "schematicview.h"
 #include "plot.h"
-#include "settings.h"
-#include "spiceprocess.h"
+#include "plotcurve.h"
+#include "resulttable.h"
+#include "trace.h"
 
 using namespace Spiceplus;
 
 //
-// ACAnalysisBodeDialog
+// ACAnalysisDialog
 //
 
-ACAnalysisBodeDialog::ACAnalysisBodeDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const Meter &meter)
+ACAnalysisDialog::ACAnalysisDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const MeterList &meters)
     : AnalysisDialog(view),
       m_startFrequency(startFrequency),
       m_stopFrequency(stopFrequency),
-      m_meter(meter),
-      m_magnitudeCurve(0),
-      m_phaseCurve(0)
+      m_meters(meters),
+      m_run(0)
 {
-    setCaption(i18n("Bode Plot %1").arg(m_meter.name()));
+}
 
-    m_magnitudePlot = new Plot(centralWidget());
-    m_magnitudePlot->setAxisOptions(QwtPlot::xBottom, QwtAutoScale::Logarithmic);
-    m_magnitudePlot->setAxisTitle(QwtPlot::xBottom, "Frequency [Hz]");
-    m_magnitudePlot->setAxisTitle(QwtPlot::yLeft, "Magnitude [dB]");
-    m_plotLayout->addWidget(m_magnitudePlot);
-    m_phasePlot = new Plot(centralWidget());
-    m_phasePlot->setAxisOptions(QwtPlot::xBottom, QwtAutoScale::Logarithmic);
-    m_phasePlot->setAxisTitle(QwtPlot::xBottom, "Frequency [Hz]");
-    m_phasePlot->setAxisTitle(QwtPlot::yLeft, "Phase [deg]");
-    m_plotLayout->addWidget(m_phasePlot);
+ACAnalysisDialog::~ACAnalysisDialog()
+{
+    releaseRun();
 }
 
-bool ACAnalysisBodeDialog::runAnalysis()
+bool ACAnalysisDialog::runAnalysis()
 {
+    // the built-in solver names its vectors like SPICE
+    m_meterCmds.clear();
+    for (MeterList::Iterator it = m_meters.begin(); it != m_meters.end(); ++it)
+    {
+        QString meterCmd = (*it).createCommand(m_view->schematic());
+        if (meterCmd.isNull())
+        {
+            m_errorString = (*it).errorString();
+            return false;
+        }
+        m_meterCmds.append(meterCmd);
+    }
+
+    ResultTable table;
+    if (solveAC(m_startFrequency, m_stopFrequency, m_meters, table))
+    {
+        releaseRun();
+        plotData(table);
+        return true;
+    }
+
     QString cmdList = m_view->schematic()->createCommandList();
     if (cmdList.isNull())
     {
         m_errorString = m_view->schematic()->errorString();
         return false;
     }
+    cmdList += createSaveCommand(m_meters);
 
-    QString meterCmd = m_meter.createCommand(m_view->schematic());
-    if (meterCmd.isNull())
-    {
-        m_errorString = m_meter.errorString();
+    ACAnalysisRun *run = ACAnalysisRun::acquire(cmdList, m_meterCmds, m_startFrequency, m_stopFrequency,
+                                                acNumPointsPerDecade(), m_errorString);
+    if (!run)
         return false;
-    }
 
-    cmdList += ".control\n"
-               "set nobreak\n"
-               "set units=degrees\n"
-               ".endc\n"
-               ".ac dec " + QString::number(Settings::self()->acAnalysisNumPointsPerDecade()) + " "
-                          + m_startFrequency + " " + m_stopFrequency + "\n"
-               ".print ac db(" + meterCmd + ") ph(" + meterCmd + ")\n"
-               ".end\n";
+    // released only now, so that asking for the same run again keeps it
+    releaseRun();
+    m_run = run;
 
-    if (!m_spiceProcess->start(cmdList, 5))
+    if (m_run->isRunning())
     {
-        m_errorString = m_spiceProcess->errorString();
-        return false;
+        connect(m_run, SIGNAL(finished()), SLOT(finishRun()));
+        connect(m_run, SIGNAL(failed(const QString &, const QString &)), SLOT(displayErrorMessage(const QString &, const QString &)));
     }
+    else
+        plotRun();
 
     return true;
 }
 
+bool ACAnalysisDialog::isAnalysisRunning() const
+{
+    return AnalysisDialog::isAnalysisRunning() || (m_run && m_run->isRunning());
+}
 
-void ACAnalysisBodeDialog::plotData(const QValueVector<QMemArray<double> > &table)
+void ACAnalysisDialog::cancelAnalysis()
 {
-    if (!m_magnitudeCurve)
+    // a run shared with other dialogs goes on for them
+    releaseRun();
+    AnalysisDialog::cancelAnalysis();
+}
+
+void ACAnalysisDialog::createCurves(Plot *plot, QValueVector<QwtPlotCurve *> &curves)
+{
+    uint numMeters = m_meters.count();
+    if (numMeters > 1)
     {
-        m_magnitudeCurve = new QwtPlotCurve(m_magnitudePlot);
-        m_magnitudeCurve->setPen(Qt::red);
-        m_magnitudePlot->insertCurve(m_magnitudeCurve);
+        plot->setAutoLegend(true);
+        plot->enableLegend(true);
     }
-    m_magnitudeCurve->setData(table[1], table[3]);
 
-    if (!m_phaseCurve)
+    uint index = 0;
+    for (MeterList::ConstIterator it = m_meters.begin(); it != m_meters.end(); ++it, ++index)
     {
-        m_phaseCurve = new QwtPlotCurve(m_phasePlot);
-        m_phaseCurve->setPen(Qt::red);
-        m_phasePlot->insertCurve(m_phaseCurve);
+        QColor color = Qt::red;
+        if (numMeters > 1)
+            color.setHsv(300 * index / (numMeters - 1), 255, 200);
+
+        QwtPlotCurve *curve = new PlotCurve(plot, (*it).name());
+        curve->setPen(color);
+        plot->insertCurve(curve);
+        curves.push_back(curve);
     }
-    m_phaseCurve->setData(table[1], table[4]);
+}
 
-    m_magnitudePlot->replot();
-    m_phasePlot->replot();
+void ACAnalysisDialog::plotData(const ResultTable &table)
+{
+    QValueVector<ACResponse> responses;
+    for (QStringList::ConstIterator it = m_meterCmds.begin(); it != m_meterCmds.end(); ++it)
+        responses.push_back(ACResponse(table, *it));
+    plotTraces(m_meters, table);
+    plotResponses(responses);
+    storeResponses(responses);
+}
+
+void ACAnalysisDialog::plotRun()
+{
+    QValueVector<ACResponse> responses;
+    for (QStringList::ConstIterator it = m_meterCmds.begin(); it != m_meterCmds.end(); ++it)
+        responses.push_back(m_run->response(*it));
+    plotTraces(m_meters, m_run->table());
+    plotResponses(responses);
+
+    if (!m_run->isStored())
+    {
+        storeResponses(responses);
+        m_run->setStored();
+    }
+}
+
+void ACAnalysisDialog::finishRun()
+{
+    plotRun();
+    // only a run that was waited for took the time of an analysis
+    measureRun();
+}
+
+void ACAnalysisDialog::overlayRun(const ResultTable &table, const QString &label)
+{
+    QValueVector<ACResponse> responses;
+    for (QStringList::ConstIterator it = m_meterCmds.begin(); it != m_meterCmds.end(); ++it)
+        responses.push_back(ACResponse(table, *it));
+    overlayResponses(responses, label);
+}
+
+void ACAnalysisDialog::plotTrace(uint index, const QString &title, const ResultTable &table,
+                                 const QMemArray<double> &real, const QMemArray<double> &imag)
+{
+    if (imag.isEmpty())
+        plotRealTrace(index, title, table.axis(), real);
+    else
+        plotComplexTrace(index, title, ACResponse(table.axis(), real, imag));
+}
+
+void ACAnalysisDialog::storeResponses(const QValueVector<ACResponse> &responses)
+{
+    ResultTable table;
+    for (uint i = 0; i < responses.size(); ++i)
+    {
+        if (responses[i].count() == 0)
+            continue;
+        if (table.axisName().isNull())
+            table.setAxis("frequency", responses[i].frequencies());
+        table.addVector(m_meterCmds[i], responses[i].real(), responses[i].imag());
+    }
+    storeRun(m_meters, table);
+}
+
+void ACAnalysisDialog::releaseRun()
+{
+    if (!m_run)
+        return;
+
+    m_run->disconnect(this);
+    m_run->release();
+    m_run = 0;
 }
 
 //
-// ACAnalysisNyquistDialog
+// ACAnalysisBodeDialog
 //
 
-ACAnalysisNyquistDialog::ACAnalysisNyquistDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const Meter &meter)
-    : AnalysisDialog(view),
-      m_startFrequency(startFrequency),
-      m_stopFrequency(stopFrequency),
-      m_meter(meter),
-      m_curve(0)
+ACAnalysisBodeDialog::ACAnalysisBodeDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const MeterList &meters)
+    : ACAnalysisDialog(view, startFrequency, stopFrequency, meters)
 {
-    setCaption(i18n("Nyquist Plot %1").arg(m_meter.name()));
+    setCaption(i18n("Bode Plot %1").arg(Meter::names(m_meters)));
 
-    m_plot = new Plot(centralWidget());
-    m_plot->setAxisTitle(QwtPlot::xBottom, "Real [" + m_meter.shortUnit() + "]");
-    m_plot->setAxisTitle(QwtPlot::yLeft, "Imag [" + m_meter.shortUnit() + "]");
-    m_plotLayout->addWidget(m_plot);
+    m_magnitudePlot = new Plot(centralWidget());
+    m_magnitudePlot->setAxisOptions(QwtPlot::xBottom, QwtAutoScale::Logarithmic);
+    m_magnitudePlot->setAxisTitle(QwtPlot::xBottom, "Frequency [Hz]");
+    m_magnitudePlot->setAxisTitle(QwtPlot::yLeft, "Magnitude [dB]");
+    createCurves(m_magnitudePlot, m_magnitudeCurves);
+    m_plotLayout->addWidget(m_magnitudePlot);
+    m_phasePlot = new Plot(centralWidget());
+    m_phasePlot->setAxisOptions(QwtPlot::xBottom, QwtAutoScale::Logarithmic);
+    m_phasePlot->setAxisTitle(QwtPlot::xBottom, "Frequency [Hz]");
+    m_phasePlot->setAxisTitle(QwtPlot::yLeft, "Phase [deg]");
+    createCurves(m_phasePlot, m_phaseCurves);
+    m_plotLayout->addWidget(m_phasePlot);
 }
 
-bool ACAnalysisNyquistDialog::runAnalysis()
+void ACAnalysisBodeDialog::plotResponses(const QValueVector<ACResponse> &responses)
 {
-    QString cmdList = m_view->schematic()->createCommandList();
-    if (cmdList.isNull())
+    TraceSpan span("ACAnalysisBodeDialog::plotResponses");
+
+    for (uint i = 0; i < responses.size(); ++i)
     {
-        m_errorString = m_view->schematic()->errorString();
-        return false;
+        m_magnitudeCurves[i]->setData(responses[i].frequencies(), responses[i].magnitudeDB());
+        m_phaseCurves[i]->setData(responses[i].frequencies(), responses[i].phase());
     }
 
-    QString meterCmd = m_meter.createCommand(m_view->schematic());
-    if (meterCmd.isNull())
+    m_magnitudePlot->replot();
+    m_phasePlot->replot();
+}
+
+void ACAnalysisBodeDialog::overlayResponses(const QValueVector<ACResponse> &responses, const QString &label)
+{
+    uint index = 0;
+    for (MeterList::ConstIterator it = m_meters.begin(); it != m_meters.end(); ++it, ++index)
     {
-        m_errorString = m_meter.errorString();
-        return false;
+        const ACResponse &response = responses[index];
+        if (response.count() == 0)
+            continue;
+
+        QString title = (*it).name() + " (" + label + ")";
+        addOverlayCurve(m_magnitudePlot, index, m_meters.count(), title)->setData(response.frequencies(), response.magnitudeDB());
+        addOverlayCurve(m_phasePlot, index, m_meters.count(), title)->setData(response.frequencies(), response.phase());
     }
 
-    cmdList += ".control\n"
-               "set nobreak\n"
-               ".endc\n"
-               ".ac dec " + QString::number(Settings::self()->acAnalysisNumPointsPerDecade()) + " "
-                          + m_startFrequency + " " + m_stopFrequency + "\n"
-               ".print ac real(" + meterCmd + ") imag(" + meterCmd + ")\n"
-               ".end\n";
+    m_magnitudePlot->replot();
+    m_phasePlot->replot();
+}
 
-    m_spiceProcess->start(cmdList, 5);
+void ACAnalysisBodeDialog::plotRealTrace(uint index, const QString &title, const QMemArray<double> &frequencies, const QMemArray<double> &values)
+{
+    // in units of its own, like a group delay in seconds, so on an axis
+    // of its own; removeTraceCurves() hides it again
+    QwtPlotCurve *curve = addTraceCurve(m_magnitudePlot, index, title);
+    curve->setAxis(QwtPlot::xBottom, QwtPlot::yRight);
+    curve->setData(frequencies, values);
+    m_magnitudePlot->enableAxis(QwtPlot::yRight);
+    m_magnitudePlot->setAxisTitle(QwtPlot::yRight, title);
+}
 
-    return true;
+void ACAnalysisBodeDialog::plotComplexTrace(uint index, const QString &title, const ACResponse &response)
+{
+    addTraceCurve(m_magnitudePlot, index, title)->setData(response.frequencies(), response.magnitudeDB());
+    addTraceCurve(m_phasePlot, index, title)->setData(response.frequencies(), response.phase());
 }
 
+//
+// ACAnalysisNyquistDialog
+//
 
-void ACAnalysisNyquistDialog::plotData(const QValueVector<QMemArray<double> > &table)
+ACAnalysisNyquistDialog::ACAnalysisNyquistDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const MeterList &meters)
+    : ACAnalysisDialog(view, startFrequency, stopFrequency, meters)
 {
-    if (!m_curve)
+    setCaption(i18n("Nyquist Plot %1").arg(Meter::names(m_meters)));
+
+    m_plot = new Plot(centralWidget());
+    m_plot->setAxisTitle(QwtPlot::xBottom, "Real [" + Meter::shortUnits(m_meters) + "]");
+    m_plot->setAxisTitle(QwtPlot::yLeft, "Imag [" + Meter::shortUnits(m_meters) + "]");
+    createCurves(m_plot, m_curves);
+    m_plotLayout->addWidget(m_plot);
+}
+
+void ACAnalysisNyquistDialog::plotResponses(const QValueVector<ACResponse> &responses)
+{
+    TraceSpan span("ACAnalysisNyquistDialog::plotResponses");
+
+    for (uint i = 0; i < responses.size(); ++i)
+        m_curves[i]->setData(responses[i].real(), responses[i].imag());
+    m_plot->replot();
+}
+
+void ACAnalysisNyquistDialog::overlayResponses(const QValueVector<ACResponse> &responses, const QString &label)
+{
+    uint index = 0;
+    for (MeterList::ConstIterator it = m_meters.begin(); it != m_meters.end(); ++it, ++index)
     {
-        m_curve = new QwtPlotCurve(m_plot);
-        m_curve->setPen(Qt::red);
-        m_plot->insertCurve(m_curve);
+        const ACResponse &response = responses[index];
+        if (response.count() > 0)
+            addOverlayCurve(m_plot, index, m_meters.count(), (*it).name() + " (" + label + ")")->setData(response.real(), response.imag());
     }
-    m_curve->setData(table[3], table[4]);
     m_plot->replot();
 }
 
+void ACAnalysisNyquistDialog::plotRealTrace(uint, const QString &, const QMemArray<double> &, const QMemArray<double> &)
+{
+    // there is no frequency axis to plot it over
+}
+
+void ACAnalysisNyquistDialog::plotComplexTrace(uint index, const QString &title, const ACResponse &response)
+{
+    addTraceCurve(m_plot, index, title)->setData(response.real(), response.imag());
+}
+
 //
 // ACAnalysisLinearMagnitudeDialog
 //
 
-ACAnalysisLinearMagnitudeDialog::ACAnalysisLinearMagnitudeDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const Meter &meter)
-    : AnalysisDialog(view),
-      m_startFrequency(startFrequency),
-      m_stopFrequency(stopFrequency),
-      m_meter(meter),
-      m_curve(0)
+ACAnalysisLinearMagnitudeDialog::ACAnalysisLinearMagnitudeDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const MeterList &meters)
+    : ACAnalysisDialog(view, startFrequency, stopFrequency, meters)
 {
-    setCaption(i18n("Linear Magnitude Plot %1").arg(m_meter.name()));
+    setCaption(i18n("Linear Magnitude Plot %1").arg(Meter::names(m_meters)));
 
     m_plot = new Plot(centralWidget());
     m_plot->setAxisOptions(QwtPlot::xBottom, QwtAutoScale::Logarithmic);
     m_plot->setAxisTitle(QwtPlot::xBottom, "Frequency [Hz]");
-    m_plot->setAxisTitle(QwtPlot::yLeft, "Magnitude [" + m_meter.shortUnit() + "]");
+    m_plot->setAxisTitle(QwtPlot::yLeft, "Magnitude [" + Meter::shortUnits(m_meters) + "]");
+    createCurves(m_plot, m_curves);
     m_plotLayout->addWidget(m_plot);
 }
 
-bool ACAnalysisLinearMagnitudeDialog::runAnalysis()
+void ACAnalysisLinearMagnitudeDialog::plotResponses(const QValueVector<ACResponse> &responses)
 {
-    QString cmdList = m_view->schematic()->createCommandList();
-    if (cmdList.isNull())
-    {
-        m_errorString = m_view->schematic()->errorString();
-        return false;
-    }
-
-    QString meterCmd = m_meter.createCommand(m_view->schematic());
-    if (meterCmd.isNull())
-    {
-        m_errorString = m_meter.errorString();
-        return false;
-    }
-
-    cmdList += ".control\n"
-               "set nobreak\n"
-               "set units=degrees\n"
-               ".endc\n"
-               ".ac dec " + QString::number(Settings::self()->acAnalysisNumPointsPerDecade()) + " "
-                          + m_startFrequency + " " + m_stopFrequency + "\n"
-               ".print ac mag(" + meterCmd + ")\n"
-               ".end\n";
+    TraceSpan span("ACAnalysisLinearMagnitudeDialog::plotResponses");
 
-    m_spiceProcess->start(cmdList, 4);
-
-    return true;
+    for (uint i = 0; i < responses.size(); ++i)
+        m_curves[i]->setData(responses[i].frequencies(), responses[i].magnitude());
+    m_plot->replot();
 }
 
-
-void ACAnalysisLinearMagnitudeDialog::plotData(const QValueVector<QMemArray<double> > &table)
+void ACAnalysisLinearMagnitudeDialog::overlayResponses(const QValueVector<ACResponse> &responses, const QString &label)
 {
-    if (!m_curve)
+    uint index = 0;
+    for (MeterList::ConstIterator it = m_meters.begin(); it != m_meters.end(); ++it, ++index)
     {
-        m_curve = new QwtPlotCurve(m_plot);
-        m_curve->setPen(Qt::red);
-        m_plot->insertCurve(m_curve);
+        const ACResponse &response = responses[index];
+        if (response.count() > 0)
+            addOverlayCurve(m_plot, index, m_meters.count(), (*it).name() + " (" + label + ")")->setData(response.frequencies(), response.magnitude());
     }
-    m_curve->setData(table[1], table[3]);
     m_plot->replot();
 }
 
+void ACAnalysisLinearMagnitudeDialog::plotRealTrace(uint index, const QString &title, const QMemArray<double> &frequencies, const QMemArray<double> &values)
+{
+    addTraceCurve(m_plot, index, title)->setData(frequencies, values);
+}
+
+void ACAnalysisLinearMagnitudeDialog::plotComplexTrace(uint index, const QString &title, const ACResponse &response)
+{
+    addTraceCurve(m_plot, index, title)->setData(response.frequencies(), response.magnitude());
+}
+
 #include "acanalysisdialog.moc"
 
 // vim: ts=4 sw=4 et
@@ -20,6 +20,8 @@
 #ifndef ACANALYSISDIALOG_H
 #define ACANALYSISDIALOG_H
 
+#include <qvaluevector.h>
+
 #include "analysisdialog.h"
 #include "meter.h"
 
@@ -29,69 +31,113 @@ namespace Spiceplus {
 
 class Plot;
 
-class ACAnalysisBodeDialog : public AnalysisDialog
+class ACAnalysisRun;
+class ACResponse;
+
+// The common part of the AC dialogs: they all plot some view of the
+// complex response at each meter, which comes from the built-in solver or
+// from a SPICE run shared with the other dialogs.
+class ACAnalysisDialog : public AnalysisDialog
 {
     Q_OBJECT
 
 public:
-    ACAnalysisBodeDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const Meter &meter);
+    ACAnalysisDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const MeterList &meters);
+    ~ACAnalysisDialog();
 
+    bool isAnalysisRunning() const;
+
+protected:
     bool runAnalysis();
+    void cancelAnalysis();
+    QString analysisName() const { return "AC"; }
+    void overlayRun(const ResultTable &table, const QString &label);
+    // one response per meter, in the order of the meters
+    virtual void plotResponses(const QValueVector<ACResponse> &responses) = 0;
+    // the same for a stored run, with addOverlayCurve(); a meter the run
+    // doesn't have comes with an empty response
+    virtual void overlayResponses(const QValueVector<ACResponse> &responses, const QString &label) = 0;
+    void plotTrace(uint index, const QString &title, const ResultTable &table,
+                   const QMemArray<double> &real, const QMemArray<double> &imag);
+    // and for a complex trace, as the response of a meter
+    virtual void plotRealTrace(uint index, const QString &title, const QMemArray<double> &frequencies, const QMemArray<double> &values) = 0;
+    virtual void plotComplexTrace(uint index, const QString &title, const ACResponse &response) = 0;
+    // a curve per meter, told apart by colour and legend if there are several
+    void createCurves(Plot *plot, QValueVector<QwtPlotCurve *> &curves);
+
+    QString m_startFrequency;
+    QString m_stopFrequency;
+    MeterList m_meters;
 
 protected slots:
-    void plotData(const QValueVector<QMemArray<double> > &table);
+    void plotData(const ResultTable &table);
+
+private slots:
+    void plotRun();
+    void finishRun();
 
 private:
-    QString m_startFrequency;
-    QString m_stopFrequency;
-    Meter m_meter;
+    void releaseRun();
+    // as complex vectors, whatever the table they came from looked like
+    void storeResponses(const QValueVector<ACResponse> &responses);
+
+    ACAnalysisRun *m_run;
+};
+
+class ACAnalysisBodeDialog : public ACAnalysisDialog
+{
+    Q_OBJECT
+
+public:
+    ACAnalysisBodeDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const MeterList &meters);
+
+protected:
+    void plotResponses(const QValueVector<ACResponse> &responses);
+    void overlayResponses(const QValueVector<ACResponse> &responses, const QString &label);
+    void plotRealTrace(uint index, const QString &title, const QMemArray<double> &frequencies, const QMemArray<double> &values);
+    void plotComplexTrace(uint index, const QString &title, const ACResponse &response);
 
+private:
     Plot *m_magnitudePlot;
-    QwtPlotCurve *m_magnitudeCurve;
+    QValueVector<QwtPlotCurve *> m_magnitudeCurves;
     Plot *m_phasePlot;
-    QwtPlotCurve *m_phaseCurve;
+    QValueVector<QwtPlotCurve *> m_phaseCurves;
 };
 
-class ACAnalysisNyquistDialog : public AnalysisDialog
+class ACAnalysisNyquistDialog : public ACAnalysisDialog
 {
     Q_OBJECT
 
 public:
-    ACAnalysisNyquistDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const Meter &meter);
-
-    bool runAnalysis();
+    ACAnalysisNyquistDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const MeterList &meters);
 
-protected slots:
-    void plotData(const QValueVector<QMemArray<double> > &table);
+protected:
+    void plotResponses(const QValueVector<ACResponse> &responses);
+    void overlayResponses(const QValueVector<ACResponse> &responses, const QString &label);
+    void plotRealTrace(uint index, const QString &title, const QMemArray<double> &frequencies, const QMemArray<double> &values);
+    void plotComplexTrace(uint index, const QString &title, const ACResponse &response);
 
 private:
-    QString m_startFrequency;
-    QString m_stopFrequency;
-    Meter m_meter;
-
     Plot *m_plot;
-    QwtPlotCurve *m_curve;
+    QValueVector<QwtPlotCurve *> m_curves;
 };
 
-class ACAnalysisLinearMagnitudeDialog : public AnalysisDialog
+class ACAnalysisLinearMagnitudeDialog : public ACAnalysisDialog
 {
     Q_OBJECT
 
 public:
-    ACAnalysisLinearMagnitudeDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const Meter &meter);
-
-    bool runAnalysis();
+    ACAnalysisLinearMagnitudeDialog(SchematicView *view, const QString &startFrequency, const QString &stopFrequency, const MeterList &meters);
 
-protected slots:
-    void plotData(const QValueVector<QMemArray<double> > &table);
+protected:
+    void plotResponses(const QValueVector<ACResponse> &responses);
+    void overlayResponses(const QValueVector<ACResponse> &responses, const QString &label);
+    void plotRealTrace(uint index, const QString &title, const QMemArray<double> &frequencies, const QMemArray<double> &values);
+    void plotComplexTrace(uint index, const QString &title, const ACResponse &response);
 
 private:
-    QString m_startFrequency;
-    QString m_stopFrequency;
-    Meter m_meter;
-
     Plot *m_plot;
-    QwtPlotCurve *m_curve;
+    QValueVector<QwtPlotCurve *> m_curves;
 };
 
 } // namespace Spiceplus
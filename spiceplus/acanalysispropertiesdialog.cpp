@@ -62,34 +62,37 @@ ACAnalysisPropertiesDialog::ACAnalysisPropertiesDialog(SchematicView *view, QWid
     new QLabel(i18n("Herz"), freqBox);
     topLayout->addWidget(freqBox);
 
-    GroupBox *outputBox = new GroupBox(0, Qt::Vertical, i18n("Output Variable"), w);
+    GroupBox *outputBox = new GroupBox(0, Qt::Vertical, i18n("Output Variables"), w);
     outputBox->layout()->setMargin(KDialog::marginHint());
     outputBox->layout()->setSpacing(KDialog::spacingHint());
-    QGridLayout *outputGrid = new QGridLayout(outputBox->layout(), 2, 4, KDialog::spacingHint());
-    m_meterSelector = new MeterSelector(m_view->schematic(), outputBox, outputGrid, 0, 0);
+    QGridLayout *outputGrid = new QGridLayout(outputBox->layout(), 4, 4, KDialog::spacingHint());
+    m_meterSelector = new MeterSelector(m_view->schematic(), outputBox, outputGrid, 0, 0, true);
     topLayout->addWidget(outputBox);
 }
 
 void ACAnalysisPropertiesDialog::slotUser1()
 {
-    Meter meter = m_meterSelector->meter();
+    MeterList meters = m_meterSelector->meters();
 
-    if (meter.type() == Meter::Voltmeter && meter.testPoint1() == meter.testPoint2())
+    for (MeterList::ConstIterator it = meters.begin(); it != meters.end(); ++it)
     {
-        KMessageBox::sorry(this, i18n("Test Points must differ"));
-        return;
+        if ((*it).type() == Meter::Voltmeter && (*it).testPoint1() == (*it).testPoint2())
+        {
+            KMessageBox::sorry(this, i18n("Test Points must differ"));
+            return;
+        }
     }
 
     AnalysisDialog *dlg;
 
     if (m_bodeButton->isChecked())
-        dlg = new ACAnalysisBodeDialog(m_view, m_startFrequency->text(), m_stopFrequency->text(), meter);
+        dlg = new ACAnalysisBodeDialog(m_view, m_startFrequency->text(), m_stopFrequency->text(), meters);
     else if (m_nyquistButton->isChecked())
-        dlg = new ACAnalysisNyquistDialog(m_view, m_startFrequency->text(), m_stopFrequency->text(), meter);
+        dlg = new ACAnalysisNyquistDialog(m_view, m_startFrequency->text(), m_stopFrequency->text(), meters);
     else
-        dlg = new ACAnalysisLinearMagnitudeDialog(m_view, m_startFrequency->text(), m_stopFrequency->text(), meter);
+        dlg = new ACAnalysisLinearMagnitudeDialog(m_view, m_startFrequency->text(), m_stopFrequency->text(), meters);
 
-    if (!dlg->runAnalysis())
+    if (!dlg->startAnalysis())
     {
         KMessageBox::error(this, dlg->errorString());
         delete dlg;
@@ -0,0 +1,238 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <math.h>
+
+#include <qstringlist.h>
+
+#include "acanalysisrun.h"
+#include "spicejobscheduler.h"
+#include "spicenumber.h"
+#include "spiceprocess.h"
+
+using namespace Spiceplus;
+
+QPtrList<ACAnalysisRun> ACAnalysisRun::s_runs;
+
+ACAnalysisRun::ACAnalysisRun(const QString &key)
+    : m_key(key),
+      m_numUsers(0),
+      m_isFinished(false),
+      m_hasFailed(false),
+      m_isStored(false),
+      m_spiceProcess(0),
+      m_scheduler(0)
+{
+}
+
+ACAnalysisRun *ACAnalysisRun::acquire(const QString &cmdList, const QStringList &probeCmds,
+                                      const QString &startFrequency, const QString &stopFrequency,
+                                      int numPointsPerDecade, QString &errorString)
+{
+    QString controlCmdList = cmdList + ".control\n"
+                                       "set nobreak\n"
+                                       ".endc\n";
+    QString printCmd = ".print ac";
+    for (QStringList::ConstIterator it = probeCmds.begin(); it != probeCmds.end(); ++it)
+        printCmd += " real(" + *it + ") imag(" + *it + ")";
+    printCmd += "\n";
+    QString key = controlCmdList + ".ac dec " + QString::number(numPointsPerDecade) + " "
+                                 + startFrequency + " " + stopFrequency + "\n"
+                                 + printCmd + ".end\n";
+
+    for (uint i = 0; i < s_runs.count(); ++i)
+    {
+        ACAnalysisRun *run = s_runs.at(i);
+        if (run->m_key == key && !run->m_hasFailed)
+        {
+            s_runs.take(i);
+            s_runs.prepend(run);
+            ++run->m_numUsers;
+            return run;
+        }
+    }
+
+    ACAnalysisRun *run = new ACAnalysisRun(key);
+    if (!run->start(controlCmdList, printCmd, startFrequency, stopFrequency, numPointsPerDecade, errorString))
+    {
+        delete run;
+        return 0;
+    }
+
+    run->m_numUsers = 1;
+    s_runs.prepend(run);
+    return run;
+}
+
+void ACAnalysisRun::release()
+{
+    if (--m_numUsers > 0)
+        return;
+
+    if (m_isFinished && !m_hasFailed)
+        trimKeptRuns();
+    else
+        discard();
+}
+
+bool ACAnalysisRun::start(const QString &cmdList, const QString &printCmd, const QString &startFrequency,
+                          const QString &stopFrequency, int numPointsPerDecade, QString &errorString)
+{
+    QString points = QString::number(numPointsPerDecade);
+
+    double start, stop;
+    int numDecades = 0;
+    if (SpiceJobScheduler::maxRunningJobs() > 1 &&
+        SpiceNumber::parse(startFrequency, start) &&
+        SpiceNumber::parse(stopFrequency, stop) && start > 0 && stop > start)
+        numDecades = int(ceil(log10(stop / start) - 1e-9));
+
+    if (numDecades < 2)
+    {
+        m_spiceProcess = new SpiceProcess(this);
+        connect(m_spiceProcess, SIGNAL(analysisFailed(const QString &, const QString &)), SLOT(fail(const QString &, const QString &)));
+        connect(m_spiceProcess, SIGNAL(analysisFinished(const ResultTable &)), SLOT(finish(const ResultTable &)));
+
+        if (!m_spiceProcess->start(m_key))
+        {
+            errorString = m_spiceProcess->errorString();
+            return false;
+        }
+        return true;
+    }
+
+    // Bands start at whole decades above the start frequency, so that
+    // they hit the same frequencies as a single sweep would. Their first
+    // point repeats the last one of the band before.
+    int numBands = QMIN(numDecades, SpiceJobScheduler::maxRunningJobs());
+    int decadesPerBand = (numDecades + numBands - 1) / numBands;
+
+    QStringList commandLists;
+    QString bandStart = startFrequency;
+    for (int decade = decadesPerBand; ; decade += decadesPerBand)
+    {
+        QString bandStop = decade < numDecades ? SpiceNumber::format(start * pow(10.0, decade)) : stopFrequency;
+        commandLists.append(cmdList + ".ac dec " + points + " " + bandStart + " " + bandStop + "\n"
+                                    + printCmd + ".end\n");
+        if (decade >= numDecades)
+            break;
+        bandStart = bandStop;
+    }
+
+    m_scheduler = new SpiceJobScheduler(this);
+    connect(m_scheduler, SIGNAL(jobFinished(int, const ResultTable &)), SLOT(collectBand(int, const ResultTable &)));
+    connect(m_scheduler, SIGNAL(jobFailed(int, const QString &, const QString &)), SLOT(failBand(int, const QString &, const QString &)));
+    connect(m_scheduler, SIGNAL(finished()), SLOT(joinBands()));
+
+    m_bands.resize(commandLists.count());
+    m_scheduler->run(commandLists);
+    return true;
+}
+
+void ACAnalysisRun::finish(const ResultTable &table)
+{
+    m_table = table;
+    m_isFinished = true;
+    emit finished();
+}
+
+void ACAnalysisRun::fail(const QString &errorString, const QString &errorDetails)
+{
+    // not shared any more, the next one to ask tries again
+    m_isFinished = true;
+    m_hasFailed = true;
+    emit failed(errorString, errorDetails);
+}
+
+void ACAnalysisRun::collectBand(int job, const ResultTable &table)
+{
+    m_bands[job] = table;
+}
+
+void ACAnalysisRun::failBand(int, const QString &errorString, const QString &errorDetails)
+{
+    // a result with a gap is of no use
+    m_scheduler->cancel();
+    m_bands.clear();
+    fail(errorString, errorDetails);
+}
+
+void ACAnalysisRun::joinBands()
+{
+    const ResultTable &firstBand = m_bands[0];
+    ResultTable table;
+    table.setAxis(firstBand.axisName(), ResultTable::Real);
+    for (uint vector = 0; vector < firstBand.numVectors(); ++vector)
+        table.addVector(firstBand.vectorName(vector), firstBand.vectorType(vector));
+
+    uint numRows = 0;
+    for (uint band = 0; band < m_bands.count(); ++band)
+        numRows += m_bands[band].numRows();
+    table.reserve(numRows);
+
+    for (uint band = 0; band < m_bands.count(); ++band)
+    {
+        const ResultTable &bandTable = m_bands[band];
+        for (uint bandRow = 0; bandRow < bandTable.numRows(); ++bandRow)
+        {
+            // drop the boundary point the band before has already
+            uint row = table.numRows();
+            if (row > 0 && bandTable.axis()[bandRow] <= table.axis()[row - 1] * (1 + 1e-9))
+                continue;
+
+            table.appendRow(bandTable, bandRow);
+        }
+    }
+
+    table.squeeze();
+    m_bands.clear();
+
+    finish(table);
+}
+
+void ACAnalysisRun::discard()
+{
+    s_runs.removeRef(this);
+
+    if (m_spiceProcess)
+        m_spiceProcess->cancel();
+    if (m_scheduler)
+        m_scheduler->cancel();
+
+    // release() may be called from within one of our signals
+    deleteLater();
+}
+
+void ACAnalysisRun::trimKeptRuns()
+{
+    uint numKept = 0;
+    for (uint i = 0; i < s_runs.count(); )
+    {
+        ACAnalysisRun *run = s_runs.at(i);
+        if (run->m_numUsers == 0 && ++numKept > MaxKeptRuns)
+            run->discard();
+        else
+            ++i;
+    }
+}
+
+#include "acanalysisrun.moc"
+
+// vim: ts=4 sw=4 et
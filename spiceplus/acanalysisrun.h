@@ -0,0 +1,107 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef ACANALYSISRUN_H
+#define ACANALYSISRUN_H
+
+#include <qobject.h>
+#include <qstringlist.h>
+#include <qptrlist.h>
+#include <qvaluevector.h>
+
+#include "acresponse.h"
+#include "resulttable.h"
+
+namespace Spiceplus {
+
+class SpiceProcess;
+class SpiceJobScheduler;
+
+// An AC analysis in SPICE of the complex response at a set of probes.
+// Dialogs asking for the same netlist, probes and sweep share one run, so
+// that a Bode, Nyquist and linear magnitude plot cost a single simulation.
+// The last few finished runs are kept for dialogs opened later.
+//
+// A sweep over several decades is split into bands of whole decades that
+// run in parallel and are joined in frequency order.
+class ACAnalysisRun : public QObject
+{
+    Q_OBJECT
+
+public:
+    // The run for the netlist and the SPICE expressions of the probes,
+    // started if there is none yet. Every acquire() needs a release().
+    static ACAnalysisRun *acquire(const QString &cmdList, const QStringList &probeCmds,
+                                  const QString &startFrequency, const QString &stopFrequency,
+                                  int numPointsPerDecade, QString &errorString);
+    // a run nobody waits for any more is cancelled
+    void release();
+
+    bool isRunning() const { return !m_isFinished; }
+    // empty until finished() is emitted
+    const ResultTable &table() const { return m_table; }
+    ACResponse response(const QString &probeCmd) const { return ACResponse(m_table, probeCmd); }
+    // a run shared by several dialogs goes to the results of the project once
+    bool isStored() const { return m_isStored; }
+    void setStored() { m_isStored = true; }
+
+signals:
+    void finished();
+    void failed(const QString &errorString, const QString &errorDetails);
+
+private slots:
+    void finish(const ResultTable &table);
+    void fail(const QString &errorString, const QString &errorDetails);
+    void collectBand(int job, const ResultTable &table);
+    void failBand(int job, const QString &errorString, const QString &errorDetails);
+    void joinBands();
+
+private:
+    ACAnalysisRun(const QString &key);
+
+    bool start(const QString &cmdList, const QString &printCmd, const QString &startFrequency,
+               const QString &stopFrequency, int numPointsPerDecade, QString &errorString);
+    void discard();
+    static void trimKeptRuns();
+
+    // finished runs nobody uses that are kept
+    static const uint MaxKeptRuns = 4;
+
+    // the command list of a single run, which identifies the analysis
+    QString m_key;
+    int m_numUsers;
+    bool m_isFinished;
+    bool m_hasFailed;
+    bool m_isStored;
+
+    SpiceProcess *m_spiceProcess;
+    SpiceJobScheduler *m_scheduler;
+    QValueVector<ResultTable> m_bands;
+    ResultTable m_table;
+
+    // all runs, the most recently used first
+    static QPtrList<ACAnalysisRun> s_runs;
+};
+
+} // namespace Spiceplus
+
+#endif // ACANALYSISRUN_H
+
+// vim: ts=4 sw=4 et
@@ -17,22 +17,43 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <qlabel.h>
 #include <qlayout.h>
+#include <qpopupmenu.h>
 #include <qpushbutton.h>
+#include <qtimer.h>
 
 #include <klocale.h>
+#include <kglobal.h>
+#include <kdebug.h>
 #include <kdialog.h>
+#include <kinputdialog.h>
 #include <kmessagebox.h>
+#include <kprogress.h>
 #include <kseparator.h>
 
 #include "analysisdialog.h"
+#include "meter.h"
+#include "parametertuner.h"
+#include "plot.h"
+#include "plotcurve.h"
+#include "resultstore.h"
+#include "schematic.h"
 #include "schematicview.h"
+#include "settings.h"
+#include "spicenumber.h"
 #include "spiceprocess.h"
+#include "trace.h"
 
 using namespace Spiceplus;
 
 AnalysisDialog::AnalysisDialog(SchematicView *view, QBoxLayout::Direction plotLayoutDirection)
-    : m_view(view)
+    : m_view(view),
+      m_isCancelled(false),
+      m_numSavedVectors(0),
+      m_isDraft(false),
+      m_draftDivisor(1),
+      m_isTuneRunPending(false)
 {
     resize(560, 420);
 
@@ -40,7 +61,15 @@ AnalysisDialog::AnalysisDialog(SchematicView *view, QBoxLayout::Direction plotLa
 
     m_spiceProcess = new SpiceProcess(this);
     connect(m_spiceProcess, SIGNAL(analysisFailed(const QString &, const QString &)), SLOT(displayErrorMessage(const QString &, const QString &)));
-    connect(m_spiceProcess, SIGNAL(analysisFinished(const QValueVector<QMemArray<double> > &)), SLOT(plotData(const QValueVector<QMemArray<double> > &)));
+    connect(m_spiceProcess, SIGNAL(analysisFinished(const ResultTable &)), SLOT(plotData(const ResultTable &)));
+    connect(m_spiceProcess, SIGNAL(analysisFinished(const ResultTable &)), SLOT(measureRun()));
+    connect(m_spiceProcess, SIGNAL(analysisCancelled()), SLOT(resumeTuning()));
+
+    m_tuneTimer = new QTimer(this);
+    connect(m_tuneTimer, SIGNAL(timeout()), SLOT(runTuned()));
+
+    m_progressTimer = new QTimer(this);
+    connect(m_progressTimer, SIGNAL(timeout()), SLOT(updateProgress()));
 
     QWidget *w = new QWidget(this);
     setCentralWidget(w);
@@ -48,35 +77,527 @@ AnalysisDialog::AnalysisDialog(SchematicView *view, QBoxLayout::Direction plotLa
 
     m_plotLayout = new QBoxLayout(vbox, plotLayoutDirection, KDialog::spacingHint());
 
+    m_tuner = new ParameterTuner(m_view, w);
+    m_tuner->hide();
+    connect(m_tuner, SIGNAL(changed()), SLOT(scheduleTunedRun()));
+    connect(m_tuner, SIGNAL(released()), SLOT(finishTuning()));
+    vbox->addWidget(m_tuner);
+
     vbox->addWidget(new KSeparator(KSeparator::HLine, w));
 
     QBoxLayout *hbox = new QHBoxLayout(vbox, KDialog::spacingHint());
-    hbox->addStretch();
 
-    QPushButton *updateButton = new QPushButton(i18n("Update"), w);
-    connect(updateButton, SIGNAL(clicked()), SLOT(updatePlot()));
-    hbox->addWidget(updateButton);
+    QPushButton *tuneButton = new QPushButton(i18n("Live Tune"), w);
+    tuneButton->setToggleButton(true);
+    connect(tuneButton, SIGNAL(toggled(bool)), SLOT(showTuner(bool)));
+    hbox->addWidget(tuneButton);
+
+    m_progress = new KProgress(w);
+    hbox->addWidget(m_progress, 1);
+
+    m_status = new QLabel(w);
+    hbox->addWidget(m_status);
+
+    QPushButton *compareButton = new QPushButton(i18n("Compare"), w);
+    m_compareMenu = new QPopupMenu(compareButton);
+    connect(m_compareMenu, SIGNAL(aboutToShow()), SLOT(fillCompareMenu()));
+    connect(m_compareMenu, SIGNAL(activated(int)), SLOT(compareRun(int)));
+    compareButton->setPopup(m_compareMenu);
+    hbox->addWidget(compareButton);
+
+    QPushButton *traceButton = new QPushButton(i18n("Traces"), w);
+    m_traceMenu = new QPopupMenu(traceButton);
+    connect(m_traceMenu, SIGNAL(aboutToShow()), SLOT(fillTraceMenu()));
+    connect(m_traceMenu, SIGNAL(activated(int)), SLOT(editTraces(int)));
+    traceButton->setPopup(m_traceMenu);
+    hbox->addWidget(traceButton);
+
+    m_cancelButton = new QPushButton(i18n("Cancel"), w);
+    m_cancelButton->setEnabled(false);
+    connect(m_cancelButton, SIGNAL(clicked()), SLOT(cancel()));
+    hbox->addWidget(m_cancelButton);
+
+    m_updateButton = new QPushButton(i18n("Update"), w);
+    connect(m_updateButton, SIGNAL(clicked()), SLOT(updatePlot()));
+    hbox->addWidget(m_updateButton);
 }
 
 void AnalysisDialog::displayErrorMessage(const QString &errorString, const QString &errorDetails)
 {
+    // intermediate values while dragging may well be invalid
+    if (m_isDraft)
+        return;
+
     if (errorDetails.isNull())
         KMessageBox::error(this, errorString);
     else
         KMessageBox::detailedError(this, errorString, errorDetails);
 }
 
+bool AnalysisDialog::startAnalysis()
+{
+    m_runTime.start();
+    m_isCancelled = false;
+    m_numSavedVectors = 0;
+
+    // the schematic may be edited while the run is on
+    m_runSchematicHash = QString::null;
+    if (!analysisName().isNull() && ResultStore::self()->isOpen())
+        m_runSchematicHash = ResultStore::hash(m_view->schematic()->createCommandList());
+
+    if (!runAnalysis())
+        return false;
+
+    if (isAnalysisRunning())
+    {
+        m_cancelButton->setEnabled(true);
+        m_updateButton->setEnabled(false);
+        if (!m_progressTimer->isActive())
+            m_progressTimer->start(ProgressTime);
+    }
+
+    updateProgress();
+    return true;
+}
+
 void AnalysisDialog::updatePlot()
 {
-    if (m_spiceProcess->isRunning())
+    // the button is disabled while a run is on, but a tuned run may have
+    // started since the click
+    if (isAnalysisRunning())
         return;
 
     m_view->resetTool();
 
-    if (!runAnalysis())
+    if (!startAnalysis())
         KMessageBox::error(this, m_errorString);
 }
 
+bool AnalysisDialog::isAnalysisRunning() const
+{
+    return m_spiceProcess->isBusy();
+}
+
+void AnalysisDialog::cancelAnalysis()
+{
+    m_spiceProcess->cancel();
+}
+
+int AnalysisDialog::analysisProgress() const
+{
+    return m_spiceProcess->isBusy() ? m_spiceProcess->progress() : -1;
+}
+
+void AnalysisDialog::cancel()
+{
+    m_tuneTimer->stop();
+    m_isTuneRunPending = false;
+    m_isCancelled = true;
+
+    cancelAnalysis();
+    updateProgress();
+}
+
+void AnalysisDialog::updateProgress()
+{
+    int seconds = m_runTime.elapsed() / 1000;
+
+    if (!m_isCancelled && isAnalysisRunning())
+    {
+        int percent = analysisProgress();
+        if (percent >= 0)
+        {
+            m_progress->setTotalSteps(100);
+            m_progress->setProgress(percent);
+        }
+        else
+        {
+            // a busy indicator, moved on by each step
+            m_progress->setTotalSteps(0);
+            m_progress->advance(1);
+        }
+
+        if (m_numSavedVectors > 0)
+            m_status->setText(i18n("%1 s, %2 vectors saved").arg(seconds).arg(m_numSavedVectors));
+        else
+            m_status->setText(i18n("%1 s").arg(seconds));
+        return;
+    }
+
+    m_progressTimer->stop();
+    m_cancelButton->setEnabled(false);
+    m_updateButton->setEnabled(true);
+    m_progress->setTotalSteps(100);
+    m_progress->setProgress(0);
+    if (m_isCancelled)
+        m_status->setText(i18n("Cancelled"));
+    else if (m_numSavedVectors > 0)
+        m_status->setText(i18n("%1 vectors saved").arg(m_numSavedVectors));
+    else
+        m_status->setText(QString::null);
+}
+
+QString AnalysisDialog::createSaveCommand(const MeterList &meters)
+{
+    return Meter::createSaveCommand(m_view->schematic(), meters, &m_numSavedVectors);
+}
+
+void AnalysisDialog::storeRun(const MeterList &meters, const ResultTable &table)
+{
+    // drafts while tuning are not worth keeping
+    ResultStore *store = ResultStore::self();
+    if (analysisName().isNull() || m_isDraft || densityDivisor() > 1 || !store->isOpen() || table.isEmpty() || m_runSchematicHash.isNull())
+        return;
+
+    ResultStore::Run run;
+    run.analysis = analysisName();
+    run.schematicHash = m_runSchematicHash;
+    for (MeterList::ConstIterator it = meters.begin(); it != meters.end(); ++it)
+        run.meters.append((*it).name());
+
+    if (!store->append(run, table))
+        kdWarning() << k_funcinfo << store->errorString() << endl;
+}
+
+void AnalysisDialog::overlayRun(const ResultTable &, const QString &)
+{
+}
+
+QwtPlotCurve *AnalysisDialog::addOverlayCurve(Plot *plot, uint meter, uint numMeters, const QString &title, bool hasLegend)
+{
+    QColor color = Qt::red;
+    if (numMeters > 1)
+        color.setHsv(300 * meter / (numMeters - 1), 255, 200);
+
+    QwtPlotCurve *curve = new PlotCurve(plot, title);
+    curve->setPen(QPen(color, 0, Qt::DashLine));
+    long key = plot->insertCurve(curve);
+    if (!hasLegend)
+        plot->enableLegend(false, key);
+    m_overlayCurves.append(qMakePair(plot, key));
+    return curve;
+}
+
+void AnalysisDialog::clearOverlays()
+{
+    QValueList<Plot *> plots;
+    for (QValueList<QPair<Plot *, long> >::Iterator it = m_overlayCurves.begin(); it != m_overlayCurves.end(); ++it)
+    {
+        (*it).first->removeCurve((*it).second);
+        if (!plots.contains((*it).first))
+            plots.append((*it).first);
+    }
+    m_overlayCurves.clear();
+
+    for (QValueList<Plot *>::Iterator it = plots.begin(); it != plots.end(); ++it)
+        (*it)->replot();
+}
+
+void AnalysisDialog::fillCompareMenu()
+{
+    m_compareMenu->clear();
+
+    // the latest runs of this analysis that have one of the meters
+    ResultStore *store = ResultStore::self();
+    QString schematicHash;
+    uint numRuns = 0;
+    for (int index = int(store->numRuns()) - 1; index >= 0 && numRuns < MaxComparedRuns; --index)
+    {
+        const ResultStore::Run &run = store->run(index);
+        if (run.analysis != analysisName())
+            continue;
+
+        bool hasMeter = false;
+        for (QStringList::ConstIterator it = m_meterCmds.begin(); it != m_meterCmds.end() && !hasMeter; ++it)
+            hasMeter = store->hasVector(index, *it);
+        if (!hasMeter)
+            continue;
+
+        if (schematicHash.isNull())
+            schematicHash = ResultStore::hash(m_view->schematic()->createCommandList());
+
+        QString text = KGlobal::locale()->formatDateTime(run.time, true, true) + "  " + run.meters.join(", ");
+        if (run.schematicHash != schematicHash)
+            text += " " + i18n("(other schematic)");
+        m_compareMenu->insertItem(text, index + 1);
+        ++numRuns;
+    }
+
+    if (numRuns == 0)
+    {
+        int id = m_compareMenu->insertItem(store->isOpen() ? i18n("No stored runs") : i18n("No project open"));
+        m_compareMenu->setItemEnabled(id, false);
+    }
+
+    m_compareMenu->insertSeparator();
+    m_compareMenu->insertItem(i18n("Clear Comparison"), ClearComparisonId);
+    m_compareMenu->setItemEnabled(ClearComparisonId, !m_overlayCurves.isEmpty());
+}
+
+void AnalysisDialog::compareRun(int id)
+{
+    clearOverlays();
+    if (id == ClearComparisonId)
+        return;
+
+    ResultStore *store = ResultStore::self();
+    uint index = id - 1;
+    if (index >= store->numRuns())
+        return;
+
+    ResultTable table;
+    if (!store->readTable(index, m_meterCmds, table))
+    {
+        KMessageBox::error(this, store->errorString());
+        return;
+    }
+
+    overlayRun(table, KGlobal::locale()->formatDateTime(store->run(index).time, true, true));
+}
+
+void AnalysisDialog::plotTraces(const MeterList &meters, const ResultTable &table)
+{
+    TraceSpan span("AnalysisDialog::plotTraces");
+
+    m_traceTable = table;
+    m_traceAliases.clear();
+    uint meter = 0;
+    for (MeterList::ConstIterator it = meters.begin(); it != meters.end() && meter < m_meterCmds.count(); ++it, ++meter)
+        m_traceAliases[(*it).name()] = m_meterCmds[meter];
+
+    QValueList<Plot *> plots;
+    drawTraces(plots);
+}
+
+void AnalysisDialog::drawTraces(QValueList<Plot *> &plots)
+{
+    removeTraceCurves(plots);
+
+    uint index = 0;
+    for (QValueList<WaveformExpression>::Iterator it = m_traces.begin(); it != m_traces.end(); ++it, ++index)
+    {
+        QMemArray<double> real, imag;
+        if ((*it).evaluate(m_traceTable, real, imag))
+            plotTrace(index, (*it).text(), m_traceTable, real, imag);
+        else
+            kdWarning() << k_funcinfo << (*it).errorString() << endl;
+    }
+}
+
+void AnalysisDialog::plotTrace(uint, const QString &, const ResultTable &, const QMemArray<double> &, const QMemArray<double> &)
+{
+}
+
+QwtPlotCurve *AnalysisDialog::addTraceCurve(Plot *plot, uint index, const QString &title, bool hasLegend)
+{
+    // darker than the meters, so that they stand apart
+    QColor color;
+    color.setHsv((30 + 137 * index) % 360, 255, 120);
+
+    QwtPlotCurve *curve = new PlotCurve(plot, title);
+    curve->setPen(QPen(color, 2));
+    long key = plot->insertCurve(curve);
+    if (hasLegend)
+    {
+        plot->setAutoLegend(true);
+        plot->enableLegend(true, key);
+    }
+    else
+        plot->enableLegend(false, key);
+    m_traceCurves.append(qMakePair(plot, key));
+    return curve;
+}
+
+void AnalysisDialog::fillTraceMenu()
+{
+    m_traceMenu->clear();
+    m_traceMenu->insertItem(i18n("Add Trace..."), AddTraceId);
+
+    if (m_traces.isEmpty())
+        return;
+
+    m_traceMenu->insertSeparator();
+    int id = 1;
+    for (QValueList<WaveformExpression>::ConstIterator it = m_traces.begin(); it != m_traces.end(); ++it, ++id)
+        m_traceMenu->insertItem(i18n("Remove %1").arg((*it).text()), id);
+}
+
+void AnalysisDialog::editTraces(int id)
+{
+    if (id != AddTraceId)
+    {
+        if (id - 1 < int(m_traces.count()))
+            m_traces.remove(m_traces.at(id - 1));
+        replotTraces();
+        return;
+    }
+
+    QString text;
+    for (;;)
+    {
+        bool ok;
+        text = KInputDialog::getText(i18n("Add Trace"),
+                                     i18n("A quantity derived from the results, like db(v(2)/v(1)),\n"
+                                          "gd(v(3)) or deriv(\"TP1->TP2\") with the name of a meter:"),
+                                     text, &ok, this);
+        if (!ok || text.stripWhiteSpace().isEmpty())
+            return;
+
+        WaveformExpression trace;
+        if (trace.compile(text.stripWhiteSpace(), m_traceTable, m_traceAliases))
+        {
+            m_traces.append(trace);
+            break;
+        }
+        KMessageBox::sorry(this, trace.errorString());
+    }
+
+    replotTraces();
+}
+
+void AnalysisDialog::removeTraceCurves(QValueList<Plot *> &plots)
+{
+    for (QValueList<QPair<Plot *, long> >::Iterator it = m_traceCurves.begin(); it != m_traceCurves.end(); ++it)
+    {
+        // only traces go on the right axis
+        (*it).first->removeCurve((*it).second);
+        (*it).first->enableAxis(QwtPlot::yRight, false);
+        if (!plots.contains((*it).first))
+            plots.append((*it).first);
+    }
+    m_traceCurves.clear();
+}
+
+void AnalysisDialog::replotTraces()
+{
+    // the plots that had traces, and those that have them now
+    QValueList<Plot *> plots;
+    drawTraces(plots);
+    for (QValueList<QPair<Plot *, long> >::Iterator it = m_traceCurves.begin(); it != m_traceCurves.end(); ++it)
+        if (!plots.contains((*it).first))
+            plots.append((*it).first);
+
+    for (QValueList<Plot *>::Iterator it = plots.begin(); it != plots.end(); ++it)
+        (*it)->replot();
+}
+
+bool AnalysisDialog::prepareBuiltInSolver(MeterList &meters, LinearCircuit::ProbeList &probes)
+{
+    if (!Settings::self()->useBuiltInSolver() || !m_circuit.build(m_view->schematic()))
+        return false;
+
+    probes.clear();
+    for (MeterList::Iterator it = meters.begin(); it != meters.end(); ++it)
+    {
+        LinearCircuit::Probe probe;
+        if (!(*it).createProbe(m_view->schematic(), m_circuit, probe))
+            return false;
+        probes.push_back(probe);
+    }
+
+    return true;
+}
+
+bool AnalysisDialog::solveAC(const QString &startFrequency, const QString &stopFrequency, MeterList &meters, ResultTable &table)
+{
+    LinearCircuit::ProbeList probes;
+    if (!prepareBuiltInSolver(meters, probes))
+        return false;
+
+    double start, stop;
+    if (!SpiceNumber::parse(startFrequency, start) || !SpiceNumber::parse(stopFrequency, stop))
+        return false;
+
+    if (Settings::self()->isACAnalysisAdaptive())
+    {
+        int maxPoints = QMAX(2, Settings::self()->acAnalysisMaxPoints() / densityDivisor());
+        return m_circuit.adaptiveACSweep(start, stop, QMIN(acNumPointsPerDecade(), int(AdaptiveCoarsePointsPerDecade)),
+                                         Settings::self()->acAnalysisTolerance(), maxPoints, probes, table);
+    }
+
+    return m_circuit.acSweep(start, stop, acNumPointsPerDecade(), probes, table);
+}
+
+int AnalysisDialog::acNumPointsPerDecade() const
+{
+    return QMAX(1, Settings::self()->acAnalysisNumPointsPerDecade() / densityDivisor());
+}
+
+void AnalysisDialog::showTuner(bool on)
+{
+    if (on)
+    {
+        m_tuner->refresh();
+        m_tuner->show();
+    }
+    else
+        m_tuner->hide();
+}
+
+void AnalysisDialog::scheduleTunedRun()
+{
+    if (!m_tuner->isDragging())
+        return;
+
+    // changes arriving while the timer runs are picked up by that run
+    m_isDraft = true;
+    if (!m_tuneTimer->isActive())
+        m_tuneTimer->start(FrameTime, true);
+}
+
+void AnalysisDialog::finishTuning()
+{
+    m_tuneTimer->stop();
+    m_isDraft = false;
+    runTuned();
+}
+
+void AnalysisDialog::runTuned()
+{
+    // a run for an older value is of no use any more
+    if (m_spiceProcess->isBusy())
+    {
+        m_isTuneRunPending = true;
+        m_spiceProcess->cancel();
+        return;
+    }
+
+    m_isTuneRunPending = false;
+
+    if (!startAnalysis())
+    {
+        if (!m_isDraft)
+            KMessageBox::error(this, m_errorString);
+        return;
+    }
+
+    if (!isAnalysisRunning())
+        adaptDensity(m_runTime.elapsed());
+}
+
+void AnalysisDialog::resumeTuning()
+{
+    if (m_isTuneRunPending)
+        runTuned();
+}
+
+void AnalysisDialog::measureRun()
+{
+    adaptDensity(m_runTime.elapsed());
+    updateProgress();
+}
+
+void AnalysisDialog::adaptDensity(int elapsed)
+{
+    if (!m_isDraft)
+        return;
+
+    if (elapsed > FrameTime && m_draftDivisor < MaxDraftDivisor)
+        m_draftDivisor *= 2;
+    else if (elapsed < FrameTime / 4 && m_draftDivisor > 1)
+        m_draftDivisor /= 2;
+}
+
 #include "analysisdialog.moc"
 
 // vim: ts=4 sw=4 et
@@ -20,15 +20,30 @@
 #ifndef ANALYSISDIALOG_H
 #define ANALYSISDIALOG_H
 
+#include <qdatetime.h>
+#include <qstringlist.h>
+#include <qvaluelist.h>
+#include <qpair.h>
+#include <qmap.h>
+
 #include <kmainwindow.h>
 
-template<class T> class QValueVector;
-template<class T> class QMemArray;
-class QString;
+#include "linearcircuit.h"
+#include "meter.h"
+#include "waveformexpression.h"
+
 class QBoxLayout;
+class QLabel;
+class QPopupMenu;
+class QPushButton;
+class QTimer;
+class QwtPlotCurve;
+class KProgress;
 
 namespace Spiceplus {
 
+class ParameterTuner;
+class Plot;
 class SchematicView;
 class SpiceProcess;
 
@@ -39,21 +54,132 @@ class AnalysisDialog : public KMainWindow
 public:
     AnalysisDialog(SchematicView *view, QBoxLayout::Direction plotLayoutDirection = QBoxLayout::TopToBottom);
 
-    virtual bool runAnalysis() = 0;
+    // Runs the analysis and shows its progress until it is done; the
+    // result arrives through plotData().
+    bool startAnalysis();
+    // whether results of the last run are still to come
+    virtual bool isAnalysisRunning() const;
     QString errorString() const { return m_errorString; }
 
 protected slots:
-    virtual void plotData(const QValueVector<QMemArray<double> > &table) = 0;
+    virtual void plotData(const ResultTable &table) = 0;
+    void displayErrorMessage(const QString &errorString, const QString &errorDetails);
+    void measureRun();
 
 protected:
+    virtual bool runAnalysis() = 0;
+    // stops the runs of the analysis; what has been plotted so far stays
+    virtual void cancelAnalysis();
+    // in percent, or -1 if SPICE doesn't tell
+    virtual int analysisProgress() const;
+
+    // The name runs are stored and compared under in the project's
+    // results; null if they are not.
+    virtual QString analysisName() const { return QString::null; }
+    // keeps a finished run at full density in the results of the project
+    void storeRun(const MeterList &meters, const ResultTable &table);
+    // draws a stored run over the current one, with addOverlayCurve()
+    virtual void overlayRun(const ResultTable &table, const QString &label);
+    // a dashed curve in the colour of the meter, gone with clearOverlays()
+    QwtPlotCurve *addOverlayCurve(Plot *plot, uint meter, uint numMeters, const QString &title, bool hasLegend = true);
+    void clearOverlays();
+
+    // Evaluates the derived traces the user added over the table and hands
+    // them to plotTrace(); the caller replots. The names of the meters can
+    // be used in the traces.
+    void plotTraces(const MeterList &meters, const ResultTable &table);
+    // imag is empty for a real trace
+    virtual void plotTrace(uint index, const QString &title, const ResultTable &table,
+                           const QMemArray<double> &real, const QMemArray<double> &imag);
+    // A curve for the trace, gone with the next plotTraces(). A trace may
+    // be put on the right axis, which is hidden again along with it.
+    QwtPlotCurve *addTraceCurve(Plot *plot, uint index, const QString &title, bool hasLegend = true);
+
+    // Set up the built-in solver if it is enabled and can handle the
+    // schematic; otherwise the analysis is left to SPICE. The circuit is
+    // kept between runs, so that value changes can reuse its factors.
+    bool prepareBuiltInSolver(MeterList &meters, LinearCircuit::ProbeList &probes);
+    bool solveAC(const QString &startFrequency, const QString &stopFrequency, MeterList &meters, ResultTable &table);
+
+    // While a parameter is tuned, sweeps are thinned out by this factor to
+    // keep up with the slider. The run after release is at full density.
+    int densityDivisor() const { return m_isDraft ? m_draftDivisor : 1; }
+    int acNumPointsPerDecade() const;
+
+    // Meter::createSaveCommand() for the run, which tells in the status
+    // how many vectors SPICE keeps
+    QString createSaveCommand(const MeterList &meters);
+
     SchematicView *m_view;
     QBoxLayout *m_plotLayout;
     SpiceProcess *m_spiceProcess;
     QString m_errorString;
+    LinearCircuit m_circuit;
+    // the SPICE expressions of the meters, which name their vectors
+    QStringList m_meterCmds;
 
 private slots:
-    void displayErrorMessage(const QString &errorString, const QString &errorDetails);
     void updatePlot();
+    void showTuner(bool on);
+    void scheduleTunedRun();
+    void finishTuning();
+    void runTuned();
+    void resumeTuning();
+    void cancel();
+    void updateProgress();
+    void fillCompareMenu();
+    void compareRun(int id);
+    void fillTraceMenu();
+    void editTraces(int id);
+
+private:
+    void adaptDensity(int elapsed);
+    // the traces over m_traceTable; adds the plots of the old curves to plots
+    void drawTraces(QValueList<Plot *> &plots);
+    // adds the plots they were on to plots
+    void removeTraceCurves(QValueList<Plot *> &plots);
+    // after the traces changed
+    void replotTraces();
+
+    // the time budget for one update while dragging, in ms
+    static const int FrameTime = 50;
+    // how often the progress of a run is looked at, in ms
+    static const int ProgressTime = 250;
+    static const int MaxDraftDivisor = 16;
+    // the first pass of an adaptive AC sweep
+    static const int AdaptiveCoarsePointsPerDecade = 10;
+    // stored runs offered for comparison; their menu ids start at 1
+    static const uint MaxComparedRuns = 20;
+    static const int ClearComparisonId = 0;
+    // the traces have menu ids from 1 on
+    static const int AddTraceId = 0;
+
+    ParameterTuner *m_tuner;
+    QTimer *m_tuneTimer;
+    QTime m_runTime;
+    // of the schematic the current run was started for
+    QString m_runSchematicHash;
+    QTimer *m_progressTimer;
+    bool m_isCancelled;
+    // by the .save line of the current run; 0 if there is none
+    uint m_numSavedVectors;
+
+    KProgress *m_progress;
+    QLabel *m_status;
+    QPushButton *m_cancelButton;
+    QPushButton *m_updateButton;
+    QPopupMenu *m_compareMenu;
+    // the overlay curves and their plots
+    QValueList<QPair<Plot *, long> > m_overlayCurves;
+    QPopupMenu *m_traceMenu;
+    QValueList<WaveformExpression> m_traces;
+    // what the traces were last plotted for
+    ResultTable m_traceTable;
+    QMap<QString, QString> m_traceAliases;
+    QValueList<QPair<Plot *, long> > m_traceCurves;
+    bool m_isDraft;
+    int m_draftDivisor;
+    bool m_isTuneRunPending;
 };
 
 } // namespace Spiceplus
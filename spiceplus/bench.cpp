@@ -0,0 +1,537 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <config.h>
+
+#include <qfile.h>
+#include <qfileinfo.h>
+#include <qtextstream.h>
+#include <qregexp.h>
+#include <qdatetime.h>
+#include <qpixmap.h>
+#include <qpainter.h>
+#include <qmemarray.h>
+
+#include <kapplication.h>
+#include <kaboutdata.h>
+#include <kcmdlineargs.h>
+#include <klocale.h>
+#include <ktempfile.h>
+#include <kurl.h>
+
+#include "benchgenerator.h"
+#include "schematic.h"
+#include "schematicwire.h"
+#include "schematicdevice.h"
+#include "schematicjunction.h"
+#include "schematiccommand.h"
+#include "spiceprocess.h"
+#include "spicenumber.h"
+#include "model.h"
+#include "settings.h"
+#include "trace.h"
+
+using namespace Spiceplus;
+
+static const char description[] = I18N_NOOP("Benchmarks SPICE+ on synthetic schematics");
+
+static KCmdLineOptions options[] =
+{
+    { "generators <list>", I18N_NOOP("Comma separated list of generators (rc-ladder, resistor-mesh, diode-array, junction-tree)"), "rc-ladder,resistor-mesh,diode-array,junction-tree" },
+    { "sizes <list>", I18N_NOOP("Comma separated list of device counts, up to 100000"), "100,1000,10000" },
+    { "iterations <count>", I18N_NOOP("Number of times each measurement is repeated"), "3" },
+    { "spice-output <file>", I18N_NOOP("Recorded SPICE output to parse, may be given more than once"), 0 },
+    { "label <text>", I18N_NOOP("Label stored with the results, e.g. a commit ID"), 0 },
+    { "o", 0, 0 },
+    { "output <file>", I18N_NOOP("Write the results to file instead of standard output"), 0 },
+    KCmdLineLastOption
+};
+
+namespace Spiceplus {
+
+// Runs the measurements and collects the results as JSON records.
+class BenchRunner
+{
+public:
+    BenchRunner(int iterations) : m_iterations(QMAX(1, iterations)) {}
+
+    bool runGenerator(const QString &kind, int numDevices);
+    bool runParser(const QString &name, const QString &output);
+    void runNumbers(int numValues);
+
+    QString toJSON(const QString &label) const;
+    QString errorString() const { return m_errorString; }
+
+private:
+    void addResult(const QString &benchmark, const QString &input, int size, int numOperations, const QValueList<Q_LLONG> &times);
+    Schematic *createSchematic(const QRect &extent) const;
+
+    void benchHitTesting(Schematic *schematic, const QRect &extent, const QString &kind, int numDevices);
+    void benchRendering(Schematic *schematic, const QRect &extent, const QString &kind, int numDevices);
+    void benchWireEdits(Schematic *schematic, const QString &kind, int numDevices);
+
+    int m_iterations;
+    QStringList m_results;
+    QString m_errorString;
+};
+
+} // namespace Spiceplus
+
+bool BenchRunner::runGenerator(const QString &kind, int numDevices)
+{
+    QValueList<Q_LLONG> times;
+
+    Schematic *schematic = createSchematic(QRect());
+    BenchGenerator generator(schematic);
+
+    Q_LLONG start = Trace::now();
+    if (!generator.generate(kind, numDevices))
+    {
+        m_errorString = generator.errorString();
+        delete schematic;
+        return false;
+    }
+    times.append(Trace::now() - start);
+
+    int size = generator.numDevices();
+    QRect extent = generator.extent();
+    addResult("generate", kind, size, 1, times);
+
+    KTempFile tempFile(QString::null, ".schematic");
+    tempFile.setAutoDelete(true);
+    KURL url;
+    url.setPath(tempFile.name());
+
+    times.clear();
+    for (int i = 0; i < m_iterations; ++i)
+    {
+        start = Trace::now();
+        if (!schematic->save(url))
+        {
+            m_errorString = schematic->errorString();
+            delete schematic;
+            return false;
+        }
+        times.append(Trace::now() - start);
+    }
+    addResult("save", kind, size, 1, times);
+    delete schematic;
+
+    // everything below works on the schematic as read back from disk
+    schematic = 0;
+    times.clear();
+    for (int i = 0; i < m_iterations; ++i)
+    {
+        delete schematic;
+        schematic = createSchematic(extent);
+
+        start = Trace::now();
+        if (!schematic->load(url))
+        {
+            m_errorString = schematic->errorString();
+            delete schematic;
+            return false;
+        }
+        times.append(Trace::now() - start);
+    }
+    addResult("load", kind, size, 1, times);
+
+    times.clear();
+    for (int i = 0; i < m_iterations; ++i)
+    {
+        QMap<QString, Model> modelList;
+        start = Trace::now();
+        if (!schematic->createModelList(modelList))
+        {
+            m_errorString = schematic->errorString();
+            delete schematic;
+            return false;
+        }
+        times.append(Trace::now() - start);
+    }
+    addResult("createModelList", kind, size, 1, times);
+
+    times.clear();
+    for (int i = 0; i < m_iterations; ++i)
+    {
+        start = Trace::now();
+        if (schematic->createCommandList().isNull())
+        {
+            m_errorString = schematic->errorString();
+            delete schematic;
+            return false;
+        }
+        times.append(Trace::now() - start);
+    }
+    addResult("createCommandList", kind, size, 1, times);
+
+    benchHitTesting(schematic, extent, kind, size);
+    benchRendering(schematic, extent, kind, size);
+    benchWireEdits(schematic, kind, size);
+
+    delete schematic;
+    return true;
+}
+
+bool BenchRunner::runParser(const QString &name, const QString &output)
+{
+    QValueList<Q_LLONG> times;
+    int numRows = 0;
+
+    for (int i = 0; i < m_iterations; ++i)
+    {
+        ResultTable table;
+        QString errorString;
+
+        Q_LLONG start = Trace::now();
+        if (!SpiceProcess::parseOutput(output, table, errorString))
+        {
+            m_errorString = QString("%1: %2").arg(name).arg(errorString);
+            return false;
+        }
+        times.append(Trace::now() - start);
+
+        numRows = table.numRows();
+    }
+
+    addResult("SpiceProcess::parseOutput", name, numRows, 1, times);
+    return true;
+}
+
+void BenchRunner::runNumbers(int numValues)
+{
+    // typical device values, once with suffixes and once as plain numbers
+    static const char *const suffixed[] = { "4.7k", "100meg", "1u", "2.2e-3", "10", "33p", "1.5mil", "68n" };
+    static const char *const plain[] = { "4700", "1e8", "1e-6", "2.2e-3", "10", "3.3e-11", "3.81e-5", "6.8e-8" };
+    const int numSamples = sizeof(suffixed) / sizeof(suffixed[0]);
+
+    QStringList suffixedValues;
+    QStringList plainValues;
+    QMemArray<double> values(numValues);
+    for (int i = 0; i < numValues; ++i)
+    {
+        suffixedValues.append(suffixed[i % numSamples]);
+        plainValues.append(plain[i % numSamples]);
+    }
+
+    QValueList<Q_LLONG> parseTimes;
+    QValueList<Q_LLONG> toDoubleTimes;
+    QValueList<Q_LLONG> formatTimes;
+    double sum = 0.0;
+
+    for (int i = 0; i < m_iterations; ++i)
+    {
+        int index = 0;
+        Q_LLONG start = Trace::now();
+        for (QStringList::ConstIterator it = suffixedValues.begin(); it != suffixedValues.end(); ++it)
+            SpiceNumber::parse(*it, values[index++]);
+        parseTimes.append(Trace::now() - start);
+
+        start = Trace::now();
+        for (QStringList::ConstIterator it = plainValues.begin(); it != plainValues.end(); ++it)
+            sum += (*it).toDouble();
+        toDoubleTimes.append(Trace::now() - start);
+
+        start = Trace::now();
+        for (int j = 0; j < numValues; ++j)
+            sum += SpiceNumber::format(values[j]).length();
+        formatTimes.append(Trace::now() - start);
+    }
+
+    // keeps the compiler from dropping the loops above
+    if (sum == 0.0)
+        qWarning("no values parsed");
+
+    addResult("SpiceNumber::parse", "device-values", numValues, numValues, parseTimes);
+    addResult("QString::toDouble", "device-values", numValues, numValues, toDoubleTimes);
+    addResult("SpiceNumber::format", "device-values", numValues, numValues, formatTimes);
+}
+
+QString BenchRunner::toJSON(const QString &label) const
+{
+    QString json = "{\n";
+    json += QString("  \"version\": \"%1\",\n").arg(VERSION);
+    json += QString("  \"label\": \"%1\",\n").arg(QString(label).replace('\\', "\\\\").replace('"', "\\\""));
+    json += QString("  \"date\": \"%1\",\n").arg(QDateTime::currentDateTime().toString(Qt::ISODate));
+    json += QString("  \"iterations\": %1,\n").arg(m_iterations);
+    json += "  \"results\": [\n    " + m_results.join(",\n    ") + "\n  ]\n}\n";
+    return json;
+}
+
+void BenchRunner::addResult(const QString &benchmark, const QString &input, int size, int numOperations, const QValueList<Q_LLONG> &times)
+{
+    QValueList<Q_LLONG> sorted = times;
+    qHeapSort(sorted);
+
+    Q_LLONG total = 0;
+    for (QValueList<Q_LLONG>::ConstIterator it = sorted.begin(); it != sorted.end(); ++it)
+        total += *it;
+
+    m_results << QString("{\"benchmark\": \"%1\", \"input\": \"%2\", \"size\": %3, \"operations\": %4, "
+                         "\"min_us\": %5, \"median_us\": %6, \"mean_us\": %7}")
+                 .arg(benchmark).arg(input).arg(size).arg(numOperations)
+                 .arg(QString::number(sorted.first()))
+                 .arg(QString::number(sorted[sorted.count() / 2]))
+                 .arg(QString::number(total / Q_LLONG(sorted.count())));
+}
+
+Schematic *BenchRunner::createSchematic(const QRect &extent) const
+{
+    Schematic *schematic = new Schematic;
+
+    // the default chunk size makes the chunk table of a large canvas huge
+    schematic->retune(128);
+    schematic->resize(QMAX(4000, extent.right() + 80), QMAX(4000, extent.bottom() + 80));
+
+    return schematic;
+}
+
+void BenchRunner::benchHitTesting(Schematic *schematic, const QRect &extent, const QString &kind, int numDevices)
+{
+    // a regular grid of probes over the occupied area
+    const int numSteps = 32;
+    QValueList<Q_LLONG> times;
+
+    for (int i = 0; i < m_iterations; ++i)
+    {
+        Q_LLONG start = Trace::now();
+        for (int row = 0; row < numSteps; ++row)
+        {
+            for (int col = 0; col < numSteps; ++col)
+            {
+                QPoint p(extent.left() + extent.width() * col / numSteps, extent.top() + extent.height() * row / numSteps);
+                schematic->findItem(p);
+                schematic->findPin(p);
+                schematic->findWire(p);
+            }
+        }
+        times.append(Trace::now() - start);
+    }
+
+    addResult("hit-test", kind, numDevices, numSteps * numSteps, times);
+}
+
+void BenchRunner::benchRendering(Schematic *schematic, const QRect &extent, const QString &kind, int numDevices)
+{
+    QPixmap pixmap(1024, 768);
+    QValueList<Q_LLONG> times;
+
+    for (int i = 0; i < m_iterations; ++i)
+    {
+        QRect rect(extent.topLeft(), pixmap.size());
+        QPainter p(&pixmap);
+        p.translate(-rect.x(), -rect.y());
+
+        Q_LLONG start = Trace::now();
+        schematic->drawArea(rect, &p);
+        times.append(Trace::now() - start);
+    }
+    addResult("render-viewport", kind, numDevices, 1, times);
+
+    times.clear();
+    for (int i = 0; i < m_iterations; ++i)
+    {
+        QPainter p(&pixmap);
+        double scale = QMIN(double(pixmap.width()) / extent.width(), double(pixmap.height()) / extent.height());
+        p.scale(scale, scale);
+        p.translate(-extent.x(), -extent.y());
+
+        Q_LLONG start = Trace::now();
+        schematic->drawArea(extent, &p);
+        times.append(Trace::now() - start);
+    }
+    addResult("render-overview", kind, numDevices, 1, times);
+}
+
+void BenchRunner::benchWireEdits(Schematic *schematic, const QString &kind, int numDevices)
+{
+    // Deleting a wire whose junction is left with less than three wires
+    // removes the junction, which the round trip below would not restore.
+    QValueList<SchematicWire *> wires;
+    QCanvasItemList l = schematic->allItems();
+    for (QCanvasItemList::Iterator it = l.begin(); it != l.end(); ++it)
+    {
+        if ((*it)->rtti() != SchematicWire::RTTI)
+            continue;
+
+        SchematicWire *wire = static_cast<SchematicWire *>(*it);
+        SchematicDevicePin *pins[] = { wire->end1()->pin(), wire->end2()->pin() };
+
+        bool ok = true;
+        for (int i = 0; i < 2; ++i)
+            if (pins[i]->device()->id() == SchematicJunction::ID && pins[i]->wireCount() < 3)
+                ok = false;
+
+        if (ok)
+            wires.append(wire);
+    }
+
+    // spread the edits over the whole schematic
+    const int maxEdits = 20;
+    QValueList<SchematicWire *> edits;
+    int step = QMAX(1, int(wires.count()) / maxEdits);
+    for (int i = 0; i < int(wires.count()) && int(edits.count()) < maxEdits; i += step)
+        edits.append(wires[i]);
+
+    if (edits.isEmpty())
+        return;
+
+    QValueList<Q_LLONG> deleteTimes, placeTimes;
+
+    for (int i = 0; i < m_iterations; ++i)
+    {
+        Q_LLONG deleteTime = 0, placeTime = 0;
+
+        for (QValueList<SchematicWire *>::Iterator it = edits.begin(); it != edits.end(); ++it)
+        {
+            SchematicDevicePin *pin1 = (*it)->end1()->pin();
+            SchematicDevicePin *pin2 = (*it)->end2()->pin();
+            QPointArray vertices = (*it)->vertices();
+
+            Q_LLONG start = Trace::now();
+            SchematicCommand *deleteCmd = new SchematicCommandDeleteWire(*it);
+            deleteCmd->execute();
+            deleteTime += Trace::now() - start;
+
+            start = Trace::now();
+            SchematicWire *wire = new SchematicWire(pin1, pin2, schematic);
+            wire->setVertices(vertices);
+            wire->show();
+            SchematicCommand *placeCmd = new SchematicCommandPlaceWire(wire);
+            placeTime += Trace::now() - start;
+
+            // undo both, so that every pass starts from the loaded schematic
+            placeCmd->unexecute();
+            delete placeCmd;
+            deleteCmd->unexecute();
+            delete deleteCmd;
+        }
+
+        deleteTimes.append(deleteTime);
+        placeTimes.append(placeTime);
+    }
+
+    addResult("SchematicCommandDeleteWire", kind, numDevices, edits.count(), deleteTimes);
+    addResult("SchematicCommandPlaceWire", kind, numDevices, edits.count(), placeTimes);
+}
+
+// Produces output in the format of the spice3 print command.
+static QString synthesizeOutput(int numRows, int numColumns)
+{
+    QString output;
+    QTextStream stream(&output, IO_WriteOnly);
+
+    stream << "Circuit: Generated by SPICE+ " VERSION "\n\n";
+    stream << "--------------------------------------------------------------------------------\n";
+    stream << "Index   frequency       ";
+    for (int col = 1; col < numColumns; ++col)
+        stream << "v(" << col << ")            ";
+    stream << "\n--------------------------------------------------------------------------------\n";
+
+    for (int row = 0; row < numRows; ++row)
+    {
+        stream << row << "\t" << QString::number(1.0 + row * 10.0, 'e', 6);
+        for (int col = 2; col < numColumns; ++col)
+            stream << ",\t" << QString::number(1.0 / (col + row), 'e', 6);
+        stream << "\n";
+    }
+    stream << "\n";
+
+    return output;
+}
+
+int main(int argc, char **argv)
+{
+    KAboutData about("spiceplus-bench", "SPICE+ Benchmark", VERSION,
+                     description,
+                     KAboutData::License_GPL,
+                     "(c) 2004, Andreas Unger", 0, "http://spiceplus.sourceforge.net", "a_unger@gmx.de");
+
+    KCmdLineArgs::init(argc, argv, &about);
+    KCmdLineArgs::addCmdLineOptions(options);
+
+    // a GUI application, because rendering needs pixmaps and fonts
+    KApplication app;
+    Settings::self()->readConfig();
+
+    KCmdLineArgs *args = KCmdLineArgs::parsedArgs();
+    BenchRunner runner(QString(args->getOption("iterations")).toInt());
+
+    QStringList generators = QStringList::split(',', args->getOption("generators"));
+    QStringList sizes = QStringList::split(',', args->getOption("sizes"));
+
+    for (QStringList::Iterator sizeIt = sizes.begin(); sizeIt != sizes.end(); ++sizeIt)
+    {
+        int numDevices = (*sizeIt).toInt();
+
+        for (QStringList::Iterator it = generators.begin(); it != generators.end(); ++it)
+        {
+            if (!runner.runGenerator(*it, numDevices))
+            {
+                qWarning("%s, %d devices: %s", (*it).latin1(), numDevices, runner.errorString().local8Bit().data());
+                return 1;
+            }
+        }
+
+        if (!runner.runParser("synthetic", synthesizeOutput(numDevices, 5)))
+        {
+            qWarning("%s", runner.errorString().local8Bit().data());
+            return 1;
+        }
+    }
+
+    runner.runNumbers(100000);
+
+    QCStringList recorded = args->getOptionList("spice-output");
+    for (QCStringList::Iterator it = recorded.begin(); it != recorded.end(); ++it)
+    {
+        QFile file(QFile::decodeName(*it));
+        if (!file.open(IO_ReadOnly))
+        {
+            qWarning("Could not open %s", (*it).data());
+            return 1;
+        }
+
+        if (!runner.runParser(QFileInfo(file).fileName(), QString::fromLatin1(file.readAll())))
+        {
+            qWarning("%s", runner.errorString().local8Bit().data());
+            return 1;
+        }
+    }
+
+    QString json = runner.toJSON(args->getOption("label"));
+
+    if (args->isSet("output"))
+    {
+        QFile file(QFile::decodeName(args->getOption("output")));
+        if (!file.open(IO_WriteOnly))
+        {
+            qWarning("Could not write %s", args->getOption("output").data());
+            return 1;
+        }
+        QTextStream(&file) << json;
+    }
+    else
+        QTextStream(stdout, IO_WriteOnly) << json;
+
+    args->clear();
+    return 0;
+}
+
+// vim: ts=4 sw=4 et
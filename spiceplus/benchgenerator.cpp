@@ -0,0 +1,394 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+
+#include <qvaluevector.h>
+
+#include "benchgenerator.h"
+#include "schematic.h"
+#include "schematicwire.h"
+#include "schematicstandarddevice.h"
+#include "schematicground.h"
+#include "schematicjunction.h"
+#include "pluginmanager.h"
+
+using namespace Spiceplus;
+
+BenchGenerator::BenchGenerator(Schematic *schematic)
+    : m_schematic(schematic), m_nextNode(1), m_numDevices(0)
+{
+}
+
+QStringList BenchGenerator::kinds()
+{
+    return QStringList() << "rc-ladder" << "resistor-mesh" << "diode-array" << "junction-tree";
+}
+
+bool BenchGenerator::generate(const QString &kind, int numDevices)
+{
+    bool ok;
+
+    if (kind == "rc-ladder")
+        ok = generateRCLadder(numDevices);
+    else if (kind == "resistor-mesh")
+        ok = generateResistorMesh(numDevices);
+    else if (kind == "diode-array")
+        ok = generateDiodeArray(numDevices);
+    else if (kind == "junction-tree")
+        ok = generateJunctionTree(numDevices);
+    else
+    {
+        m_errorString = QString("Unknown generator %1").arg(kind);
+        return false;
+    }
+
+    if (!ok)
+        return false;
+
+    m_extent = QRect();
+    QCanvasItemList l = m_schematic->allItems();
+    for (QCanvasItemList::Iterator it = l.begin(); it != l.end(); ++it)
+        m_extent |= (*it)->boundingRect();
+
+    // items outside the canvas are not found by collision tests
+    m_schematic->resize(QMAX(m_schematic->width(), m_extent.right() + 80), QMAX(m_schematic->height(), m_extent.bottom() + 80));
+    return true;
+}
+
+bool BenchGenerator::generateRCLadder(int numDevices)
+{
+    // V1 feeding stages of a series resistor and a capacitor to ground
+    int numStages = QMAX(1, (numDevices - 2) / 3);
+    int numColumns = QMAX(1, int(sqrt(double(numStages))));
+
+    SchematicStandardDevice *src = placeSource(40, 40);
+    SchematicGround *gnd = placeGround(40, 160);
+    if (!src || !gnd)
+        return false;
+
+    connect(src->findPin("n"), gnd->pin());
+    SchematicDevicePin *prev = src->findPin("p");
+
+    for (int i = 0; i < numStages; ++i)
+    {
+        int x = 160 + (i % numColumns) * 160;
+        int y = 40 + (i / numColumns) * 240;
+
+        SchematicStandardDevice *r = placeDevice("Standard/Resistor", "R", x, y);
+        SchematicStandardDevice *c = placeDevice("Standard/Capacitor", "C", x + 80, y + 80);
+        SchematicGround *g = placeGround(x + 80, y + 160);
+        if (!r || !c || !g)
+            return false;
+
+        r->setParameter("value", "1k");
+        r->updateLabels();
+        c->setParameter("value", "1n");
+        c->updateLabels();
+
+        connect(c->findPin("n"), g->pin());
+        connect(prev, r->findPin("a"));
+        connect(r->findPin("b"), c->findPin("p"));
+        prev = c->findPin("p");
+    }
+
+    return true;
+}
+
+bool BenchGenerator::generateResistorMesh(int numDevices)
+{
+    // k x k junctions with resistors between neighbours, driven between
+    // two opposite corners
+    int k = QMAX(2, int(ceil(sqrt(numDevices / 3.0))));
+
+    SchematicStandardDevice *src = placeSource(40, 40);
+    SchematicGround *gnd = placeGround(120, 40);
+    if (!src || !gnd)
+        return false;
+
+    connect(src->findPin("n"), gnd->pin());
+
+    QValueVector<SchematicJunction *> junctions(k * k);
+    for (int row = 0; row < k; ++row)
+    {
+        for (int col = 0; col < k; ++col)
+        {
+            SchematicJunction *jun = placeJunction(40 + col * 120, 160 + row * 120);
+            junctions[row * k + col] = jun;
+
+            if (col > 0)
+            {
+                SchematicStandardDevice *r = placeDevice("Standard/Resistor", "R", col * 120 - 20, 160 + row * 120);
+                if (!r)
+                    return false;
+                r->setParameter("value", "1k");
+                r->updateLabels();
+                connect(junctions[row * k + col - 1]->pin(), r->findPin("a"));
+                connect(r->findPin("b"), jun->pin());
+            }
+
+            if (row > 0)
+            {
+                SchematicStandardDevice *r = placeDevice("Standard/Resistor", "R", 40 + col * 120, row * 120 + 100);
+                if (!r)
+                    return false;
+                r->setParameter("value", "1k");
+                r->updateLabels();
+                connect(junctions[(row - 1) * k + col]->pin(), r->findPin("a"));
+                connect(r->findPin("b"), jun->pin());
+            }
+        }
+    }
+
+    connect(src->findPin("p"), junctions[0]->pin());
+
+    SchematicGround *g = placeGround(40 + k * 120, 160 + (k - 1) * 120);
+    if (!g)
+        return false;
+    connect(junctions[k * k - 1]->pin(), g->pin());
+
+    return true;
+}
+
+bool BenchGenerator::generateDiodeArray(int numDevices)
+{
+    // a rail of junctions, each feeding a diode and a resistor to ground
+    int numBranches = QMAX(1, (numDevices - 2) / 4);
+    int numColumns = QMAX(1, int(sqrt(double(numBranches))));
+
+    SchematicStandardDevice *src = placeSource(40, 40);
+    SchematicGround *gnd = placeGround(40, 160);
+    if (!src || !gnd)
+        return false;
+
+    connect(src->findPin("n"), gnd->pin());
+    SchematicDevicePin *rail = src->findPin("p");
+
+    for (int i = 0; i < numBranches; ++i)
+    {
+        int x = 160 + (i % numColumns) * 120;
+        int y = 40 + (i / numColumns) * 320;
+
+        SchematicJunction *jun = placeJunction(x, y);
+        SchematicStandardDevice *d = placeDevice("Standard/Diode", "D", x + 40, y + 60);
+        SchematicStandardDevice *r = placeDevice("Standard/Resistor", "R", x + 40, y + 140);
+        SchematicGround *g = placeGround(x + 40, y + 220);
+        if (!d || !r || !g)
+            return false;
+
+        d->setModelPath("standard:d/1N4148.model");
+        d->setModelName("1N4148");
+        d->setParameter("area", "1");
+        d->updateLabels();
+        r->setParameter("value", "1k");
+        r->updateLabels();
+
+        connect(rail, jun->pin());
+        connect(jun->pin(), d->findPin("p"));
+        connect(r->findPin("b"), g->pin());
+        connect(d->findPin("n"), r->findPin("a"));
+        rail = jun->pin();
+    }
+
+    return true;
+}
+
+bool BenchGenerator::generateJunctionTree(int numDevices)
+{
+    // a binary tree of junctions on a single net, each leaf loaded by a
+    // resistor to ground
+    int numLeaves = QMAX(2, (numDevices - 2) / 4);
+    int numLevels = int(ceil(log(double(numLeaves)) / log(2.0))) + 1;
+    int leafY = 40 + numLevels * 60;
+
+    SchematicNode *net = createNode();
+
+    QValueVector<SchematicJunction *> level(numLeaves);
+    for (int i = 0; i < numLeaves; ++i)
+    {
+        int x = 160 + i * 40;
+
+        SchematicJunction *jun = placeJunction(x, leafY);
+        jun->pin()->setNode(net);
+        SchematicStandardDevice *r = placeDevice("Standard/Resistor", "R", x, leafY + 60);
+        SchematicGround *g = placeGround(x, leafY + 140);
+        if (!r || !g)
+            return false;
+
+        r->setParameter("value", "1k");
+        r->updateLabels();
+
+        connect(r->findPin("b"), g->pin());
+        connect(jun->pin(), r->findPin("a"));
+        level[i] = jun;
+    }
+
+    for (int y = leafY - 60; level.size() > 1; y -= 60)
+    {
+        QValueVector<SchematicJunction *> parents;
+        for (size_t i = 0; i < level.size(); i += 2)
+        {
+            if (i + 1 == level.size())
+            {
+                parents.push_back(level[i]);
+                continue;
+            }
+
+            SchematicJunction *jun = placeJunction((int(level[i]->x()) + int(level[i + 1]->x())) / 20 * 10, y);
+            jun->pin()->setNode(net);
+            connect(jun->pin(), level[i]->pin());
+            connect(jun->pin(), level[i + 1]->pin());
+            parents.push_back(jun);
+        }
+        level = parents;
+    }
+
+    SchematicStandardDevice *src = placeSource(40, 40);
+    SchematicGround *gnd = placeGround(40, 160);
+    if (!src || !gnd)
+        return false;
+
+    connect(src->findPin("n"), gnd->pin());
+    connect(src->findPin("p"), level[0]->pin());
+
+    return true;
+}
+
+SchematicStandardDevice *BenchGenerator::placeDevice(const QString &deviceID, const QString &prefix, int x, int y)
+{
+    SchematicDeviceFactory *factory = PluginManager::self()->deviceFactory(deviceID);
+    if (!factory)
+    {
+        m_errorString = PluginManager::self()->errorString();
+        return 0;
+    }
+
+    // all shipped plugins derive from SchematicStandardDevice
+    SchematicStandardDevice *dev = static_cast<SchematicStandardDevice *>(factory->createDevice(m_schematic));
+    if (!dev)
+    {
+        m_errorString = QString("Could not create device %1").arg(deviceID);
+        return 0;
+    }
+
+    if (!dev->loadSymbol())
+    {
+        m_errorString = dev->errorString();
+        delete dev;
+        return 0;
+    }
+
+    // Schematic::createUniqueDeviceName() is too slow for large circuits
+    dev->setName(prefix + QString::number(++m_nameCounters[prefix]));
+    dev->move(x, y);
+    dev->show();
+    ++m_numDevices;
+
+    return dev;
+}
+
+SchematicStandardDevice *BenchGenerator::placeSource(int x, int y)
+{
+    SchematicStandardDevice *src = placeDevice("Standard/IndependentVoltageSource", "V", x, y);
+    if (!src)
+        return 0;
+
+    src->setParameter("type", "dc");
+    src->setParameter("dcvalue", "1");
+    src->setParameter("acmag", "1");
+    src->setParameter("acphase", "0");
+    src->updateLabels();
+
+    return src;
+}
+
+SchematicGround *BenchGenerator::placeGround(int x, int y)
+{
+    SchematicGround *gnd = new SchematicGround(m_schematic);
+    if (!gnd->initialize())
+    {
+        m_errorString = gnd->errorString();
+        delete gnd;
+        return 0;
+    }
+
+    gnd->setName(SchematicGround::Name + QString::number(++m_nameCounters[SchematicGround::Name]));
+    gnd->move(x, y);
+    gnd->show();
+    gnd->pin()->setNode(m_schematic->findNode("0"));
+    ++m_numDevices;
+
+    return gnd;
+}
+
+SchematicJunction *BenchGenerator::placeJunction(int x, int y)
+{
+    // constructed without a schematic, so that it is not named
+    SchematicJunction *jun = new SchematicJunction(0);
+    jun->setName(SchematicJunction::Name + QString::number(++m_nameCounters[SchematicJunction::Name]));
+    jun->setSchematic(m_schematic);
+    jun->move(x, y);
+    jun->show();
+    ++m_numDevices;
+
+    return jun;
+}
+
+SchematicNode *BenchGenerator::createNode()
+{
+    SchematicNode *node = new SchematicNode(QString::number(m_nextNode++));
+    m_schematic->addNode(node);
+    return node;
+}
+
+void BenchGenerator::connect(SchematicDevicePin *pin1, SchematicDevicePin *pin2)
+{
+    SchematicWire *wire = new SchematicWire(pin1, pin2, m_schematic);
+    wire->show();
+
+    SchematicNode *node1 = pin1->node();
+    SchematicNode *node2 = pin2->node();
+
+    if (!node1 && !node2)
+    {
+        SchematicNode *node = createNode();
+        pin1->setNode(node);
+        pin2->setNode(node);
+    }
+    else if (!node1)
+        pin1->setNode(node2);
+    else if (!node2)
+        pin2->setNode(node1);
+    else if (node1 != node2)
+    {
+        // keep the ground node when merging
+        if (node2->name() == "0")
+        {
+            SchematicNode *node = node1;
+            node1 = node2;
+            node2 = node;
+        }
+
+        m_schematic->removeNode(node2);
+        m_schematic->setNodePins(node2->pins().first(), node1);
+        delete node2;
+    }
+}
+
+// vim: ts=4 sw=4 et
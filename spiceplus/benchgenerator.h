@@ -0,0 +1,79 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BENCHGENERATOR_H
+#define BENCHGENERATOR_H
+
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qrect.h>
+#include <qmap.h>
+
+namespace Spiceplus {
+
+class Schematic;
+class SchematicNode;
+class SchematicDevicePin;
+class SchematicStandardDevice;
+class SchematicGround;
+class SchematicJunction;
+
+// Fills a schematic with a synthetic circuit of about the requested number
+// of devices (grounds and junctions included) for benchmarking. Nodes are
+// assigned directly, so generating large circuits stays linear.
+class BenchGenerator
+{
+public:
+    BenchGenerator(Schematic *schematic);
+
+    static QStringList kinds();
+
+    bool generate(const QString &kind, int numDevices);
+
+    int numDevices() const { return m_numDevices; }
+    QRect extent() const { return m_extent; }
+    QString errorString() const { return m_errorString; }
+
+private:
+    bool generateRCLadder(int numDevices);
+    bool generateResistorMesh(int numDevices);
+    bool generateDiodeArray(int numDevices);
+    bool generateJunctionTree(int numDevices);
+
+    SchematicStandardDevice *placeDevice(const QString &deviceID, const QString &prefix, int x, int y);
+    SchematicStandardDevice *placeSource(int x, int y);
+    SchematicGround *placeGround(int x, int y);
+    SchematicJunction *placeJunction(int x, int y);
+
+    SchematicNode *createNode();
+    void connect(SchematicDevicePin *pin1, SchematicDevicePin *pin2);
+
+    Schematic *m_schematic;
+    QMap<QString, int> m_nameCounters;
+    int m_nextNode;
+    int m_numDevices;
+    QRect m_extent;
+    QString m_errorString;
+};
+
+} // namespace Spiceplus
+
+#endif // BENCHGENERATOR_H
+
+// vim: ts=4 sw=4 et
@@ -29,6 +29,7 @@
 #include <kcolorbutton.h>
 #include <kfontrequester.h>
 #include <kurlrequester.h>
+#include <knuminput.h>
 #include <kstandarddirs.h>
 #include <kmessagebox.h>
 
@@ -50,6 +51,7 @@ ConfigDialog::ConfigDialog(QWidget *parent, const char *name)
     addPage(new ConfigDialogPageSchematicEditor, i18n("Schematic Editor"), "misc_doc", i18n("Customize the schematic editor"));
     addPage(new ConfigDialogPageAnalysis, i18n("Analysis"), "misc_doc", i18n("Analysis settings"));
     addPage(m_pathsPage = new ConfigDialogPagePaths, i18n("Paths"), "misc_doc", i18n("Configure paths"));
+    addPage(new ConfigDialogPageTracing, i18n("Tracing"), "misc_doc", i18n("Record startup and analysis timings"));
 
     connect(m_pathsPage, SIGNAL(widgetModified()), SIGNAL(widgetModified()));
     connect(m_pathsPage, SIGNAL(widgetModified()), SLOT(updateButtons()));
@@ -165,11 +167,57 @@ ConfigDialogPageAnalysis::ConfigDialogPageAnalysis()
     QBoxLayout *vbox = new QVBoxLayout(this, 0, KDialog::spacingHint());
 
     GroupBox *group = new GroupBox(0, Qt::Vertical, i18n("AC Analysis"), this);
-    QGridLayout *grid = new QGridLayout(group->layout(), 1, 2, KDialog::spacingHint());
+    QGridLayout *grid = new QGridLayout(group->layout(), 4, 2, KDialog::spacingHint());
     grid->addWidget(new QLabel(i18n("Number of points per decade:"), group), 0, 0);
     grid->addWidget(new QSpinBox(1, 999999, 1, group, "kcfg_ACAnalysisNumPointsPerDecade"), 0, 1);
+
+    QCheckBox *adaptive = new QCheckBox(i18n("Add points where the curve bends (built-in solver only)"), group, "kcfg_ACAnalysisAdaptive");
+    grid->addMultiCellWidget(adaptive, 1, 1, 0, 1);
+    QLabel *label = new QLabel(i18n("Tolerance [dB]:"), group);
+    grid->addWidget(label, 2, 0);
+    label->setEnabled(adaptive->isChecked());
+    label->connect(adaptive, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    KDoubleNumInput *tolerance = new KDoubleNumInput(group, "kcfg_ACAnalysisTolerance");
+    tolerance->setRange(0.001, 10, 0.01, false);
+    tolerance->setPrecision(3);
+    grid->addWidget(tolerance, 2, 1);
+    tolerance->setEnabled(adaptive->isChecked());
+    tolerance->connect(adaptive, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    label = new QLabel(i18n("Maximum number of points:"), group);
+    grid->addWidget(label, 3, 0);
+    label->setEnabled(adaptive->isChecked());
+    label->connect(adaptive, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    QSpinBox *maxPoints = new QSpinBox(2, 999999, 100, group, "kcfg_ACAnalysisMaxPoints");
+    grid->addWidget(maxPoints, 3, 1);
+    maxPoints->setEnabled(adaptive->isChecked());
+    maxPoints->connect(adaptive, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
     vbox->addWidget(group);
 
+    vbox->addWidget(new QCheckBox(i18n("Solve linear circuits without SPICE"), this, "kcfg_UseBuiltInSolver"));
+
+    QBoxLayout *hbox = new QHBoxLayout(vbox, KDialog::spacingHint());
+    hbox->addWidget(new QLabel(i18n("Parallel SPICE runs:"), this));
+    QSpinBox *spin = new QSpinBox(0, 256, 1, this, "kcfg_NumSpiceJobs");
+    spin->setSpecialValueText(i18n("One per processor"));
+    hbox->addWidget(spin);
+    hbox->addStretch();
+
+    hbox = new QHBoxLayout(vbox, KDialog::spacingHint());
+    hbox->addWidget(new QLabel(i18n("Time limit per SPICE run:"), this));
+    spin = new QSpinBox(0, 86400, 10, this, "kcfg_SpiceTimeLimit");
+    spin->setSpecialValueText(i18n("None"));
+    spin->setSuffix(i18n(" s"));
+    hbox->addWidget(spin);
+    hbox->addStretch();
+
+    hbox = new QHBoxLayout(vbox, KDialog::spacingHint());
+    hbox->addWidget(new QLabel(i18n("Memory limit per SPICE run:"), this));
+    spin = new QSpinBox(0, 65536, 64, this, "kcfg_SpiceMemoryLimit");
+    spin->setSpecialValueText(i18n("None"));
+    spin->setSuffix(i18n(" MB"));
+    hbox->addWidget(spin);
+    hbox->addStretch();
+
     vbox->addStretch();
 }
 
@@ -241,6 +289,37 @@ bool ConfigDialogPagePaths::hasChanged()
     return Settings::self()->userSymbolDirs() != m_symbolDirsEdit->dirs() || Settings::self()->userModelDirs() != m_modelDirsEdit->dirs();
 }
 
+//
+// ConfigDialogPageTracing
+//
+
+ConfigDialogPageTracing::ConfigDialogPageTracing()
+{
+    QBoxLayout *vbox = new QVBoxLayout(this, 0, KDialog::spacingHint());
+
+    QCheckBox *checkBox = new QCheckBox(i18n("Record trace"), this, "kcfg_TraceEnabled");
+    vbox->addWidget(checkBox);
+
+    QGridLayout *grid = new QGridLayout(vbox, 1, 2, KDialog::spacingHint());
+    QLabel *label = new QLabel(i18n("Trace file:"), this);
+    label->setEnabled(checkBox->isChecked());
+    label->connect(checkBox, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    grid->addWidget(label, 0, 0);
+    KURLRequester *req = new KURLRequester(this, "kcfg_TraceFile");
+    req->setMode(KFile::File);
+    req->setFilter("*.json");
+    req->setEnabled(checkBox->isChecked());
+    req->connect(checkBox, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    grid->addWidget(req, 0, 1);
+
+    label = new QLabel(i18n("The trace is written when recording is switched off or SPICE+ exits. "
+                            "It can be viewed with chrome://tracing or Perfetto."), this);
+    label->setAlignment(Qt::WordBreak);
+    vbox->addWidget(label);
+
+    vbox->addStretch();
+}
+
 #include "configdialog.moc"
 
 // vim: ts=4 sw=4 et
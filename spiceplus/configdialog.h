@@ -83,6 +83,14 @@ private:
     ModelDirsEdit *m_modelDirsEdit;
 };
 
+class ConfigDialogPageTracing : public QWidget
+{
+    Q_OBJECT
+
+public:
+    ConfigDialogPageTracing();
+};
+
 } // namespace Spiceplus
 
 #endif // CONFIGDIALOG_H
@@ -17,6 +17,8 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <math.h>
+
 #include <qlayout.h>
 
 #include <klocale.h>
@@ -25,13 +27,17 @@
 #include "schematicdevice.h"
 #include "schematicview.h"
 #include "plot.h"
+#include "plotcurve.h"
 #include "settings.h"
 #include "spiceprocess.h"
+#include "spicejobscheduler.h"
+#include "spicenumber.h"
+#include "trace.h"
 
 using namespace Spiceplus;
 
 DCAnalysisDialog::DCAnalysisDialog(SchematicView *view,
-                                   const Meter &meter,
+                                   const MeterList &meters,
                                    const QString &sourceName,
                                    const QString &startingValue,
                                    const QString &finalValue,
@@ -49,8 +55,16 @@ DCAnalysisDialog::DCAnalysisDialog(SchematicView *view,
       m_startingValue2(startingValue2),
       m_finalValue2(finalValue2),
       m_incrementingValue2(incrementingValue2),
-      m_meter(meter)
+      m_meters(meters),
+      m_isFailureReported(false),
+      m_numCurvesPerMeter(0)
 {
+    m_scheduler = new SpiceJobScheduler(this);
+    connect(m_scheduler, SIGNAL(jobFinished(int, const ResultTable &)), SLOT(plotJob(int, const ResultTable &)));
+    connect(m_scheduler, SIGNAL(jobFailed(int, const QString &, const QString &)), SLOT(reportJobFailure(int, const QString &, const QString &)));
+    connect(m_scheduler, SIGNAL(finished()), SLOT(measureRun()));
+    connect(m_scheduler, SIGNAL(finished()), SLOT(finishSplitSweep()));
+
     SchematicDevice *dev = m_view->schematic()->findDevice(m_sourceName);
     QString unit;
     if (dev->type() == "v")
@@ -58,29 +72,51 @@ DCAnalysisDialog::DCAnalysisDialog(SchematicView *view,
     else if (dev->type() = "i")
         unit = " [A]";
 
-    setCaption(i18n("DC Plot %1,%2").arg(m_sourceName).arg(m_meter.name()));
+    setCaption(i18n("DC Plot %1,%2").arg(m_sourceName).arg(Meter::names(m_meters)));
     m_plot = new Plot(centralWidget());
     m_plot->setAxisTitle(QwtPlot::xBottom, "Source value" + unit);
-    m_plot->setAxisTitle(QwtPlot::yLeft, "Measured value [" + m_meter.shortUnit() + "]");
+    m_plot->setAxisTitle(QwtPlot::yLeft, "Measured value [" + Meter::shortUnits(m_meters) + "]");
+    if (m_meters.count() > 1)
+    {
+        m_plot->setAutoLegend(true);
+        m_plot->enableLegend(true);
+    }
     m_plotLayout->addWidget(m_plot);
 }
 
 bool DCAnalysisDialog::runAnalysis()
 {
-    QString cmdList = m_view->schematic()->createCommandList();
-    if (cmdList.isNull())
+    // the jobs of an earlier split sweep are of no use any more
+    m_scheduler->cancel();
+
+    // the built-in solver names its vectors like SPICE
+    m_meterCmds.clear();
+    for (MeterList::Iterator it = m_meters.begin(); it != m_meters.end(); ++it)
     {
-        m_errorString = m_view->schematic()->errorString();
-        return false;
+        QString meterCmd = (*it).createCommand(m_view->schematic());
+        if (meterCmd.isNull())
+        {
+            m_errorString = (*it).errorString();
+            return false;
+        }
+        m_meterCmds.append(meterCmd);
     }
 
-    QString meterCmd = m_meter.createCommand(m_view->schematic());
-    if (meterCmd.isNull())
+    ResultTable table;
+    if (solveDC(table))
+    {
+        plotData(table);
+        return true;
+    }
+
+    QString cmdList = m_view->schematic()->createCommandList();
+    if (cmdList.isNull())
     {
-        m_errorString = m_meter.errorString();
+        m_errorString = m_view->schematic()->errorString();
         return false;
     }
 
+    cmdList += createSaveCommand(m_meters);
     cmdList += ".control\n"
                "set nobreak\n"
                ".endc\n";
@@ -91,7 +127,9 @@ bool DCAnalysisDialog::runAnalysis()
         m_errorString = i18n("Source %1 not found").arg(m_sourceName);
         return false;
     }
-    cmdList += ".dc " + src->type() + src->name().lower() + " " + m_startingValue + " " + m_finalValue + " " + m_incrementingValue;
+    QString sweep1 = src->type() + src->name().lower() + " " + m_startingValue + " " + m_finalValue + " " + incrementingValue();
+    QString printCmd = ".print dc " + m_meterCmds.join(" ") + "\n"
+                       ".end\n";
 
     if (!m_sourceName2.isNull())
     {
@@ -101,14 +139,19 @@ bool DCAnalysisDialog::runAnalysis()
             m_errorString = i18n("Source %1 not found").arg(m_sourceName2);
             return false;
         }
-        cmdList += " " + src2->type() + src2->name().lower() + " " + m_startingValue2 + " " + m_finalValue2 + " " + m_incrementingValue2;
+
+        QString source2 = src2->type() + src2->name().lower();
+        if (startSplitSweep(cmdList, sweep1, source2, printCmd))
+            return true;
+
+        cmdList += ".dc " + sweep1 + " " + source2 + " " + m_startingValue2 + " " + m_finalValue2 + " " + m_incrementingValue2 + "\n";
     }
+    else
+        cmdList += ".dc " + sweep1 + "\n";
 
-    cmdList += "\n"
-               ".print dc " + meterCmd + "\n"
-               ".end\n";
+    cmdList += printCmd;
 
-    if (!m_spiceProcess->start(cmdList, 3))
+    if (!m_spiceProcess->start(cmdList))
     {
         m_errorString = m_spiceProcess->errorString();
         return false;
@@ -117,33 +160,294 @@ bool DCAnalysisDialog::runAnalysis()
     return true;
 }
 
-void DCAnalysisDialog::plotData(const QValueVector<QMemArray<double> > &table)
+bool DCAnalysisDialog::isAnalysisRunning() const
 {
-    m_plot->removeCurves();
+    return AnalysisDialog::isAnalysisRunning() || m_scheduler->isRunning();
+}
+
+void DCAnalysisDialog::cancelAnalysis()
+{
+    m_scheduler->cancel();
+    AnalysisDialog::cancelAnalysis();
+}
+
+int DCAnalysisDialog::analysisProgress() const
+{
+    if (!m_scheduler->isRunning())
+        return AnalysisDialog::analysisProgress();
+
+    return 100 * m_scheduler->numFinishedJobs() / m_scheduler->numJobs();
+}
+
+bool DCAnalysisDialog::solveDC(ResultTable &table)
+{
+    LinearCircuit::ProbeList probes;
+    if (!prepareBuiltInSolver(m_meters, probes))
+        return false;
 
-    if (table[1].count() == 0)
+    LinearCircuit::Sweep sweep1, sweep2;
+    sweep1.source = m_sourceName;
+    if (!SpiceNumber::parse(m_startingValue, sweep1.start) ||
+        !SpiceNumber::parse(m_finalValue, sweep1.stop) ||
+        !SpiceNumber::parse(incrementingValue(), sweep1.step))
+        return false;
+
+    if (!m_sourceName2.isNull())
+    {
+        sweep2.source = m_sourceName2;
+        if (!SpiceNumber::parse(m_startingValue2, sweep2.start) ||
+            !SpiceNumber::parse(m_finalValue2, sweep2.stop) ||
+            !SpiceNumber::parse(m_incrementingValue2, sweep2.step))
+            return false;
+    }
+
+    return m_circuit.dcSweep(sweep1, sweep2, probes, table);
+}
+
+bool DCAnalysisDialog::startSplitSweep(const QString &cmdList, const QString &sweep1, const QString &source2, const QString &printCmd)
+{
+    double start, stop, step;
+    if (SpiceJobScheduler::maxRunningJobs() < 2 ||
+        !SpiceNumber::parse(m_startingValue2, start) ||
+        !SpiceNumber::parse(m_finalValue2, stop) ||
+        !SpiceNumber::parse(m_incrementingValue2, step) ||
+        step == 0 || (stop - start) / step < 0)
+        return false;
+
+    // SPICE allows for some rounding at the end of a sweep, so do we
+    uint numValues = uint(floor((stop - start) / step + 1e-9)) + 1;
+    if (numValues < 2)
+        return false;
+
+    // a few jobs per processor even out differences in run time, but
+    // each job costs a start of SPICE
+    uint numJobs = QMIN(numValues, uint(4 * SpiceJobScheduler::maxRunningJobs()));
+    uint valuesPerJob = (numValues + numJobs - 1) / numJobs;
+
+    QStringList commandLists;
+    m_jobCurves.clear();
+    for (uint first = 0; first < numValues; first += valuesPerJob)
+    {
+        uint last = QMIN(first + valuesPerJob, numValues) - 1;
+        commandLists.append(cmdList + ".dc " + sweep1 + " " + source2 + " "
+                                    + SpiceNumber::format(start + first * step) + " "
+                                    + SpiceNumber::format(start + last * step) + " "
+                                    + m_incrementingValue2 + "\n"
+                                    + printCmd);
+        m_jobCurves.append(first);
+    }
+    m_jobTables.clear();
+    m_jobTables.resize(m_jobCurves.size());
+
+    // the curves of the last run stay until their job replaces them
+    setCurveCount(numValues);
+    m_isFailureReported = false;
+    m_scheduler->run(commandLists);
+    return true;
+}
+
+QString DCAnalysisDialog::incrementingValue() const
+{
+    double step;
+    if (densityDivisor() == 1 || !SpiceNumber::parse(m_incrementingValue, step))
+        return m_incrementingValue;
+
+    return QString::number(step * densityDivisor());
+}
+
+void DCAnalysisDialog::plotData(const ResultTable &table)
+{
+    TraceSpan span("DCAnalysisDialog::plotData");
+
+    // curves are updated in place as long as their number stays the same
+    const QMemArray<double> &axis = table.axis();
+    uint numCurves = 0;
+    if (table.numRows() > 0)
+    {
+        ++numCurves;
+        for (uint row = 1; row < table.numRows(); ++row)
+            if (axis[row] == axis[0])
+                ++numCurves;
+    }
+
+    setCurveCount(numCurves);
+    setCurveData(table, 0);
+    plotTraces(m_meters, table);
+    m_plot->replot();
+
+    storeRun(m_meters, table);
+}
+
+void DCAnalysisDialog::overlayRun(const ResultTable &table, const QString &label)
+{
+    uint numRows = table.numRows();
+    if (numRows == 0)
         return;
 
-    int firstRow = 0;
-    double firstValue = table[1][0];
-    for (size_t row = 1;; ++row)
+    const QMemArray<double> &axis = table.axis();
+    uint meter = 0;
+    for (MeterList::ConstIterator it = m_meters.begin(); it != m_meters.end(); ++it, ++meter)
     {
-        if (row == table[1].count() || table[1][row] == firstValue)
-        {
-            QwtPlotCurve *curve = new QwtPlotCurve(m_plot);
-            curve->setPen(Qt::red);
-            curve->setData(table[1].data() + firstRow, table[2].data() + firstRow, row - firstRow);
-            m_plot->insertCurve(curve);
-            m_curves.append(curve);
+        const QMemArray<double> &values = table.real(m_meterCmds[meter]);
+        if (values.size() != numRows)
+            continue;
 
-            if (row < table[1].count())
+        QString title = (*it).name() + " (" + label + ")";
+        uint firstRow = 0;
+        for (uint row = 1; row <= numRows; ++row)
+        {
+            if (row == numRows || axis[row] == axis[0])
+            {
+                QwtPlotCurve *curve = addOverlayCurve(m_plot, meter, m_meters.count(), title, firstRow == 0);
+                curve->setData(axis.data() + firstRow, values.data() + firstRow, row - firstRow);
                 firstRow = row;
-            else
-                break;
+            }
         }
     }
+    m_plot->replot();
+}
+
+void DCAnalysisDialog::plotJob(int job, const ResultTable &table)
+{
+    TraceSpan span("DCAnalysisDialog::plotJob");
 
+    setCurveData(table, m_jobCurves[job]);
     m_plot->replot();
+
+    m_jobTables[job] = table;
+}
+
+void DCAnalysisDialog::finishSplitSweep()
+{
+    // the jobs cover the values of the second source in order, so their
+    // rows follow each other as in a single run; a failed job leaves a gap
+    uint numRows = 0;
+    for (uint job = 0; job < m_jobTables.size(); ++job)
+    {
+        if (m_jobTables[job].isEmpty() || m_jobTables[job].numVectors() != m_jobTables[0].numVectors())
+        {
+            m_jobTables.clear();
+            return;
+        }
+        numRows += m_jobTables[job].numRows();
+    }
+
+    if (numRows == 0)
+        return;
+
+    const ResultTable &first = m_jobTables[0];
+    ResultTable table;
+    table.setAxis(first.axisName(), ResultTable::Real);
+    for (uint i = 0; i < first.numVectors(); ++i)
+        table.addVector(first.vectorName(i), first.vectorType(i));
+
+    table.reserve(numRows);
+    for (uint job = 0; job < m_jobTables.size(); ++job)
+        for (uint row = 0; row < m_jobTables[job].numRows(); ++row)
+            table.appendRow(m_jobTables[job], row);
+    m_jobTables.clear();
+
+    plotTraces(m_meters, table);
+    m_plot->replot();
+    storeRun(m_meters, table);
+}
+
+void DCAnalysisDialog::reportJobFailure(int, const QString &errorString, const QString &errorDetails)
+{
+    // the other jobs most likely fail the same way
+    if (m_isFailureReported)
+        return;
+
+    m_isFailureReported = true;
+    displayErrorMessage(errorString, errorDetails);
+}
+
+void DCAnalysisDialog::plotTrace(uint index, const QString &title, const ResultTable &table,
+                                 const QMemArray<double> &real, const QMemArray<double> &)
+{
+    // split at the repeats of the first value like the curves of the meters
+    uint numRows = table.numRows();
+    const QMemArray<double> &axis = table.axis();
+    uint firstRow = 0;
+    for (uint row = 1; row <= numRows; ++row)
+    {
+        if (row == numRows || axis[row] == axis[0])
+        {
+            QwtPlotCurve *curve = addTraceCurve(m_plot, index, title, firstRow == 0);
+            curve->setData(axis.data() + firstRow, real.data() + firstRow, row - firstRow);
+            firstRow = row;
+        }
+    }
+}
+
+void DCAnalysisDialog::setCurveCount(uint numCurves)
+{
+    if (numCurves == m_numCurvesPerMeter)
+        return;
+
+    clearOverlays();
+    m_plot->removeCurves();
+    m_curves.clear();
+    m_numCurvesPerMeter = numCurves;
+
+    uint numMeters = m_meters.count();
+    uint meter = 0;
+    for (MeterList::ConstIterator it = m_meters.begin(); it != m_meters.end(); ++it, ++meter)
+    {
+        QColor color = Qt::red;
+        if (numMeters > 1)
+            color.setHsv(300 * meter / (numMeters - 1), 255, 200);
+
+        for (uint i = 0; i < numCurves; ++i)
+        {
+            QwtPlotCurve *curve = new PlotCurve(m_plot, (*it).name());
+            curve->setPen(color);
+            long key = m_plot->insertCurve(curve);
+            // one legend entry per meter is enough
+            if (i > 0)
+                m_plot->enableLegend(false, key);
+            m_curves.append(curve);
+        }
+    }
+}
+
+void DCAnalysisDialog::setCurveData(const ResultTable &table, uint firstCurve)
+{
+    uint numRows = table.numRows();
+    if (numRows == 0)
+        return;
+
+    const QMemArray<double> &axis = table.axis();
+    for (uint meter = 0; meter < m_meterCmds.count(); ++meter)
+    {
+        const QMemArray<double> &values = table.real(m_meterCmds[meter]);
+        if (values.size() != numRows)
+            continue;
+
+        uint endCurve = (meter + 1) * m_numCurvesPerMeter;
+
+        // a nested sweep starts a new curve at each repeat of the first value
+        uint firstRow = 0;
+        uint curveIndex = meter * m_numCurvesPerMeter + firstCurve;
+        double firstValue = axis[0];
+        for (uint row = 1; curveIndex < endCurve; ++row)
+        {
+            if (row == numRows || axis[row] == firstValue)
+            {
+                // a curve of the whole table shares its columns, a part
+                // of one is copied
+                if (firstRow == 0 && row == numRows)
+                    m_curves[curveIndex++]->setData(axis, values);
+                else
+                    m_curves[curveIndex++]->setData(axis.data() + firstRow, values.data() + firstRow, row - firstRow);
+
+                if (row < numRows)
+                    firstRow = row;
+                else
+                    break;
+            }
+        }
+    }
 }
 
 #include "dcanalysisdialog.moc"
@@ -30,6 +30,7 @@ class QwtPlotCurve;
 namespace Spiceplus {
 
 class Plot;
+class SpiceJobScheduler;
 
 class DCAnalysisDialog : public AnalysisDialog
 {
@@ -37,7 +38,7 @@ class DCAnalysisDialog : public AnalysisDialog
 
 public:
     DCAnalysisDialog(SchematicView *view,
-                     const Meter &meter,
+                     const MeterList &meters,
                      const QString &sourceName,
                      const QString &startingValue,
                      const QString &finalValue,
@@ -47,12 +48,38 @@ public:
                      const QString &finalValue2 = QString::null,
                      const QString &incrementingValue2 = QString::null);
 
+    bool isAnalysisRunning() const;
+
+protected:
+    QString analysisName() const { return "DC"; }
+    void overlayRun(const ResultTable &table, const QString &label);
+    void plotTrace(uint index, const QString &title, const ResultTable &table,
+                   const QMemArray<double> &real, const QMemArray<double> &imag);
     bool runAnalysis();
+    void cancelAnalysis();
+    int analysisProgress() const;
 
 protected slots:
-    void plotData(const QValueVector<QMemArray<double> > &table);
+    void plotData(const ResultTable &table);
+
+private slots:
+    void plotJob(int job, const ResultTable &table);
+    void reportJobFailure(int job, const QString &errorString, const QString &errorDetails);
+    // joins the tables of the jobs and stores them as one run
+    void finishSplitSweep();
 
 private:
+    bool solveDC(ResultTable &table);
+    QString incrementingValue() const;
+    // Runs a nested sweep as several SPICE jobs, each covering a part of
+    // the values of the second source. Returns false if the sweep can't
+    // be split, the caller then runs it in one piece.
+    bool startSplitSweep(const QString &cmdList, const QString &sweep1, const QString &source2, const QString &printCmd);
+    // there are numCurves curves per meter, one for each value of the
+    // second source
+    void setCurveCount(uint numCurves);
+    void setCurveData(const ResultTable &table, uint firstCurve);
+
     QString m_sourceName;
     QString m_startingValue;
     QString m_finalValue;
@@ -61,10 +88,18 @@ private:
     QString m_startingValue2;
     QString m_finalValue2;
     QString m_incrementingValue2;
-    Meter m_meter;
+    MeterList m_meters;
+
+    SpiceJobScheduler *m_scheduler;
+    // the index of the first curve and the results of each job
+    QValueVector<uint> m_jobCurves;
+    QValueVector<ResultTable> m_jobTables;
+    bool m_isFailureReported;
 
     Plot *m_plot;
+    // the curves of the first meter, then those of the second, and so on
     QValueVector<QwtPlotCurve *> m_curves;
+    uint m_numCurvesPerMeter;
 };
 
 } // namespace Spiceplus
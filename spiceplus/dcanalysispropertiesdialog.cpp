@@ -125,28 +125,31 @@ DCAnalysisPropertiesDialog::DCAnalysisPropertiesDialog(SchematicView *view, QWid
 
     topLayout->addWidget(srcBox);
 
-    GroupBox *outputBox = new GroupBox(0, Qt::Vertical, i18n("Output Variable"), w);
+    GroupBox *outputBox = new GroupBox(0, Qt::Vertical, i18n("Output Variables"), w);
     outputBox->layout()->setMargin(KDialog::marginHint());
     outputBox->layout()->setSpacing(KDialog::spacingHint());
-    QGridLayout *outputGrid = new QGridLayout(outputBox->layout(), 2, 4, KDialog::spacingHint());
-    m_meterSelector = new MeterSelector(m_view->schematic(), outputBox, outputGrid, 0, 0);
+    QGridLayout *outputGrid = new QGridLayout(outputBox->layout(), 4, 4, KDialog::spacingHint());
+    m_meterSelector = new MeterSelector(m_view->schematic(), outputBox, outputGrid, 0, 0, true);
     topLayout->addWidget(outputBox);
 }
 
 void DCAnalysisPropertiesDialog::slotUser1()
 {
-    Meter meter = m_meterSelector->meter();
+    MeterList meters = m_meterSelector->meters();
 
-    if (meter.type() == Meter::Voltmeter && meter.testPoint1() == meter.testPoint2())
+    for (MeterList::ConstIterator it = meters.begin(); it != meters.end(); ++it)
     {
-        KMessageBox::sorry(this, i18n("Test Points must differ"));
-        return;
+        if ((*it).type() == Meter::Voltmeter && (*it).testPoint1() == (*it).testPoint2())
+        {
+            KMessageBox::sorry(this, i18n("Test Points must differ"));
+            return;
+        }
     }
 
     DCAnalysisDialog *dlg;
     if (m_useSource2->isChecked())
         dlg = new DCAnalysisDialog(m_view,
-                                   meter,
+                                   meters,
                                    m_sourceName->currentText(),
                                    m_startingValue->text(),
                                    m_finalValue->text(),
@@ -157,13 +160,13 @@ void DCAnalysisPropertiesDialog::slotUser1()
                                    m_incrementingValue2->text());
     else
         dlg = new DCAnalysisDialog(m_view,
-                                   meter,
+                                   meters,
                                    m_sourceName->currentText(),
                                    m_startingValue->text(),
                                    m_finalValue->text(),
                                    m_incrementingValue->text());
 
-    if (!dlg->runAnalysis())
+    if (!dlg->startAnalysis())
     {
         KMessageBox::error(this, dlg->errorString());
         delete dlg;
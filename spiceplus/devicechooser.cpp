@@ -25,6 +25,7 @@
 
 #include "devicechooser.h"
 #include "settings.h"
+#include "devicecatalog.h"
 
 using namespace Spiceplus;
 
@@ -42,20 +43,19 @@ DeviceChooserBranch::DeviceChooserBranch(KFileTreeView *view, const KURL &url, c
 KFileTreeViewItem *DeviceChooserBranch::createTreeViewItem(KFileTreeViewItem *parent, KFileItem *fileItem)
 {
     KFileTreeViewItem *item = new KFileTreeViewItem(parent, fileItem, this);
-    KConfig *config = new KConfig(item->isDir() ? fileItem->url().path() + "/_directory" : fileItem->url().path(), true);
 
-    QString name = config->readEntry("Name", item->isDir() ? fileItem->text() : QString(fileItem->text()).remove(QRegExp("\\.device$")));
-    item->setText(0, name);
-    item->setText(1, (item->isDir() ? '0' : '1') + config->readEntry("Position", "9999").rightJustify(4, '0') + name);
+    DeviceCatalog::Entry entry;
+    if (!DeviceCatalog::self()->find(fileItem->url().path(), entry))
+        entry.name = item->isDir() ? fileItem->text() : QString(fileItem->text()).remove(QRegExp("\\.device$"));
 
-    QString icon;
-    if (!item->isDir() && !(icon = config->readEntry("Icon")).isEmpty())
-        item->setPixmap(0, KGlobal::iconLoader()->loadIcon(icon, KIcon::Panel));
+    item->setText(0, entry.name);
+    item->setText(1, (item->isDir() ? '0' : '1') + QString::number(entry.position).rightJustify(4, '0') + entry.name);
+
+    if (!item->isDir() && !entry.icon.isEmpty())
+        item->setPixmap(0, KGlobal::iconLoader()->loadIcon(entry.icon, KIcon::Panel));
     else
         item->setPixmap(0, QPixmap());
 
-    delete config;
-
     return item;
 }
 
@@ -92,6 +92,7 @@ void DeviceChooser::resetTree()
     m_dirLister->stop();
     selectAll(false);
     clear();
+    DeviceCatalog::self()->validate();
     m_dirLister->openURL(Settings::self()->deviceDir(), true);
 }
 
@@ -105,13 +106,13 @@ void DeviceChooser::addDirectories(const KFileItemList &items)
     for (KFileItemList::Iterator it = items.begin(); it != items.end(); ++it)
     {
         DeviceChooserBranch *branch = new DeviceChooserBranch(this, (*it)->url(), (*it)->text(), QPixmap());
-        KConfig *config = new KConfig(branch->root()->url().path() + "/_directory", true);
 
-        QString name = config->readEntry("Name", (*it)->text());
-        branch->root()->setText(0, name);
-        branch->root()->setText(1, '0' + config->readEntry("Position", "9999").rightJustify(4, '0') + name);
+        DeviceCatalog::Entry entry;
+        if (!DeviceCatalog::self()->find(branch->root()->url().path(), entry))
+            entry.name = (*it)->text();
 
-        delete config;
+        branch->root()->setText(0, entry.name);
+        branch->root()->setText(1, '0' + QString::number(entry.position).rightJustify(4, '0') + entry.name);
 
         addBranch(branch);
         branch->root()->setOpen(true);
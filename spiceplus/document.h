@@ -75,6 +75,9 @@ public slots:
 
     virtual void analysisDC() {}
     virtual void analysisAC() {}
+    virtual void analysisTransient() {}
+    virtual void analysisSweep() {}
+    virtual void analysisMonteCarlo() {}
 
     virtual void toolSelect() {}
     virtual void toolPlaceWire() {}
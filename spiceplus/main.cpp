@@ -18,6 +18,8 @@
  */
 
 #include <config.h>
+#include <qtimer.h>
+
 #include <kapplication.h>
 #include <kaboutdata.h>
 #include <kcmdlineargs.h>
@@ -26,6 +28,7 @@
 #include "mainwindow.h"
 #include "settings.h"
 #include "pluginmanager.h"
+#include "trace.h"
 
 using namespace Spiceplus;
 
@@ -39,6 +42,8 @@ static KCmdLineOptions options[] =
 
 int main(int argc, char **argv)
 {
+    Q_LLONG startTime = Trace::now();
+
     KAboutData about(PACKAGE, "SPICE+", VERSION,
                      description,
                      KAboutData::License_GPL,
@@ -50,7 +55,14 @@ int main(int argc, char **argv)
     KCmdLineArgs::addCmdLineOptions(options);
 
     KApplication app;
-    Settings::self()->readConfig();
+    Trace::self();
+
+    {
+        TraceSpan span("Settings::readConfig");
+        Settings::self()->readConfig();
+    }
+
+    Trace::self()->loadSettings();
 
     if (app.isRestored())
     {
@@ -60,14 +72,21 @@ int main(int argc, char **argv)
     {
     	KCmdLineArgs *args = KCmdLineArgs::parsedArgs();
 
+    	TraceSpan span("MainWindow");
     	MainWindow *mainWin = new MainWindow;
     	mainWin->show();
 
         args->clear();
     }
 
+    if (Trace::isEnabled())
+        Trace::addSpan("startup", startTime, Trace::now() - startTime);
+
+    QTimer::singleShot(0, PluginManager::self(), SLOT(preloadPlugins()));
+
     int ret = app.exec();
     Settings::self()->writeConfig();
+    Trace::self()->flush();
     return ret;
 }
 
@@ -181,6 +181,24 @@ MainWindow::MainWindow()
     m_mux->connect(action, SIGNAL(activated()), SLOT(analysisAC()));
     m_mux->connect(SIGNAL(analysisEnabled(bool)), action, SLOT(setEnabled(bool)));
 
+    action = new KAction(i18n("&Transient Analysis"), 0, 0, 0, 0, actionCollection(), "analysis_tran");
+    action->setEnabled(false);
+    connect(this, SIGNAL(guiEnabled(bool)), action, SLOT(setEnabled(bool)));
+    m_mux->connect(action, SIGNAL(activated()), SLOT(analysisTransient()));
+    m_mux->connect(SIGNAL(analysisEnabled(bool)), action, SLOT(setEnabled(bool)));
+
+    action = new KAction(i18n("&Parameter Sweep"), 0, 0, 0, 0, actionCollection(), "analysis_sweep");
+    action->setEnabled(false);
+    connect(this, SIGNAL(guiEnabled(bool)), action, SLOT(setEnabled(bool)));
+    m_mux->connect(action, SIGNAL(activated()), SLOT(analysisSweep()));
+    m_mux->connect(SIGNAL(analysisEnabled(bool)), action, SLOT(setEnabled(bool)));
+
+    action = new KAction(i18n("&Monte Carlo"), 0, 0, 0, 0, actionCollection(), "analysis_montecarlo");
+    action->setEnabled(false);
+    connect(this, SIGNAL(guiEnabled(bool)), action, SLOT(setEnabled(bool)));
+    m_mux->connect(action, SIGNAL(activated()), SLOT(analysisMonteCarlo()));
+    m_mux->connect(SIGNAL(analysisEnabled(bool)), action, SLOT(setEnabled(bool)));
+
     createToolAction(i18n("&Select"), "spiceplus_select", "tool_select",
                      SLOT(toolSelect()), SIGNAL(toolSelectChecked(bool)));
 
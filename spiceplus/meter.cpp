@@ -18,16 +18,24 @@
  */
 
 #include <qstring.h>
+#include <qstringlist.h>
 
 #include <klocale.h>
+#include <kdebug.h>
 
 #include "meter.h"
 #include "schematic.h"
 #include "schematictestpoint.h"
 #include "schematicammeter.h"
+#include "trace.h"
 
 using namespace Spiceplus;
 
+Meter::Meter()
+    : m_type(Voltmeter)
+{
+}
+
 Meter::Meter(const QString &testPoint1, const QString &testPoint2)
     : m_type(Voltmeter), m_testPoint1(testPoint1), m_testPoint2(testPoint2)
 {
@@ -44,42 +52,14 @@ QString Meter::createCommand(Schematic *schematic)
 
     if (m_type == Voltmeter)
     {
-        SchematicTestPoint *tp1 = dynamic_cast<SchematicTestPoint *>(schematic->findDevice(m_testPoint1));
-        if (!tp1)
-        {
-            m_errorString = i18n("Test Point %1 not found").arg(m_testPoint1);
-            return QString::null;
-        }
-
-        QString tp1NodeName = tp1->nodeName();
-        if (tp1NodeName.isNull())
-        {
-            m_errorString = i18n("Test Point %1 not connected").arg(m_testPoint1);
-            return QString::null;
-        }
-
-        SchematicTestPoint *tp2 = dynamic_cast<SchematicTestPoint *>(schematic->findDevice(m_testPoint2));
-        if (!tp2)
-        {
-            m_errorString = i18n("Test Point %1 not found").arg(m_testPoint2);
-            return QString::null;
-        }
-
-        QString tp2NodeName = tp2->nodeName();
-        if (tp2NodeName.isNull())
-        {
-            m_errorString = i18n("Test Point %1 not connected").arg(m_testPoint2);
-            return QString::null;
-        }
-
-        if (tp1NodeName == tp2NodeName)
-        {
-            m_errorString = i18n("Both Test Points are connected to the same node").arg(m_testPoint2);
+        QString tp1NodeName, tp2NodeName;
+        if (!findNodeNames(schematic, tp1NodeName, tp2NodeName))
             return QString::null;
-        }
 
+        // not "-v(...)", which would subtract from the expression before
+        // it in a .print line of several meters
         if (tp1NodeName == "0")
-            cmd = "-v(" + tp2NodeName + ")";
+            cmd = "v(0," + tp2NodeName + ")";
         else if (tp2NodeName == "0")
             cmd = "v(" + tp1NodeName + ")";
         else
@@ -87,12 +67,8 @@ QString Meter::createCommand(Schematic *schematic)
     }
     else
     {
-        SchematicAmmeter *amm = dynamic_cast<SchematicAmmeter *>(schematic->findDevice(m_ammeter));
-        if (!amm)
-        {
-            m_errorString = i18n("Ammeter %1 not found").arg(m_ammeter);
+        if (!findAmmeter(schematic))
             return QString::null;
-        }
 
         cmd = "i(v" + m_ammeter.lower() + ")";
     }
@@ -100,4 +76,151 @@ QString Meter::createCommand(Schematic *schematic)
     return cmd;
 }
 
+bool Meter::addSaveVectors(Schematic *schematic, QStringList &vectors)
+{
+    QStringList meterVectors;
+
+    if (m_type == Voltmeter)
+    {
+        QString tp1NodeName, tp2NodeName;
+        if (!findNodeNames(schematic, tp1NodeName, tp2NodeName))
+            return false;
+
+        // ground is always there
+        if (tp1NodeName != "0")
+            meterVectors.append(tp1NodeName);
+        if (tp2NodeName != "0")
+            meterVectors.append(tp2NodeName);
+    }
+    else
+    {
+        if (!findAmmeter(schematic))
+            return false;
+
+        meterVectors.append("v" + m_ammeter.lower() + "#branch");
+    }
+
+    for (QStringList::ConstIterator it = meterVectors.begin(); it != meterVectors.end(); ++it)
+        if (!vectors.contains(*it))
+            vectors.append(*it);
+
+    return true;
+}
+
+QString Meter::createSaveCommand(Schematic *schematic, const MeterList &meters, uint *numVectors)
+{
+    QStringList vectors;
+    for (MeterList::ConstIterator it = meters.begin(); it != meters.end(); ++it)
+    {
+        Meter meter = *it;
+        if (!meter.addSaveVectors(schematic, vectors))
+            return QString::null;
+    }
+
+    kdDebug() << k_funcinfo << "saving " << vectors.count() << " vectors: " << vectors.join(" ") << endl;
+    Trace::addCounter("saved vectors", vectors.count());
+    if (numVectors)
+        *numVectors = vectors.count();
+    return ".save " + vectors.join(" ") + "\n";
+}
+
+QString Meter::names(const MeterList &meters)
+{
+    QStringList names;
+    for (MeterList::ConstIterator it = meters.begin(); it != meters.end(); ++it)
+        names.append((*it).name());
+    return names.join(", ");
+}
+
+QString Meter::shortUnits(const MeterList &meters)
+{
+    QStringList units;
+    for (MeterList::ConstIterator it = meters.begin(); it != meters.end(); ++it)
+        if (!units.contains((*it).shortUnit()))
+            units.append((*it).shortUnit());
+    return units.join(", ");
+}
+
+bool Meter::createProbe(Schematic *schematic, LinearCircuit &circuit, LinearCircuit::Probe &probe)
+{
+    bool ok;
+
+    if (m_type == Voltmeter)
+    {
+        QString tp1NodeName, tp2NodeName;
+        if (!findNodeNames(schematic, tp1NodeName, tp2NodeName))
+            return false;
+
+        ok = circuit.voltageProbe(tp1NodeName, tp2NodeName, probe);
+    }
+    else
+    {
+        if (!findAmmeter(schematic))
+            return false;
+
+        ok = circuit.currentProbe(m_ammeter, probe);
+    }
+
+    if (!ok)
+    {
+        m_errorString = circuit.errorString();
+        return false;
+    }
+
+    // the vector a SPICE run would print
+    probe.name = createCommand(schematic);
+    return true;
+}
+
+bool Meter::findNodeNames(Schematic *schematic, QString &tp1NodeName, QString &tp2NodeName)
+{
+    SchematicTestPoint *tp1 = dynamic_cast<SchematicTestPoint *>(schematic->findDevice(m_testPoint1));
+    if (!tp1)
+    {
+        m_errorString = i18n("Test Point %1 not found").arg(m_testPoint1);
+        return false;
+    }
+
+    tp1NodeName = tp1->nodeName();
+    if (tp1NodeName.isNull())
+    {
+        m_errorString = i18n("Test Point %1 not connected").arg(m_testPoint1);
+        return false;
+    }
+
+    SchematicTestPoint *tp2 = dynamic_cast<SchematicTestPoint *>(schematic->findDevice(m_testPoint2));
+    if (!tp2)
+    {
+        m_errorString = i18n("Test Point %1 not found").arg(m_testPoint2);
+        return false;
+    }
+
+    tp2NodeName = tp2->nodeName();
+    if (tp2NodeName.isNull())
+    {
+        m_errorString = i18n("Test Point %1 not connected").arg(m_testPoint2);
+        return false;
+    }
+
+    if (tp1NodeName == tp2NodeName)
+    {
+        m_errorString = i18n("Both Test Points are connected to the same node").arg(m_testPoint2);
+        return false;
+    }
+
+    return true;
+}
+
+bool Meter::findAmmeter(Schematic *schematic)
+{
+    SchematicAmmeter *amm = dynamic_cast<SchematicAmmeter *>(schematic->findDevice(m_ammeter));
+    if (!amm)
+    {
+        m_errorString = i18n("Ammeter %1 not found").arg(m_ammeter);
+        return false;
+    }
+
+    return true;
+}
+
 // vim: ts=4 sw=4 et
@@ -20,7 +20,11 @@
 #ifndef METER_H
 #define METER_H
 
-class QString;
+#include <qstring.h>
+#include <qvaluelist.h>
+#include <qstringlist.h>
+
+#include "linearcircuit.h"
 
 namespace Spiceplus {
 
@@ -30,6 +34,7 @@ class Meter
 {
 public:
     enum Type { Voltmeter, Ammeter };
+    Meter();
     Meter(const QString &testPoint1, const QString &testPoint2);
     Meter(const QString &ammeter);
 
@@ -41,10 +46,27 @@ public:
     QString name() const { return m_type == Voltmeter ? m_testPoint1 + "->" + m_testPoint2 : m_ammeter; }
     QString shortUnit() const { return m_type == Voltmeter ? "V" : "A"; }
 
+    // for captions and axis titles of plots showing several meters
+    static QString names(const QValueList<Meter> &meters);
+    static QString shortUnits(const QValueList<Meter> &meters);
+
+    // the SPICE expression of the meter, which also names its vector in a
+    // ResultTable, whether SPICE or the built-in solver made it
     QString createCommand(Schematic *schematic);
+    // The vectors SPICE has to keep for createCommand(): the nodes of the
+    // test points, or the branch of the ammeter's zero-volt source.
+    bool addSaveVectors(Schematic *schematic, QStringList &vectors);
+    // A .save line for the vectors of the meters, so that SPICE doesn't
+    // keep every node and branch of the circuit; null if a meter is broken.
+    // numVectors is set to how many vectors the line names.
+    static QString createSaveCommand(Schematic *schematic, const QValueList<Meter> &meters, uint *numVectors = 0);
+    bool createProbe(Schematic *schematic, LinearCircuit &circuit, LinearCircuit::Probe &probe);
     QString errorString() const { return m_errorString; }
 
 private:
+    bool findNodeNames(Schematic *schematic, QString &tp1NodeName, QString &tp2NodeName);
+    bool findAmmeter(Schematic *schematic);
+
     Type m_type;
     QString m_testPoint1;
     QString m_testPoint2;
@@ -53,6 +75,8 @@ private:
     QString m_errorString;
 };
 
+typedef QValueList<Meter> MeterList;
+
 } // namespace Spiceplus
 
 #endif // METER_H
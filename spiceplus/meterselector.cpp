@@ -22,6 +22,8 @@
 #include <qradiobutton.h>
 #include <qcombobox.h>
 #include <qlabel.h>
+#include <qlistbox.h>
+#include <qpushbutton.h>
 
 #include <klocale.h>
 
@@ -31,8 +33,10 @@
 
 using namespace Spiceplus;
 
-MeterSelector::MeterSelector(Schematic *schematic, QWidget *parent, QGridLayout *layout, int startRow, int startCol)
-    : QObject(parent)
+MeterSelector::MeterSelector(Schematic *schematic, QWidget *parent, QGridLayout *layout, int startRow, int startCol, bool isMultiple)
+    : QObject(parent),
+      m_meterList(0),
+      m_removeButton(0)
 {
     QButtonGroup *group = new QButtonGroup(parent);
     group->hide();
@@ -94,6 +98,23 @@ MeterSelector::MeterSelector(Schematic *schematic, QWidget *parent, QGridLayout
 
         m_ammeter->insertStringList(ammeters);
     }
+
+    if (!isMultiple)
+        return;
+
+    QPushButton *addButton = new QPushButton(i18n("Add"), parent);
+    addButton->setEnabled(testPoints.count() >= 2 || ammeters.count() >= 1);
+    connect(addButton, SIGNAL(clicked()), SLOT(addMeter()));
+    layout->addWidget(addButton, startRow + 2, startCol);
+
+    m_meterList = new QListBox(parent);
+    m_meterList->setMinimumHeight(m_meterList->fontMetrics().lineSpacing() * 4);
+    layout->addMultiCellWidget(m_meterList, startRow + 2, startRow + 3, startCol + 1, startCol + 3);
+
+    m_removeButton = new QPushButton(i18n("Remove"), parent);
+    m_removeButton->setEnabled(false);
+    connect(m_removeButton, SIGNAL(clicked()), SLOT(removeMeter()));
+    layout->addWidget(m_removeButton, startRow + 3, startCol, Qt::AlignTop);
 }
 
 Meter MeterSelector::meter() const
@@ -104,6 +125,36 @@ Meter MeterSelector::meter() const
         return Meter(m_ammeter->currentText());
 }
 
+MeterList MeterSelector::meters() const
+{
+    if (m_meters.isEmpty())
+        return MeterList() << meter();
+    return m_meters;
+}
+
+void MeterSelector::addMeter()
+{
+    Meter newMeter = meter();
+    for (MeterList::ConstIterator it = m_meters.begin(); it != m_meters.end(); ++it)
+        if ((*it).name() == newMeter.name())
+            return;
+
+    m_meters.append(newMeter);
+    m_meterList->insertItem(newMeter.name());
+    m_removeButton->setEnabled(true);
+}
+
+void MeterSelector::removeMeter()
+{
+    int index = m_meterList->currentItem();
+    if (index < 0)
+        return;
+
+    m_meters.remove(m_meters.at(index));
+    m_meterList->removeItem(index);
+    m_removeButton->setEnabled(!m_meters.isEmpty());
+}
+
 #include "meterselector.moc"
 
 // vim: ts=4 sw=4 et
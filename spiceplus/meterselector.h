@@ -22,23 +22,35 @@
 
 #include <qobject.h>
 
+#include "meter.h"
+
 class QWidget;
 class QGridLayout;
 class QRadioButton;
 class QComboBox;
+class QListBox;
+class QPushButton;
 
 namespace Spiceplus {
 
 class Schematic;
-class Meter;
 
+// Chooses a voltmeter between two test points or an ammeter. With
+// multiple selection, meters are collected in a list below, which takes
+// two more rows of the layout.
 class MeterSelector : public QObject
 {
     Q_OBJECT
 
 public:
-    MeterSelector(Schematic *schematic, QWidget *parent, QGridLayout *layout, int startRow, int startCol);
+    MeterSelector(Schematic *schematic, QWidget *parent, QGridLayout *layout, int startRow, int startCol, bool isMultiple = false);
     Meter meter() const;
+    // the collected meters, or the current one if none were added
+    MeterList meters() const;
+
+private slots:
+    void addMeter();
+    void removeMeter();
 
 private:
     QRadioButton *m_voltmeterButton;
@@ -47,6 +59,10 @@ private:
 
     QRadioButton *m_ammeterButton;
     QComboBox *m_ammeter;
+
+    QListBox *m_meterList;
+    QPushButton *m_removeButton;
+    MeterList m_meters;
 };
 
 } // namespace Spiceplus
@@ -0,0 +1,390 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <math.h>
+
+#include <qlayout.h>
+#include <qlabel.h>
+#include <qpushbutton.h>
+#include <qtimer.h>
+
+#include <klocale.h>
+#include <kdialog.h>
+#include <kmessagebox.h>
+#include <kprogress.h>
+#include <kseparator.h>
+
+#include "montecarlodialog.h"
+#include "montecarlo.h"
+#include "schematic.h"
+#include "schematicview.h"
+#include "plot.h"
+#include "resulttable.h"
+#include "settings.h"
+#include "spicejobscheduler.h"
+#include "spicenumber.h"
+#include "trace.h"
+
+using namespace Spiceplus;
+
+MonteCarloDialog::MonteCarloDialog(SchematicView *view, const Meter &meter, Metric metric, int numRuns, uint seed)
+    : m_view(view),
+      m_meter(meter),
+      m_metric(metric),
+      m_numRuns(numRuns),
+      m_seed(seed),
+      m_hasLowerLimit(false),
+      m_lowerLimit(0.0),
+      m_hasUpperLimit(false),
+      m_upperLimit(0.0),
+      m_numPassedRuns(0),
+      m_numInvalidRuns(0),
+      m_numFailedRuns(0),
+      m_curve(0)
+{
+    resize(560, 480);
+    setCaption(i18n("Monte Carlo %1").arg(m_meter.name()));
+
+    connect(m_view, SIGNAL(destroyed()), SLOT(close()));
+
+    m_scheduler = new SpiceJobScheduler(this);
+    connect(m_scheduler, SIGNAL(jobFinished(int, const ResultTable &)), SLOT(addResult(int, const ResultTable &)));
+    connect(m_scheduler, SIGNAL(jobFailed(int, const QString &, const QString &)), SLOT(recordFailure(int, const QString &, const QString &)));
+    connect(m_scheduler, SIGNAL(progress(int, int)), SLOT(updateProgress(int, int)));
+    connect(m_scheduler, SIGNAL(finished()), SLOT(finishRuns()));
+
+    // a thousand results a second would be a thousand replots otherwise
+    m_updateTimer = new QTimer(this);
+    connect(m_updateTimer, SIGNAL(timeout()), SLOT(updateStatistics()));
+
+    QWidget *w = new QWidget(this);
+    setCentralWidget(w);
+    QBoxLayout *vbox = new QVBoxLayout(w, KDialog::marginHint(), KDialog::spacingHint());
+
+    m_plot = new Plot(w);
+    m_plot->setAxisTitle(QwtPlot::xBottom, m_metric == DCValue ? "Measured value [" + m_meter.shortUnit() + "]" : QString("Magnitude [dB]"));
+    m_plot->setAxisTitle(QwtPlot::yLeft, "Runs");
+    vbox->addWidget(m_plot, 1);
+
+    m_statistics = new QLabel(w);
+    vbox->addWidget(m_statistics);
+
+    vbox->addWidget(new KSeparator(KSeparator::HLine, w));
+
+    QBoxLayout *hbox = new QHBoxLayout(vbox, KDialog::spacingHint());
+
+    m_progress = new KProgress(w);
+    hbox->addWidget(m_progress, 1);
+
+    m_status = new QLabel(w);
+    hbox->addWidget(m_status);
+
+    m_cancelButton = new QPushButton(i18n("Cancel"), w);
+    m_cancelButton->setEnabled(false);
+    connect(m_cancelButton, SIGNAL(clicked()), SLOT(cancel()));
+    hbox->addWidget(m_cancelButton);
+
+    QPushButton *updateButton = new QPushButton(i18n("Update"), w);
+    connect(updateButton, SIGNAL(clicked()), SLOT(updatePlot()));
+    hbox->addWidget(updateButton);
+}
+
+void MonteCarloDialog::setFrequency(const QString &frequency)
+{
+    m_frequency = frequency;
+}
+
+void MonteCarloDialog::setFrequencyRange(const QString &startFrequency, const QString &stopFrequency)
+{
+    m_startFrequency = startFrequency;
+    m_stopFrequency = stopFrequency;
+}
+
+void MonteCarloDialog::setSource(const QString &sourceName, const QString &value)
+{
+    m_sourceName = sourceName;
+    m_sourceValue = value;
+}
+
+void MonteCarloDialog::setLimits(const QString &lowerLimit, const QString &upperLimit)
+{
+    m_hasLowerLimit = SpiceNumber::parse(lowerLimit, m_lowerLimit);
+    m_hasUpperLimit = SpiceNumber::parse(upperLimit, m_upperLimit);
+}
+
+bool MonteCarloDialog::runAnalysis()
+{
+    QStringList commandLists;
+    if (!createCommandLists(commandLists))
+        return false;
+
+    m_histogram.clear();
+    m_numPassedRuns = 0;
+    m_numInvalidRuns = 0;
+    m_numFailedRuns = 0;
+    m_failureString = QString::null;
+    m_failureDetails = QString::null;
+
+    m_progress->setTotalSteps(commandLists.count());
+    m_progress->setProgress(0);
+    updateProgress(0, commandLists.count());
+    m_cancelButton->setEnabled(true);
+    updateStatistics();
+
+    m_scheduler->run(commandLists);
+    return true;
+}
+
+QString MonteCarloDialog::createAnalysisCommands(const QString &meterCmd)
+{
+    QString cmds = ".control\n"
+                   "set nobreak\n"
+                   ".endc\n";
+
+    if (m_metric == ACMagnitude)
+    {
+        cmds += ".ac lin 1 " + m_frequency + " " + m_frequency + "\n"
+                ".print ac db(" + meterCmd + ")\n";
+    }
+    else if (m_metric == ACPeakMagnitude)
+    {
+        cmds += ".ac dec " + QString::number(Settings::self()->acAnalysisNumPointsPerDecade()) + " "
+                           + m_startFrequency + " " + m_stopFrequency + "\n"
+                ".print ac db(" + meterCmd + ")\n";
+    }
+    else
+    {
+        SchematicDevice *src = m_view->schematic()->findDevice(m_sourceName);
+        if (!src)
+        {
+            m_errorString = i18n("Source %1 not found").arg(m_sourceName);
+            return QString::null;
+        }
+
+        cmds += ".dc " + src->type() + src->name().lower() + " " + m_sourceValue + " " + m_sourceValue + " 1\n"
+                ".print dc " + meterCmd + "\n";
+    }
+
+    return cmds + ".end\n";
+}
+
+bool MonteCarloDialog::createCommandLists(QStringList &commandLists)
+{
+    TraceSpan span("MonteCarloDialog::createCommandLists");
+
+    Schematic *schematic = m_view->schematic();
+    MonteCarlo monteCarlo(schematic);
+    if (!monteCarlo.prepare())
+    {
+        m_errorString = monteCarlo.errorString();
+        return false;
+    }
+
+    if (monteCarlo.numVariedDevices() == 0)
+    {
+        m_errorString = i18n("No device has a tolerance");
+        return false;
+    }
+
+    QString meterCmd = m_meter.createCommand(schematic);
+    if (meterCmd.isNull())
+    {
+        m_errorString = m_meter.errorString();
+        return false;
+    }
+
+    QString analysisCmds = createAnalysisCommands(meterCmd);
+    if (analysisCmds.isNull())
+        return false;
+    m_vectorName = m_metric == DCValue ? meterCmd : "db(" + meterCmd + ")";
+    analysisCmds.prepend(Meter::createSaveCommand(schematic, MeterList() << m_meter));
+
+    for (int run = 0; run < m_numRuns; ++run)
+    {
+        QString cmdList = monteCarlo.createCommandList(m_seed, run);
+        if (cmdList.isNull())
+        {
+            m_errorString = monteCarlo.errorString();
+            return false;
+        }
+
+        commandLists.append(cmdList + analysisCmds);
+    }
+
+    return true;
+}
+
+bool MonteCarloDialog::metricValue(const ResultTable &table, double &value) const
+{
+    const QMemArray<double> &column = table.real(m_vectorName);
+    if (column.count() == 0)
+        return false;
+
+    value = column[0];
+    if (m_metric == ACPeakMagnitude)
+        for (uint row = 1; row < column.count(); ++row)
+            value = QMAX(value, column[row]);
+
+    // the magnitude of a zero output is -inf dB
+    return finite(value);
+}
+
+void MonteCarloDialog::addResult(int, const ResultTable &table)
+{
+    double value;
+    if (!metricValue(table, value))
+    {
+        ++m_numInvalidRuns;
+        scheduleUpdate();
+        return;
+    }
+
+    m_histogram.add(value);
+    if ((!m_hasLowerLimit || value >= m_lowerLimit) && (!m_hasUpperLimit || value <= m_upperLimit))
+        ++m_numPassedRuns;
+
+    scheduleUpdate();
+}
+
+void MonteCarloDialog::recordFailure(int, const QString &errorString, const QString &errorDetails)
+{
+    if (m_numFailedRuns++ == 0)
+    {
+        m_failureString = errorString;
+        m_failureDetails = errorDetails;
+    }
+}
+
+void MonteCarloDialog::updateProgress(int numFinishedJobs, int numJobs)
+{
+    m_progress->setProgress(numFinishedJobs);
+    m_status->setText(i18n("%1 of %2 runs").arg(numFinishedJobs).arg(numJobs));
+}
+
+void MonteCarloDialog::scheduleUpdate()
+{
+    if (!m_updateTimer->isActive())
+        m_updateTimer->start(100, true);
+}
+
+void MonteCarloDialog::updateStatistics()
+{
+    TraceSpan span("MonteCarloDialog::updateStatistics");
+
+    // the bars are drawn from a copy, the range of the histogram itself is
+    // only fixed once it holds back as many values as it has bins
+    Histogram histogram(m_histogram);
+    histogram.flush();
+
+    int firstBin = histogram.firstBin();
+    int lastBin = histogram.lastBin();
+
+    // about forty bars, whatever the width of the bins
+    int numBins = lastBin - firstBin + 1;
+    int binsPerBar = QMAX(1, (numBins + 39) / 40);
+    int numBars = (numBins + binsPerBar - 1) / binsPerBar;
+
+    QMemArray<double> x(numBars + 1);
+    QMemArray<double> y(numBars + 1);
+    for (int bar = 0; bar < numBars; ++bar)
+    {
+        int count = 0;
+        for (int bin = firstBin + bar * binsPerBar; bin < firstBin + (bar + 1) * binsPerBar && bin <= lastBin; ++bin)
+            count += histogram.binCount(bin);
+
+        x[bar] = histogram.binStart(firstBin + bar * binsPerBar);
+        y[bar] = count;
+    }
+    // the step of the last bar needs its right edge
+    x[numBars] = histogram.binStart(firstBin + numBars * binsPerBar);
+    y[numBars] = numBars > 0 ? y[numBars - 1] : 0;
+
+    if (!m_curve)
+    {
+        m_curve = new QwtPlotCurve(m_plot);
+        m_curve->setPen(Qt::red);
+        m_curve->setStyle(QwtCurve::Steps);
+        m_plot->insertCurve(m_curve);
+    }
+    m_curve->setData(x, y);
+    m_plot->replot();
+
+    int numRuns = m_histogram.count() + m_numInvalidRuns;
+    QString text = i18n("Seed %1: %2 runs").arg(m_seed).arg(numRuns);
+    if (m_numInvalidRuns > 0)
+        text += i18n(", %1 without a value").arg(m_numInvalidRuns);
+
+    if (m_histogram.count() > 0)
+    {
+        text += "\n" + i18n("Mean %1, standard deviation %2, minimum %3, maximum %4")
+                           .arg(m_histogram.mean(), 0, 'g', 5)
+                           .arg(m_histogram.standardDeviation(), 0, 'g', 5)
+                           .arg(m_histogram.minimum(), 0, 'g', 5)
+                           .arg(m_histogram.maximum(), 0, 'g', 5);
+        text += "\n" + i18n("Percentiles 1%: %1, 5%: %2, 50%: %3, 95%: %4, 99%: %5")
+                           .arg(m_histogram.percentile(1), 0, 'g', 5)
+                           .arg(m_histogram.percentile(5), 0, 'g', 5)
+                           .arg(m_histogram.percentile(50), 0, 'g', 5)
+                           .arg(m_histogram.percentile(95), 0, 'g', 5)
+                           .arg(m_histogram.percentile(99), 0, 'g', 5);
+    }
+
+    if ((m_hasLowerLimit || m_hasUpperLimit) && numRuns > 0)
+        text += "\n" + i18n("Yield %1%").arg(100.0 * m_numPassedRuns / numRuns, 0, 'f', 1);
+
+    m_statistics->setText(text);
+}
+
+void MonteCarloDialog::finishRuns()
+{
+    m_updateTimer->stop();
+    updateStatistics();
+    m_cancelButton->setEnabled(false);
+
+    if (m_numFailedRuns == 0)
+        return;
+
+    QString message = i18n("%1 of %2 runs failed").arg(m_numFailedRuns).arg(m_numRuns) + "\n" + m_failureString;
+    if (m_failureDetails.isNull())
+        KMessageBox::error(this, message);
+    else
+        KMessageBox::detailedError(this, message, m_failureDetails);
+}
+
+void MonteCarloDialog::updatePlot()
+{
+    m_view->resetTool();
+
+    if (!runAnalysis())
+        KMessageBox::error(this, m_errorString);
+}
+
+void MonteCarloDialog::cancel()
+{
+    m_scheduler->cancel();
+    m_updateTimer->stop();
+    updateStatistics();
+    m_cancelButton->setEnabled(false);
+    m_status->setText(i18n("Cancelled"));
+}
+
+#include "montecarlodialog.moc"
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,124 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef MONTECARLODIALOG_H
+#define MONTECARLODIALOG_H
+
+#include <qvaluevector.h>
+
+#include <kmainwindow.h>
+
+#include "meter.h"
+#include "histogram.h"
+
+class QLabel;
+class QPushButton;
+class QTimer;
+class QwtPlotCurve;
+class KProgress;
+
+namespace Spiceplus {
+
+class Plot;
+class ResultTable;
+class SchematicView;
+class SpiceJobScheduler;
+
+// Runs the schematic many times with device values varied within their
+// tolerances and shows the distribution of one measured quantity. Only
+// that quantity is kept of each run, so the memory needed doesn't grow
+// with the number of runs.
+class MonteCarloDialog : public KMainWindow
+{
+    Q_OBJECT
+
+public:
+    enum Metric { ACMagnitude, ACPeakMagnitude, DCValue };
+
+    MonteCarloDialog(SchematicView *view, const Meter &meter, Metric metric, int numRuns, uint seed);
+
+    // the frequency of ACMagnitude
+    void setFrequency(const QString &frequency);
+    // the frequency range searched by ACPeakMagnitude
+    void setFrequencyRange(const QString &startFrequency, const QString &stopFrequency);
+    // the source setting of DCValue
+    void setSource(const QString &sourceName, const QString &value);
+    // runs within the limits count toward the yield; an empty limit is none
+    void setLimits(const QString &lowerLimit, const QString &upperLimit);
+
+    bool runAnalysis();
+    QString errorString() const { return m_errorString; }
+
+private slots:
+    void addResult(int job, const ResultTable &table);
+    void recordFailure(int job, const QString &errorString, const QString &errorDetails);
+    void updateProgress(int numFinishedJobs, int numJobs);
+    void finishRuns();
+    void updateStatistics();
+    void updatePlot();
+    void cancel();
+
+private:
+    QString createAnalysisCommands(const QString &meterCmd);
+    bool createCommandLists(QStringList &commandLists);
+    bool metricValue(const ResultTable &table, double &value) const;
+    void scheduleUpdate();
+
+    SchematicView *m_view;
+    Meter m_meter;
+    Metric m_metric;
+    // the vector of the measured quantity in the result of a run
+    QString m_vectorName;
+    int m_numRuns;
+    uint m_seed;
+
+    QString m_frequency;
+    QString m_startFrequency;
+    QString m_stopFrequency;
+    QString m_sourceName;
+    QString m_sourceValue;
+    bool m_hasLowerLimit;
+    double m_lowerLimit;
+    bool m_hasUpperLimit;
+    double m_upperLimit;
+
+    SpiceJobScheduler *m_scheduler;
+    Histogram m_histogram;
+    int m_numPassedRuns;
+    int m_numInvalidRuns;
+    int m_numFailedRuns;
+    QString m_failureString;
+    QString m_failureDetails;
+    QString m_errorString;
+
+    Plot *m_plot;
+    QwtPlotCurve *m_curve;
+    QLabel *m_statistics;
+    KProgress *m_progress;
+    QLabel *m_status;
+    QPushButton *m_cancelButton;
+    QTimer *m_updateTimer;
+};
+
+} // namespace Spiceplus
+
+#endif // MONTECARLODIALOG_H
+
+// vim: ts=4 sw=4 et
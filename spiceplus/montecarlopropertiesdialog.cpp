@@ -0,0 +1,295 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <limits.h>
+
+#include <qlayout.h>
+#include <qlabel.h>
+#include <qcombobox.h>
+#include <qspinbox.h>
+#include <qpushbutton.h>
+#include <qradiobutton.h>
+#include <qbuttongroup.h>
+
+#include <klocale.h>
+#include <kdialog.h>
+#include <klineedit.h>
+#include <klistview.h>
+#include <kmessagebox.h>
+
+#include "montecarlopropertiesdialog.h"
+#include "montecarlodialog.h"
+#include "montecarlo.h"
+#include "schematic.h"
+#include "schematicstandarddevice.h"
+#include "schematicview.h"
+#include "schematiccommand.h"
+#include "schematiccommandhistory.h"
+#include "parameterlineedit.h"
+#include "meterselector.h"
+#include "groupbox.h"
+
+using namespace Spiceplus;
+
+MonteCarloPropertiesDialog::MonteCarloPropertiesDialog(SchematicView *view, QWidget *parent)
+    : KDialogBase(parent, 0, true, i18n("Monte Carlo Analysis"), User1 | Close, User1, false, KGuiItem(i18n("&Plot"), "ok")), m_view(view)
+{
+    QStringList sources = m_view->schematic()->deviceNamesByType("v") + m_view->schematic()->deviceNamesByType("i");
+
+    QWidget *w = new QWidget(this);
+    setMainWidget(w);
+    QBoxLayout *topLayout = new QVBoxLayout(w, 0, KDialog::spacingHint());
+
+    GroupBox *toleranceBox = new GroupBox(0, Qt::Vertical, i18n("Tolerances"), w);
+    QBoxLayout *toleranceLayout = new QVBoxLayout(toleranceBox->layout(), KDialog::spacingHint());
+
+    m_devices = new KListView(toleranceBox);
+    m_devices->addColumn(i18n("Device"));
+    m_devices->addColumn(i18n("Value"));
+    m_devices->addColumn(i18n("Tolerance"));
+    m_devices->addColumn(i18n("Distribution"));
+    m_devices->setSelectionMode(QListView::Extended);
+    m_devices->setAllColumnsShowFocus(true);
+    toleranceLayout->addWidget(m_devices);
+
+    QCanvasItemList l = m_view->schematic()->allItems();
+    for (QCanvasItemList::Iterator it = l.begin(); it != l.end(); ++it)
+    {
+        if (!(*it)->isVisible() || (*it)->rtti() != SchematicDevice::RTTI)
+            continue;
+
+        SchematicStandardDevice *dev = dynamic_cast<SchematicStandardDevice *>(*it);
+        double value;
+        if (!dev || !dev->parameterValue("value", value))
+            continue;
+
+        QString distribution;
+        if (!dev->parameter("tolerance").isEmpty())
+            distribution = MonteCarlo::parseDistribution(dev->parameter("distribution")) == MonteCarlo::Gaussian ? i18n("Gaussian") : i18n("Uniform");
+
+        new KListViewItem(m_devices, dev->name(), dev->parameter("value"), dev->parameter("tolerance"), distribution);
+    }
+
+    QBoxLayout *hbox = new QHBoxLayout(toleranceLayout, KDialog::spacingHint());
+    hbox->addWidget(new QLabel(i18n("Tolerance:"), toleranceBox));
+    m_tolerance = new KLineEdit("5%", toleranceBox);
+    hbox->addWidget(m_tolerance);
+    m_distribution = new QComboBox(toleranceBox);
+    // in the order of MonteCarlo::Distribution
+    m_distribution->insertItem(i18n("Uniform"));
+    m_distribution->insertItem(i18n("Gaussian"));
+    hbox->addWidget(m_distribution);
+    QPushButton *button = new QPushButton(i18n("&Set"), toleranceBox);
+    connect(button, SIGNAL(clicked()), SLOT(setTolerance()));
+    hbox->addWidget(button);
+    button = new QPushButton(i18n("C&lear"), toleranceBox);
+    connect(button, SIGNAL(clicked()), SLOT(clearTolerance()));
+    hbox->addWidget(button);
+
+    topLayout->addWidget(toleranceBox);
+
+    GroupBox *analysisBox = new GroupBox(0, Qt::Vertical, i18n("Measured Quantity"), w);
+    QGridLayout *analysisGrid = new QGridLayout(analysisBox->layout(), 6, 3, KDialog::spacingHint());
+
+    QButtonGroup *analysisGroup = new QButtonGroup(analysisBox);
+    analysisGroup->hide();
+
+    QLabel *label;
+
+    analysisGrid->addWidget(m_acMagnitudeButton = new QRadioButton(i18n("AC magnitude at:"), analysisBox), 0, 0);
+    analysisGroup->insert(m_acMagnitudeButton);
+    analysisGrid->addWidget(m_frequency = new ParameterLineEdit("1k", "1k", analysisBox), 0, 1);
+    m_frequency->connect(m_acMagnitudeButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    label = new QLabel(i18n("Herz"), analysisBox);
+    label->connect(m_acMagnitudeButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 0, 2);
+
+    analysisGrid->addWidget(m_acPeakButton = new QRadioButton(i18n("AC peak magnitude from:"), analysisBox), 1, 0);
+    analysisGroup->insert(m_acPeakButton);
+    analysisGrid->addWidget(m_startFrequency = new ParameterLineEdit("10", "10", analysisBox), 1, 1);
+    m_startFrequency->connect(m_acPeakButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    label = new QLabel(i18n("Herz"), analysisBox);
+    label->connect(m_acPeakButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 1, 2);
+    label = new QLabel(i18n("to:"), analysisBox);
+    label->connect(m_acPeakButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 2, 0, Qt::AlignRight);
+    analysisGrid->addWidget(m_stopFrequency = new ParameterLineEdit("100meg", "100meg", analysisBox), 2, 1);
+    m_stopFrequency->connect(m_acPeakButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    label = new QLabel(i18n("Herz"), analysisBox);
+    label->connect(m_acPeakButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 2, 2);
+
+    analysisGrid->addWidget(m_dcButton = new QRadioButton(i18n("DC value with source:"), analysisBox), 3, 0);
+    analysisGroup->insert(m_dcButton);
+    if (sources.isEmpty())
+        m_dcButton->setEnabled(false);
+    m_sourceName = new QComboBox(analysisBox);
+    m_sourceName->insertStringList(sources);
+    m_sourceName->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(m_sourceName, 3, 1);
+    label = new QLabel(i18n("at:"), analysisBox);
+    label->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 4, 0, Qt::AlignRight);
+    analysisGrid->addWidget(m_sourceValue = new ParameterLineEdit("1", "0", analysisBox), 4, 1);
+    m_sourceValue->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    label = new QLabel(i18n("Volts / Amps"), analysisBox);
+    label->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 4, 2);
+
+    // toggling every button once brings all dependent widgets into their state
+    m_dcButton->setChecked(true);
+    m_acPeakButton->setChecked(true);
+    m_acMagnitudeButton->setChecked(true);
+
+    topLayout->addWidget(analysisBox);
+
+    GroupBox *runsBox = new GroupBox(0, Qt::Vertical, i18n("Runs"), w);
+    QGridLayout *runsGrid = new QGridLayout(runsBox->layout(), 2, 4, KDialog::spacingHint());
+    runsGrid->addWidget(new QLabel(i18n("Number of runs:"), runsBox), 0, 0);
+    runsGrid->addWidget(m_numRuns = new QSpinBox(1, 1000000, 100, runsBox), 0, 1);
+    m_numRuns->setValue(1000);
+    runsGrid->addWidget(new QLabel(i18n("Seed:"), runsBox), 0, 2);
+    runsGrid->addWidget(m_seed = new QSpinBox(0, INT_MAX, 1, runsBox), 0, 3);
+    m_seed->setValue(1);
+    runsGrid->addWidget(new QLabel(i18n("Lower limit:"), runsBox), 1, 0);
+    runsGrid->addWidget(m_lowerLimit = new KLineEdit(runsBox), 1, 1);
+    runsGrid->addWidget(new QLabel(i18n("Upper limit:"), runsBox), 1, 2);
+    runsGrid->addWidget(m_upperLimit = new KLineEdit(runsBox), 1, 3);
+    topLayout->addWidget(runsBox);
+
+    GroupBox *outputBox = new GroupBox(0, Qt::Vertical, i18n("Output Variable"), w);
+    QGridLayout *outputGrid = new QGridLayout(outputBox->layout(), 2, 4, KDialog::spacingHint());
+    m_meterSelector = new MeterSelector(m_view->schematic(), outputBox, outputGrid, 0, 0);
+    topLayout->addWidget(outputBox);
+}
+
+void MonteCarloPropertiesDialog::setTolerance()
+{
+    double tolerance;
+    if (!MonteCarlo::parseTolerance(m_tolerance->text(), tolerance))
+    {
+        KMessageBox::sorry(this, i18n("The tolerance must be a percentage below 100%"));
+        return;
+    }
+
+    for (QListViewItem *item = m_devices->firstChild(); item; item = item->nextSibling())
+    {
+        if (!item->isSelected())
+            continue;
+
+        item->setText(2, MonteCarlo::formatTolerance(tolerance));
+        item->setText(3, m_distribution->currentText());
+    }
+}
+
+void MonteCarloPropertiesDialog::clearTolerance()
+{
+    for (QListViewItem *item = m_devices->firstChild(); item; item = item->nextSibling())
+    {
+        if (!item->isSelected())
+            continue;
+
+        item->setText(2, QString::null);
+        item->setText(3, QString::null);
+    }
+}
+
+void MonteCarloPropertiesDialog::applyTolerances()
+{
+    // all changes of this dialog are undone in one step
+    SchematicCommandGroup *cmdGroup = new SchematicCommandGroup;
+
+    for (QListViewItem *item = m_devices->firstChild(); item; item = item->nextSibling())
+    {
+        SchematicStandardDevice *dev = dynamic_cast<SchematicStandardDevice *>(m_view->schematic()->findDevice(item->text(0)));
+        if (!dev)
+            continue;
+
+        QString tolerance = item->text(2);
+        QString distribution;
+        if (!tolerance.isEmpty())
+            distribution = MonteCarlo::distributionName(item->text(3) == m_distribution->text(MonteCarlo::Gaussian) ? MonteCarlo::Gaussian : MonteCarlo::Uniform);
+
+        if (tolerance == dev->parameter("tolerance") && distribution == dev->parameter("distribution"))
+            continue;
+
+        SchematicDeviceState *oldState = dev->createState();
+        if (tolerance.isEmpty())
+        {
+            dev->removeParameter("tolerance");
+            dev->removeParameter("distribution");
+        }
+        else
+        {
+            dev->setParameter("tolerance", tolerance);
+            dev->setParameter("distribution", distribution);
+        }
+        cmdGroup->add(new SchematicCommandChangeDeviceProperties(dev, oldState, dev->createState()));
+    }
+
+    if (cmdGroup->isEmpty())
+        delete cmdGroup;
+    else
+        m_view->history()->add(cmdGroup);
+}
+
+void MonteCarloPropertiesDialog::slotUser1()
+{
+    Meter meter = m_meterSelector->meter();
+
+    if (meter.type() == Meter::Voltmeter && meter.testPoint1() == meter.testPoint2())
+    {
+        KMessageBox::sorry(this, i18n("Test Points must differ"));
+        return;
+    }
+
+    applyTolerances();
+
+    MonteCarloDialog::Metric metric;
+    if (m_acMagnitudeButton->isChecked())
+        metric = MonteCarloDialog::ACMagnitude;
+    else if (m_acPeakButton->isChecked())
+        metric = MonteCarloDialog::ACPeakMagnitude;
+    else
+        metric = MonteCarloDialog::DCValue;
+
+    MonteCarloDialog *dlg = new MonteCarloDialog(m_view, meter, metric, m_numRuns->value(), m_seed->value());
+    dlg->setFrequency(m_frequency->text());
+    dlg->setFrequencyRange(m_startFrequency->text(), m_stopFrequency->text());
+    dlg->setSource(m_sourceName->currentText(), m_sourceValue->text());
+    dlg->setLimits(m_lowerLimit->text(), m_upperLimit->text());
+
+    if (!dlg->runAnalysis())
+    {
+        KMessageBox::error(this, dlg->errorString());
+        delete dlg;
+        dlg = 0;
+    }
+    else
+    {
+        dlg->show();
+        done(User1);
+    }
+}
+
+#include "montecarlopropertiesdialog.moc"
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,81 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef MONTECARLOPROPERTIESDIALOG_H
+#define MONTECARLOPROPERTIESDIALOG_H
+
+#include <kdialogbase.h>
+
+class QWidget;
+class QComboBox;
+class QRadioButton;
+class QSpinBox;
+class KLineEdit;
+class KListView;
+
+namespace Spiceplus {
+
+class SchematicView;
+class ParameterLineEdit;
+class MeterSelector;
+
+class MonteCarloPropertiesDialog : public KDialogBase
+{
+    Q_OBJECT
+
+public:
+    MonteCarloPropertiesDialog(SchematicView *view, QWidget *parent = 0);
+
+private slots:
+    void setTolerance();
+    void clearTolerance();
+    void slotUser1();
+
+private:
+    void applyTolerances();
+
+    SchematicView *m_view;
+
+    KListView *m_devices;
+    KLineEdit *m_tolerance;
+    QComboBox *m_distribution;
+
+    QRadioButton *m_acMagnitudeButton;
+    ParameterLineEdit *m_frequency;
+    QRadioButton *m_acPeakButton;
+    ParameterLineEdit *m_startFrequency;
+    ParameterLineEdit *m_stopFrequency;
+    QRadioButton *m_dcButton;
+    QComboBox *m_sourceName;
+    ParameterLineEdit *m_sourceValue;
+
+    QSpinBox *m_numRuns;
+    QSpinBox *m_seed;
+    KLineEdit *m_lowerLimit;
+    KLineEdit *m_upperLimit;
+
+    MeterSelector *m_meterSelector;
+};
+
+} // namespace Spiceplus
+
+#endif // MONTECARLOPROPERTIESDIALOG_H
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,299 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <qlayout.h>
+#include <qlabel.h>
+#include <qpushbutton.h>
+
+#include <klocale.h>
+#include <kdialog.h>
+#include <kmessagebox.h>
+#include <kprogress.h>
+#include <kseparator.h>
+
+#include "parametersweepdialog.h"
+#include "schematic.h"
+#include "schematicstandarddevice.h"
+#include "schematicview.h"
+#include "plot.h"
+#include "plotcurve.h"
+#include "resulttable.h"
+#include "settings.h"
+#include "spicejobscheduler.h"
+#include "trace.h"
+
+using namespace Spiceplus;
+
+ParameterSweepDialog::ParameterSweepDialog(SchematicView *view,
+                                           const Meter &meter,
+                                           const QString &deviceName,
+                                           const QString &parameterName,
+                                           const QStringList &values,
+                                           AnalysisType analysisType)
+    : m_view(view),
+      m_meter(meter),
+      m_deviceName(deviceName),
+      m_parameterName(parameterName),
+      m_values(values),
+      m_analysisType(analysisType),
+      m_numFailedJobs(0)
+{
+    resize(560, 420);
+    setCaption(i18n("Parameter Sweep %1 %2,%3").arg(m_deviceName).arg(m_parameterName).arg(m_meter.name()));
+
+    connect(m_view, SIGNAL(destroyed()), SLOT(close()));
+
+    m_scheduler = new SpiceJobScheduler(this);
+    connect(m_scheduler, SIGNAL(jobFinished(int, const ResultTable &)), SLOT(plotCurve(int, const ResultTable &)));
+    connect(m_scheduler, SIGNAL(jobFailed(int, const QString &, const QString &)), SLOT(recordFailure(int, const QString &, const QString &)));
+    connect(m_scheduler, SIGNAL(progress(int, int)), SLOT(updateProgress(int, int)));
+    connect(m_scheduler, SIGNAL(finished()), SLOT(finishSweep()));
+
+    QWidget *w = new QWidget(this);
+    setCentralWidget(w);
+    QBoxLayout *vbox = new QVBoxLayout(w, KDialog::marginHint(), KDialog::spacingHint());
+
+    m_plot = new Plot(w);
+    m_plot->setAutoLegend(true);
+    m_plot->enableLegend(true);
+    if (m_analysisType == AC)
+    {
+        m_plot->setAxisOptions(QwtPlot::xBottom, QwtAutoScale::Logarithmic);
+        m_plot->setAxisTitle(QwtPlot::xBottom, "Frequency [Hz]");
+        m_plot->setAxisTitle(QwtPlot::yLeft, "Magnitude [dB]");
+    }
+    else
+    {
+        m_plot->setAxisTitle(QwtPlot::xBottom, "Source value");
+        m_plot->setAxisTitle(QwtPlot::yLeft, "Measured value [" + m_meter.shortUnit() + "]");
+    }
+    vbox->addWidget(m_plot);
+
+    vbox->addWidget(new KSeparator(KSeparator::HLine, w));
+
+    QBoxLayout *hbox = new QHBoxLayout(vbox, KDialog::spacingHint());
+
+    m_progress = new KProgress(w);
+    hbox->addWidget(m_progress, 1);
+
+    m_status = new QLabel(w);
+    hbox->addWidget(m_status);
+
+    m_cancelButton = new QPushButton(i18n("Cancel"), w);
+    m_cancelButton->setEnabled(false);
+    connect(m_cancelButton, SIGNAL(clicked()), SLOT(cancel()));
+    hbox->addWidget(m_cancelButton);
+
+    QPushButton *updateButton = new QPushButton(i18n("Update"), w);
+    connect(updateButton, SIGNAL(clicked()), SLOT(updatePlot()));
+    hbox->addWidget(updateButton);
+}
+
+void ParameterSweepDialog::setDCSweep(const QString &sourceName, const QString &startingValue, const QString &finalValue, const QString &incrementingValue)
+{
+    m_sourceName = sourceName;
+    m_startingValue = startingValue;
+    m_finalValue = finalValue;
+    m_incrementingValue = incrementingValue;
+
+    SchematicDevice *dev = m_view->schematic()->findDevice(m_sourceName);
+    QString unit;
+    if (dev && dev->type() == "v")
+        unit = " [V]";
+    else if (dev && dev->type() == "i")
+        unit = " [A]";
+    m_plot->setAxisTitle(QwtPlot::xBottom, "Source value" + unit);
+}
+
+void ParameterSweepDialog::setFrequencyRange(const QString &startFrequency, const QString &stopFrequency)
+{
+    m_startFrequency = startFrequency;
+    m_stopFrequency = stopFrequency;
+}
+
+bool ParameterSweepDialog::runAnalysis()
+{
+    QStringList commandLists;
+    if (!createCommandLists(commandLists))
+        return false;
+
+    m_plot->removeCurves();
+    m_curves.clear();
+
+    // one curve per value, so that the legend keeps the order of the values
+    int index = 0;
+    for (QStringList::ConstIterator it = m_values.begin(); it != m_values.end(); ++it, ++index)
+    {
+        QColor color;
+        color.setHsv(300 * index / QMAX(1, int(m_values.count()) - 1), 255, 200);
+
+        QwtPlotCurve *curve = new PlotCurve(m_plot, m_parameterName + " = " + *it);
+        curve->setPen(color);
+        m_plot->insertCurve(curve);
+        m_curves.append(curve);
+    }
+    m_plot->replot();
+
+    m_numFailedJobs = 0;
+    m_failureString = QString::null;
+    m_failureDetails = QString::null;
+
+    m_progress->setTotalSteps(commandLists.count());
+    m_progress->setProgress(0);
+    updateProgress(0, commandLists.count());
+    m_cancelButton->setEnabled(true);
+
+    m_scheduler->run(commandLists);
+    return true;
+}
+
+QString ParameterSweepDialog::createAnalysisCommands(const QString &meterCmd)
+{
+    QString cmds = ".control\n"
+                   "set nobreak\n"
+                   ".endc\n";
+
+    if (m_analysisType == AC)
+    {
+        cmds += ".ac dec " + QString::number(Settings::self()->acAnalysisNumPointsPerDecade()) + " "
+                           + m_startFrequency + " " + m_stopFrequency + "\n"
+                ".print ac db(" + meterCmd + ")\n";
+    }
+    else
+    {
+        SchematicDevice *src = m_view->schematic()->findDevice(m_sourceName);
+        if (!src)
+        {
+            m_errorString = i18n("Source %1 not found").arg(m_sourceName);
+            return QString::null;
+        }
+
+        cmds += ".dc " + src->type() + src->name().lower() + " " + m_startingValue + " " + m_finalValue + " " + m_incrementingValue + "\n"
+                ".print dc " + meterCmd + "\n";
+    }
+
+    return cmds + ".end\n";
+}
+
+bool ParameterSweepDialog::createCommandLists(QStringList &commandLists)
+{
+    TraceSpan span("ParameterSweepDialog::createCommandLists");
+
+    Schematic *schematic = m_view->schematic();
+    SchematicStandardDevice *dev = dynamic_cast<SchematicStandardDevice *>(schematic->findDevice(m_deviceName));
+    if (!dev)
+    {
+        m_errorString = i18n("Device %1 not found").arg(m_deviceName);
+        return false;
+    }
+
+    QString meterCmd = m_meter.createCommand(schematic);
+    if (meterCmd.isNull())
+    {
+        m_errorString = m_meter.errorString();
+        return false;
+    }
+
+    QString analysisCmds = createAnalysisCommands(meterCmd);
+    if (analysisCmds.isNull())
+        return false;
+    m_vectorName = m_analysisType == AC ? "db(" + meterCmd + ")" : meterCmd;
+    analysisCmds.prepend(Meter::createSaveCommand(schematic, MeterList() << m_meter));
+
+    // each variant is the schematic with the parameter set to one value;
+    // the device gets its own value back afterwards
+    QString oldValue = dev->parameter(m_parameterName);
+    bool ok = true;
+
+    for (QStringList::ConstIterator it = m_values.begin(); it != m_values.end(); ++it)
+    {
+        dev->setParameter(m_parameterName, *it);
+
+        QString cmdList = schematic->createCommandList();
+        if (cmdList.isNull())
+        {
+            m_errorString = schematic->errorString();
+            ok = false;
+            break;
+        }
+
+        commandLists.append(cmdList + analysisCmds);
+    }
+
+    dev->setParameter(m_parameterName, oldValue);
+    return ok;
+}
+
+void ParameterSweepDialog::plotCurve(int job, const ResultTable &table)
+{
+    TraceSpan span("ParameterSweepDialog::plotCurve");
+
+    m_curves[job]->setData(table.axis(), table.real(m_vectorName));
+    m_plot->replot();
+}
+
+void ParameterSweepDialog::recordFailure(int, const QString &errorString, const QString &errorDetails)
+{
+    // the first failure is reported, the others are most likely alike
+    if (m_numFailedJobs++ == 0)
+    {
+        m_failureString = errorString;
+        m_failureDetails = errorDetails;
+    }
+}
+
+void ParameterSweepDialog::updateProgress(int numFinishedJobs, int numJobs)
+{
+    m_progress->setProgress(numFinishedJobs);
+    m_status->setText(i18n("%1 of %2 runs").arg(numFinishedJobs).arg(numJobs));
+}
+
+void ParameterSweepDialog::finishSweep()
+{
+    m_cancelButton->setEnabled(false);
+
+    if (m_numFailedJobs == 0)
+        return;
+
+    QString message = i18n("%1 of %2 runs failed").arg(m_numFailedJobs).arg(m_values.count()) + "\n" + m_failureString;
+    if (m_failureDetails.isNull())
+        KMessageBox::error(this, message);
+    else
+        KMessageBox::detailedError(this, message, m_failureDetails);
+}
+
+void ParameterSweepDialog::updatePlot()
+{
+    m_view->resetTool();
+
+    if (!runAnalysis())
+        KMessageBox::error(this, m_errorString);
+}
+
+void ParameterSweepDialog::cancel()
+{
+    m_scheduler->cancel();
+    m_cancelButton->setEnabled(false);
+    m_status->setText(i18n("Cancelled"));
+}
+
+#include "parametersweepdialog.moc"
+
+// vim: ts=4 sw=4 et
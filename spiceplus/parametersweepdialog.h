@@ -0,0 +1,113 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PARAMETERSWEEPDIALOG_H
+#define PARAMETERSWEEPDIALOG_H
+
+#include <qvaluevector.h>
+#include <qstringlist.h>
+
+#include <kmainwindow.h>
+
+#include "meter.h"
+
+class QLabel;
+class QPushButton;
+class QwtPlotCurve;
+class KProgress;
+
+namespace Spiceplus {
+
+class Plot;
+class ResultTable;
+class SchematicView;
+class SpiceJobScheduler;
+
+// Repeats a DC or AC analysis for each value of one device parameter and
+// plots the results as a family of curves. The runs go to SPICE in
+// parallel; each curve is drawn as soon as its run is done.
+class ParameterSweepDialog : public KMainWindow
+{
+    Q_OBJECT
+
+public:
+    enum AnalysisType { DC, AC };
+
+    ParameterSweepDialog(SchematicView *view,
+                         const Meter &meter,
+                         const QString &deviceName,
+                         const QString &parameterName,
+                         const QStringList &values,
+                         AnalysisType analysisType);
+
+    // the source sweep of a DC analysis
+    void setDCSweep(const QString &sourceName, const QString &startingValue, const QString &finalValue, const QString &incrementingValue);
+    // the frequency range of an AC analysis, plotted as magnitude in dB
+    void setFrequencyRange(const QString &startFrequency, const QString &stopFrequency);
+
+    bool runAnalysis();
+    QString errorString() const { return m_errorString; }
+
+private slots:
+    void plotCurve(int job, const ResultTable &table);
+    void recordFailure(int job, const QString &errorString, const QString &errorDetails);
+    void updateProgress(int numFinishedJobs, int numJobs);
+    void finishSweep();
+    void updatePlot();
+    void cancel();
+
+private:
+    QString createAnalysisCommands(const QString &meterCmd);
+    bool createCommandLists(QStringList &commandLists);
+
+    SchematicView *m_view;
+    Meter m_meter;
+    QString m_deviceName;
+    QString m_parameterName;
+    QStringList m_values;
+    AnalysisType m_analysisType;
+    // the vector of the plotted quantity in the result of a run
+    QString m_vectorName;
+
+    QString m_sourceName;
+    QString m_startingValue;
+    QString m_finalValue;
+    QString m_incrementingValue;
+    QString m_startFrequency;
+    QString m_stopFrequency;
+
+    SpiceJobScheduler *m_scheduler;
+    int m_numFailedJobs;
+    QString m_failureString;
+    QString m_failureDetails;
+    QString m_errorString;
+
+    Plot *m_plot;
+    QValueVector<QwtPlotCurve *> m_curves;
+    KProgress *m_progress;
+    QLabel *m_status;
+    QPushButton *m_cancelButton;
+};
+
+} // namespace Spiceplus
+
+#endif // PARAMETERSWEEPDIALOG_H
+
+// vim: ts=4 sw=4 et
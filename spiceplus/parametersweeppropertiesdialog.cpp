@@ -0,0 +1,332 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <math.h>
+
+#include <qlayout.h>
+#include <qlabel.h>
+#include <qcombobox.h>
+#include <qcheckbox.h>
+#include <qspinbox.h>
+#include <qradiobutton.h>
+#include <qbuttongroup.h>
+#include <qregexp.h>
+
+#include <klocale.h>
+#include <kdialog.h>
+#include <klineedit.h>
+#include <kmessagebox.h>
+
+#include "parametersweeppropertiesdialog.h"
+#include "schematic.h"
+#include "schematicstandarddevice.h"
+#include "schematicview.h"
+#include "parameterlineedit.h"
+#include "meterselector.h"
+#include "parametersweepdialog.h"
+#include "spicenumber.h"
+#include "groupbox.h"
+
+using namespace Spiceplus;
+
+ParameterSweepPropertiesDialog::ParameterSweepPropertiesDialog(SchematicView *view, QWidget *parent)
+    : KDialogBase(parent, 0, true, i18n("Parameter Sweep"), User1 | Close, User1, false, KGuiItem(i18n("&Plot"), "ok")), m_view(view)
+{
+    // devices with at least one numeric parameter
+    QStringList devices;
+    QCanvasItemList l = m_view->schematic()->allItems();
+    for (QCanvasItemList::Iterator it = l.begin(); it != l.end(); ++it)
+    {
+        if (!(*it)->isVisible() || (*it)->rtti() != SchematicDevice::RTTI)
+            continue;
+
+        SchematicStandardDevice *dev = dynamic_cast<SchematicStandardDevice *>(*it);
+        if (!dev)
+            continue;
+
+        QStringList params = dev->parameterNames();
+        for (QStringList::Iterator p = params.begin(); p != params.end(); ++p)
+        {
+            double value;
+            if (dev->parameterValue(*p, value))
+            {
+                devices << dev->name();
+                break;
+            }
+        }
+    }
+    devices.sort();
+
+    QStringList sources = m_view->schematic()->deviceNamesByType("v") + m_view->schematic()->deviceNamesByType("i");
+
+    QWidget *w = new QWidget(this);
+    setMainWidget(w);
+    QBoxLayout *topLayout = new QVBoxLayout(w, 0, KDialog::spacingHint());
+
+    GroupBox *paramBox = new GroupBox(0, Qt::Vertical, i18n("Swept Parameter"), w);
+    QGridLayout *paramGrid = new QGridLayout(paramBox->layout(), 6, 3, KDialog::spacingHint());
+    paramGrid->addWidget(new QLabel(i18n("Device:"), paramBox), 0, 0);
+    m_deviceName = new QComboBox(paramBox);
+    m_deviceName->insertStringList(devices);
+    connect(m_deviceName, SIGNAL(activated(int)), SLOT(selectDevice()));
+    paramGrid->addWidget(m_deviceName, 0, 1);
+    m_parameterName = new QComboBox(paramBox);
+    paramGrid->addWidget(m_parameterName, 0, 2);
+
+    QButtonGroup *valuesGroup = new QButtonGroup(paramBox);
+    valuesGroup->hide();
+
+    paramGrid->addWidget(m_listButton = new QRadioButton(i18n("Values:"), paramBox), 1, 0);
+    valuesGroup->insert(m_listButton);
+    m_valueList = new KLineEdit("1k 2.2k 4.7k 10k", paramBox);
+    m_valueList->connect(m_listButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    paramGrid->addMultiCellWidget(m_valueList, 1, 1, 1, 2);
+
+    paramGrid->addWidget(m_rangeButton = new QRadioButton(i18n("Range:"), paramBox), 2, 0);
+    valuesGroup->insert(m_rangeButton);
+
+    QLabel *label;
+
+    label = new QLabel(i18n("Starting Value:"), paramBox);
+    label->connect(m_rangeButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    paramGrid->addWidget(label, 3, 0);
+    paramGrid->addWidget(m_startingValue = new ParameterLineEdit("1k", "0", paramBox), 3, 1);
+    m_startingValue->connect(m_rangeButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+
+    label = new QLabel(i18n("Final Value:"), paramBox);
+    label->connect(m_rangeButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    paramGrid->addWidget(label, 4, 0);
+    paramGrid->addWidget(m_finalValue = new ParameterLineEdit("10k", "0", paramBox), 4, 1);
+    m_finalValue->connect(m_rangeButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+
+    label = new QLabel(i18n("Number of Points:"), paramBox);
+    label->connect(m_rangeButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    paramGrid->addWidget(label, 5, 0);
+    paramGrid->addWidget(m_numPoints = new QSpinBox(2, 1000, 1, paramBox), 5, 1);
+    m_numPoints->setValue(8);
+    m_numPoints->connect(m_rangeButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    paramGrid->addWidget(m_logarithmic = new QCheckBox(i18n("Logarithmic"), paramBox), 5, 2);
+    m_logarithmic->setChecked(true);
+    m_logarithmic->connect(m_rangeButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+
+    // toggling both ways brings every dependent widget into its state
+    m_rangeButton->setChecked(true);
+    m_listButton->setChecked(true);
+
+    topLayout->addWidget(paramBox);
+
+    GroupBox *analysisBox = new GroupBox(0, Qt::Vertical, i18n("Analysis"), w);
+    QGridLayout *analysisGrid = new QGridLayout(analysisBox->layout(), 8, 3, KDialog::spacingHint());
+
+    QButtonGroup *analysisGroup = new QButtonGroup(analysisBox);
+    analysisGroup->hide();
+
+    analysisGrid->addMultiCellWidget(m_acButton = new QRadioButton(i18n("AC magnitude"), analysisBox), 0, 0, 0, 2);
+    analysisGroup->insert(m_acButton);
+
+    label = new QLabel(i18n("Start:"), analysisBox);
+    label->connect(m_acButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 1, 0);
+    analysisGrid->addWidget(m_startFrequency = new ParameterLineEdit("10", "10", analysisBox), 1, 1);
+    m_startFrequency->connect(m_acButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    label = new QLabel(i18n("Herz"), analysisBox);
+    label->connect(m_acButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 1, 2);
+
+    label = new QLabel(i18n("Stop:"), analysisBox);
+    label->connect(m_acButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 2, 0);
+    analysisGrid->addWidget(m_stopFrequency = new ParameterLineEdit("100meg", "100meg", analysisBox), 2, 1);
+    m_stopFrequency->connect(m_acButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    label = new QLabel(i18n("Herz"), analysisBox);
+    label->connect(m_acButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 2, 2);
+
+    analysisGrid->addMultiCellWidget(m_dcButton = new QRadioButton(i18n("DC transfer"), analysisBox), 3, 3, 0, 2);
+    analysisGroup->insert(m_dcButton);
+    if (sources.isEmpty())
+        m_dcButton->setEnabled(false);
+
+    label = new QLabel(i18n("Source:"), analysisBox);
+    label->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 4, 0);
+    m_sourceName = new QComboBox(analysisBox);
+    m_sourceName->insertStringList(sources);
+    m_sourceName->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(m_sourceName, 4, 1);
+
+    label = new QLabel(i18n("Starting Value:"), analysisBox);
+    label->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 5, 0);
+    analysisGrid->addWidget(m_sourceStartingValue = new ParameterLineEdit("0", "0", analysisBox), 5, 1);
+    m_sourceStartingValue->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    label = new QLabel(i18n("Volts / Amps"), analysisBox);
+    label->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 5, 2);
+
+    label = new QLabel(i18n("Final Value:"), analysisBox);
+    label->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 6, 0);
+    analysisGrid->addWidget(m_sourceFinalValue = new ParameterLineEdit("10", "0", analysisBox), 6, 1);
+    m_sourceFinalValue->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    label = new QLabel(i18n("Volts / Amps"), analysisBox);
+    label->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 6, 2);
+
+    label = new QLabel(i18n("Incrementing Value:"), analysisBox);
+    label->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 7, 0);
+    analysisGrid->addWidget(m_sourceIncrementingValue = new ParameterLineEdit("0.1", "0", analysisBox), 7, 1);
+    m_sourceIncrementingValue->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    label = new QLabel(i18n("Volts / Amps"), analysisBox);
+    label->connect(m_dcButton, SIGNAL(toggled(bool)), SLOT(setEnabled(bool)));
+    analysisGrid->addWidget(label, 7, 2);
+
+    m_dcButton->setChecked(true);
+    m_acButton->setChecked(true);
+
+    topLayout->addWidget(analysisBox);
+
+    GroupBox *outputBox = new GroupBox(0, Qt::Vertical, i18n("Output Variable"), w);
+    QGridLayout *outputGrid = new QGridLayout(outputBox->layout(), 2, 4, KDialog::spacingHint());
+    m_meterSelector = new MeterSelector(m_view->schematic(), outputBox, outputGrid, 0, 0);
+    topLayout->addWidget(outputBox);
+
+    selectDevice();
+}
+
+void ParameterSweepPropertiesDialog::selectDevice()
+{
+    m_parameterName->clear();
+
+    SchematicStandardDevice *dev = dynamic_cast<SchematicStandardDevice *>(m_view->schematic()->findDevice(m_deviceName->currentText()));
+    if (!dev)
+        return;
+
+    QStringList params = dev->parameterNames();
+    for (QStringList::Iterator p = params.begin(); p != params.end(); ++p)
+    {
+        double value;
+        if (dev->parameterValue(*p, value))
+        {
+            m_parameterName->insertItem(*p);
+            if (*p == "value")
+                m_parameterName->setCurrentItem(m_parameterName->count() - 1);
+        }
+    }
+}
+
+bool ParameterSweepPropertiesDialog::createValues(QStringList &values)
+{
+    if (m_listButton->isChecked())
+    {
+        values = QStringList::split(QRegExp("[\\s,;]+"), m_valueList->text());
+        for (QStringList::Iterator it = values.begin(); it != values.end(); ++it)
+        {
+            double value;
+            if (!SpiceNumber::parse(*it, value))
+            {
+                KMessageBox::sorry(this, i18n("%1 is not a valid value").arg(*it));
+                return false;
+            }
+        }
+
+        if (values.isEmpty())
+        {
+            KMessageBox::sorry(this, i18n("No values given"));
+            return false;
+        }
+
+        return true;
+    }
+
+    double start, stop;
+    if (!SpiceNumber::parse(m_startingValue->text(), start) || !SpiceNumber::parse(m_finalValue->text(), stop))
+    {
+        KMessageBox::sorry(this, i18n("Invalid range"));
+        return false;
+    }
+
+    bool logarithmic = m_logarithmic->isChecked();
+    if (logarithmic && start * stop <= 0)
+    {
+        KMessageBox::sorry(this, i18n("A logarithmic range must not include zero"));
+        return false;
+    }
+
+    int numPoints = m_numPoints->value();
+    for (int i = 0; i < numPoints; ++i)
+    {
+        double t = double(i) / (numPoints - 1);
+        double value = logarithmic ? start * pow(stop / start, t) : start + t * (stop - start);
+        // a sweep point is a value one would type, not a 17 digit number
+        values.append(SpiceNumber::format(QString::number(value, 'g', 4).toDouble()));
+    }
+
+    return true;
+}
+
+void ParameterSweepPropertiesDialog::slotUser1()
+{
+    if (m_parameterName->count() == 0)
+    {
+        KMessageBox::sorry(this, i18n("The schematic has no device with a numeric parameter"));
+        return;
+    }
+
+    QStringList values;
+    if (!createValues(values))
+        return;
+
+    Meter meter = m_meterSelector->meter();
+
+    if (meter.type() == Meter::Voltmeter && meter.testPoint1() == meter.testPoint2())
+    {
+        KMessageBox::sorry(this, i18n("Test Points must differ"));
+        return;
+    }
+
+    ParameterSweepDialog *dlg = new ParameterSweepDialog(m_view,
+                                                         meter,
+                                                         m_deviceName->currentText(),
+                                                         m_parameterName->currentText(),
+                                                         values,
+                                                         m_dcButton->isChecked() ? ParameterSweepDialog::DC : ParameterSweepDialog::AC);
+    if (m_dcButton->isChecked())
+        dlg->setDCSweep(m_sourceName->currentText(), m_sourceStartingValue->text(), m_sourceFinalValue->text(), m_sourceIncrementingValue->text());
+    else
+        dlg->setFrequencyRange(m_startFrequency->text(), m_stopFrequency->text());
+
+    if (!dlg->runAnalysis())
+    {
+        KMessageBox::error(this, dlg->errorString());
+        delete dlg;
+        dlg = 0;
+    }
+    else
+    {
+        dlg->show();
+        done(User1);
+    }
+}
+
+#include "parametersweeppropertiesdialog.moc"
+
+// vim: ts=4 sw=4 et
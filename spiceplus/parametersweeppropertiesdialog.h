@@ -0,0 +1,81 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PARAMETERSWEEPPROPERTIESDIALOG_H
+#define PARAMETERSWEEPPROPERTIESDIALOG_H
+
+#include <kdialogbase.h>
+
+class QWidget;
+class QComboBox;
+class QRadioButton;
+class QCheckBox;
+class QSpinBox;
+class KLineEdit;
+
+namespace Spiceplus {
+
+class SchematicView;
+class ParameterLineEdit;
+class MeterSelector;
+
+class ParameterSweepPropertiesDialog : public KDialogBase
+{
+    Q_OBJECT
+
+public:
+    ParameterSweepPropertiesDialog(SchematicView *view, QWidget *parent = 0);
+
+private slots:
+    void selectDevice();
+    void slotUser1();
+
+private:
+    bool createValues(QStringList &values);
+
+    SchematicView *m_view;
+
+    QComboBox *m_deviceName;
+    QComboBox *m_parameterName;
+    QRadioButton *m_listButton;
+    KLineEdit *m_valueList;
+    QRadioButton *m_rangeButton;
+    ParameterLineEdit *m_startingValue;
+    ParameterLineEdit *m_finalValue;
+    QSpinBox *m_numPoints;
+    QCheckBox *m_logarithmic;
+
+    QRadioButton *m_dcButton;
+    QComboBox *m_sourceName;
+    ParameterLineEdit *m_sourceStartingValue;
+    ParameterLineEdit *m_sourceFinalValue;
+    ParameterLineEdit *m_sourceIncrementingValue;
+    QRadioButton *m_acButton;
+    ParameterLineEdit *m_startFrequency;
+    ParameterLineEdit *m_stopFrequency;
+
+    MeterSelector *m_meterSelector;
+};
+
+} // namespace Spiceplus
+
+#endif // PARAMETERSWEEPPROPERTIESDIALOG_H
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,273 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <math.h>
+
+#include <qlayout.h>
+#include <qcombobox.h>
+#include <qcheckbox.h>
+#include <qslider.h>
+#include <qlabel.h>
+
+#include <klocale.h>
+#include <kdialog.h>
+#include <klineedit.h>
+
+#include "parametertuner.h"
+#include "schematicview.h"
+#include "schematiccommand.h"
+#include "schematiccommandhistory.h"
+#include "schematic.h"
+#include "schematicstandarddevice.h"
+#include "spicenumber.h"
+
+using namespace Spiceplus;
+
+ParameterTuner::ParameterTuner(SchematicView *view, QWidget *parent)
+    : QWidget(parent),
+      m_view(view),
+      m_oldState(0),
+      m_isUpdatingSlider(false)
+{
+    QBoxLayout *vbox = new QVBoxLayout(this, 0, KDialog::spacingHint());
+
+    QBoxLayout *hbox = new QHBoxLayout(vbox, KDialog::spacingHint());
+    hbox->addWidget(new QLabel(i18n("Device:"), this));
+    m_device = new QComboBox(this);
+    connect(m_device, SIGNAL(activated(int)), SLOT(selectDevice()));
+    hbox->addWidget(m_device);
+    m_parameter = new QComboBox(this);
+    connect(m_parameter, SIGNAL(activated(int)), SLOT(selectParameter()));
+    hbox->addWidget(m_parameter);
+    hbox->addWidget(new QLabel(i18n("From:"), this));
+    m_min = new KLineEdit(this);
+    connect(m_min, SIGNAL(returnPressed()), SLOT(updateSlider()));
+    hbox->addWidget(m_min);
+    hbox->addWidget(new QLabel(i18n("To:"), this));
+    m_max = new KLineEdit(this);
+    connect(m_max, SIGNAL(returnPressed()), SLOT(updateSlider()));
+    hbox->addWidget(m_max);
+    m_logarithmic = new QCheckBox(i18n("Logarithmic"), this);
+    connect(m_logarithmic, SIGNAL(toggled(bool)), SLOT(updateSlider()));
+    hbox->addWidget(m_logarithmic);
+
+    hbox = new QHBoxLayout(vbox, KDialog::spacingHint());
+    m_slider = new QSlider(0, Steps, Steps / 10, 0, Qt::Horizontal, this);
+    connect(m_slider, SIGNAL(valueChanged(int)), SLOT(applySliderValue(int)));
+    connect(m_slider, SIGNAL(sliderReleased()), SLOT(commit()));
+    hbox->addWidget(m_slider, 1);
+    m_value = new QLabel(this);
+    m_value->setMinimumWidth(m_value->fontMetrics().width("-0.0000e-00"));
+    hbox->addWidget(m_value);
+
+    refresh();
+}
+
+ParameterTuner::~ParameterTuner()
+{
+    delete m_oldState;
+}
+
+bool ParameterTuner::isDragging() const
+{
+    return m_slider->isSliderDown();
+}
+
+void ParameterTuner::refresh()
+{
+    QString current = m_device->currentText();
+    QStringList names;
+
+    QCanvasItemList l = m_view->schematic()->allItems();
+    for (QCanvasItemList::Iterator it = l.begin(); it != l.end(); ++it)
+    {
+        if (!(*it)->isVisible() || (*it)->rtti() != SchematicDevice::RTTI)
+            continue;
+
+        SchematicStandardDevice *dev = dynamic_cast<SchematicStandardDevice *>(*it);
+        if (!dev)
+            continue;
+
+        QStringList params = dev->parameterNames();
+        for (QStringList::Iterator p = params.begin(); p != params.end(); ++p)
+        {
+            double value;
+            if (dev->parameterValue(*p, value))
+            {
+                names << dev->name();
+                break;
+            }
+        }
+    }
+
+    names.sort();
+    m_device->clear();
+    m_device->insertStringList(names);
+
+    int index = names.findIndex(current);
+    if (index >= 0)
+        m_device->setCurrentItem(index);
+
+    selectDevice();
+}
+
+void ParameterTuner::selectDevice()
+{
+    QString current = m_parameter->currentText();
+    m_parameter->clear();
+
+    SchematicStandardDevice *dev = device();
+    if (dev)
+    {
+        QStringList params = dev->parameterNames();
+        for (QStringList::Iterator p = params.begin(); p != params.end(); ++p)
+        {
+            double value;
+            if (dev->parameterValue(*p, value))
+                m_parameter->insertItem(*p);
+        }
+
+        // the main value of a device is the most likely choice
+        for (int i = 0; i < m_parameter->count(); ++i)
+            if (m_parameter->text(i) == (current.isEmpty() ? QString("value") : current))
+                m_parameter->setCurrentItem(i);
+    }
+
+    selectParameter();
+}
+
+void ParameterTuner::selectParameter()
+{
+    SchematicStandardDevice *dev = device();
+    double value;
+    bool ok = dev && dev->parameterValue(m_parameter->currentText(), value);
+
+    m_slider->setEnabled(ok);
+    if (!ok)
+    {
+        m_min->clear();
+        m_max->clear();
+        m_value->clear();
+        return;
+    }
+
+    // a decade up and down, or a symmetric range around zero
+    if (value > 0)
+    {
+        m_min->setText(SpiceNumber::format(value / 10));
+        m_max->setText(SpiceNumber::format(value * 10));
+    }
+    else
+    {
+        double span = value < 0 ? -value * 10 : 1;
+        m_min->setText(SpiceNumber::format(-span));
+        m_max->setText(SpiceNumber::format(span));
+    }
+
+    m_logarithmic->blockSignals(true);
+    m_logarithmic->setChecked(value > 0);
+    m_logarithmic->blockSignals(false);
+
+    updateSlider();
+}
+
+void ParameterTuner::updateSlider()
+{
+    SchematicStandardDevice *dev = device();
+    double value, min, max;
+    if (!dev || !dev->parameterValue(m_parameter->currentText(), value) || !range(min, max))
+        return;
+
+    double position;
+    if (m_logarithmic->isChecked())
+        position = log(value / min) / log(max / min);
+    else
+        position = (value - min) / (max - min);
+
+    m_isUpdatingSlider = true;
+    m_slider->setValue(int(QMIN(QMAX(position, 0.0), 1.0) * Steps + 0.5));
+    m_isUpdatingSlider = false;
+
+    m_value->setText(dev->parameter(m_parameter->currentText()));
+}
+
+void ParameterTuner::applySliderValue(int position)
+{
+    SchematicStandardDevice *dev = device();
+    double min, max;
+    if (m_isUpdatingSlider || !dev || !range(min, max))
+        return;
+
+    double t = double(position) / Steps;
+    double value = m_logarithmic->isChecked() ? min * pow(max / min, t) : min + t * (max - min);
+    // four significant digits are plenty for a slider position
+    SchematicParameter param(QString::number(value, 'g', 4).toDouble());
+
+    if (!m_oldState)
+        m_oldState = dev->createState();
+
+    dev->setParameter(m_parameter->currentText(), param);
+    dev->updateLabels();
+    m_view->schematic()->update();
+    m_value->setText(param.toString());
+
+    emit changed();
+
+    // keyboard and wheel steps are complete changes of their own
+    if (!m_slider->isSliderDown())
+        commit();
+}
+
+void ParameterTuner::commit()
+{
+    if (!m_oldState)
+        return;
+
+    SchematicStandardDevice *dev = device();
+    if (dev)
+        m_view->history()->add(new SchematicCommandChangeDeviceProperties(dev, m_oldState, dev->createState()));
+    else
+        delete m_oldState;
+
+    m_oldState = 0;
+
+    emit released();
+}
+
+SchematicStandardDevice *ParameterTuner::device() const
+{
+    return dynamic_cast<SchematicStandardDevice *>(m_view->schematic()->findDevice(m_device->currentText()));
+}
+
+bool ParameterTuner::range(double &min, double &max) const
+{
+    if (!SpiceNumber::parse(m_min->text(), min) || !SpiceNumber::parse(m_max->text(), max) || min == max)
+        return false;
+
+    // a logarithmic scale needs a range on one side of zero
+    if (m_logarithmic->isChecked() && min * max <= 0)
+        return false;
+
+    return true;
+}
+
+#include "parametertuner.moc"
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,89 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PARAMETERTUNER_H
+#define PARAMETERTUNER_H
+
+#include <qwidget.h>
+
+class QComboBox;
+class QCheckBox;
+class QSlider;
+class QLabel;
+class KLineEdit;
+
+namespace Spiceplus {
+
+class SchematicView;
+class SchematicStandardDevice;
+class SchematicDeviceState;
+
+// A slider bound to a numeric parameter of a device in the schematic.
+// Dragging sets the parameter directly and emits changed(); on release
+// the whole drag becomes one undoable property change and released() is
+// emitted.
+class ParameterTuner : public QWidget
+{
+    Q_OBJECT
+
+public:
+    ParameterTuner(SchematicView *view, QWidget *parent = 0);
+    ~ParameterTuner();
+
+    bool isDragging() const;
+
+public slots:
+    void refresh();
+
+signals:
+    void changed();
+    void released();
+
+private slots:
+    void selectDevice();
+    void selectParameter();
+    void updateSlider();
+    void applySliderValue(int position);
+    void commit();
+
+private:
+    SchematicStandardDevice *device() const;
+    bool range(double &min, double &max) const;
+
+    static const int Steps = 1000;
+
+    SchematicView *m_view;
+    QComboBox *m_device;
+    QComboBox *m_parameter;
+    KLineEdit *m_min;
+    KLineEdit *m_max;
+    QCheckBox *m_logarithmic;
+    QSlider *m_slider;
+    QLabel *m_value;
+
+    SchematicDeviceState *m_oldState;
+    bool m_isUpdatingSlider;
+};
+
+} // namespace Spiceplus
+
+#endif // PARAMETERTUNER_H
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,204 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <qpainter.h>
+#include <qpointarray.h>
+#include <qtl.h>
+
+#include "plotcurve.h"
+#include "trace.h"
+
+using namespace Spiceplus;
+
+PlotCurve::PlotCurve(QwtPlot *plot, const QString &title)
+    : QwtPlotCurve(plot, title),
+      m_isPyramidValid(false),
+      m_isAscending(false)
+{
+}
+
+void PlotCurve::curveChanged()
+{
+    m_isPyramidValid = false;
+    QwtPlotCurve::curveChanged();
+}
+
+void PlotCurve::draw(QPainter *painter, const QwtDiMap &xMap, const QwtDiMap &yMap, int from, int to)
+{
+    int numPoints = dataSize();
+    int numPixels = QABS(xMap.i2() - xMap.i1()) + 1;
+
+    // a part of the curve is drawn on its own only when it is appended to
+    if (from != 0 || (to >= 0 && to < numPoints - 1) || numPoints <= MaxPointsPerPixel * numPixels ||
+        style() != Lines || symbol().style() != QwtSymbol::None || brush().style() != Qt::NoBrush)
+    {
+        QwtPlotCurve::draw(painter, xMap, yMap, from, to);
+        return;
+    }
+
+    if (!m_isPyramidValid)
+        buildPyramid();
+
+    if (!m_isAscending)
+    {
+        QwtPlotCurve::draw(painter, xMap, yMap, from, to);
+        return;
+    }
+
+    double x1 = xMap.invTransform(xMap.i1());
+    double x2 = xMap.invTransform(xMap.i2());
+    int first = QMAX(0, lowerBound(QMIN(x1, x2)) - 1);
+    int last = QMIN(numPoints - 1, lowerBound(QMAX(x1, x2)));
+    int numVisible = last - first + 1;
+
+    if (numVisible <= MaxPointsPerPixel * numPixels)
+    {
+        QwtPlotCurve::draw(painter, xMap, yMap, first, last);
+        return;
+    }
+
+    // the coarsest level with at least two blocks per pixel column
+    int level = 0;
+    while (level + 1 < int(m_minima.count()) && (numVisible >> (level + 2)) >= 2 * numPixels)
+        ++level;
+
+    drawDecimated(painter, xMap, yMap, first, last, level);
+}
+
+void PlotCurve::buildPyramid()
+{
+    TraceSpan span("PlotCurve::buildPyramid");
+
+    m_isPyramidValid = true;
+    m_minima.clear();
+    m_maxima.clear();
+
+    int numPoints = dataSize();
+    m_isAscending = true;
+    for (int i = 1; i < numPoints && m_isAscending; ++i)
+        m_isAscending = x(i) >= x(i - 1);
+    if (!m_isAscending)
+        return;
+
+    // the first level from the points, each further one from the level
+    // below; all levels together take as much as the points
+    int numBlocks = (numPoints + 1) / 2;
+    QMemArray<double> minima(numBlocks), maxima(numBlocks);
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        int i = 2 * block;
+        double y0 = y(i);
+        double y1 = i + 1 < numPoints ? y(i + 1) : y0;
+        minima[block] = QMIN(y0, y1);
+        maxima[block] = QMAX(y0, y1);
+    }
+
+    for (;;)
+    {
+        m_minima.push_back(minima);
+        m_maxima.push_back(maxima);
+        if (numBlocks <= MaxPointsPerPixel)
+            break;
+
+        int numLowerBlocks = numBlocks;
+        numBlocks = (numLowerBlocks + 1) / 2;
+        QMemArray<double> upperMinima(numBlocks), upperMaxima(numBlocks);
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            int i = 2 * block;
+            int j = i + 1 < numLowerBlocks ? i + 1 : i;
+            upperMinima[block] = QMIN(minima[i], minima[j]);
+            upperMaxima[block] = QMAX(maxima[i], maxima[j]);
+        }
+
+        minima = upperMinima;
+        maxima = upperMaxima;
+    }
+}
+
+int PlotCurve::lowerBound(double value) const
+{
+    int low = 0;
+    int high = dataSize();
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (x(middle) < value)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+void PlotCurve::drawDecimated(QPainter *painter, const QwtDiMap &xMap, const QwtDiMap &yMap, int first, int last, int level)
+{
+    const QMemArray<double> &minima = m_minima[level];
+    const QMemArray<double> &maxima = m_maxima[level];
+    int shift = level + 1;
+    int firstBlock = first >> shift;
+    int lastBlock = last >> shift;
+
+    // each pixel column becomes a vertical stroke over the extremes of the
+    // blocks starting in it, entered from the end nearer the last column
+    QPointArray points(2 * (lastBlock - firstBlock + 1));
+    int numPoints = 0;
+    int column = 0;
+    double low = 0, high = 0;
+    int lastY = 0;
+
+    for (int block = firstBlock; block <= lastBlock + 1; ++block)
+    {
+        int blockColumn = block <= lastBlock ? xMap.transform(x(block << shift)) : 0;
+        if (block > firstBlock && (block > lastBlock || blockColumn != column))
+        {
+            int lowY = yMap.transform(low);
+            int highY = yMap.transform(high);
+            if (numPoints > 0 && QABS(highY - lastY) < QABS(lowY - lastY))
+                qSwap(lowY, highY);
+
+            points.setPoint(numPoints++, column, lowY);
+            if (highY != lowY)
+                points.setPoint(numPoints++, column, highY);
+            lastY = points.point(numPoints - 1).y();
+        }
+
+        if (block > lastBlock)
+            break;
+
+        if (block == firstBlock || blockColumn != column)
+        {
+            column = blockColumn;
+            low = minima[block];
+            high = maxima[block];
+        }
+        else
+        {
+            low = QMIN(low, minima[block]);
+            high = QMAX(high, maxima[block]);
+        }
+    }
+
+    painter->setPen(pen());
+    painter->drawPolyline(points, 0, numPoints);
+    Trace::addCounter("decimated curve points", numPoints);
+}
+
+// vim: ts=4 sw=4 et
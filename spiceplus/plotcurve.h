@@ -0,0 +1,71 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PLOTCURVE_H
+#define PLOTCURVE_H
+
+#include <qvaluevector.h>
+#include <qmemarray.h>
+
+#include <qwt/qwt_plot.h>
+#include <qwt/qwt_plot_classes.h>
+
+namespace Spiceplus {
+
+// A curve that draws no more than a few points per pixel column. Once
+// per data change it builds a pyramid of the minimum and maximum of y
+// over blocks of 2, 4, 8, ... points. Each draw then takes the level
+// with a few blocks per pixel for the visible part of the axis, so that
+// zooming, panning and resizing cost time in pixels, not in points. A
+// column shows the whole range of its blocks, so no peak goes missing.
+//
+// Only plain lines with x in ascending order are decimated, anything
+// else (a Nyquist plot, symbols) is drawn as QwtPlotCurve does.
+class PlotCurve : public QwtPlotCurve
+{
+public:
+    PlotCurve(QwtPlot *plot, const QString &title = QString::null);
+
+    void draw(QPainter *painter, const QwtDiMap &xMap, const QwtDiMap &yMap, int from = 0, int to = -1);
+
+protected:
+    void curveChanged();
+
+private:
+    void buildPyramid();
+    // the first point with x at or after value
+    int lowerBound(double value) const;
+    void drawDecimated(QPainter *painter, const QwtDiMap &xMap, const QwtDiMap &yMap, int first, int last, int level);
+
+    // below this many points per pixel column curves are drawn as they are
+    static const int MaxPointsPerPixel = 4;
+
+    bool m_isPyramidValid;
+    bool m_isAscending;
+    // level i holds the extremes of blocks of 2^(i+1) points
+    QValueVector<QMemArray<double> > m_minima;
+    QValueVector<QMemArray<double> > m_maxima;
+};
+
+} // namespace Spiceplus
+
+#endif // PLOTCURVE_H
+
+// vim: ts=4 sw=4 et
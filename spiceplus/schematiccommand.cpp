@@ -17,8 +17,6 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
-#include <math.h>
-
 #include <kdebug.h>
 
 #include "schematiccommand.h"
@@ -110,10 +108,11 @@ void SchematicCommandDeleteDevice::execute()
             }
 
             QValueList<SchematicWireEnd *> wireEnds = pins[i]->wireEnds();
-            if (wireEnds.count() == 2 &&
-                pinVariance(wireEnds.first()->oppositePin(), wireEnds.last()->oppositePin(), pins[i]) < 1)
+            if (wireEnds.count() == 2 && wireEnds.first()->oppositePin() != wireEnds.last()->oppositePin())
             {
+                // join both wires, bending at the pin if they are not straight
                 SchematicWire *wire = new SchematicWire(wireEnds.first()->oppositePin(), wireEnds.last()->oppositePin(), m_schematic);
+                wire->setVertices(SchematicWire::joinVertices(wireEnds.first(), wireEnds.last()));
                 wire->show();
                 m_commands->add(new SchematicCommandPlaceWire(wire));
 
@@ -133,6 +132,7 @@ void SchematicCommandDeleteDevice::execute()
                 for (QValueList<SchematicWireEnd *>::Iterator it = wireEnds.begin(); it != wireEnds.end(); ++it)
                 {
                     SchematicWire *wire = new SchematicWire((*it)->oppositePin(), jun->pin(), m_schematic);
+                    wire->setVertices((*it)->wire()->verticesFrom((*it)->oppositePin()));
                     wire->show();
                     m_commands->add(new SchematicCommandPlaceWire(wire));
 
@@ -156,20 +156,6 @@ void SchematicCommandDeleteDevice::unexecute()
     m_commands->unexecute();
 }
 
-double SchematicCommandDeleteDevice::pinVariance(SchematicDevicePin *pin1, SchematicDevicePin *pin2, SchematicDevicePin *refPin) const
-{
-    QPoint p1a = refPin->worldPoint() - pin1->worldPoint();
-    QPoint p1b = pin2->worldPoint() - pin1->worldPoint();
-
-    QPoint p2a = refPin->worldPoint() - pin2->worldPoint();
-    QPoint p2b = pin1->worldPoint() - pin2->worldPoint();
-
-    double a1 = fabs(fmod((atan2(p1a.y(), p1a.x()) - atan2(p1b.y(), p1b.x())) / M_PI * 180, 360));
-    double a2 = fabs(fmod((atan2(p2a.y(), p2a.x()) - atan2(p2b.y(), p2b.x())) / M_PI * 180, 360));
-
-    return a1 > a2 ? a1 : a2;
-}
-
 //
 // SchematicCommandRotateDevice
 //
@@ -216,6 +202,25 @@ void SchematicCommandFlipDevice::unexecute()
     m_device->flip(m_orientation);
 }
 
+//
+// SchematicCommandMoveWireVertices
+//
+
+SchematicCommandMoveWireVertices::SchematicCommandMoveWireVertices(SchematicWire *wire, const QPointArray &oldVertices)
+    : m_wire(wire), m_oldVertices(oldVertices.copy()), m_newVertices(wire->vertices())
+{
+}
+
+void SchematicCommandMoveWireVertices::execute()
+{
+    m_wire->setVertices(m_newVertices);
+}
+
+void SchematicCommandMoveWireVertices::unexecute()
+{
+    m_wire->setVertices(m_oldVertices);
+}
+
 //
 // SchematicCommandDeleteWire
 //
@@ -21,6 +21,7 @@
 #define SCHEMATICCOMMAND_H
 
 #include <qvaluevector.h>
+#include <qpointarray.h>
 #include <qnamespace.h>
 
 class QPoint;
@@ -82,8 +83,6 @@ public:
     virtual void unexecute();
 
 private:
-    double pinVariance(SchematicDevicePin *pin1, SchematicDevicePin *pin2, SchematicDevicePin *refPin) const;
-
     SchematicDevice *m_device;
     Schematic *m_schematic;
     SchematicCommandGroup *m_commands;
@@ -122,6 +121,20 @@ private:
     Qt::Orientation m_orientation;
 };
 
+class SchematicCommandMoveWireVertices : public SchematicCommand
+{
+public:
+    SchematicCommandMoveWireVertices(SchematicWire *wire, const QPointArray &oldVertices);
+
+    virtual void execute();
+    virtual void unexecute();
+
+private:
+    SchematicWire *m_wire;
+    QPointArray m_oldVertices;
+    QPointArray m_newVertices;
+};
+
 class SchematicCommandDeleteWire : public SchematicCommand
 {
 public:
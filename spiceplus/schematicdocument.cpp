@@ -35,6 +35,9 @@
 #include "schematiccommandhistory.h"
 #include "dcanalysispropertiesdialog.h"
 #include "acanalysispropertiesdialog.h"
+#include "transientanalysispropertiesdialog.h"
+#include "parametersweeppropertiesdialog.h"
+#include "montecarlopropertiesdialog.h"
 
 using namespace Spiceplus;
 
@@ -317,6 +320,51 @@ void SchematicDocument::analysisAC()
     delete dlg;
 }
 
+void SchematicDocument::analysisTransient()
+{
+    if (!m_view->schematic()->canRunAnalysis())
+    {
+        KMessageBox::error(this, m_view->schematic()->errorString());
+        return;
+    }
+
+    m_view->resetTool();
+
+    TransientAnalysisPropertiesDialog *dlg = new TransientAnalysisPropertiesDialog(m_view, this);
+    dlg->exec();
+    delete dlg;
+}
+
+void SchematicDocument::analysisSweep()
+{
+    if (!m_view->schematic()->canRunAnalysis())
+    {
+        KMessageBox::error(this, m_view->schematic()->errorString());
+        return;
+    }
+
+    m_view->resetTool();
+
+    ParameterSweepPropertiesDialog *dlg = new ParameterSweepPropertiesDialog(m_view, this);
+    dlg->exec();
+    delete dlg;
+}
+
+void SchematicDocument::analysisMonteCarlo()
+{
+    if (!m_view->schematic()->canRunAnalysis())
+    {
+        KMessageBox::error(this, m_view->schematic()->errorString());
+        return;
+    }
+
+    m_view->resetTool();
+
+    MonteCarloPropertiesDialog *dlg = new MonteCarloPropertiesDialog(m_view, this);
+    dlg->exec();
+    delete dlg;
+}
+
 void SchematicDocument::toolSelect()
 {
     new SchematicToolSelect(m_view);
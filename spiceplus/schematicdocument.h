@@ -73,6 +73,9 @@ public slots:
 
     void analysisDC();
     void analysisAC();
+    void analysisTransient();
+    void analysisSweep();
+    void analysisMonteCarlo();
 
     void toolSelect();
     void toolPlaceWire();
@@ -144,6 +144,7 @@ void SchematicToolDeviceConnector::connectDevice(SchematicDevice *device, Schema
             {
                 SchematicWireEnd *wireEnd = static_cast<SchematicJunction *>(device)->pin()->wireEnds().first();
                 SchematicWire *w = new SchematicWire(wireEnd->oppositePin(), pin, m_schematic);
+                w->setVertices(wireEnd->wire()->verticesFrom(wireEnd->oppositePin()));
                 w->show();
                 cmdGroup->add(new SchematicCommandPlaceWire(w));
                 
@@ -160,6 +161,7 @@ void SchematicToolDeviceConnector::connectDevice(SchematicDevice *device, Schema
                 for (QValueList<SchematicWireEnd *>::Iterator it = wireEnds.begin(); it != wireEnds.end(); ++it)
                 {
                     SchematicWire *w = new SchematicWire((*it)->oppositePin(), pins[i], m_schematic);
+                    w->setVertices((*it)->wire()->verticesFrom((*it)->oppositePin()));
                     w->show();
                     cmdGroup->add(new SchematicCommandPlaceWire(w));
                     
@@ -188,11 +190,16 @@ void SchematicToolDeviceConnector::connectDevice(SchematicDevice *device, Schema
                 
             if (wire && canConnectItem(wire))
             {
+                QPointArray vertices1, vertices2;
+                wire->splitVertices(pins[i]->worldPoint(), vertices1, vertices2);
+
                 SchematicWire *w = new SchematicWire(wire->end1()->pin(), pins[i], m_schematic);
+                w->setVertices(vertices1);
                 w->show();
                 cmdGroup->add(new SchematicCommandPlaceWire(w));
 
                 w = new SchematicWire(wire->end2()->pin(), pins[i], m_schematic);
+                w->setVertices(vertices2);
                 w->show();
                 cmdGroup->add(new SchematicCommandPlaceWire(w));
 
@@ -290,7 +297,7 @@ void SchematicToolSelect::processMouseDoubleClickEvent(QMouseEvent *event)
     {
         if (!m_deviceSelectionMoved)
         {
-            m_deviceSelection.clear();
+            deviceSelectionClear();
             m_settingProperties = true;
         }
     }
@@ -387,6 +394,10 @@ void SchematicToolSelect::processMouseReleaseEvent(QMouseEvent *event)
             deleteConnectionMarks();
             SchematicCommandGroup *cmdGroup = new SchematicCommandGroup;
 
+            for (size_t i = 0; i < m_wireSelection.count(); ++i)
+                if (m_wireSelection[i].wire->vertices() != m_wireSelection[i].oldVertices)
+                    cmdGroup->add(new SchematicCommandMoveWireVertices(m_wireSelection[i].wire, m_wireSelection[i].oldVertices));
+
             for (size_t i = 0; i < m_deviceSelection.count(); ++i)
             {
                 if (m_deviceSelection[i].device->position() != m_deviceSelection[i].oldPosition)
@@ -402,11 +413,11 @@ void SchematicToolSelect::processMouseReleaseEvent(QMouseEvent *event)
                 m_view->history()->add(cmdGroup);
 
             m_view->schematic()->update();
-            m_deviceSelection.clear();
+            deviceSelectionClear();
         }
         else
         {
-            m_deviceSelection.clear();
+            deviceSelectionClear();
 
             if (m_highlightedItems.count() > 0)
             {
@@ -469,6 +480,20 @@ void SchematicToolSelect::processMouseMoveEvent(QMouseEvent *event)
                 m_deviceSelection[i].device->move(nextStep(p.x() - m_deviceSelection[i].origin.x()), nextStep(p.y() - m_deviceSelection[i].origin.y()));
                 placeConnectionMarks(m_deviceSelection[i].device);
             }
+
+            // the bends move along only if both ends of the wire do
+            QPoint d = m_deviceSelection[0].device->position() - m_deviceSelection[0].oldPosition;
+            for (size_t i = 0; i < m_wireSelection.count(); ++i)
+            {
+                SchematicWire *wire = m_wireSelection[i].wire;
+                if (!deviceSelectionContains(wire->end1()->pin()->device()) ||
+                    !deviceSelectionContains(wire->end2()->pin()->device()))
+                    continue;
+
+                QPointArray v = m_wireSelection[i].oldVertices.copy();
+                v.translate(d.x(), d.y());
+                m_wireSelection[i].wire->setVertices(v);
+            }
             m_deviceSelectionMoved = true;
             m_view->schematic()->update();
         }
@@ -501,7 +526,9 @@ void SchematicToolSelect::reset()
     {
         for (size_t i = 0; i < m_deviceSelection.count(); ++i)
             m_deviceSelection[i].device->setPosition(m_deviceSelection[i].oldPosition);
-        m_deviceSelection.clear();
+        for (size_t i = 0; i < m_wireSelection.count(); ++i)
+            m_wireSelection[i].wire->setVertices(m_wireSelection[i].oldVertices);
+        deviceSelectionClear();
     }
 
     unselectItems();
@@ -647,7 +674,7 @@ void SchematicToolSelect::highlightItem(const QPoint &p)
 
 void SchematicToolSelect::highlightItems(const QRect &r)
 {
-    QCanvasItemList l = m_view->schematic()->collisions(r);
+    QCanvasItemList l = m_view->schematic()->findItems(r);
     for (QCanvasItemList::Iterator it = l.begin(); it != l.end(); ++it)
     {
         SchematicItem *item = dynamic_cast<SchematicItem *>(*it);
@@ -826,6 +853,19 @@ void SchematicToolSelect::deviceSelectionAdd(SchematicItem *item, const QPoint &
         SchematicWire *wire = static_cast<SchematicWire *>(item);
         SchematicDevice *dev;
 
+        bool contained = false;
+        for (size_t i = 0; i < m_wireSelection.count(); ++i)
+            if (m_wireSelection[i].wire == wire)
+                contained = true;
+
+        if (!contained && !wire->vertices().isEmpty())
+        {
+            WireState ws;
+            ws.wire = wire;
+            ws.oldVertices = wire->vertices();
+            m_wireSelection.append(ws);
+        }
+
         dev = wire->end1()->pin()->device();
         if (dev->id() == SchematicJunction::ID && !deviceSelectionContains(dev))
         {
@@ -842,6 +882,12 @@ void SchematicToolSelect::deviceSelectionAdd(SchematicItem *item, const QPoint &
     }
 }
 
+void SchematicToolSelect::deviceSelectionClear()
+{
+    m_deviceSelection.clear();
+    m_wireSelection.clear();
+}
+
 //
 // SchematicToolPlaceWire
 //
@@ -868,7 +914,23 @@ void SchematicToolPlaceWire::processMouseDoubleClickEvent(QMouseEvent *event)
     {
         MainWindow::self()->statusBar()->changeItem("", 0);
 
-        m_wireCommands->unexecute();
+        QPointArray vertices = m_wire->vertices();
+        if (vertices.isEmpty())
+            m_wireCommands->unexecute();
+        else
+        {
+            // terminate the wire at its last bend, as part of placing it
+            SchematicDevice *jun2 = m_wire->end2()->pin()->device();
+            QPoint oldPosition = jun2->position();
+            QPoint v = vertices.point(vertices.size() - 1);
+            m_wire->removeLastVertex();
+            m_wireCommands->add(new SchematicCommandMoveWireVertices(m_wire, vertices));
+            jun2->move(v.x(), v.y());
+            m_wireCommands->add(new SchematicCommandMoveDevice(jun2, oldPosition));
+            m_wire->setHighlighted(false);
+            m_view->history()->add(m_wireCommands);
+        }
+
         m_wireCommands = 0;
         m_view->schematic()->update();
         m_wireMoved = false;
@@ -882,6 +944,20 @@ void SchematicToolPlaceWire::processMousePressEvent(QMouseEvent *event)
 
     if (event->button() == Qt::LeftButton)
     {
+        if (m_wire && !m_view->schematic()->findPinExcluding(p, m_wire->end2()->pin()) &&
+            !m_view->schematic()->findWireExcluding(p, m_wire))
+        {
+            // bend the wire instead of terminating it at a new junction
+            QPointArray points = m_wire->points();
+            QPoint v = nextStep(p);
+            if (v != points.point(0) && (points.size() < 3 || v != points.point(points.size() - 2)))
+                m_wire->addVertex(v);
+
+            m_wireMoved = false;
+            m_view->schematic()->update();
+            return;
+        }
+
         SchematicDevicePin *wirePin = setupWirePin(p);
         if (wirePin)
         {
@@ -1026,6 +1102,7 @@ SchematicDevicePin *SchematicToolPlaceWire::setupWirePin(const QPoint &p)
             wirePin = pin;
 
             SchematicWire *w = new SchematicWire(m_wire->end1()->pin(), wirePin, m_view->schematic());
+            w->setVertices(m_wire->vertices());
             w->show();
             m_wireCommands->add(new SchematicCommandPlaceWire(w));
 
@@ -1053,11 +1130,16 @@ SchematicDevicePin *SchematicToolPlaceWire::setupWirePin(const QPoint &p)
         SchematicWire *wire = m_view->schematic()->findWireExcluding(p, m_wire);
         if (wire)
         {
+            QPointArray vertices1, vertices2;
+            wire->splitVertices(p, vertices1, vertices2);
+
             SchematicWire *w = new SchematicWire(wire->end1()->pin(), wirePin, m_view->schematic());
+            w->setVertices(vertices1);
             w->show();
             m_wireCommands->add(new SchematicCommandPlaceWire(w));
 
             w = new SchematicWire(wire->end2()->pin(), wirePin, m_view->schematic());
+            w->setVertices(vertices2);
             w->show();
             m_wireCommands->add(new SchematicCommandPlaceWire(w));
 
@@ -1103,11 +1185,16 @@ void SchematicToolSplitWire::processMousePressEvent(QMouseEvent *event)
 
         SchematicCommandGroup *cmdGroup = new SchematicCommandGroup;
 
+        QPointArray vertices1, vertices2;
+        m_highlightedWire->splitVertices(p, vertices1, vertices2);
+
         SchematicWire *w = new SchematicWire(m_highlightedWire->end1()->pin(), m_junction->pin(), m_view->schematic());
+        w->setVertices(vertices1);
         w->show();
         cmdGroup->add(new SchematicCommandPlaceWire(w));
 
         w = new SchematicWire(m_highlightedWire->end2()->pin(), m_junction->pin(), m_view->schematic());
+        w->setVertices(vertices2);
         w->show();
         cmdGroup->add(new SchematicCommandPlaceWire(w));
 
@@ -23,6 +23,7 @@
 #include <qobject.h>
 #include <qvaluevector.h>
 #include <qvaluelist.h>
+#include <qpointarray.h>
 
 class QEvent;
 class QMouseEvent;
@@ -158,6 +159,7 @@ private:
 
     bool deviceSelectionContains(SchematicDevice *device) const;
     void deviceSelectionAdd(SchematicItem *item, const QPoint &p);
+    void deviceSelectionClear();
 
     QValueVector<SchematicItem *> m_highlightedItems;
 
@@ -182,6 +184,14 @@ private:
     };
 
     QValueVector<DeviceState> m_deviceSelection;
+
+    struct WireState
+    {
+        SchematicWire *wire;
+        QPointArray oldVertices;
+    };
+
+    QValueVector<WireState> m_wireSelection;
     bool m_deviceSelectionMoved;
     bool m_settingProperties;
 
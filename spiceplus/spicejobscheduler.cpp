@@ -0,0 +1,169 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include <unistd.h>
+
+#include <qvaluevector.h>
+#include <qmemarray.h>
+#include <qtimer.h>
+
+#include "spicejobscheduler.h"
+#include "spiceprocess.h"
+#include "settings.h"
+
+using namespace Spiceplus;
+
+SpiceJobScheduler::SpiceJobScheduler(QObject *parent)
+    : QObject(parent), m_batch(0), m_nextJob(0), m_numFinishedJobs(0)
+{
+}
+
+void SpiceJobScheduler::run(const QStringList &commandLists)
+{
+    cancel();
+
+    m_commandLists = commandLists;
+    m_nextCommandList = m_commandLists.begin();
+
+    // results are always delivered from the event loop, never from here
+    scheduleJobs();
+}
+
+void SpiceJobScheduler::cancel()
+{
+    for (QMap<SpiceProcess *, int>::Iterator it = m_jobs.begin(); it != m_jobs.end(); ++it)
+        it.key()->cancel();
+    m_jobs.clear();
+
+    ++m_batch;
+    m_commandLists.clear();
+    m_nextJob = 0;
+    m_numFinishedJobs = 0;
+}
+
+int SpiceJobScheduler::maxRunningJobs()
+{
+    if (Settings::self()->numSpiceJobs() > 0)
+        return Settings::self()->numSpiceJobs();
+
+    long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+    return numProcessors > 1 ? int(numProcessors) : 1;
+}
+
+void SpiceJobScheduler::scheduleJobs()
+{
+    // a process may not be restarted from within its own exit handler
+    QTimer::singleShot(0, this, SLOT(startJobs()));
+}
+
+void SpiceJobScheduler::startJobs()
+{
+    while (m_nextJob < numJobs())
+    {
+        SpiceProcess *proc = idleProcess();
+        if (!proc)
+            break;
+
+        int job = m_nextJob++;
+        QString commandList = *m_nextCommandList++;
+
+        if (!proc->start(commandList))
+        {
+            int batch = m_batch;
+            emit jobFailed(job, proc->errorString(), QString::null);
+            if (batch == m_batch)
+                countFinishedJob();
+            continue;
+        }
+
+        m_jobs[proc] = job;
+    }
+}
+
+void SpiceJobScheduler::finishJob(const ResultTable &table)
+{
+    int job = takeJob(const_cast<QObject *>(sender()));
+    if (job < 0)
+        return;
+
+    // the receiver may have started another batch meanwhile
+    int batch = m_batch;
+    emit jobFinished(job, table);
+    if (batch == m_batch)
+        countFinishedJob();
+}
+
+void SpiceJobScheduler::failJob(const QString &errorString, const QString &errorDetails)
+{
+    int job = takeJob(const_cast<QObject *>(sender()));
+    if (job < 0)
+        return;
+
+    int batch = m_batch;
+    emit jobFailed(job, errorString, errorDetails);
+    if (batch == m_batch)
+        countFinishedJob();
+}
+
+SpiceProcess *SpiceJobScheduler::idleProcess()
+{
+    // processes that are still being killed or parsed after a cancel
+    // count as busy
+    for (SpiceProcess *proc = m_processes.first(); proc; proc = m_processes.next())
+        if (!proc->isBusy() && !m_jobs.contains(proc))
+            return proc;
+
+    if (static_cast<int>(m_processes.count()) >= maxRunningJobs())
+        return 0;
+
+    SpiceProcess *proc = new SpiceProcess(this);
+    connect(proc, SIGNAL(analysisFinished(const ResultTable &)), SLOT(finishJob(const ResultTable &)));
+    connect(proc, SIGNAL(analysisFailed(const QString &, const QString &)), SLOT(failJob(const QString &, const QString &)));
+    connect(proc, SIGNAL(analysisCancelled()), SLOT(scheduleJobs()));
+    m_processes.append(proc);
+    return proc;
+}
+
+int SpiceJobScheduler::takeJob(QObject *process)
+{
+    // results of cancelled batches are dropped
+    QMap<SpiceProcess *, int>::Iterator it = m_jobs.find(static_cast<SpiceProcess *>(process));
+    if (it == m_jobs.end())
+        return -1;
+
+    int job = it.data();
+    m_jobs.remove(it);
+    return job;
+}
+
+void SpiceJobScheduler::countFinishedJob()
+{
+    ++m_numFinishedJobs;
+    emit progress(m_numFinishedJobs, numJobs());
+
+    if (m_numFinishedJobs == numJobs())
+        emit finished();
+    else
+        scheduleJobs();
+}
+
+#include "spicejobscheduler.moc"
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,88 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef SPICEJOBSCHEDULER_H
+#define SPICEJOBSCHEDULER_H
+
+#include <qobject.h>
+#include <qstringlist.h>
+#include <qptrlist.h>
+#include <qmap.h>
+
+namespace Spiceplus {
+
+class ResultTable;
+class SpiceProcess;
+
+// Runs a batch of independent SPICE jobs, as many at a time as there are
+// processors (or as configured). Jobs are numbered in the order they
+// were given, results arrive in the order the jobs finish.
+class SpiceJobScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    SpiceJobScheduler(QObject *parent = 0);
+
+    // cancels the previous batch, if any
+    void run(const QStringList &commandLists);
+    void cancel();
+
+    bool isRunning() const { return m_numFinishedJobs < numJobs(); }
+    int numJobs() const { return m_commandLists.count(); }
+    int numFinishedJobs() const { return m_numFinishedJobs; }
+
+    static int maxRunningJobs();
+
+signals:
+    void jobFinished(int job, const ResultTable &table);
+    void jobFailed(int job, const QString &errorString, const QString &errorDetails);
+    void progress(int numFinishedJobs, int numJobs);
+    // all jobs of the batch are done, successfully or not
+    void finished();
+
+private slots:
+    void startJobs();
+    void finishJob(const ResultTable &table);
+    void failJob(const QString &errorString, const QString &errorDetails);
+    void scheduleJobs();
+
+private:
+    SpiceProcess *idleProcess();
+    int takeJob(QObject *process);
+    void countFinishedJob();
+
+    // counts batches, so that a batch replaced from within a signal is noticed
+    int m_batch;
+    QStringList m_commandLists;
+    QStringList::ConstIterator m_nextCommandList;
+    int m_nextJob;
+    int m_numFinishedJobs;
+
+    QPtrList<SpiceProcess> m_processes;
+    // the job each busy process works on
+    QMap<SpiceProcess *, int> m_jobs;
+};
+
+} // namespace Spiceplus
+
+#endif // SPICEJOBSCHEDULER_H
+
+// vim: ts=4 sw=4 et
@@ -17,34 +17,141 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
-#include <qvaluevector.h>
-#include <qmemarray.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <qapplication.h>
+#include <qthread.h>
+#include <qdeepcopy.h>
 #include <qregexp.h>
 #include <qfile.h>
+#include <qtimer.h>
 
 #include <klocale.h>
 
 #include "spiceprocess.h"
 #include "settings.h"
+#include "trace.h"
 
 using namespace Spiceplus;
 
+//
+// SpiceParserThread
+//
+
+namespace Spiceplus {
+
+// Carries a parsed table from the parser thread to the process. Nothing
+// else refers to the table until the event is delivered.
+class SpiceParseEvent : public QCustomEvent
+{
+public:
+    SpiceParseEvent(int run) : QCustomEvent(SpiceProcess::ParseEvent), m_run(run), m_error(SpiceProcess::NoParseError) {}
+
+    int run() const { return m_run; }
+    SpiceProcess::ParseError error() const { return m_error; }
+    const ResultTable &table() const { return m_table; }
+
+private:
+    friend class SpiceParserThread;
+
+    int m_run;
+    SpiceProcess::ParseError m_error;
+    ResultTable m_table;
+};
+
+class SpiceParserThread : public QThread
+{
+public:
+    SpiceParserThread(SpiceProcess *process, const QString &output, const QStringList &names, int run);
+
+protected:
+    void run();
+
+private:
+    SpiceProcess *m_process;
+    QString m_output;
+    QStringList m_names;
+    int m_run;
+};
+
+} // namespace Spiceplus
+
+SpiceParserThread::SpiceParserThread(SpiceProcess *process, const QString &output, const QStringList &names, int run)
+    : m_process(process),
+      m_output(QDeepCopy<QString>(output)),
+      m_run(run)
+{
+    for (QStringList::ConstIterator it = names.begin(); it != names.end(); ++it)
+        m_names << QDeepCopy<QString>(*it);
+}
+
+void SpiceParserThread::run()
+{
+    TraceSpan span("SpiceParserThread::run");
+
+    SpiceParseEvent *event = new SpiceParseEvent(m_run);
+    event->m_error = SpiceProcess::parseTable(m_output, m_names, event->m_table);
+    m_output = QString::null;
+
+    QApplication::postEvent(m_process, event);
+}
+
+//
+// SpiceProcess
+//
+
 SpiceProcess::SpiceProcess(QObject *parent)
-    : KProcess(parent), m_numColumns(0)
+    : KProcess(parent),
+      m_traceStart(-1),
+      m_isCancelled(false),
+      m_progress(-1),
+      m_timeLimit(0),
+      m_memoryLimit(0),
+      m_isTimedOut(false),
+      m_isStreaming(false),
+      m_streamState(StreamDone),
+      m_streamPos(0),
+      m_parser(0),
+      m_run(0)
 {
     *this << Settings::self()->spiceExecutablePath() << "-b";
     connect(this, SIGNAL(wroteStdin(KProcess *)), SLOT(closeStdin(KProcess *)));
     connect(this, SIGNAL(receivedStdout(KProcess *, char *, int)), SLOT(processStdout(KProcess *, char *, int)));
     connect(this, SIGNAL(receivedStderr(KProcess *, char *, int)), SLOT(processStderr(KProcess *, char *, int)));
     connect(this, SIGNAL(processExited(KProcess *)), SLOT(finishAnalysis(KProcess *)));
+
+    m_timeLimitTimer = new QTimer(this);
+    connect(m_timeLimitTimer, SIGNAL(timeout()), SLOT(stopAtTimeLimit()));
 }
 
-bool SpiceProcess::start(const QString &commandList, int numColumns)
+SpiceProcess::~SpiceProcess()
 {
+    deleteParser();
+}
+
+bool SpiceProcess::start(const QString &commandList)
+{
+    // the result of the last run, if still being parsed, is dropped
+    ++m_run;
+    deleteParser();
+
     m_commandList = commandList;
-    m_numColumns = numColumns;
+    m_printNames = printNames(commandList);
     m_stdout = "";
     m_stderr = "";
+    m_traceStart = Trace::isEnabled() ? Trace::now() : -1;
+    m_isCancelled = false;
+    m_progress = -1;
+    m_timeLimit = Settings::self()->spiceTimeLimit();
+    m_memoryLimit = Settings::self()->spiceMemoryLimit();
+    m_isTimedOut = false;
+    m_streamState = StreamSeekingTable;
+    m_streamPos = 0;
+    m_streamTable = ResultTable();
 
     if (!QFile::exists(args()[0]))
     {
@@ -64,9 +171,57 @@ bool SpiceProcess::start(const QString &commandList, int numColumns)
         return false;
     }
 
+    if (m_timeLimit > 0)
+        m_timeLimitTimer->start(m_timeLimit * 1000, true);
+
     return true;
 }
 
+void SpiceProcess::cancel()
+{
+    if (!isBusy())
+        return;
+
+    m_isCancelled = true;
+    if (isRunning())
+        killProcessGroup();
+}
+
+int SpiceProcess::commSetupDoneC()
+{
+    // runs in the child: SPICE gets a process group of its own, so that
+    // anything it starts goes with it, and the memory limit
+    if (!KProcess::commSetupDoneC())
+        return 0;
+
+    setpgid(0, 0);
+
+    if (m_memoryLimit > 0)
+    {
+        struct rlimit limit;
+        limit.rlim_cur = limit.rlim_max = rlim_t(m_memoryLimit) * 1024 * 1024;
+        setrlimit(RLIMIT_AS, &limit);
+    }
+
+    return 1;
+}
+
+void SpiceProcess::killProcessGroup()
+{
+    // the child may not have its group yet
+    if (::kill(-pid(), SIGKILL) < 0)
+        kill(SIGKILL);
+}
+
+void SpiceProcess::stopAtTimeLimit()
+{
+    if (!isRunning() || m_isCancelled)
+        return;
+
+    m_isTimedOut = true;
+    killProcessGroup();
+}
+
 void SpiceProcess::closeStdin(KProcess *)
 {
     KProcess::closeStdin();
@@ -75,15 +230,157 @@ void SpiceProcess::closeStdin(KProcess *)
 void SpiceProcess::processStdout(KProcess *, char *buffer, int buflen)
 {
     m_stdout += QString::fromLatin1(buffer, buflen);
+
+    if (m_isStreaming && !m_isCancelled)
+        streamOutput();
 }
 
 void SpiceProcess::processStderr(KProcess *, char *buffer, int buflen)
 {
-    m_stderr += QString::fromLatin1(buffer, buflen);
+    QString text = QString::fromLatin1(buffer, buflen);
+    m_stderr += text;
+
+    // some SPICE versions report how far the analysis has got
+    static QRegExp percent("(\\d+(\\.\\d+)?)\\s*%");
+    for (int pos = 0; (pos = percent.search(text, pos)) >= 0; pos += percent.matchedLength())
+        m_progress = QMIN(100, int(percent.cap(1).toDouble()));
+}
+
+// Declares the vectors of a table from its header and first data row,
+// where a complex value is printed as "real,<tab>imag". The first vector
+// of a row is the index, which is left out, the second the axis. The
+// others are named by the expressions of the .print line, counting from
+// firstVector, or else as in the header.
+static void setUpTable(const QString &header, const QString &firstRow, const QStringList &names, uint firstVector, ResultTable &table)
+{
+    QStringList headerNames = QStringList::split(QRegExp("\\s+"), header);
+    QStringList tokens = QStringList::split(QRegExp("\\s+"), firstRow);
+
+    uint vector = 0;
+    for (QStringList::Iterator it = tokens.begin(); it != tokens.end(); ++vector)
+    {
+        ResultTable::Type type = ResultTable::Real;
+        if ((*it++).endsWith(",") && it != tokens.end())
+        {
+            type = ResultTable::Complex;
+            ++it;
+        }
+
+        if (vector == 1)
+            table.setAxis(vector < headerNames.count() ? headerNames[vector] : QString(""), type);
+        else if (vector > 1)
+        {
+            uint printed = firstVector + vector - 2;
+            QString name = printed < names.count() ? names[printed]
+                         : vector < headerNames.count() ? headerNames[vector] : QString::number(printed + 1);
+            table.addVector(name, type);
+        }
+    }
+}
+
+// Appends the values of a data row, without the index, to a table set up
+// for it. The values go through row, which is reused from row to row.
+static bool appendRow(const QString &line, ResultTable &table, QMemArray<double> &row)
+{
+    QStringList values = QStringList::split(QRegExp("\\s|,"), line);
+    uint numValues = table.numValuesPerRow();
+    if (values.count() != numValues + 1)
+        return false;
+
+    if (row.size() != numValues)
+        row.resize(numValues);
+
+    QStringList::Iterator valueIt = values.begin();
+    for (uint i = 0; i < numValues; ++i)
+    {
+        bool ok;
+        row[i] = (*++valueIt).toDouble(&ok);
+        if (!ok)
+            return false;
+    }
+
+    table.appendRow(row.data());
+    return true;
+}
+
+void SpiceProcess::streamOutput()
+{
+    bool isGrown = false;
+    int end;
+
+    while (m_streamState != StreamDone && (end = m_stdout.find('\n', m_streamPos)) >= 0)
+    {
+        QString line = m_stdout.mid(m_streamPos, end - m_streamPos);
+        m_streamPos = end + 1;
+
+        switch (m_streamState)
+        {
+        case StreamSeekingTable:
+            if (line.startsWith("--------"))
+                m_streamState = StreamSeekingIndex;
+            break;
+
+        case StreamSeekingIndex:
+            m_streamHeader = line;
+            m_streamState = line.startsWith("Index") ? StreamSeekingRows : StreamSeekingTable;
+            break;
+
+        case StreamSeekingRows:
+            m_streamState = line.startsWith("--------") ? StreamFirstRow : StreamSeekingTable;
+            break;
+
+        case StreamFirstRow:
+            setUpTable(m_streamHeader, line, m_printNames, 0, m_streamTable);
+            m_streamState = StreamRows;
+            // fall through
+
+        case StreamRows:
+            // anything unexpected is left to the parse of the whole output
+            if (line.isEmpty() || !appendRow(line, m_streamTable, m_streamRow))
+                m_streamState = StreamDone;
+            else
+                isGrown = true;
+            break;
+
+        case StreamDone:
+            break;
+        }
+    }
+
+    if (isGrown)
+        emit analysisProgress(m_streamTable);
 }
 
 void SpiceProcess::finishAnalysis(KProcess *)
 {
+    m_timeLimitTimer->stop();
+
+    if (m_traceStart >= 0)
+        Trace::addSpan("SPICE run", m_traceStart, Trace::now() - m_traceStart);
+
+    if (m_isCancelled)
+    {
+        emit analysisCancelled();
+        return;
+    }
+
+    if (m_isTimedOut)
+    {
+        emit analysisFailed(i18n("Analysis stopped\nSPICE ran longer than %1 seconds.").arg(m_timeLimit));
+        return;
+    }
+
+    if (!normalExit())
+    {
+        QString errorString = i18n("Analysis failed\nSPICE stopped abnormally.");
+        if (m_memoryLimit > 0)
+            errorString += " " + i18n("It may have run out of its %1 MB of memory.").arg(m_memoryLimit);
+        emit analysisFailed(errorString, m_stderr);
+        return;
+    }
+
+    TraceSpan span("SpiceProcess::finishAnalysis");
+
     QStringList errors = QStringList::split('\n', m_stderr, true);
 
     for (QStringList::Iterator it = errors.begin(); it != errors.end(); ++it)
@@ -95,60 +392,148 @@ void SpiceProcess::finishAnalysis(KProcess *)
         }
     }
 
-    QStringList data = QStringList::split('\n', m_stdout, true);
-    QStringList::Iterator dataIt = data.begin();
+    // a long output takes a while to decode; the table comes back to
+    // customEvent() while the GUI goes on
+    m_parser = new SpiceParserThread(this, m_stdout, m_printNames, m_run);
+    m_stdout = QString::null;
+    m_parser->start();
+}
 
-    for (; dataIt != data.end(); ++dataIt)
-        if ((*dataIt).contains(QRegExp("^--------")))
-            break;
+void SpiceProcess::customEvent(QCustomEvent *event)
+{
+    if (event->type() != ParseEvent)
+        return;
+
+    SpiceParseEvent *parseEvent = static_cast<SpiceParseEvent *>(event);
+    if (parseEvent->run() != m_run)
+        return;
 
-    if (dataIt == data.end() || ++dataIt == data.end() || !(*dataIt).contains(QRegExp("^Index")) || ++dataIt == data.end() || !(*dataIt).contains(QRegExp("^--------")))
+    deleteParser();
+
+    if (m_isCancelled)
     {
-        emit analysisFailed(i18n("Analysis failed: Invalid data"));
+        emit analysisCancelled();
         return;
     }
- 
-    if (++dataIt == data.end())
+
+    if (parseEvent->error() != NoParseError)
     {
-        emit analysisFailed(i18n("Analysis failed: No data"));
+        emit analysisFailed(parseErrorString(parseEvent->error()));
         return;
     }
 
-    QValueVector<QMemArray<double> > table(m_numColumns);
+    Trace::addCounter("analysis rows", parseEvent->table().numRows());
+    emit analysisFinished(parseEvent->table());
+}
 
-    for (int col = 0; col < m_numColumns; ++col)
-        table[col].detach();
+void SpiceProcess::deleteParser()
+{
+    if (!m_parser)
+        return;
+
+    m_parser->wait();
+    delete m_parser;
+    m_parser = 0;
+}
+
+QStringList SpiceProcess::printNames(const QString &commandList)
+{
+    int start = commandList.find(QRegExp("(^|\\n)\\.print\\s", false));
+    if (start < 0)
+        return QStringList();
+
+    int end = commandList.find('\n', start + 1);
+    QStringList tokens = QStringList::split(QRegExp("\\s+"), commandList.mid(start, end < 0 ? -1 : end - start));
+
+    // ".print" and the analysis type
+    tokens.remove(tokens.begin());
+    if (!tokens.isEmpty())
+        tokens.remove(tokens.begin());
+    return tokens;
+}
+
+bool SpiceProcess::parseOutput(const QString &output, ResultTable &table, QString &errorString)
+{
+    ParseError error = parseTable(output, QStringList(), table);
+    if (error == NoParseError)
+        return true;
+
+    errorString = parseErrorString(error);
+    return false;
+}
 
-    for (int row = 0; dataIt != data.end(); ++row, ++dataIt)
+QString SpiceProcess::parseErrorString(ParseError error)
+{
+    switch (error)
+    {
+    case InvalidData:
+        return i18n("Analysis failed: Invalid data");
+    case NoData:
+        return i18n("Analysis failed: No data");
+    case InvalidValues:
+        return i18n("Analysis failed: Invalid values");
+    default:
+        return QString::null;
+    }
+}
+
+SpiceProcess::ParseError SpiceProcess::parseTable(const QString &output, const QStringList &names, ResultTable &table)
+{
+    QStringList data = QStringList::split('\n', output, true);
+    QStringList::Iterator dataIt = data.begin();
+
+    // SPICE splits the vectors of a wide .print into several tables,
+    // which all start with the index and the axis
+    ResultTable result;
+    bool isFirstTable = true;
+    QMemArray<double> row;
+
+    for (;;)
     {
-        if ((*dataIt).isEmpty())
+        for (; dataIt != data.end(); ++dataIt)
+            if ((*dataIt).contains(QRegExp("^--------")))
+                break;
+
+        if (dataIt == data.end() && !isFirstTable)
             break;
 
-        QStringList values = QStringList::split(QRegExp("\\s|,"), *dataIt);
-        bool ok = true;
+        if (dataIt == data.end() || ++dataIt == data.end() || !(*dataIt).contains(QRegExp("^Index")))
+            return InvalidData;
 
-        if (static_cast<int>(values.count()) == m_numColumns)
-        {
-            int col = 0;
-            for (QStringList::Iterator valueIt = values.begin(); valueIt != values.end(); ++col, ++valueIt)
-            {
-                double value = (*valueIt).toDouble(&ok);
-                if (!ok)
-                    break;
-
-                table[col].resize(row + 1, QGArray::SpeedOptim);
-                table[col][row] = value;
-            }
-        }
+        QString header = *dataIt;
+        if (++dataIt == data.end() || !(*dataIt).contains(QRegExp("^--------")))
+            return InvalidData;
+
+        if (++dataIt == data.end() || (*dataIt).isEmpty())
+            return NoData;
+
+        // the rows are counted first, so that the columns are allocated once
+        uint numRows = 0;
+        for (QStringList::Iterator it = dataIt; it != data.end() && !(*it).isEmpty(); ++it)
+            ++numRows;
 
-        if (static_cast<int>(values.count()) != m_numColumns || !ok)
+        ResultTable part;
+        setUpTable(header, *dataIt, names, result.numVectors(), part);
+        part.reserve(numRows);
+
+        for (; dataIt != data.end(); ++dataIt)
         {
-            emit analysisFailed(i18n("Analysis failed: Invalid values"));
-            return;
+            if ((*dataIt).isEmpty())
+                break;
+
+            if (!appendRow(*dataIt, part, row))
+                return InvalidValues;
         }
+
+        if (isFirstTable)
+            result = part;
+        else if (!result.addVectors(part))
+            return InvalidData;
+        isFirstTable = false;
     }
 
-    emit analysisFinished(table);
+    table = result;
+    return NoParseError;
 }
 
 #include "spiceprocess.moc"
@@ -20,39 +20,106 @@
 #ifndef SPICEPROCESS_H
 #define SPICEPROCESS_H
 
+#include <qstringlist.h>
+#include <qmemarray.h>
+
+#include <qevent.h>
+
 #include <kprocess.h>
 
-template<class T> class QValueVector;
-template<class T> class QMemArray;
+#include "resulttable.h"
+
+class QTimer;
 
 namespace Spiceplus {
 
+class SpiceParserThread;
+
 class SpiceProcess : public KProcess
 {
     Q_OBJECT
 
 public:
     SpiceProcess(QObject *parent = 0);
+    ~SpiceProcess();
 
-    bool start(const QString &commandList, int numColumns);
+    bool start(const QString &commandList);
+    // While streaming, the rows of the first table are parsed as SPICE
+    // writes them and passed on by analysisProgress().
+    void setStreaming(bool on) { m_isStreaming = on; }
+    // SPICE is running, or its output is still being parsed
+    bool isBusy() const { return isRunning() || m_parser; }
+    // stops a running analysis without reporting its result
+    void cancel();
     QString errorString() const { return m_errorString; }
+    // as last reported by SPICE in percent, -1 if it doesn't
+    int progress() const { return m_progress; }
+
+    enum ParseError { NoParseError, InvalidData, NoData, InvalidValues };
+
+    // The table has a vector for each expression of the .print line;
+    // they are named as in the header of the output.
+    static bool parseOutput(const QString &output, ResultTable &table, QString &errorString);
+    // The same without translated messages, for use outside the GUI thread.
+    // The vectors are named by the given expressions as far as they go.
+    static ParseError parseTable(const QString &output, const QStringList &names, ResultTable &table);
+    // the expressions of the .print line of a command list
+    static QStringList printNames(const QString &commandList);
+    static QString parseErrorString(ParseError error);
+
+    static const int ParseEvent = QEvent::User + 3;
 
 signals:
     void analysisFailed(const QString &errorString, const QString &errorDetails = QString::null);
-    void analysisFinished(const QValueVector<QMemArray<double> > &table);
+    void analysisFinished(const ResultTable &table);
+    void analysisCancelled();
+    // the rows parsed so far; the table grows in place as more arrive
+    void analysisProgress(const ResultTable &table);
+
+protected:
+    int commSetupDoneC();
+    void customEvent(QCustomEvent *event);
 
 private slots:
+    void stopAtTimeLimit();
     void closeStdin(KProcess *proc);
     void processStdout(KProcess *proc, char *buffer, int buflen);
     void processStderr(KProcess *proc, char *buffer, int buflen);
     void finishAnalysis(KProcess *proc);
 
 private:
+    enum StreamState { StreamSeekingTable, StreamSeekingIndex, StreamSeekingRows, StreamFirstRow, StreamRows, StreamDone };
+
+    void streamOutput();
+    void killProcessGroup();
+    void deleteParser();
+
     QString m_commandList;
-    int m_numColumns;
+    QStringList m_printNames;
     QString m_stdout;
     QString m_stderr;
     QString m_errorString;
+    Q_LLONG m_traceStart;
+    bool m_isCancelled;
+    int m_progress;
+
+    // the limits of the current run from the settings, 0 for none
+    int m_timeLimit;
+    int m_memoryLimit;
+    QTimer *m_timeLimitTimer;
+    bool m_isTimedOut;
+
+    bool m_isStreaming;
+    StreamState m_streamState;
+    uint m_streamPos;
+    QString m_streamHeader;
+    ResultTable m_streamTable;
+    QMemArray<double> m_streamRow;
+
+    // the output of a finished run is parsed in a thread of its own
+    SpiceParserThread *m_parser;
+    // counts the runs, so that the result of an abandoned parse is noticed
+    int m_run;
 };
 
 } // namespace Spiceplus
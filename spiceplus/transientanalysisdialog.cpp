@@ -0,0 +1,214 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <qlayout.h>
+#include <qtimer.h>
+
+#include <klocale.h>
+
+#include "transientanalysisdialog.h"
+#include "schematic.h"
+#include "schematicview.h"
+#include "plot.h"
+#include "plotcurve.h"
+#include "spicenumber.h"
+#include "spiceprocess.h"
+#include "trace.h"
+
+using namespace Spiceplus;
+
+TransientAnalysisDialog::TransientAnalysisDialog(SchematicView *view, const QString &stopTime, const QString &maxStep, const MeterList &meters)
+    : AnalysisDialog(view),
+      m_stopTime(stopTime),
+      m_maxStep(maxStep),
+      m_meters(meters)
+{
+    m_spiceProcess->setStreaming(true);
+    connect(m_spiceProcess, SIGNAL(analysisProgress(const ResultTable &)), SLOT(receiveRows(const ResultTable &)));
+    connect(m_spiceProcess, SIGNAL(analysisFinished(const ResultTable &)), SLOT(finishRun()));
+    connect(m_spiceProcess, SIGNAL(analysisFailed(const QString &, const QString &)), SLOT(keepRows()));
+    connect(m_spiceProcess, SIGNAL(analysisCancelled()), SLOT(keepRows()));
+
+    m_updateTimer = new QTimer(this);
+    connect(m_updateTimer, SIGNAL(timeout()), SLOT(plotRows()));
+
+    setCaption(i18n("Transient Plot %1").arg(Meter::names(m_meters)));
+
+    m_plot = new Plot(centralWidget());
+    m_plot->setAxisTitle(QwtPlot::xBottom, "Time [s]");
+    m_plot->setAxisTitle(QwtPlot::yLeft, "Measured value [" + Meter::shortUnits(m_meters) + "]");
+    m_plotLayout->addWidget(m_plot);
+
+    uint numMeters = m_meters.count();
+    if (numMeters > 1)
+    {
+        m_plot->setAutoLegend(true);
+        m_plot->enableLegend(true);
+    }
+
+    uint meter = 0;
+    for (MeterList::ConstIterator it = m_meters.begin(); it != m_meters.end(); ++it, ++meter)
+    {
+        QColor color = Qt::red;
+        if (numMeters > 1)
+            color.setHsv(300 * meter / (numMeters - 1), 255, 200);
+
+        QwtPlotCurve *curve = new PlotCurve(m_plot, (*it).name());
+        curve->setPen(color);
+        m_plot->insertCurve(curve);
+        m_curves.append(curve);
+    }
+}
+
+bool TransientAnalysisDialog::runAnalysis()
+{
+    QString cmdList = m_view->schematic()->createCommandList();
+    if (cmdList.isNull())
+    {
+        m_errorString = m_view->schematic()->errorString();
+        return false;
+    }
+
+    m_meterCmds.clear();
+    for (MeterList::Iterator it = m_meters.begin(); it != m_meters.end(); ++it)
+    {
+        QString meterCmd = (*it).createCommand(m_view->schematic());
+        if (meterCmd.isNull())
+        {
+            m_errorString = (*it).errorString();
+            return false;
+        }
+        m_meterCmds.append(meterCmd);
+    }
+
+    // a line wide enough for all meters keeps them in the first table,
+    // which is the one that is plotted while it arrives
+    cmdList += createSaveCommand(m_meters);
+    cmdList += ".control\n"
+               "set nobreak\n"
+               "set width=" + QString::number(20 * (m_meters.count() + 2)) + "\n"
+               ".endc\n"
+               ".tran " + maxStep() + " " + m_stopTime + " 0 " + maxStep() + "\n"
+               ".print tran " + m_meterCmds.join(" ") + "\n"
+               ".end\n";
+
+    if (!m_spiceProcess->start(cmdList))
+    {
+        m_errorString = m_spiceProcess->errorString();
+        return false;
+    }
+
+    return true;
+}
+
+QString TransientAnalysisDialog::maxStep() const
+{
+    double step;
+    if (densityDivisor() == 1 || !SpiceNumber::parse(m_maxStep, step))
+        return m_maxStep;
+
+    return QString::number(step * densityDivisor());
+}
+
+void TransientAnalysisDialog::plotData(const ResultTable &table)
+{
+    TraceSpan span("TransientAnalysisDialog::plotData");
+
+    setCurveData(table, true);
+    plotTraces(m_meters, table);
+    m_plot->replot();
+
+    storeRun(m_meters, table);
+}
+
+void TransientAnalysisDialog::overlayRun(const ResultTable &table, const QString &label)
+{
+    uint meter = 0;
+    for (MeterList::ConstIterator it = m_meters.begin(); it != m_meters.end(); ++it, ++meter)
+    {
+        const QMemArray<double> &values = table.real(m_meterCmds[meter]);
+        if (values.size() == table.numRows() && !values.isEmpty())
+            addOverlayCurve(m_plot, meter, m_meters.count(), (*it).name() + " (" + label + ")")->setData(table.axis(), values);
+    }
+    m_plot->replot();
+}
+
+void TransientAnalysisDialog::receiveRows(const ResultTable &table)
+{
+    // the table is shared with the process and keeps growing
+    m_rows = table;
+    if (!m_updateTimer->isActive())
+        m_updateTimer->start(UpdateTime, true);
+}
+
+void TransientAnalysisDialog::plotRows()
+{
+    TraceSpan span("TransientAnalysisDialog::plotRows");
+
+    setCurveData(m_rows, false);
+    plotTraces(m_meters, m_rows);
+    m_plot->replot();
+}
+
+void TransientAnalysisDialog::keepRows()
+{
+    // a cancelled or timed out run leaves the rows so far on the plot
+    if (!m_rows.isEmpty())
+        plotRows();
+    finishRun();
+}
+
+void TransientAnalysisDialog::finishRun()
+{
+    m_updateTimer->stop();
+    m_rows = ResultTable();
+}
+
+void TransientAnalysisDialog::plotTrace(uint index, const QString &title, const ResultTable &table,
+                                        const QMemArray<double> &real, const QMemArray<double> &)
+{
+    // the axis of a table that is still growing has more room than rows
+    const QMemArray<double> &axis = table.axis();
+    QwtPlotCurve *curve = addTraceCurve(m_plot, index, title);
+    if (axis.size() == real.size())
+        curve->setData(axis, real);
+    else
+        curve->setData(axis.data(), real.data(), real.size());
+}
+
+void TransientAnalysisDialog::setCurveData(const ResultTable &table, bool isComplete)
+{
+    uint numRows = table.numRows();
+    const QMemArray<double> &axis = table.axis();
+    for (uint meter = 0; meter < m_meterCmds.count() && meter < m_curves.count(); ++meter)
+    {
+        const QMemArray<double> &values = table.real(m_meterCmds[meter]);
+        if (values.size() < numRows)
+            continue;
+
+        if (isComplete)
+            m_curves[meter]->setData(axis, values);
+        else
+            m_curves[meter]->setData(axis.data(), values.data(), numRows);
+    }
+}
+
+#include "transientanalysisdialog.moc"
+
+// vim: ts=4 sw=4 et
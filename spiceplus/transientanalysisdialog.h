@@ -0,0 +1,82 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRANSIENTANALYSISDIALOG_H
+#define TRANSIENTANALYSISDIALOG_H
+
+#include <qvaluevector.h>
+
+#include "analysisdialog.h"
+
+class QTimer;
+class QwtPlotCurve;
+
+namespace Spiceplus {
+
+class Plot;
+
+// Plots the meters over time. The curves grow while SPICE writes its
+// output; a stopped run keeps what has arrived so far.
+class TransientAnalysisDialog : public AnalysisDialog
+{
+    Q_OBJECT
+
+public:
+    TransientAnalysisDialog(SchematicView *view, const QString &stopTime, const QString &maxStep, const MeterList &meters);
+
+protected:
+    QString analysisName() const { return "Transient"; }
+    void overlayRun(const ResultTable &table, const QString &label);
+    void plotTrace(uint index, const QString &title, const ResultTable &table,
+                   const QMemArray<double> &real, const QMemArray<double> &imag);
+    bool runAnalysis();
+
+protected slots:
+    void plotData(const ResultTable &table);
+
+private slots:
+    void receiveRows(const ResultTable &table);
+    void plotRows();
+    void keepRows();
+    void finishRun();
+
+private:
+    QString maxStep() const;
+    // The curves share the columns of a complete table; those of a table
+    // that is still growing are copied.
+    void setCurveData(const ResultTable &table, bool isComplete);
+
+    QString m_stopTime;
+    QString m_maxStep;
+    MeterList m_meters;
+
+    // the rows of the running analysis, plotted at most every UpdateTime ms
+    ResultTable m_rows;
+    QTimer *m_updateTimer;
+    static const int UpdateTime = 100;
+
+    Plot *m_plot;
+    QValueVector<QwtPlotCurve *> m_curves;
+};
+
+} // namespace Spiceplus
+
+#endif // TRANSIENTANALYSISDIALOG_H
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,92 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <qlayout.h>
+#include <qlabel.h>
+
+#include <klocale.h>
+#include <kdialog.h>
+#include <kmessagebox.h>
+
+#include "transientanalysispropertiesdialog.h"
+#include "schematicview.h"
+#include "parameterlineedit.h"
+#include "meterselector.h"
+#include "transientanalysisdialog.h"
+#include "groupbox.h"
+
+using namespace Spiceplus;
+
+TransientAnalysisPropertiesDialog::TransientAnalysisPropertiesDialog(SchematicView *view, QWidget *parent)
+    : KDialogBase(parent, 0, true, i18n("Transient Analysis"), User1 | Close, User1, false, KGuiItem(i18n("&Plot"), "ok")), m_view(view)
+{
+    QWidget *w = new QWidget(this);
+    setMainWidget(w);
+    QBoxLayout *topLayout = new QVBoxLayout(w, 0, KDialog::spacingHint());
+
+    GroupBox *timeBox = new GroupBox(3, Qt::Horizontal, i18n("Time"), w);
+    timeBox->layout()->setMargin(KDialog::marginHint());
+    timeBox->layout()->setSpacing(KDialog::spacingHint());
+    new QLabel(i18n("Stop:"), timeBox);
+    m_stopTime = new ParameterLineEdit("10m", "10m", timeBox);
+    new QLabel(i18n("Seconds"), timeBox);
+    new QLabel(i18n("Maximum step:"), timeBox);
+    m_maxStep = new ParameterLineEdit("10u", "10u", timeBox);
+    new QLabel(i18n("Seconds"), timeBox);
+    topLayout->addWidget(timeBox);
+
+    GroupBox *outputBox = new GroupBox(0, Qt::Vertical, i18n("Output Variables"), w);
+    outputBox->layout()->setMargin(KDialog::marginHint());
+    outputBox->layout()->setSpacing(KDialog::spacingHint());
+    QGridLayout *outputGrid = new QGridLayout(outputBox->layout(), 4, 4, KDialog::spacingHint());
+    m_meterSelector = new MeterSelector(m_view->schematic(), outputBox, outputGrid, 0, 0, true);
+    topLayout->addWidget(outputBox);
+}
+
+void TransientAnalysisPropertiesDialog::slotUser1()
+{
+    MeterList meters = m_meterSelector->meters();
+
+    for (MeterList::ConstIterator it = meters.begin(); it != meters.end(); ++it)
+    {
+        if ((*it).type() == Meter::Voltmeter && (*it).testPoint1() == (*it).testPoint2())
+        {
+            KMessageBox::sorry(this, i18n("Test Points must differ"));
+            return;
+        }
+    }
+
+    TransientAnalysisDialog *dlg = new TransientAnalysisDialog(m_view, m_stopTime->text(), m_maxStep->text(), meters);
+
+    if (!dlg->startAnalysis())
+    {
+        KMessageBox::error(this, dlg->errorString());
+        delete dlg;
+        dlg = 0;
+    }
+    else
+    {
+        dlg->show();
+        done(User1);
+    }
+}
+
+#include "transientanalysispropertiesdialog.moc"
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,56 @@
+/*
+ * SPICE+
+ * Copyright (C) 2004 Andreas Unger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRANSIENTANALYSISPROPERTIESDIALOG_H
+#define TRANSIENTANALYSISPROPERTIESDIALOG_H
+
+#include <kdialogbase.h>
+
+class QWidget;
+
+namespace Spiceplus {
+
+class SchematicView;
+class ParameterLineEdit;
+class MeterSelector;
+
+class TransientAnalysisPropertiesDialog : public KDialogBase
+{
+    Q_OBJECT
+
+public:
+    TransientAnalysisPropertiesDialog(SchematicView *view, QWidget *parent = 0);
+
+private slots:
+    void slotUser1();
+
+private:
+    SchematicView *m_view;
+
+    ParameterLineEdit *m_stopTime;
+    ParameterLineEdit *m_maxStep;
+
+    MeterSelector *m_meterSelector;
+};
+
+} // namespace Spiceplus
+
+#endif // TRANSIENTANALYSISPROPERTIESDIALOG_H
+
+// vim: ts=4 sw=4 et